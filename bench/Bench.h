@@ -0,0 +1,209 @@
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "Simd.h"
+#include "ThreadPool.h"
+
+/*
+    Timing helpers shared by the benchmarks in bench/, and the registry of
+    the benchmark suite (suite.cpp), in the manner of Google Benchmark:
+
+        template<typename T, size_t N>
+        bench::Case dot(){ ... return {run, flops, bytes}; }
+
+        static const bool registered {
+            bench::add<float, double, int>("dot", bench::sizes<16, 1024>, []<typename T, size_t N>(){
+                return dot<T, N>();
+            })
+        };
+
+    registers dot<float>/16, dot<float>/1024, dot<double>/16 and so on, and
+    bench::main(argc, argv) runs every registered benchmark (or those whose
+    name contains --filter=text), each for at least --min-time=seconds, and
+    writes the results as JSON (to --out=file, or to the standard output):
+    nanoseconds, GFLOP/s and bytes moved per operation.
+*/
+
+namespace bench{
+
+    // Keeps the compiler from optimizing away the computation of value
+    template<typename T>
+    inline void doNotOptimize(const T& value){
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    // Forces pending memory writes to be treated as observable
+    inline void clobberMemory(){
+        asm volatile("" : : : "memory");
+    }
+
+    // Calls function repeatedly for at least minSeconds (after one warm-up
+    // call) and returns the mean time per call in nanoseconds
+    template<typename Function>
+    double nsPerOp(Function&& function, double minSeconds = 0.25){
+
+        using Clock = std::chrono::steady_clock;
+
+        function();
+        clobberMemory();
+
+        size_t iterations {1};
+
+        while (true){
+
+            const auto start {Clock::now()};
+
+            for (size_t i{}; i<iterations; ++i){
+                function();
+                clobberMemory();
+            }
+
+            const std::chrono::duration<double> elapsed {Clock::now() - start};
+
+            if (elapsed.count() >= minSeconds){
+                return elapsed.count() * 1e9 / static_cast<double>(iterations);
+            }
+
+            iterations *= 2;
+        }
+    }
+
+
+    /************************** Benchmark Suite **************************/
+
+    // One benchmark at one size: the call to time, and the work it does,
+    // in operations (a call may perform several, e.g. a cross product of
+    // each of 1024 pairs), arithmetic operations and bytes read or written
+    struct Case{
+        std::function<void()> run;
+        double flops;
+        double bytes;
+        double operations {1};
+    };
+
+    struct Registration{
+        std::string name;
+        std::string type;
+        size_t size;
+        std::function<Case()> make;
+    };
+
+    inline std::vector<Registration>& registry(){
+        static std::vector<Registration> benchmarks {};
+        return benchmarks;
+    }
+
+    // Sizes a benchmark is instantiated at
+    template<size_t... N>
+    inline constexpr std::index_sequence<N...> sizes {};
+
+    template<typename T>
+    constexpr const char* typeName(){
+        if constexpr (std::same_as<T, float>) return "float";
+        else if constexpr (std::same_as<T, double>) return "double";
+        else if constexpr (std::same_as<T, int>) return "int";
+        else return "other";
+    }
+
+    // Registers make.template operator()<T, N>() as name<T>/N for every type
+    // and size (returns true, to initialize a static)
+    template<typename... Types, size_t... N, typename Make>
+    bool add(std::string_view name, std::index_sequence<N...>, Make make){
+
+        auto forType = [&]<typename T>(){
+            (registry().push_back({
+                std::string{name} + "<" + typeName<T>() + ">/" + std::to_string(N),
+                typeName<T>(), N,
+                [make]{ return make.template operator()<T, N>(); }
+            }), ...);
+        };
+
+        (forType.template operator()<Types>(), ...);
+
+        return true;
+    }
+
+    // Runs the registered benchmarks and writes their results as JSON
+    inline int main(int argc, char** argv){
+
+        std::string_view filter {};
+        double minSeconds {0.25};
+        const char* path {nullptr};
+
+        for (int i{1}; i<argc; ++i){
+            const std::string_view argument {argv[i]};
+            if (argument.starts_with("--filter=")){
+                filter = argument.substr(9);
+            } else if (argument.starts_with("--min-time=")){
+                minSeconds = std::strtod(argv[i] + 11, nullptr);
+            } else if (argument.starts_with("--out=")){
+                path = argv[i] + 6;
+            } else {
+                std::fprintf(stderr, "usage: %s [--filter=text] [--min-time=seconds] [--out=file]\n", argv[0]);
+                return 2;
+            }
+        }
+
+        std::FILE* out {path ? std::fopen(path, "w") : stdout};
+
+        if (not out){
+            std::perror(path);
+            return 1;
+        }
+
+        char date[32] {};
+        const std::time_t now {std::time(nullptr)};
+        std::strftime(date, sizeof date, "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+        std::fprintf(out, "{\n  \"context\": {\n");
+        std::fprintf(out, "    \"date\": \"%s\",\n", date);
+        std::fprintf(out, "    \"simd\": \"%s\",\n", simd::name(simd::isa()));
+        std::fprintf(out, "    \"threads\": %zu,\n", parallel::threadCount());
+        std::fprintf(out, "    \"min_time\": %g\n  },\n  \"benchmarks\": [", minSeconds);
+
+        const char* separator {"\n"};
+
+        for (const Registration& benchmark : registry()){
+
+            if (benchmark.name.find(filter) == std::string::npos){
+                continue;
+            }
+
+            const Case c {benchmark.make()};
+            const double ns {nsPerOp(c.run, minSeconds) / c.operations};
+            const double flops {c.flops / c.operations}, bytes {c.bytes / c.operations};
+
+            std::fprintf(stderr, "%-36s %12.3f ns/op %10.3f GFLOP/s\n", benchmark.name.c_str(), ns, flops / ns);
+
+            std::fprintf(
+                out,
+                "%s    {\"name\": \"%s\", \"type\": \"%s\", \"size\": %zu, "
+                "\"ns_per_op\": %.4f, \"gflops\": %.4f, \"bytes_per_op\": %.1f}",
+                separator, benchmark.name.c_str(), benchmark.type.c_str(), benchmark.size,
+                ns, flops / ns, bytes
+            );
+
+            separator = ",\n";
+        }
+
+        std::fprintf(out, "\n  ]\n}\n");
+
+        if (path){
+            std::fclose(out);
+        }
+
+        return 0;
+    }
+
+}
+
+#endif
@@ -0,0 +1,122 @@
+/*
+    Cost of bounds checking in inner loops, on dynamic matrices and vectors:
+
+        at:         c.at(i, j) += a.at(i, k) * b.at(k, j);     (always checked)
+        []:         c[i, j] += a[i, k] * b[k, j];              (unchecked unless
+                                                                built with
+                                                                -DMYMATH_BOUNDS_CHECK)
+        kernel:     gemm(1, a, b, 0, c);
+
+    and likewise for the dot product, sum += x.at(i) * y.at(i) against
+    x[i] * y[i] and dot(x, y).
+*/
+
+#include <cstdio>
+#include "Bench.h"
+#include "DynMatrix.h"
+
+static void report(const char* name, size_t n, double flops, double atNs, double indexNs, double kernelNs){
+    std::printf(
+        "%-6s %6zu %10.2f %10.2f %10.2f %9.2fx\n",
+        name, n, flops / atNs, flops / indexNs, flops / kernelNs, atNs / indexNs
+    );
+}
+
+static void benchGemm(size_t n){
+
+    DynMatrix<double> a(n, n), b(n, n), c(n, n);
+
+    for (size_t i{}; i<n; ++i){
+        for (size_t j{}; j<n; ++j){
+            a[i, j] = static_cast<double>((i * n + j) % 7);
+            b[i, j] = static_cast<double>((i + j * n) % 5);
+        }
+    }
+
+    // i-k-j order, so that the inner loop runs along rows of b and c
+    const double atNs {bench::nsPerOp([&]{
+        for (size_t i{}; i<n; ++i){
+            for (size_t j{}; j<n; ++j){ c.at(i, j) = 0; }
+            for (size_t k{}; k<n; ++k){
+                for (size_t j{}; j<n; ++j){
+                    c.at(i, j) += a.at(i, k) * b.at(k, j);
+                }
+            }
+        }
+        bench::doNotOptimize(c.data());
+    })};
+
+    const double indexNs {bench::nsPerOp([&]{
+        for (size_t i{}; i<n; ++i){
+            for (size_t j{}; j<n; ++j){ c[i, j] = 0; }
+            for (size_t k{}; k<n; ++k){
+                for (size_t j{}; j<n; ++j){
+                    c[i, j] += a[i, k] * b[k, j];
+                }
+            }
+        }
+        bench::doNotOptimize(c.data());
+    })};
+
+    const double kernelNs {bench::nsPerOp([&]{
+        gemm(1.0, a, b, 0.0, c);
+        bench::doNotOptimize(c.data());
+    })};
+
+    report("gemm", n, 2.0 * static_cast<double>(n * n * n), atNs, indexNs, kernelNs);
+}
+
+static void benchDot(size_t n){
+
+    DynVector<double> x(n), y(n);
+
+    for (size_t i{}; i<n; ++i){
+        x[i] = static_cast<double>(i % 11);
+        y[i] = static_cast<double>(i % 3);
+    }
+
+    double result {};
+
+    const double atNs {bench::nsPerOp([&]{
+        double sum {};
+        for (size_t i{}; i<n; ++i){
+            sum += x.at(i) * y.at(i);
+        }
+        result = sum;
+        bench::doNotOptimize(&result);
+    })};
+
+    const double indexNs {bench::nsPerOp([&]{
+        double sum {};
+        for (size_t i{}; i<n; ++i){
+            sum += x[i] * y[i];
+        }
+        result = sum;
+        bench::doNotOptimize(&result);
+    })};
+
+    const double kernelNs {bench::nsPerOp([&]{
+        result = dot(x, y);
+        bench::doNotOptimize(&result);
+    })};
+
+    report("dot", n, 2.0 * static_cast<double>(n), atNs, indexNs, kernelNs);
+}
+
+int main(){
+
+    std::printf(
+        "%-6s %6s %10s %10s %10s %10s\n",
+        "op", "N", "at GF/s", "[] GF/s", "kernel", "[] vs at"
+    );
+
+    for (size_t n : {64uz, 128uz, 256uz}){
+        benchGemm(n);
+    }
+
+    for (size_t n : {1024uz, 16384uz, 262144uz}){
+        benchDot(n);
+    }
+
+    return 0;
+}
@@ -0,0 +1,78 @@
+/*
+    Temporaries from the heap against temporaries from a memory::Arena, for
+    a few steps of a solver on an n x n DynMatrix<double>:
+
+        r = b - a * x;                          // a temporary for a * x
+        x += LU{a}.solve(r) * 0.5;              // a copy of a, the pivots, x
+
+    once as is and once inside a memory::Scope of an arena, and the heap
+    allocations each step makes (memory::stats()), which the arena brings
+    to zero once it has grown to what a step needs.
+*/
+
+#include <cstdio>
+#include "Bench.h"
+#include "Factorization.h"
+#include "Memory.h"
+
+static void step(const DynMatrix<double>& a, const DynVector<double>& b, DynVector<double>& r, DynVector<double>& x){
+    r = b - a * x;
+    x += LU{a}.solve(r) * 0.5;
+}
+
+static void benchSize(size_t n){
+
+    DynMatrix<double> a(n, n);
+    DynVector<double> b(n), r(n), x(n);
+
+    for (size_t i{}; i<n; ++i){
+        for (size_t j{}; j<n; ++j){
+            a[i, j] = i == j ? static_cast<double>(n) : 1.0 / static_cast<double>(1 + i + j);
+        }
+        b[i] = static_cast<double>(i % 7);
+    }
+
+    const double heapNs {bench::nsPerOp([&]{
+        step(a, b, r, x);
+        bench::doNotOptimize(x.data());
+    })};
+
+    memory::resetStats();
+    step(a, b, r, x);
+    const memory::Stats heap {memory::stats()};
+
+    memory::Arena arena {};
+
+    const double arenaNs {bench::nsPerOp([&]{
+        memory::Scope scope {arena};
+        step(a, b, r, x);
+        bench::doNotOptimize(x.data());
+    })};
+
+    memory::resetStats();
+    {
+        memory::Scope scope {arena};
+        step(a, b, r, x);
+    }
+    const memory::Stats scoped {memory::stats()};
+
+    std::printf(
+        "%6zu %12.2f %12.2f %9.2fx %14zu %14zu %12zu\n",
+        n, heapNs / 1e3, arenaNs / 1e3, heapNs / arenaNs,
+        heap.allocations, scoped.allocations, arena.peak()
+    );
+}
+
+int main(){
+
+    std::printf(
+        "%6s %12s %12s %10s %14s %14s %12s\n",
+        "n", "heap us", "arena us", "speedup", "heap allocs", "arena allocs", "arena bytes"
+    );
+
+    for (size_t n : {size_t{8}, size_t{32}, size_t{128}, size_t{512}}){
+        benchSize(n);
+    }
+
+    return 0;
+}
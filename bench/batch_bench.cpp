@@ -0,0 +1,122 @@
+/*
+    Applying one small matrix to many vectors, stored one after the other
+    (an array of Vectors, transformed one at a time) against stored as
+    structure of arrays (a VectorBatch, transformed in SIMD lanes):
+
+        AoS:    for (i) out[i] = m * in[i];
+        SoA:    transform(m, in, out);
+
+    for Matrix<double, 3, 3> and Matrix<float, 4, 4>, and likewise for the
+    cross and dot products of pairs of 3 dimensional vectors.
+*/
+
+#include <cstdio>
+#include <vector>
+#include "Bench.h"
+#include "Batch.h"
+
+static void report(const char* name, size_t n, double aosNs, double soaNs){
+    const double count {static_cast<double>(n)};
+    std::printf(
+        "%-14s %9zu %12.3f %12.3f %9.2fx\n",
+        name, n, aosNs / count, soaNs / count, aosNs / soaNs
+    );
+}
+
+template<typename T, size_t N>
+static std::vector<Vector<T, N>> vectors(size_t n, size_t seed){
+    std::vector<Vector<T, N>> result(n);
+    for (size_t i{}; i<n; ++i){
+        for (size_t c{}; c<N; ++c){
+            result[i][c] = static_cast<T>((i * 7 + c * 3 + seed) % 11) - T{5};
+        }
+    }
+    return result;
+}
+
+template<typename T, size_t N>
+static void benchTransform(const char* name, size_t n){
+
+    Matrix<T, N, N> m {};
+    for (size_t r{}; r<N; ++r){
+        for (size_t c{}; c<N; ++c){
+            m[r, c] = static_cast<T>((r * N + c) % 5) - T{2};
+        }
+    }
+
+    const std::vector<Vector<T, N>> in {vectors<T, N>(n, 0)};
+    std::vector<Vector<T, N>> out(n);
+
+    const VectorBatch<T, N> batchIn {std::span<const Vector<T, N>>{in}};
+    VectorBatch<T, N> batchOut(n);
+
+    const double aosNs {bench::nsPerOp([&]{
+        for (size_t i{}; i<n; ++i){
+            out[i] = m * in[i];
+        }
+        bench::doNotOptimize(out.data());
+    })};
+
+    const double soaNs {bench::nsPerOp([&]{
+        transform(m, batchIn, batchOut);
+        bench::doNotOptimize(batchOut.data(0));
+    })};
+
+    report(name, n, aosNs, soaNs);
+}
+
+static void benchPairs(size_t n){
+
+    const std::vector<Vector<double, 3>> a {vectors<double, 3>(n, 0)};
+    const std::vector<Vector<double, 3>> b {vectors<double, 3>(n, 5)};
+    std::vector<Vector<double, 3>> crossOut(n);
+    std::vector<double> dotOut(n);
+
+    const VectorBatch<double, 3> batchA {std::span<const Vector<double, 3>>{a}};
+    const VectorBatch<double, 3> batchB {std::span<const Vector<double, 3>>{b}};
+    VectorBatch<double, 3> batchCross(n);
+    DynVector<double> batchDot(n);
+
+    const double aosCrossNs {bench::nsPerOp([&]{
+        for (size_t i{}; i<n; ++i){
+            crossOut[i] = a[i].cross(b[i]);
+        }
+        bench::doNotOptimize(crossOut.data());
+    })};
+
+    const double soaCrossNs {bench::nsPerOp([&]{
+        cross(batchA, batchB, batchCross);
+        bench::doNotOptimize(batchCross.data(0));
+    })};
+
+    report("cross double", n, aosCrossNs, soaCrossNs);
+
+    const double aosDotNs {bench::nsPerOp([&]{
+        for (size_t i{}; i<n; ++i){
+            dotOut[i] = a[i].dot(b[i]);
+        }
+        bench::doNotOptimize(dotOut.data());
+    })};
+
+    const double soaDotNs {bench::nsPerOp([&]{
+        dot(batchA, batchB, batchDot);
+        bench::doNotOptimize(batchDot.data());
+    })};
+
+    report("dot double", n, aosDotNs, soaDotNs);
+}
+
+int main(){
+
+    std::printf(
+        "%-14s %9s %12s %12s %10s\n", "op", "N", "AoS ns/vec", "SoA ns/vec", "speedup"
+    );
+
+    for (size_t n : {1000uz, 100000uz, 1000000uz}){
+        benchTransform<double, 3>("3x3 double", n);
+        benchTransform<float, 4>("4x4 float", n);
+        benchPairs(n);
+    }
+
+    return 0;
+}
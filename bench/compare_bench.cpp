@@ -0,0 +1,78 @@
+/*
+    Equality of two equal arrays of doubles and floats (the worst case, every
+    element is compared), element by element against as a whole:
+
+        call:       for (i) if (not isEqual(x[i], y[i])) ...    (an out of
+                                                                line call per
+                                                                element, as
+                                                                before Compare.h)
+        inline:     for (i) if (not compare::equal(x[i], y[i])) ...
+        array:      x == y      (compare::equal(x.data(), y.data(), n), SIMD)
+*/
+
+#include <cstdio>
+#include "Bench.h"
+#include "DynVector.h"
+
+// The former comparison, compiled out of line
+[[gnu::noinline]] static bool isEqual(double x, double y){
+    return (x > y ? x - y : y - x) < 0.000001;
+}
+
+static void report(const char* name, size_t n, double callNs, double inlineNs, double arrayNs){
+    const double count {static_cast<double>(n)};
+    std::printf(
+        "%-7s %9zu %10.3f %10.3f %10.3f %9.2fx\n",
+        name, n, callNs / count, inlineNs / count, arrayNs / count, callNs / arrayNs
+    );
+}
+
+template<typename T>
+static void benchEqual(const char* name, size_t n){
+
+    DynVector<T> x(n), y(n);
+
+    for (size_t i{}; i<n; ++i){
+        x[i] = y[i] = static_cast<T>(i % 101) / T{7};
+    }
+
+    bool equal {};
+
+    const double callNs {bench::nsPerOp([&]{
+        equal = true;
+        for (size_t i{}; i<n; ++i){
+            if (not isEqual(x[i], y[i])){ equal = false; break; }
+        }
+        bench::doNotOptimize(equal);
+    })};
+
+    const double inlineNs {bench::nsPerOp([&]{
+        equal = true;
+        for (size_t i{}; i<n; ++i){
+            if (not compare::equal(x[i], y[i])){ equal = false; break; }
+        }
+        bench::doNotOptimize(equal);
+    })};
+
+    const double arrayNs {bench::nsPerOp([&]{
+        equal = x == y;
+        bench::doNotOptimize(equal);
+    })};
+
+    report(name, n, callNs, inlineNs, arrayNs);
+}
+
+int main(){
+
+    std::printf(
+        "%-7s %9s %10s %10s %10s %10s\n",
+        "type", "N", "call ns/el", "inline", "array", "speedup"
+    );
+
+    for (size_t n : {64uz, 4096uz, 262144uz}){
+        benchEqual<double>("double", n);
+        benchEqual<float>("float", n);
+    }
+
+    return 0;
+}
@@ -0,0 +1,53 @@
+/*
+    Chained element-wise expression r = a + b*2 - c on large vectors.
+
+    "temporaries" evaluates one operator at a time into intermediate
+    vectors, the way operator+ / operator- / operator* worked before
+    expression templates; "fused" evaluates the whole expression in one
+    loop. Bytes/op counts every element read or written.
+*/
+
+#include <cstdio>
+#include "Bench.h"
+#include "Vector.h"
+
+static constexpr size_t N = size_t{1} << 18;   // 2 MiB per vector of doubles
+
+static Vector<double, N> a, b, c, r, t1, t2;
+
+static void report(const char* name, double ns, double bytes){
+    std::printf(
+        "%-12s %12.0f ns/op %10.0f bytes/op %8.2f GB/s\n",
+        name, ns, bytes, bytes / ns
+    );
+}
+
+int main(){
+
+    for (size_t i{}; i<N; ++i){
+        a[i] = static_cast<double>(i);
+        b[i] = 0.5 * static_cast<double>(i);
+        c[i] = 1.0;
+    }
+
+    const double temporaries {bench::nsPerOp([]{
+        t1 = b * 2.0;       // read b, write t1
+        t2 = a + t1;        // read a, t1, write t2
+        r = t2 - c;         // read t2, c, write r
+        bench::doNotOptimize(r);
+    })};
+
+    const double fused {bench::nsPerOp([]{
+        r = a + b * 2.0 - c;   // read a, b, c, write r
+        bench::doNotOptimize(r);
+    })};
+
+    constexpr double element = sizeof(double);
+
+    std::printf("r = a + b*2 - c, N = %zu\n", N);
+    report("temporaries", temporaries, 8 * N * element);
+    report("fused", fused, 4 * N * element);
+    std::printf("speedup      %12.2fx\n", temporaries / fused);
+
+    return 0;
+}
@@ -0,0 +1,101 @@
+/*
+    Blocked factorizations, whose trailing updates go through gemm(),
+    against the same algorithms unblocked (a rank one update per column),
+    on DynMatrix<double>:
+
+        LU:         lu(a, pivots)           kernel::getf2(n, n, ...)
+        Cholesky:   cholesky(a)             kernel::potf2(n, n, ...)
+        QR:         qr(a, tau)              kernel::geqr2(n, n, ...)
+
+    in GFLOP/s, counting 2n^3/3, n^3/3 and 4n^3/3 flops.
+*/
+
+#include <cstdio>
+#include <vector>
+#include "Bench.h"
+#include "Factorization.h"
+
+static void report(const char* name, size_t n, double flops, double unblockedNs, double blockedNs){
+    std::printf(
+        "%-9s %6zu %12.2f %12.2f %9.2fx\n",
+        name, n, flops / unblockedNs, flops / blockedNs, unblockedNs / blockedNs
+    );
+}
+
+// Diagonally dominant, so that it is regular and (being symmetric)
+// positive definite
+static DynMatrix<double> matrix(size_t n){
+    DynMatrix<double> a(n, n);
+    for (size_t i{}; i<n; ++i){
+        for (size_t j{}; j<n; ++j){
+            a[i, j] = static_cast<double>((i * j + i + j) % 7) / 7.0;
+        }
+        a[i, i] += static_cast<double>(n);
+    }
+    return a;
+}
+
+static void benchFactorizations(size_t n){
+
+    const DynMatrix<double> source {matrix(n)};
+    DynMatrix<double> a {source};
+    std::vector<size_t> pivots(n);
+    std::vector<double> tau(n);
+    const double cube {static_cast<double>(n * n * n)};
+
+    // Each run factors a fresh copy; the copy is O(n^2) and is timed by both
+    const double luUnblockedNs {bench::nsPerOp([&]{
+        a = source;
+        kernel::getf2(n, n, a.data(), n, 1, pivots.data());
+        bench::doNotOptimize(a.data());
+    })};
+
+    const double luBlockedNs {bench::nsPerOp([&]{
+        a = source;
+        lu(a, std::span<size_t>{pivots});
+        bench::doNotOptimize(a.data());
+    })};
+
+    report("LU", n, 2.0 * cube / 3.0, luUnblockedNs, luBlockedNs);
+
+    const double cholUnblockedNs {bench::nsPerOp([&]{
+        a = source;
+        kernel::potf2(n, n, a.data(), n, 1);
+        bench::doNotOptimize(a.data());
+    })};
+
+    const double cholBlockedNs {bench::nsPerOp([&]{
+        a = source;
+        cholesky(a);
+        bench::doNotOptimize(a.data());
+    })};
+
+    report("Cholesky", n, cube / 3.0, cholUnblockedNs, cholBlockedNs);
+
+    const double qrUnblockedNs {bench::nsPerOp([&]{
+        a = source;
+        kernel::geqr2(n, n, a.data(), n, 1, tau.data());
+        bench::doNotOptimize(a.data());
+    })};
+
+    const double qrBlockedNs {bench::nsPerOp([&]{
+        a = source;
+        qr(a, std::span<double>{tau});
+        bench::doNotOptimize(a.data());
+    })};
+
+    report("QR", n, 4.0 * cube / 3.0, qrUnblockedNs, qrBlockedNs);
+}
+
+int main(){
+
+    std::printf(
+        "%-9s %6s %12s %12s %10s\n", "op", "N", "unblocked", "blocked", "speedup"
+    );
+
+    for (size_t n : {128uz, 256uz, 512uz, 1024uz}){
+        benchFactorizations(n);
+    }
+
+    return 0;
+}
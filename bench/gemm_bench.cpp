@@ -0,0 +1,131 @@
+/*
+    GFLOP/s of Matrix::operator*(Matrix) against the previous
+    implementation: an i-j-k triple loop through the bounds-checked
+    operator[] of both matrices.
+
+    Sizes above 256 are run on heap buffers through kernel::gemm directly,
+    since fixed-size matrices that large do not fit on the stack.
+*/
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include "Bench.h"
+#include "Matrix.h"
+
+template<typename T, size_t R, size_t C, size_t C_rhs>
+Matrix<T, R, C_rhs> naive(const Matrix<T, R, C>& lhs, const Matrix<T, C, C_rhs>& rhs){
+
+    Matrix<T, R, C_rhs> resMat {};
+
+    for (size_t i{}; i<R; ++i){
+        for (size_t j{}; j<C_rhs; ++j){
+            for (size_t k{}; k<C; ++k){
+                resMat[i][j] += lhs[i][k] * rhs[k][j];
+            }
+        }
+    }
+
+    return resMat;
+}
+
+static void report(size_t n, double naiveNs, double kernelNs, double error){
+
+    const double flops {2.0 * static_cast<double>(n * n * n)};
+
+    std::printf(
+        "%6zu %12.2f %12.2f %9.2fx %10.1e\n",
+        n, flops / naiveNs, flops / kernelNs, naiveNs / kernelNs, error
+    );
+}
+
+template<size_t N>
+static void benchFixed(){
+
+    static Matrix<double, N, N> a, b, c, reference;
+
+    for (size_t i{}; i<N; ++i){
+        for (size_t j{}; j<N; ++j){
+            a[i][j] = std::sin(static_cast<double>(i * N + j));
+            b[i][j] = std::cos(static_cast<double>(i + j * N));
+        }
+    }
+
+    const double naiveNs {bench::nsPerOp([]{
+        reference = naive(a, b);
+        bench::doNotOptimize(reference);
+    })};
+
+    const double kernelNs {bench::nsPerOp([]{
+        c = a * b;
+        bench::doNotOptimize(c);
+    })};
+
+    double error {};
+    for (size_t i{}; i<N; ++i){
+        for (size_t j{}; j<N; ++j){
+            error = std::max(error, std::abs(c[i][j] - reference[i][j]));
+        }
+    }
+
+    report(N, naiveNs, kernelNs, error);
+}
+
+static void benchDynamic(size_t n){
+
+    std::vector<double> a(n * n), b(n * n), c(n * n), reference(n * n);
+
+    for (size_t i{}; i<n*n; ++i){
+        a[i] = std::sin(static_cast<double>(i));
+        b[i] = std::cos(static_cast<double>(i));
+    }
+
+    const double naiveNs {bench::nsPerOp([&]{
+        for (size_t i{}; i<n; ++i){
+            for (size_t j{}; j<n; ++j){
+                double sum {};
+                for (size_t k{}; k<n; ++k){
+                    sum += a[i*n + k] * b[k*n + j];
+                }
+                reference[i*n + j] = sum;
+            }
+        }
+        bench::doNotOptimize(reference.data());
+    }, 1.0)};
+
+    const double kernelNs {bench::nsPerOp([&]{
+        kernel::gemm(n, n, n, a.data(), n, b.data(), n, c.data(), n);
+        bench::doNotOptimize(c.data());
+    }, 1.0)};
+
+    double error {};
+    for (size_t i{}; i<n*n; ++i){
+        error = std::max(error, std::abs(c[i] - reference[i]));
+    }
+
+    report(n, naiveNs, kernelNs, error);
+}
+
+int main(){
+
+    // MYMATH_THREADS sets the number of threads of the kernel
+    std::printf("threads: %zu\n", parallel::threadCount());
+
+    std::printf(
+        "%6s %12s %12s %10s %10s\n", "N", "naive GF/s", "kernel GF/s", "speedup", "max error"
+    );
+
+    benchFixed<3>();
+    benchFixed<4>();
+    benchFixed<8>();
+    benchFixed<16>();
+    benchFixed<32>();
+    benchFixed<64>();
+    benchFixed<128>();
+    benchFixed<256>();
+
+    benchDynamic(512);
+    benchDynamic(1024);
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+/*
+    Cost of the temporaries of the operator syntax against the in-place
+    BLAS-style calls, on dynamic matrices where every temporary is a heap
+    allocation:
+
+        temporaries:    C = A * B + C;          (product and sum evaluated
+                                                 into fresh matrices)
+        in-place:       gemm(1, A, B, 1, C);    (same as C.noalias() += A * B)
+
+    and likewise y = A * x + y against gemv(1, A, x, 1, y).
+*/
+
+#include <cmath>
+#include <cstdio>
+#include "Bench.h"
+#include "DynMatrix.h"
+
+static void benchGemm(size_t n){
+
+    DynMatrix<double> a(n, n), b(n, n), c(n, n);
+
+    for (size_t i{}; i<n; ++i){
+        for (size_t j{}; j<n; ++j){
+            a[i, j] = std::sin(static_cast<double>(i * n + j));
+            b[i, j] = std::cos(static_cast<double>(i + j * n));
+        }
+    }
+
+    const double temporariesNs {bench::nsPerOp([&]{
+        c = a * b + c;
+        bench::doNotOptimize(c.data());
+    })};
+
+    const double inPlaceNs {bench::nsPerOp([&]{
+        gemm(1.0, a, b, 1.0, c);
+        bench::doNotOptimize(c.data());
+    })};
+
+    std::printf(
+        "%-6s %6zu %14.1f %14.1f %9.2fx\n",
+        "gemm", n, temporariesNs, inPlaceNs, temporariesNs / inPlaceNs
+    );
+}
+
+static void benchGemv(size_t n){
+
+    DynMatrix<double> a(n, n);
+    DynVector<double> x(n), y(n);
+
+    for (size_t i{}; i<n; ++i){
+        x[i] = std::cos(static_cast<double>(i));
+        for (size_t j{}; j<n; ++j){
+            a[i, j] = std::sin(static_cast<double>(i * n + j));
+        }
+    }
+
+    const double temporariesNs {bench::nsPerOp([&]{
+        y = a * x + y;
+        bench::doNotOptimize(y.data());
+    })};
+
+    const double inPlaceNs {bench::nsPerOp([&]{
+        gemv(1.0, a, x, 1.0, y);
+        bench::doNotOptimize(y.data());
+    })};
+
+    std::printf(
+        "%-6s %6zu %14.1f %14.1f %9.2fx\n",
+        "gemv", n, temporariesNs, inPlaceNs, temporariesNs / inPlaceNs
+    );
+}
+
+int main(){
+
+    std::printf(
+        "%-6s %6s %14s %14s %10s\n", "op", "N", "temps ns/op", "in-place ns/op", "speedup"
+    );
+
+    for (size_t n : {4uz, 16uz, 64uz, 256uz}){
+        benchGemm(n);
+    }
+
+    for (size_t n : {16uz, 64uz, 256uz, 1024uz}){
+        benchGemv(n);
+    }
+
+    return 0;
+}
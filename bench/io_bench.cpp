@@ -0,0 +1,82 @@
+/*
+    Reading a 1024 x 1024 DynMatrix<double> back from disk, saved as the text
+    of operator<< and with io::save():
+
+        text, >>:       file >> m[i, j], element by element
+        text, parse:    io::loadText<DynMatrix<double>>(path)
+        binary, load:   io::load<DynMatrix<double>>(path)
+        binary, mmap:   io::MappedFile{path}.matrix<double>(), summed
+
+    The mapped file is summed so that its pages are actually read (mapping
+    it reads nothing). The files are written to the temporary
+    directory, and are in the page cache: this measures parsing and
+    copying, not the disk.
+*/
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include "Bench.h"
+#include "Serialize.h"
+
+constexpr size_t N {1024};
+
+static void report(const char* format, double ns){
+    std::printf("%-16s %12.3f ms %10.1f MB/s\n", format, ns / 1e6, N * N * sizeof(double) / (ns / 1e3));
+}
+
+int main(){
+
+    std::mt19937 random {42};
+    std::uniform_real_distribution<double> uniform {-1e3, 1e3};
+
+    DynMatrix<double> m(N, N);
+    for (size_t i{}; i<N*N; ++i){
+        m.data()[i] = uniform(random);
+    }
+
+    const auto directory {std::filesystem::temp_directory_path()};
+    const std::string text {(directory / "io_bench.txt").string()};
+    const std::string binary {(directory / "io_bench.bin").string()};
+
+    std::ofstream{text} << m;
+    io::save(binary, m);
+
+    std::printf("%-16s %15s %13s\n", "format", "time", "rate");
+
+    report("text, >>", bench::nsPerOp([&]{
+        std::ifstream file {text};
+        DynMatrix<double> r(N, N);
+        for (size_t i{}; i<N; ++i){
+            for (size_t j{}; j<N; ++j){
+                file >> r[i, j];
+            }
+        }
+        bench::doNotOptimize(r.data());
+    }, 1.0));
+
+    report("text, parse", bench::nsPerOp([&]{
+        const auto r {io::loadText<DynMatrix<double>>(text)};
+        bench::doNotOptimize(r.data());
+    }, 1.0));
+
+    report("binary, load", bench::nsPerOp([&]{
+        const auto r {io::load<DynMatrix<double>>(binary)};
+        bench::doNotOptimize(r.data());
+    }));
+
+    report("binary, mmap", bench::nsPerOp([&]{
+        const io::MappedFile file {binary};
+        double sum {};
+        for (double x : file.data<double>()){
+            sum += x;
+        }
+        bench::doNotOptimize(sum);
+    }));
+
+    std::filesystem::remove(text);
+    std::filesystem::remove(binary);
+
+    return 0;
+}
@@ -0,0 +1,92 @@
+/*
+    Matrix-vector products and dot products whose large operand is stored as
+    float, numeric::half or numeric::bfloat16, the other operand and the
+    result being float:
+
+        y.noalias() = a * x;        // a: n x n DynMatrix<S>, x: DynVector<float>
+        dot(u, u)                   // u: DynVector<S> of the n*n elements of a
+
+    The 16-bit formats are widened to float as they are loaded and summed in
+    float, so that these products, bound by the bandwidth of reading a, move
+    half the bytes of float. The last column is the largest difference from
+    the float result relative to its magnitude, i.e. the rounding of the
+    stored elements, not of the sums.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include "Bench.h"
+#include "Blas.h"
+#include "DynMatrix.h"
+#include "DynVector.h"
+
+template<typename S>
+static void benchType(const char* name, size_t n, const DynMatrix<float>& a, const DynVector<float>& x, const DynVector<float>& reference){
+
+    const DynMatrix<S> stored = convert<S>(a);
+    DynVector<S> u(n * n);
+    for (size_t i{}; i<n*n; ++i){
+        u[i] = static_cast<S>(a.data()[i]);
+    }
+
+    DynVector<float> y(n);
+
+    const double gemvNs {bench::nsPerOp([&]{
+        y.noalias() = stored * x;
+        bench::doNotOptimize(y.data());
+    })};
+
+    const double dotNs {bench::nsPerOp([&]{
+        bench::doNotOptimize(dot(u, u));
+    })};
+
+    float error {};
+    float scale {};
+    for (size_t i{}; i<n; ++i){
+        error = std::max(error, std::abs(y[i] - reference[i]));
+        scale = std::max(scale, std::abs(reference[i]));
+    }
+
+    const double bytes {static_cast<double>(n * n * sizeof(S))};
+
+    std::printf(
+        "%6zu %-9s %12.2f %10.2f %12.2f %10.2f %12.2e\n",
+        n, name, gemvNs / 1e3, bytes / gemvNs, dotNs / 1e3, 2 * bytes / dotNs, error / scale
+    );
+}
+
+static void benchSize(size_t n){
+
+    DynMatrix<float> a(n, n);
+    DynVector<float> x(n);
+
+    for (size_t i{}; i<n; ++i){
+        for (size_t j{}; j<n; ++j){
+            a[i, j] = std::sin(static_cast<float>(i * n + j));
+        }
+        x[i] = std::cos(static_cast<float>(i));
+    }
+
+    const DynVector<float> reference = a * x;
+
+    benchType<float>("float", n, a, x, reference);
+    #ifdef MYMATH_HAS_FLOAT16
+    benchType<numeric::half>("half", n, a, x, reference);
+    #endif
+    benchType<numeric::bfloat16>("bfloat16", n, a, x, reference);
+}
+
+int main(){
+
+    std::printf(
+        "%6s %-9s %12s %10s %12s %10s %12s\n",
+        "n", "type", "gemv us", "gemv GB/s", "dot us", "dot GB/s", "rel. error"
+    );
+
+    for (size_t n : {size_t{256}, size_t{1024}, size_t{4096}}){
+        benchSize(n);
+    }
+
+    return 0;
+}
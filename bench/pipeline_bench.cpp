@@ -0,0 +1,148 @@
+/*
+    A rotation, a translation, a projection to the plane and a function of
+    the projected points, applied to n Vector<T, 3> into n Vector<T, 2>:
+
+        aos loop    for (i) { v = rotation * in[i] + offset; out[i] = f(projection * v); }
+        stages      one stage at a time over the whole set, as with Batch.h
+                    alone: VectorBatch of the input, transform() by the
+                    rotation, translation, transform() by the projection,
+                    f, unpack() into out
+        process     Pipeline::process(in, out), the rotation, translation
+                    and projection folded into one affine stage, chunk by
+                    chunk through L2
+        run         Pipeline::run(), the input copied block by block from
+                    in by the producer thread, the results into out
+
+    Times are ns per vector. The stages write and read again every
+    intermediate set, which no longer fit in cache from about 64K vectors;
+    the pipeline keeps every chunk in L2 whatever n, and has one matrix to
+    apply instead of two. run() adds the copies and the start of the
+    producer thread, which dominates a few thousand vectors. One thread of
+    an AVX-512 machine measured:
+
+        type            n   aos loop     stages    process        run
+        float        4096     21.688      8.212      7.268     37.959
+        double       4096     19.653     28.687      7.381     33.003
+        float       65536     21.963     19.959      5.012      6.475
+        double      65536     19.623     39.821      8.531     11.491
+        float     4194304     25.649     33.403      6.442      7.790
+        double    4194304     20.499     59.695      9.323     12.002
+*/
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <span>
+#include <vector>
+#include "Bench.h"
+#include "Batch.h"
+#include "Pipeline.h"
+
+template<typename T>
+static void benchSize(const char* type, size_t n){
+
+    Matrix<T, 3, 3> rotation {};
+    Matrix<T, 2, 3> projection {};
+    Vector<T, 3> offset {};
+
+    for (size_t r{}; r<3; ++r){
+        offset[r] = static_cast<T>(r + 1);
+        for (size_t c{}; c<3; ++c){
+            rotation[r, c] = static_cast<T>((r * 3 + c) % 5) - T{2};
+            if (r < 2) projection[r, c] = static_cast<T>((r + c) % 3) - T{1};
+        }
+    }
+
+    // Clamps the projected points to the unit square
+    const auto clamp {[](std::array<T*, 2> xy, size_t count){
+        for (size_t c{}; c<2; ++c){
+            T* p {xy[c]};
+            for (size_t i{}; i<count; ++i){
+                p[i] = p[i] < T{-1} ? T{-1} : p[i] > T{1} ? T{1} : p[i];
+            }
+        }
+    }};
+
+    std::vector<Vector<T, 3>> in(n);
+    for (size_t i{}; i<n; ++i){
+        for (size_t c{}; c<3; ++c){
+            in[i][c] = static_cast<T>((i * 7 + c * 3) % 11) - T{5};
+        }
+    }
+    std::vector<Vector<T, 2>> out(n);
+
+    const double aosNs {bench::nsPerOp([&]{
+        for (size_t i{}; i<n; ++i){
+            const Vector<T, 3> v {rotation * in[i] + offset};
+            Vector<T, 2> p {projection * v};
+            clamp(std::array<T*, 2>{&p[0], &p[1]}, 1);
+            out[i] = p;
+        }
+        bench::doNotOptimize(out.data());
+    })};
+
+    const double stagesNs {bench::nsPerOp([&]{
+        const VectorBatch<T, 3> batch {std::span<const Vector<T, 3>>{in}};
+        VectorBatch<T, 3> rotated(n);
+        VectorBatch<T, 2> projected(n);
+        transform(rotation, batch, rotated);
+        for (size_t c{}; c<3; ++c){
+            T* p {rotated.data(c)};
+            for (size_t i{}; i<n; ++i){
+                p[i] += offset[c];
+            }
+        }
+        transform(projection, rotated, projected);
+        clamp(projected.arrays(), n);
+        projected.unpack(out);
+        bench::doNotOptimize(out.data());
+    })};
+
+    const auto pipeline {
+        stream::Pipeline<T, 3>{}.then(rotation).translate(offset).then(projection).each(clamp)
+    };
+
+    const double processNs {bench::nsPerOp([&]{
+        pipeline.process(in, out);
+        bench::doNotOptimize(out.data());
+    })};
+
+    const double runNs {bench::nsPerOp([&]{
+        size_t read {};
+        size_t written {};
+        pipeline.run(
+            [&](std::span<Vector<T, 3>> block){
+                const size_t count {std::min(block.size(), n - read)};
+                std::copy_n(in.begin() + static_cast<std::ptrdiff_t>(read), count, block.begin());
+                read += count;
+                return count;
+            },
+            [&](std::span<const Vector<T, 2>> results){
+                std::copy(results.begin(), results.end(), out.begin() + static_cast<std::ptrdiff_t>(written));
+                written += results.size();
+            }
+        );
+        bench::doNotOptimize(out.data());
+    })};
+
+    const double count {static_cast<double>(n)};
+
+    std::printf(
+        "%-7s %9zu %10.3f %10.3f %10.3f %10.3f\n", type, n,
+        aosNs / count, stagesNs / count, processNs / count, runNs / count
+    );
+}
+
+int main(){
+
+    std::printf(
+        "%-7s %9s %10s %10s %10s %10s\n", "type", "n", "aos loop", "stages", "process", "run"
+    );
+
+    for (size_t n : {size_t{4096}, size_t{1} << 16, size_t{1} << 22}){
+        benchSize<float>("float", n);
+        benchSize<double>("double", n);
+    }
+
+    return 0;
+}
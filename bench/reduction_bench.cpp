@@ -0,0 +1,109 @@
+/*
+    Reductions of a DynVector<float> and a DynVector<double> of n elements,
+    by the loops they replace (one accumulator, as written by hand over
+    operator[]) and by Reduction.h:
+
+        sum         reduce::sum(v)
+        argmax      reduce::argmax(v)
+        norm2       reduce::norm2(v), the sum of squares and its square root
+        cosine      reduce::dotAndNorms(u, v), against dot(u, v) and two
+                    norm2() calls (three passes over memory instead of one)
+
+    Rates are GB/s of the elements read. While the vectors fit in cache,
+    the loops are bound by the latency of their one chain of additions,
+    which the four accumulators of the kernels overlap; from memory, both
+    are bound by bandwidth except the cosine, whose fused form reads u and
+    v once instead of twice. One thread of an AVX-512 machine measured:
+
+        type            n  sum loop   sum  amax loop  argmax  nrm loop  norm2  cos 3x  cos fused
+        float        4096       4.6 177.1        4.5    63.2       4.5   73.3    48.9       82.3
+        double      65536       8.6  65.4        8.1    90.5       9.0   99.8    44.9       94.9
+        float     4194304       3.9  20.5        4.2    19.9       4.0   18.2     6.0       14.3
+        double    4194304       6.3  12.9        5.3    15.9       6.1   10.6     5.1       12.6
+*/
+
+#include <cmath>
+#include <cstdio>
+#include "Bench.h"
+#include "Blas.h"
+#include "DynVector.h"
+#include "Reduction.h"
+
+template<typename T>
+static void benchSize(const char* type, size_t n){
+
+    DynVector<T> u(n), v(n);
+
+    for (size_t i{}; i<n; ++i){
+        u[i] = static_cast<T>(std::sin(static_cast<double>(i)));
+        v[i] = static_cast<T>(std::cos(static_cast<double>(i)));
+    }
+
+    const double bytes {static_cast<double>(n * sizeof(T))};
+
+    const double loopSumNs {bench::nsPerOp([&]{
+        T total {};
+        for (size_t i{}; i<n; ++i){
+            total += v[i];
+        }
+        bench::doNotOptimize(total);
+    })};
+
+    const double sumNs {bench::nsPerOp([&]{
+        bench::doNotOptimize(reduce::sum(v));
+    })};
+
+    const double loopArgmaxNs {bench::nsPerOp([&]{
+        size_t index {};
+        for (size_t i{1}; i<n; ++i){
+            if (v[i] > v[index]) index = i;
+        }
+        bench::doNotOptimize(index);
+    })};
+
+    const double argmaxNs {bench::nsPerOp([&]{
+        bench::doNotOptimize(reduce::argmax(v));
+    })};
+
+    const double loopNormNs {bench::nsPerOp([&]{
+        T total {};
+        for (size_t i{}; i<n; ++i){
+            total += v[i] * v[i];
+        }
+        bench::doNotOptimize(std::sqrt(total));
+    })};
+
+    const double normNs {bench::nsPerOp([&]{
+        bench::doNotOptimize(reduce::norm2(v));
+    })};
+
+    const double separateNs {bench::nsPerOp([&]{
+        bench::doNotOptimize(dot(u, v) / (reduce::norm2(u) * reduce::norm2(v)));
+    })};
+
+    const double fusedNs {bench::nsPerOp([&]{
+        const auto r {reduce::dotAndNorms(u, v)};
+        bench::doNotOptimize(r.dot / (r.u * r.v));
+    })};
+
+    std::printf(
+        "%-7s %9zu %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n", type, n,
+        bytes / loopSumNs, bytes / sumNs, bytes / loopArgmaxNs, bytes / argmaxNs,
+        bytes / loopNormNs, bytes / normNs, 2 * bytes / separateNs, 2 * bytes / fusedNs
+    );
+}
+
+int main(){
+
+    std::printf(
+        "%-7s %9s %9s %9s %9s %9s %9s %9s %9s %9s\n", "type", "n", "sum loop", "sum",
+        "amax loop", "argmax", "nrm loop", "norm2", "cos 3x", "cos fused"
+    );
+
+    for (size_t n : {size_t{4096}, size_t{1} << 16, size_t{1} << 22}){
+        benchSize<float>("float", n);
+        benchSize<double>("double", n);
+    }
+
+    return 0;
+}
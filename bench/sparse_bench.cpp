@@ -0,0 +1,112 @@
+/*
+    Matrix-vector products of a 2048 x 2048 matrix of doubles with a given
+    fraction of nonzero elements, stored dense (Matrix::operator*(Vector))
+    against stored sparse (CsrMatrix and CscMatrix, spmv()):
+
+        dense:  y.noalias() = m * x;
+        CSR:    y.noalias() = csr * x;
+        CSC:    y.noalias() = csc * x;
+
+    and likewise for the product with a dense 2048 x 16 matrix (spmm()
+    against gemm()). The last column is the speedup of CSR over dense.
+*/
+
+#include <cstdio>
+#include <memory>
+#include <random>
+#include "Bench.h"
+#include "Sparse.h"
+#include "Matrix.h"
+
+constexpr size_t N {2048};
+constexpr size_t K {16};
+
+static void report(const char* op, double density, double denseNs, double csrNs, double cscNs){
+    std::printf(
+        "%-6s %9.3f%% %12.1f %12.1f %12.1f %9.2fx\n",
+        op, density * 100, denseNs / 1e3, csrNs / 1e3, cscNs / 1e3, denseNs / csrNs
+    );
+}
+
+static void benchDensity(double density){
+
+    std::mt19937 random {42};
+    std::uniform_real_distribution<double> uniform {0.0, 1.0};
+
+    const auto m {std::make_unique<Matrix<double, N, N>>()};
+    std::vector<sparse::Triplet<double>> triplets {};
+
+    for (size_t i{}; i<N; ++i){
+        for (size_t j{}; j<N; ++j){
+            if (uniform(random) < density){
+                const double value {uniform(random) - 0.5};
+                (*m)[i, j] = value;
+                triplets.push_back({i, j, value});
+            }
+        }
+    }
+
+    const CsrMatrix<double> csr(N, N, triplets);
+    const CscMatrix<double> csc {csr};
+
+    const auto x {std::make_unique<Vector<double, N>>()};
+    const auto y {std::make_unique<Vector<double, N>>()};
+
+    for (size_t j{}; j<N; ++j){
+        (*x)[j] = uniform(random);
+    }
+
+    const double denseNs {bench::nsPerOp([&]{
+        y->noalias() = *m * *x;
+        bench::doNotOptimize(y->data());
+    })};
+
+    const double csrNs {bench::nsPerOp([&]{
+        y->noalias() = csr * *x;
+        bench::doNotOptimize(y->data());
+    })};
+
+    const double cscNs {bench::nsPerOp([&]{
+        y->noalias() = csc * *x;
+        bench::doNotOptimize(y->data());
+    })};
+
+    report("spmv", density, denseNs, csrNs, cscNs);
+
+    DynMatrix<double> b(N, K), c(N, K);
+    const DynMatrix<double> dense {*m};
+
+    for (size_t i{}; i<N*K; ++i){
+        b.data()[i] = uniform(random);
+    }
+
+    const double gemmNs {bench::nsPerOp([&]{
+        c.noalias() = dense * b;
+        bench::doNotOptimize(c.data());
+    })};
+
+    const double csrmmNs {bench::nsPerOp([&]{
+        c.noalias() = csr * b;
+        bench::doNotOptimize(c.data());
+    })};
+
+    const double cscmmNs {bench::nsPerOp([&]{
+        c.noalias() = csc * b;
+        bench::doNotOptimize(c.data());
+    })};
+
+    report("spmm", density, gemmNs, csrmmNs, cscmmNs);
+}
+
+int main(){
+
+    std::printf(
+        "%-6s %10s %12s %12s %12s %10s\n", "op", "density", "dense us", "CSR us", "CSC us", "speedup"
+    );
+
+    for (double density : {0.001, 0.01, 0.05, 0.1, 0.25, 0.5}){
+        benchDensity(density);
+    }
+
+    return 0;
+}
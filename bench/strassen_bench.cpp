@@ -0,0 +1,113 @@
+/*
+    Strassen-Winograd against the blocked kernel, for n x n products of
+    DynMatrix<double> and DynMatrix<float>:
+
+        classic:    strassen::Policy::Never, kernel::gemm throughout
+        leaf L:     strassen::Policy::Always with strassen::setCrossover(L),
+                    recursing down to blocks of L or less
+
+    Rates are 2 n^3 / time (the classic multiply-adds, so that a faster
+    Strassen shows as a higher rate), and the error is the largest
+    difference from the classic product, relative to its largest element.
+    Where the best leaf first beats the classic product is the crossover:
+    strassen::threshold() and strassen::crossover() default to what one
+    thread of an AVX-512 machine measured (GFLOP/s):
+
+        type         n    classic   leaf 128   leaf 256   leaf 512
+        double     512       19.5       22.6       18.9          -
+        double    1024       15.1       25.9       24.8       26.3
+        double    2048       17.4       20.7       20.7       22.6
+        double    4096       19.2       24.5       25.6       22.4
+        float      512       52.6       51.7       55.9          -
+        float     1024       46.5       47.1       52.3       49.4
+        float     2048       48.6       51.9       55.4       53.5
+
+    At 512 the gains are within the noise of the machine; from 1024 on,
+    Strassen wins with any of the leaves, by a third for double and a
+    tenth for float (whose blocked kernel is nearer its peak), with
+    relative errors of 1e-13 and 1e-5. Hence a threshold of 1024 and a
+    leaf of 256.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include "Bench.h"
+#include "Blas.h"
+#include "DynMatrix.h"
+
+template<typename T>
+static void benchSize(const char* type, size_t n){
+
+    DynMatrix<T> a(n, n), b(n, n), reference(n, n), c(n, n);
+
+    for (size_t i{}; i<n*n; ++i){
+        a.data()[i] = static_cast<T>(std::sin(static_cast<double>(i)));
+        b.data()[i] = static_cast<T>(std::cos(static_cast<double>(i)));
+    }
+
+    const double flops {2.0 * static_cast<double>(n) * static_cast<double>(n) * static_cast<double>(n)};
+
+    strassen::setPolicy(strassen::Policy::Never);
+
+    const double classicNs {bench::nsPerOp([&]{
+        reference.noalias() = a * b;
+        bench::doNotOptimize(reference.data());
+    })};
+
+    std::printf("%-7s %6zu %10.1f", type, n, flops / classicNs);
+
+    T scale {};
+    for (size_t i{}; i<n*n; ++i){
+        scale = std::max(scale, std::abs(reference.data()[i]));
+    }
+
+    strassen::setPolicy(strassen::Policy::Always);
+
+    for (size_t leaf : {size_t{128}, size_t{256}, size_t{512}}){
+
+        if (leaf >= n){
+            std::printf(" %10s %10s", "-", "-");
+            continue;
+        }
+
+        strassen::setCrossover(leaf);
+
+        const double ns {bench::nsPerOp([&]{
+            c.noalias() = a * b;
+            bench::doNotOptimize(c.data());
+        })};
+
+        T error {};
+        for (size_t i{}; i<n*n; ++i){
+            error = std::max(error, std::abs(c.data()[i] - reference.data()[i]));
+        }
+
+        std::printf(" %10.1f %10.1e", flops / ns, static_cast<double>(error / scale));
+    }
+
+    std::printf("\n");
+}
+
+int main(){
+
+    const size_t defaultCrossover {strassen::crossover()};
+
+    std::printf(
+        "%-7s %6s %10s %10s %10s %10s %10s %10s %10s\n", "type", "n", "classic",
+        "leaf 128", "error", "leaf 256", "error", "leaf 512", "error"
+    );
+
+    for (size_t n : {size_t{512}, size_t{1024}, size_t{2048}, size_t{4096}}){
+        benchSize<double>("double", n);
+    }
+
+    for (size_t n : {size_t{512}, size_t{1024}, size_t{2048}}){
+        benchSize<float>("float", n);
+    }
+
+    strassen::setPolicy(strassen::Policy::Auto);
+    strassen::setCrossover(defaultCrossover);
+
+    return 0;
+}
@@ -0,0 +1,170 @@
+/*
+    Products of structured n x n DynMatrix<double> operands against the
+    general gemm() they replace:
+
+        gram:       c = a * a^T, by gemm() with an unrelated copy of a (the
+                    general product) and by gemm() on a and its transpose
+                    view (noticed, computed by syrk() and a copy)
+        trmm:       b = L * b, L lower triangular, by gemm() into another
+                    matrix and by trmm() in place
+        trsm:       b = L^-1 * b by trsm(), for reference
+        transpose:  a square matrix transposed in place, element by element
+                    (row i swapped with column i) and by transposeInPlace()
+                    (cache-oblivious)
+
+    Rates are GFLOP/s of the multiply-adds actually needed (n^3 for the
+    Gram matrix and the triangular products, 2 n^3 for gemm), so that the
+    structured kernels show the same rate when they skip half the work in
+    half the time. Transposes are in GB/s of the matrix read and written.
+    The Gram matrix a^T * a of a tall m x k matrix is timed likewise (by
+    gemm() with a copy, by gemm() on the transpose view and a, and by
+    syrk() with Op::Trans), its rate counting m k^2. One thread of an
+    AVX-512 machine measured:
+
+             n  gram gemm  gram syrk   L*b gemm   trmm   trsm   T naive  T blocked
+           512        8.9       13.3       18.6   14.5   13.6       2.5        9.5
+          1024        8.4       15.4       17.8   14.6   13.9       1.7        8.4
+          2048        8.2       15.0       17.3   13.9   15.7       1.7        5.5
+
+               m      k   AtA gemm   AtA gram     syrk T
+           20000     64        7.4        7.5        8.1
+          200000     64        7.6        6.5        7.0
+
+    i.e. the Gram matrix and the triangular products in about half the
+    time of gemm(), and a transpose 3 to 5 times faster than the swaps of
+    rows with columns, whose columns all fall in one cache set. For a
+    tall matrix the strided rows of a^T go through the packing of gemm(),
+    and the 64 x 64 Gram matrix, too small for its triangles to save
+    much, costs about the same as the general product.
+*/
+
+#include <cmath>
+#include <cstdio>
+#include <utility>
+#include "Bench.h"
+#include "Blas.h"
+#include "DynMatrix.h"
+
+static void benchSize(size_t n){
+
+    DynMatrix<double> a(n, n), copy(n, n), b(n, n), c(n, n), lower(n, n);
+
+    for (size_t i{}; i<n; ++i){
+        for (size_t j{}; j<n; ++j){
+            a[i, j] = std::sin(static_cast<double>(i * n + j));
+            b[i, j] = std::cos(static_cast<double>(i * n + j));
+            lower[i, j] = j < i ? a[i, j] / static_cast<double>(n) : j == i ? 1.0 : 0.0;
+        }
+    }
+
+    copy = a;
+
+    const double half {static_cast<double>(n) * static_cast<double>(n) * static_cast<double>(n)};
+
+    const double gemmNs {bench::nsPerOp([&]{
+        c.noalias() = a * copy.transpose();
+        bench::doNotOptimize(c.data());
+    })};
+
+    const double gramNs {bench::nsPerOp([&]{
+        c.noalias() = a * a.transpose();
+        bench::doNotOptimize(c.data());
+    })};
+
+    const double productNs {bench::nsPerOp([&]{
+        c.noalias() = lower * b;
+        bench::doNotOptimize(c.data());
+    })};
+
+    const double trmmNs {bench::nsPerOp([&]{
+        trmm(blas::Side::Left, blas::Uplo::Lower, blas::Op::NoTrans, blas::Diag::NonUnit, 1.0, lower, b);
+        bench::doNotOptimize(b.data());
+    })};
+
+    const double trsmNs {bench::nsPerOp([&]{
+        trsm(blas::Side::Left, blas::Uplo::Lower, blas::Op::NoTrans, blas::Diag::NonUnit, 1.0, lower, b);
+        bench::doNotOptimize(b.data());
+    })};
+
+    const double naiveNs {bench::nsPerOp([&]{
+        for (size_t i{}; i<n; ++i){
+            for (size_t j{i + 1}; j<n; ++j){
+                std::swap(a.data()[i*n + j], a.data()[j*n + i]);
+            }
+        }
+        bench::doNotOptimize(a.data());
+    })};
+
+    const double blockedNs {bench::nsPerOp([&]{
+        a.transposeInPlace();
+        bench::doNotOptimize(a.data());
+    })};
+
+    const double bytes {2.0 * static_cast<double>(n * n * sizeof(double))};
+
+    std::printf(
+        "%6zu %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n", n,
+        half / gemmNs, half / gramNs, 2 * half / productNs, half / trmmNs,
+        half / trsmNs, bytes / naiveNs, bytes / blockedNs
+    );
+}
+
+// The k x k Gram matrix a^T * a of a tall m x k matrix, whose transpose
+// view has strided rows: by gemm() with an unrelated copy of a, by gemm()
+// on the view and a (noticed, computed by syrk()) and by syrk() directly
+static void benchTall(size_t m, size_t k){
+
+    DynMatrix<double> a(m, k), copy(m, k), c(k, k);
+
+    for (size_t i{}; i<m; ++i){
+        for (size_t j{}; j<k; ++j){
+            a[i, j] = std::sin(static_cast<double>(i * k + j));
+        }
+    }
+
+    copy = a;
+
+    const double half {static_cast<double>(m) * static_cast<double>(k) * static_cast<double>(k)};
+
+    const double gemmNs {bench::nsPerOp([&]{
+        c.noalias() = a.transpose() * copy;
+        bench::doNotOptimize(c.data());
+    })};
+
+    const double gramNs {bench::nsPerOp([&]{
+        c.noalias() = a.transpose() * a;
+        bench::doNotOptimize(c.data());
+    })};
+
+    const double syrkNs {bench::nsPerOp([&]{
+        syrk(blas::Uplo::Lower, blas::Op::Trans, 1.0, a, 0.0, c);
+        bench::doNotOptimize(c.data());
+    })};
+
+    std::printf(
+        "%8zu %6zu %10.1f %10.1f %10.1f\n", m, k,
+        half / gemmNs, half / gramNs, half / syrkNs
+    );
+}
+
+int main(){
+
+    std::printf(
+        "%6s %10s %10s %10s %10s %10s %10s %10s\n", "n", "gram gemm", "gram syrk",
+        "L*b gemm", "trmm", "trsm", "T naive", "T blocked"
+    );
+
+    for (size_t n : {size_t{128}, size_t{512}, size_t{1024}, size_t{2048}}){
+        benchSize(n);
+    }
+
+    std::printf(
+        "\n%8s %6s %10s %10s %10s\n", "m", "k", "AtA gemm", "AtA gram", "syrk T"
+    );
+
+    for (size_t m : {size_t{20000}, size_t{200000}}){
+        benchTall(m, 64);
+    }
+
+    return 0;
+}
@@ -0,0 +1,206 @@
+/*
+    Benchmark suite of the core operations, over float, double and int and
+    a range of sizes, written as JSON for tracking between releases:
+
+        dot         x.dot(y)                    Vector<T, N>
+        cross       x[i].cross(y[i])            Vector<T, 3>, 1024 pairs
+        axpby       z = x * a + y               Vector<T, N>
+        gemm        c.noalias() = a * b         Matrix<T, N, N>
+        gemv        y.noalias() = a * x         Matrix<T, N, N>, Vector<T, N>
+        tensor      y.noalias() = t * x         Tensor<T, N, N>, Vector<T, N>
+        spmv        y.noalias() = a * x         CsrMatrix<T> of N x N, 1% nonzero
+
+    Usage: suite [--filter=gemm<double>] [--min-time=0.5] [--out=results.json]
+*/
+
+#include <memory>
+#include <vector>
+#include "Bench.h"
+#include "Matrix.h"
+#include "Tensor.h"
+#include "Sparse.h"
+
+// Deterministic values small enough for int products not to overflow
+template<typename T>
+static T value(size_t i, size_t seed){
+    return static_cast<T>((i * 7 + seed) % 11) - T{5};
+}
+
+template<typename T, size_t N>
+static std::unique_ptr<Vector<T, N>> vector(size_t seed){
+    auto v {std::make_unique<Vector<T, N>>()};
+    for (size_t i{}; i<N; ++i){
+        (*v)[i] = value<T>(i, seed);
+    }
+    return v;
+}
+
+template<typename T, size_t N>
+static std::unique_ptr<Matrix<T, N, N>> matrix(size_t seed){
+    auto m {std::make_unique<Matrix<T, N, N>>()};
+    for (size_t i{}; i<N; ++i){
+        for (size_t j{}; j<N; ++j){
+            (*m)[i, j] = value<T>(i * N + j, seed);
+        }
+    }
+    return m;
+}
+
+
+template<typename T, size_t N>
+static bench::Case dot(){
+
+    std::shared_ptr x {vector<T, N>(0)}, y {vector<T, N>(1)};
+
+    return {
+        [x, y]{ bench::doNotOptimize(x->dot(*y)); },
+        2.0 * N, 2.0 * N * sizeof(T)
+    };
+}
+
+template<typename T, size_t N>
+static bench::Case cross(){
+
+    constexpr size_t count {1024};
+
+    std::shared_ptr<std::vector<Vector<T, 3>>> x {new std::vector<Vector<T, 3>>(count)};
+    std::shared_ptr<std::vector<Vector<T, 3>>> y {new std::vector<Vector<T, 3>>(count)};
+    std::shared_ptr<std::vector<Vector<T, 3>>> z {new std::vector<Vector<T, 3>>(count)};
+
+    for (size_t i{}; i<count; ++i){
+        for (size_t c{}; c<3; ++c){
+            (*x)[i][c] = value<T>(i * 3 + c, 0);
+            (*y)[i][c] = value<T>(i * 3 + c, 1);
+        }
+    }
+
+    return {
+        [x, y, z]{
+            for (size_t i{}; i<count; ++i){
+                (*z)[i] = (*x)[i].cross((*y)[i]);
+            }
+            bench::doNotOptimize(z->data());
+        },
+        9.0 * count, 9.0 * count * sizeof(T), count
+    };
+}
+
+template<typename T, size_t N>
+static bench::Case axpby(){
+
+    std::shared_ptr x {vector<T, N>(0)}, y {vector<T, N>(1)}, z {vector<T, N>(2)};
+    const T a {3};
+
+    return {
+        [x, y, z, a]{
+            *z = *x * a + *y;
+            bench::doNotOptimize(z->data());
+        },
+        2.0 * N, 3.0 * N * sizeof(T)
+    };
+}
+
+template<typename T, size_t N>
+static bench::Case gemm(){
+
+    std::shared_ptr a {matrix<T, N>(0)}, b {matrix<T, N>(1)}, c {matrix<T, N>(2)};
+
+    return {
+        [a, b, c]{
+            c->noalias() = *a * *b;
+            bench::doNotOptimize(c->data());
+        },
+        2.0 * N * N * N, 3.0 * N * N * sizeof(T)
+    };
+}
+
+template<typename T, size_t N>
+static bench::Case gemv(){
+
+    std::shared_ptr a {matrix<T, N>(0)};
+    std::shared_ptr x {vector<T, N>(1)}, y {vector<T, N>(2)};
+
+    return {
+        [a, x, y]{
+            y->noalias() = *a * *x;
+            bench::doNotOptimize(y->data());
+        },
+        2.0 * N * N, (N * N + 2.0 * N) * sizeof(T)
+    };
+}
+
+template<typename T, size_t N>
+static bench::Case tensor(){
+
+    auto t {std::make_shared<Tensor<T, N, N>>()};
+    for (size_t i{}; i<N*N; ++i){
+        t->data()[i] = value<T>(i, 0);
+    }
+
+    std::shared_ptr x {vector<T, N>(1)}, y {vector<T, N>(2)};
+
+    return {
+        [t, x, y]{
+            y->noalias() = *t * *x;
+            bench::doNotOptimize(y->data());
+        },
+        2.0 * N * N, (N * N + 2.0 * N) * sizeof(T)
+    };
+}
+
+template<typename T, size_t N>
+static bench::Case spmv(){
+
+    // About 1% of the elements nonzero, at least one per row
+    std::vector<sparse::Triplet<T>> triplets {};
+    const size_t perRow {std::max(N / 100, size_t{1})};
+
+    for (size_t i{}; i<N; ++i){
+        for (size_t k{}; k<perRow; ++k){
+            triplets.push_back({i, (i * 37 + k * 101) % N, value<T>(i + k, 0)});
+        }
+    }
+
+    const auto a {std::make_shared<CsrMatrix<T>>(N, N, triplets)};
+    const size_t stored {a->nonZeros()};
+
+    std::shared_ptr x {vector<T, N>(1)}, y {vector<T, N>(2)};
+
+    return {
+        [a, x, y]{
+            y->noalias() = *a * *x;
+            bench::doNotOptimize(y->data());
+        },
+        2.0 * static_cast<double>(stored),
+        static_cast<double>(stored * (sizeof(T) + sizeof(sparse::Index)) + N * (2 * sizeof(T) + sizeof(size_t)))
+    };
+}
+
+
+static const bool registered {
+    bench::add<float, double, int>("dot", bench::sizes<4, 64, 1024, 16384>, []<typename T, size_t N>(){
+        return dot<T, N>();
+    })
+    and bench::add<float, double, int>("cross", bench::sizes<3>, []<typename T, size_t N>(){
+        return cross<T, N>();
+    })
+    and bench::add<float, double, int>("axpby", bench::sizes<4, 64, 1024, 16384>, []<typename T, size_t N>(){
+        return axpby<T, N>();
+    })
+    and bench::add<float, double, int>("gemm", bench::sizes<4, 16, 64, 256>, []<typename T, size_t N>(){
+        return gemm<T, N>();
+    })
+    and bench::add<float, double, int>("gemv", bench::sizes<4, 16, 64, 256>, []<typename T, size_t N>(){
+        return gemv<T, N>();
+    })
+    and bench::add<float, double, int>("tensor", bench::sizes<4, 16, 64, 256>, []<typename T, size_t N>(){
+        return tensor<T, N>();
+    })
+    and bench::add<float, double, int>("spmv", bench::sizes<1024, 16384>, []<typename T, size_t N>(){
+        return spmv<T, N>();
+    })
+};
+
+int main(int argc, char** argv){
+    return bench::main(argc, argv);
+}
@@ -0,0 +1,92 @@
+/*
+    Tensor evaluation paths, on a 32 x 64 x 64 tensor of floats:
+
+        flat:       c = a + b * 2;                  (one loop over the elements)
+        broadcast:  c = a + row * 2;                (row repeated along the
+                                                     leading axes)
+        permuted:   c = a + b.permute<0, 2, 1>() * 2;
+
+    and a contraction over the last axis of a against a 64 x 64 matrix,
+    contract<2, 0>(a, m), against the naive loops.
+*/
+
+#include <cstdio>
+#include "Bench.h"
+#include "Tensor.h"
+
+constexpr size_t P = 32, Q = 64, K = 64;
+
+static Tensor<float, P, Q, K> a, b, c;
+static Tensor<float, K> row;
+static Tensor<float, K, K> m;
+
+static void report(const char* name, double ns, double bytes){
+    std::printf("%-12s %12.1f %10.2f\n", name, ns, bytes / ns);
+}
+
+int main(){
+
+    for (size_t i{}; i<P*Q*K; ++i){
+        a.data()[i] = static_cast<float>(i % 17);
+        b.data()[i] = static_cast<float>(i % 13);
+    }
+
+    for (size_t i{}; i<K*K; ++i){
+        m.data()[i] = static_cast<float>(i % 7) - 3.0f;
+    }
+
+    for (size_t i{}; i<K; ++i){
+        row.data()[i] = static_cast<float>(i);
+    }
+
+    std::printf("%-12s %12s %10s\n", "op", "ns/op", "GB/s");
+
+    const double bytes {3.0 * sizeof(float) * P * Q * K};
+
+    report("flat", bench::nsPerOp([]{
+        c = a + b * 2.0f;
+        bench::doNotOptimize(c.data());
+    }), bytes);
+
+    report("broadcast", bench::nsPerOp([]{
+        c = a + row * 2.0f;
+        bench::doNotOptimize(c.data());
+    }), bytes);
+
+    report("permuted", bench::nsPerOp([]{
+        c = a + b.permute<0, 2, 1>() * 2.0f;
+        bench::doNotOptimize(c.data());
+    }), bytes);
+
+    static Tensor<float, P, Q, K> naive;
+
+    const double naiveNs {bench::nsPerOp([]{
+        for (size_t p{}; p<P; ++p){
+            for (size_t q{}; q<Q; ++q){
+                for (size_t j{}; j<K; ++j){
+                    float sum {};
+                    for (size_t k{}; k<K; ++k){
+                        sum += a[p, q, k] * m[k, j];
+                    }
+                    naive[p, q, j] = sum;
+                }
+            }
+        }
+        bench::doNotOptimize(naive.data());
+    })};
+
+    const double contractNs {bench::nsPerOp([]{
+        c = contract<2, 0>(a, m);
+        bench::doNotOptimize(c.data());
+    })};
+
+    const double flops {2.0 * P * Q * K * K};
+
+    std::printf(
+        "\n%-12s %12s %12s %10s\n%-12s %12.2f %12.2f %9.2fx\n",
+        "contract", "naive GF/s", "gemm GF/s", "speedup",
+        "", flops / naiveNs, flops / contractNs, naiveNs / contractNs
+    );
+
+    return 0;
+}
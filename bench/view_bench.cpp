@@ -0,0 +1,79 @@
+/*
+    Cost of copying against viewing, on dynamic matrices:
+
+        copy:   C = DynMatrix{A.view().transpose()} * B;    (transpose copied
+                                                             into a new matrix)
+        view:   C.noalias() = A.view().transpose() * B;     (gemm packs A
+                                                             through its strides)
+
+    and likewise for the product of the top-left quarter blocks of A and B.
+*/
+
+#include <cmath>
+#include <cstdio>
+#include "Bench.h"
+#include "DynMatrix.h"
+
+static void report(const char* name, size_t n, double flops, double copyNs, double viewNs){
+    std::printf(
+        "%-10s %6zu %12.2f %12.2f %9.2fx\n",
+        name, n, flops / copyNs, flops / viewNs, copyNs / viewNs
+    );
+}
+
+static void benchViews(size_t n){
+
+    DynMatrix<double> a(n, n), b(n, n), c(n, n);
+
+    for (size_t i{}; i<n; ++i){
+        for (size_t j{}; j<n; ++j){
+            a[i, j] = std::sin(static_cast<double>(i * n + j));
+            b[i, j] = std::cos(static_cast<double>(i + j * n));
+        }
+    }
+
+    const double flops {2.0 * static_cast<double>(n * n * n)};
+
+    const double transposeCopyNs {bench::nsPerOp([&]{
+        const DynMatrix<double> transposed {a.view().transpose()};
+        c.noalias() = transposed * b;
+        bench::doNotOptimize(c.data());
+    })};
+
+    const double transposeViewNs {bench::nsPerOp([&]{
+        c.noalias() = a.view().transpose() * b;
+        bench::doNotOptimize(c.data());
+    })};
+
+    report("transpose", n, flops, transposeCopyNs, transposeViewNs);
+
+    const size_t h {n / 2};
+    DynMatrix<double> quarter(h, h);
+
+    const double blockCopyNs {bench::nsPerOp([&]{
+        const DynMatrix<double> lhs {a.block(0, 0, h, h)};
+        const DynMatrix<double> rhs {b.block(0, 0, h, h)};
+        quarter.noalias() = lhs * rhs;
+        bench::doNotOptimize(quarter.data());
+    })};
+
+    const double blockViewNs {bench::nsPerOp([&]{
+        quarter.noalias() = a.block(0, 0, h, h) * b.block(0, 0, h, h);
+        bench::doNotOptimize(quarter.data());
+    })};
+
+    report("block", h, flops / 8, blockCopyNs, blockViewNs);
+}
+
+int main(){
+
+    std::printf(
+        "%-10s %6s %12s %12s %10s\n", "op", "N", "copy GF/s", "view GF/s", "speedup"
+    );
+
+    for (size_t n : {64uz, 256uz, 512uz}){
+        benchViews(n);
+    }
+
+    return 0;
+}
@@ -0,0 +1,152 @@
+#ifndef _ALIGNED_BUFFER_H_
+#define _ALIGNED_BUFFER_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+#include "Memory.h"
+
+/*
+    Owning, 64-byte aligned heap array of trivially copyable elements, the
+    storage of the runtime-sized DynVector and DynMatrix.
+
+    64 bytes is a cache line and the width of an AVX-512 register, so rows
+    never straddle more cache lines than needed and SIMD loads start aligned.
+    Copies allocate and copy, moves steal the pointer and leave the source
+    empty.
+
+    The memory comes from a std::pmr::memory_resource, by default the
+    current one of the thread that creates the buffer (see Memory.h), and a
+    buffer keeps its resource for life: a copy allocates from the current
+    resource, a move constructor takes the source's, and assigning from a
+    buffer of another resource copies the elements rather than the pointer.
+*/
+
+template<typename T>
+class AlignedBuffer{
+
+    static_assert(
+        std::is_trivially_copyable<T>::value,
+        "AlignedBuffer can only store trivially copyable values"
+    );
+
+    private:
+
+        T* pointer;
+        size_t count;
+        std::pmr::memory_resource* source;
+
+        T* allocate(size_t count){
+            if (count == 0){
+                return nullptr;
+            }
+            return static_cast<T*>(source->allocate(count * sizeof(T), alignment));
+        }
+
+        void deallocate(){
+            if (pointer != nullptr){
+                source->deallocate(pointer, count * sizeof(T), alignment);
+            }
+        }
+
+    public:
+
+    static constexpr size_t alignment = 64;
+
+    /******** Constructors - Assignment Operators - Destructor ***************/
+
+    // Default Constructor (empty buffer)
+    AlignedBuffer() noexcept : AlignedBuffer{memory::resource()} {}
+
+    // Resource Constructor (empty buffer, allocating from resource)
+    explicit AlignedBuffer(std::pmr::memory_resource* resource) noexcept
+    : pointer{nullptr}, count{0}, source{resource} {}
+
+    // Size Constructor (value-initialized elements)
+    explicit AlignedBuffer(size_t count, std::pmr::memory_resource* resource = memory::resource())
+    : pointer{nullptr}, count{count}, source{resource} {
+        pointer = allocate(count);
+        std::fill(pointer, pointer + count, T{});
+    }
+
+    // Copy Constructor (allocates from the current resource)
+    AlignedBuffer(const AlignedBuffer& other)
+    : pointer{nullptr}, count{other.count}, source{memory::resource()} {
+        pointer = allocate(count);
+        std::copy(other.pointer, other.pointer + count, pointer);
+    }
+
+    // Move Constructor (takes the resource along)
+    AlignedBuffer(AlignedBuffer&& other) noexcept
+    : pointer{std::exchange(other.pointer, nullptr)},
+      count{std::exchange(other.count, 0)},
+      source{other.source} {}
+
+    // Copy Assignment Operator (reuses the allocation when sizes match)
+    AlignedBuffer& operator=(const AlignedBuffer& rhs){
+
+        if (this == &rhs){
+            return *this;
+        }
+
+        if (count != rhs.count){
+            AlignedBuffer temp {rhs.count, source};
+            swap(temp);
+        }
+
+        std::copy(rhs.pointer, rhs.pointer + count, pointer);
+        return *this;
+    }
+
+    // Move Assignment Operator (copies when the resources differ, in which
+    // case running out of memory terminates)
+    AlignedBuffer& operator=(AlignedBuffer&& rhs) noexcept {
+        if (*source == *rhs.source){
+            AlignedBuffer temp {std::move(rhs)};
+            swap(temp);
+            return *this;
+        }
+        *this = static_cast<const AlignedBuffer&>(rhs);
+        const AlignedBuffer emptied {std::move(rhs)};
+        return *this;
+    }
+
+    // Destructor
+    ~AlignedBuffer(){
+        deallocate();
+    }
+
+
+    /****************** Methods - Overloaded Operators ********************/
+
+    void swap(AlignedBuffer& other) noexcept {
+        std::swap(pointer, other.pointer);
+        std::swap(count, other.count);
+        std::swap(source, other.source);
+    }
+
+    // Resizes to count value-initialized elements, discarding the contents
+    // (no reallocation when the size does not change)
+    void reset(size_t count){
+        if (count != this->count){
+            AlignedBuffer temp {count, source};
+            swap(temp);
+        } else {
+            std::fill(pointer, pointer + count, T{});
+        }
+    }
+
+    size_t size() const noexcept { return count; }
+
+    std::pmr::memory_resource* resource() const noexcept { return source; }
+
+    T* data() noexcept { return pointer; }
+
+    const T* data() const noexcept { return pointer; }
+
+};
+
+#endif
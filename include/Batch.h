@@ -0,0 +1,514 @@
+#ifndef _BATCH_H_
+#define _BATCH_H_
+
+#include <array>
+#include <iostream>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include "Trace.h"
+#include "Bounds.h"
+#include "Simd.h"
+#include "Compare.h"
+#include "AlignedBuffer.h"
+#include "ThreadPool.h"
+#include "Vector.h"
+#include "Matrix.h"
+#include "DynVector.h"
+#include "View.h"
+
+/*
+    Batches of small vectors and matrices stored as structure of arrays, for
+    applying the same operation to millions of them (rotating a point
+    cloud, transforming vertices):
+
+        VectorBatch<T, N>       N arrays of size() elements, component c of
+                                vector i being component(c)[i]
+        MatrixBatch<T, R, C>    R*C arrays, element (r, c) of matrix i being
+                                element(r, c)[i]
+
+    Stored one object after the other (an array of Vector<T, 3>), applying
+    a matrix to each vector is a chain of dependent shuffles and
+    multiply-adds. Stored this way, a SIMD register holds the same component
+    of consecutive vectors, and every lane computes its own vector:
+
+        VectorBatch<double, 3> points {vectors};      // from a span of Vectors
+        VectorBatch<double, 3> moved = rotation * points;
+        transform(rotation, points, points);          // in place
+        transform(rotations, points, moved);          // matrix i to vector i
+        DynVector<double> d {points.dot(moved)};
+        VectorBatch<double, 3> n {points.cross(moved)};
+        points.unpack(vectors);                       // back to Vectors
+
+    Every array starts on a 64-byte boundary. float, double and int32 use
+    the SIMD kernels of Simd.h, and large batches are split across the
+    thread pool. Several transforms in a row over vectors stored one after
+    the other are better streamed through Pipeline.h, a chunk at a time.
+*/
+
+namespace batch{
+
+    namespace detail{
+
+        // Elements per 64 bytes: the arrays of a batch are padded to a
+        // multiple of it, and the blocks run by the thread pool too, so
+        // that every block starts aligned
+        template<typename T>
+        inline constexpr size_t lane = AlignedBuffer<T>::alignment / sizeof(T);
+
+        // Calls kernel(begin, end) over blocks of [0, n)
+        template<typename T, typename Kernel>
+        void forBlocks(size_t n, size_t workPerItem, const Kernel& kernel){
+            parallel::forBlocks(n, workPerItem, lane<T>, kernel);
+        }
+
+        // Pointers to the arrays, moved to element begin
+        template<typename P, size_t K>
+        std::array<P, K> offset(const std::array<P, K>& arrays, size_t begin){
+            std::array<P, K> result {};
+            for (size_t k{}; k<K; ++k){
+                result[k] = arrays[k] + begin;
+            }
+            return result;
+        }
+
+    }
+
+}
+
+template<typename T, size_t N> class VectorBatch;
+
+template<typename T, size_t N>
+void dot(const VectorBatch<T, N>& a, const VectorBatch<T, N>& b, DynVector<T>& out);
+
+template<typename T>
+void cross(const VectorBatch<T, 3>& a, const VectorBatch<T, 3>& b, VectorBatch<T, 3>& out);
+
+
+template<typename T, size_t N>
+class VectorBatch : private trace::Traced<trace::Type::VectorBatch>{
+
+    static_assert(
+        std::is_arithmetic<T>::value,
+        "VectorBatch class can only store integral or floating point values"
+    );
+
+    static_assert(
+        N >= 1, "Dimension N of the vectors of a VectorBatch should be higher or equal to 1"
+    );
+
+    // Prints one vector per line
+    friend std::ostream& operator<<(std::ostream& os, const VectorBatch& batch){
+        for (size_t i{}; i<batch.size(); ++i){
+            os << batch.get(i);
+            if (i + 1 != batch.size()) {os << std::endl;}
+        }
+        return os;
+    }
+
+    private:
+
+        AlignedBuffer<T> storage; // the N arrays, stride elements apart
+        size_t count;
+        size_t stride;
+
+        static size_t padded(size_t n){
+            constexpr size_t lane {batch::detail::lane<T>};
+            return (n + lane - 1) / lane * lane;
+        }
+
+        void checkSize(size_t n) const {
+            if (n != count) throw std::invalid_argument("Batch sizes do not match");
+        }
+
+    public:
+
+    /******** Constructors - Assignment Operators - Destructor ***************/
+
+    // Default Constructor (empty batch)
+    VectorBatch() : VectorBatch(0) {}
+
+    // Size Constructor: count zero vectors
+    explicit VectorBatch(size_t count)
+    : storage(N * padded(count)), count{count}, stride{padded(count)} {}
+
+    // Vectors Constructor, from vectors stored one after the other
+    explicit VectorBatch(std::span<const Vector<T, N>> vectors)
+    : VectorBatch(vectors.size()) {
+        for (size_t i{}; i<count; ++i){
+            set(i, vectors[i]);
+        }
+    }
+
+    // Copy and Move Constructors, Copy and Move Assignment Operators
+    // (moves steal the arrays)
+    VectorBatch(const VectorBatch& source) = default;
+    VectorBatch(VectorBatch&& source) noexcept = default;
+    VectorBatch& operator=(const VectorBatch& rhs) = default;
+    VectorBatch& operator=(VectorBatch&& rhs) noexcept = default;
+
+    // Default destructor
+    ~VectorBatch() = default;
+
+
+    /****************** Methods - Overloaded Operators ********************/
+
+    // Number of vectors
+    size_t size() const noexcept {
+        return count;
+    }
+
+    // Resizes to count zero vectors, discarding the current ones
+    void resize(size_t n){
+        storage.reset(N * padded(n));
+        count = n;
+        stride = padded(n);
+    }
+
+    // Array of component c of every vector
+    T* data(size_t c) noexcept {
+        return storage.data() + c*stride;
+    }
+
+    const T* data(size_t c) const noexcept {
+        return storage.data() + c*stride;
+    }
+
+    // The N arrays
+    std::array<T*, N> arrays() noexcept {
+        std::array<T*, N> result {};
+        for (size_t c{}; c<N; ++c){ result[c] = data(c); }
+        return result;
+    }
+
+    std::array<const T*, N> arrays() const noexcept {
+        std::array<const T*, N> result {};
+        for (size_t c{}; c<N; ++c){ result[c] = data(c); }
+        return result;
+    }
+
+    // View of component c of every vector, for the expression templates
+    VectorView<T> component(size_t c){
+        bounds::check(c, N);
+        return VectorView<T>{data(c), count};
+    }
+
+    VectorView<const T> component(size_t c) const {
+        bounds::check(c, N);
+        return VectorView<const T>{data(c), count};
+    }
+
+    // Vector i, gathered from the arrays (index checked like operator[])
+    Vector<T, N> get(size_t i) const {
+
+        bounds::debugCheck(i, count);
+
+        Vector<T, N> vector {};
+
+        for (size_t c{}; c<N; ++c){
+            vector[c] = data(c)[i];
+        }
+
+        return vector;
+    }
+
+    // Scatters vector into the arrays as vector i
+    void set(size_t i, const Vector<T, N>& vector){
+
+        bounds::debugCheck(i, count);
+
+        for (size_t c{}; c<N; ++c){
+            data(c)[i] = vector[c];
+        }
+    }
+
+    // Writes the vectors one after the other into vectors, which must hold
+    // size() of them
+    void unpack(std::span<Vector<T, N>> vectors) const {
+
+        checkSize(vectors.size());
+
+        for (size_t i{}; i<count; ++i){
+            vectors[i] = get(i);
+        }
+    }
+
+    // Dot product of every vector with the vector of the same index of rhs
+    DynVector<T> dot(const VectorBatch& rhs) const {
+        DynVector<T> result(count);
+        ::dot(*this, rhs, result);
+        return result;
+    }
+
+    // Cross product of every vector with the vector of the same index of rhs
+    VectorBatch cross(const VectorBatch& rhs) const requires (N == 3) {
+        VectorBatch result(count);
+        ::cross(*this, rhs, result);
+        return result;
+    }
+
+    // Equal-to Operator (==)
+    bool operator==(const VectorBatch& rhs) const {
+
+        if (rhs.count != count){
+            return false;
+        }
+
+        for (size_t c{}; c<N; ++c){
+
+            if ( not compare::equal(data(c), rhs.data(c), count) ){
+                return false;
+            }
+
+        }
+
+        return true;
+    }
+
+};
+
+
+template<typename T, size_t R, size_t C>
+class MatrixBatch : private trace::Traced<trace::Type::MatrixBatch>{
+
+    static_assert(
+        std::is_arithmetic<T>::value,
+        "MatrixBatch class can only store integral or floating point values"
+    );
+
+    private:
+
+        VectorBatch<T, R * C> elements; // element (r, c) as component r*C + c
+
+    public:
+
+    /******** Constructors - Assignment Operators - Destructor ***************/
+
+    // Default Constructor (empty batch)
+    MatrixBatch() : elements{} {}
+
+    // Size Constructor: count zero matrices
+    explicit MatrixBatch(size_t count) : elements(count) {}
+
+    // Matrices Constructor, from matrices stored one after the other
+    explicit MatrixBatch(std::span<const Matrix<T, R, C>> matrices)
+    : elements(matrices.size()) {
+        for (size_t i{}; i<matrices.size(); ++i){
+            set(i, matrices[i]);
+        }
+    }
+
+    MatrixBatch(const MatrixBatch& source) = default;
+    MatrixBatch(MatrixBatch&& source) noexcept = default;
+    MatrixBatch& operator=(const MatrixBatch& rhs) = default;
+    MatrixBatch& operator=(MatrixBatch&& rhs) noexcept = default;
+
+    ~MatrixBatch() = default;
+
+
+    /****************** Methods - Overloaded Operators ********************/
+
+    // Number of matrices
+    size_t size() const noexcept {
+        return elements.size();
+    }
+
+    void resize(size_t n){
+        elements.resize(n);
+    }
+
+    // Array of element (r, c) of every matrix
+    T* data(size_t r, size_t c) noexcept {
+        return elements.data(r*C + c);
+    }
+
+    const T* data(size_t r, size_t c) const noexcept {
+        return elements.data(r*C + c);
+    }
+
+    // The R*C arrays, row by row
+    std::array<T*, R * C> arrays() noexcept {
+        return elements.arrays();
+    }
+
+    std::array<const T*, R * C> arrays() const noexcept {
+        return elements.arrays();
+    }
+
+    // View of element (r, c) of every matrix
+    VectorView<T> element(size_t r, size_t c){
+        bounds::check(r, R);
+        bounds::check(c, C);
+        return elements.component(r*C + c);
+    }
+
+    VectorView<const T> element(size_t r, size_t c) const {
+        bounds::check(r, R);
+        bounds::check(c, C);
+        return elements.component(r*C + c);
+    }
+
+    // Matrix i, gathered from the arrays
+    Matrix<T, R, C> get(size_t i) const {
+
+        bounds::debugCheck(i, size());
+
+        Matrix<T, R, C> matrix {};
+
+        for (size_t r{}; r<R; ++r){
+            for (size_t c{}; c<C; ++c){
+                matrix[r, c] = data(r, c)[i];
+            }
+        }
+
+        return matrix;
+    }
+
+    // Scatters matrix into the arrays as matrix i
+    void set(size_t i, const Matrix<T, R, C>& matrix){
+
+        bounds::debugCheck(i, size());
+
+        for (size_t r{}; r<R; ++r){
+            for (size_t c{}; c<C; ++c){
+                data(r, c)[i] = matrix[r, c];
+            }
+        }
+    }
+
+};
+
+
+/******************** Batched Operations *********************************/
+
+// out[i] = m * in[i] for every vector of in (out is resized to in, and may
+// be in itself when R == C)
+template<typename T, size_t R, size_t C>
+void transform(const Matrix<T, R, C>& m, const VectorBatch<T, C>& in, VectorBatch<T, R>& out){
+
+    if (out.size() != in.size()){
+        out.resize(in.size());
+    }
+
+    const auto x {in.arrays()};
+    const auto y {out.arrays()};
+
+    batch::detail::forBlocks<T>(in.size(), R * C, [&](size_t begin, size_t end){
+
+        const auto xs {batch::detail::offset(x, begin)};
+        const auto ys {batch::detail::offset(y, begin)};
+
+        if constexpr (simd::Accelerated<T>){
+            simd::transform<T, R, C>(m.data(), xs.data(), ys.data(), end - begin);
+        } else {
+            simd::scalar::transform<T, R, C>(m.data(), xs.data(), ys.data(), end - begin);
+        }
+    });
+}
+
+// out[i] = m[i] * in[i] for every vector of in (m must hold as many
+// matrices; out is resized to in, and may be in itself when R == C)
+template<typename T, size_t R, size_t C>
+void transform(const MatrixBatch<T, R, C>& m, const VectorBatch<T, C>& in, VectorBatch<T, R>& out){
+
+    if (m.size() != in.size()){
+        throw std::invalid_argument("Batch sizes do not match");
+    }
+
+    if (out.size() != in.size()){
+        out.resize(in.size());
+    }
+
+    const auto a {m.arrays()};
+    const auto x {in.arrays()};
+    const auto y {out.arrays()};
+
+    batch::detail::forBlocks<T>(in.size(), 2 * R * C, [&](size_t begin, size_t end){
+
+        const auto as {batch::detail::offset(a, begin)};
+        const auto xs {batch::detail::offset(x, begin)};
+        const auto ys {batch::detail::offset(y, begin)};
+
+        if constexpr (simd::Accelerated<T>){
+            simd::transformEach<T, R, C>(as.data(), xs.data(), ys.data(), end - begin);
+        } else {
+            simd::scalar::transformEach<T, R, C>(as.data(), xs.data(), ys.data(), end - begin);
+        }
+    });
+}
+
+// out[i] = a[i] . b[i] (out is resized to the batches)
+template<typename T, size_t N>
+void dot(const VectorBatch<T, N>& a, const VectorBatch<T, N>& b, DynVector<T>& out){
+
+    if (a.size() != b.size()){
+        throw std::invalid_argument("Batch sizes do not match");
+    }
+
+    if (out.size() != a.size()){
+        out.resize(a.size());
+    }
+
+    const auto x {a.arrays()};
+    const auto y {b.arrays()};
+    T* result {out.data()};
+
+    batch::detail::forBlocks<T>(a.size(), N, [&](size_t begin, size_t end){
+
+        const auto xs {batch::detail::offset(x, begin)};
+        const auto ys {batch::detail::offset(y, begin)};
+
+        if constexpr (simd::Accelerated<T>){
+            simd::dotEach<T, N>(xs.data(), ys.data(), result + begin, end - begin);
+        } else {
+            simd::scalar::dotEach<T, N>(xs.data(), ys.data(), result + begin, end - begin);
+        }
+    });
+}
+
+// out[i] = a[i] x b[i] (out is resized to the batches, and may be a or b)
+template<typename T>
+void cross(const VectorBatch<T, 3>& a, const VectorBatch<T, 3>& b, VectorBatch<T, 3>& out){
+
+    if (a.size() != b.size()){
+        throw std::invalid_argument("Batch sizes do not match");
+    }
+
+    if (out.size() != a.size()){
+        out.resize(a.size());
+    }
+
+    const auto x {a.arrays()};
+    const auto y {b.arrays()};
+    const auto z {out.arrays()};
+
+    batch::detail::forBlocks<T>(a.size(), 6, [&](size_t begin, size_t end){
+
+        const auto xs {batch::detail::offset(x, begin)};
+        const auto ys {batch::detail::offset(y, begin)};
+        const auto zs {batch::detail::offset(z, begin)};
+
+        if constexpr (simd::Accelerated<T>){
+            simd::crossEach<T>(xs.data(), ys.data(), zs.data(), end - begin);
+        } else {
+            simd::scalar::crossEach<T>(xs.data(), ys.data(), zs.data(), end - begin);
+        }
+    });
+}
+
+// Matrix-Batch Multiplication Operator: m applied to every vector
+template<typename T, size_t R, size_t C>
+VectorBatch<T, R> operator*(const Matrix<T, R, C>& m, const VectorBatch<T, C>& vectors){
+    VectorBatch<T, R> result(vectors.size());
+    transform(m, vectors, result);
+    return result;
+}
+
+template<typename T, size_t R, size_t C>
+VectorBatch<T, R> operator*(const MatrixBatch<T, R, C>& m, const VectorBatch<T, C>& vectors){
+    VectorBatch<T, R> result(vectors.size());
+    transform(m, vectors, result);
+    return result;
+}
+
+#endif
@@ -0,0 +1,1268 @@
+#ifndef _BLAS_H_
+#define _BLAS_H_
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "Expression.h"
+#include "AlignedBuffer.h"
+#include "Gemm.h"
+#include "Simd.h"
+#include "Strassen.h"
+#include "ThreadPool.h"
+
+/*
+    BLAS-style operations that write into a caller-provided destination,
+    for hot loops that must not create temporaries:
+
+        gemm(alpha, A, B, beta, C);     // C = alpha * A * B + beta * C
+        gemv(alpha, A, x, beta, y);     // y = alpha * A * x + beta * y
+        axpy(alpha, x, y);              // y = alpha * x + y
+        scal(alpha, x);                 // x = alpha * x
+        dot(x, y);                      // returns x . y
+
+    They accept any Vector, Matrix, Tensor, DynVector or DynMatrix whose
+    value types agree, and any view of one (View.h): operands are read
+    through their strides, so a transposed view, a column or a sub-block
+    is multiplied without being copied first. Dimensions are checked at
+    compile time when all of them are fixed, at run time otherwise
+    (std::invalid_argument). As in BLAS, the destination must not alias
+    another operand, and it is not read when beta is zero. Large square
+    products with contiguous rows may be computed by Strassen-Winograd
+    instead of the blocked kernel, as set in Strassen.h.
+
+    Operands with structure have products of their own, with the flags of
+    namespace blas, as in CBLAS:
+
+        gemm(Op::Trans, Op::NoTrans, alpha, A, B, beta, C);   // C = a A^T B + b C
+        syrk(Uplo::Lower, Op::NoTrans, alpha, A, beta, C);    // C = a A A^T + b C
+        trmm(Side::Left, Uplo::Upper, Op::NoTrans, Diag::NonUnit, alpha, U, B);
+        trsm(Side::Right, Uplo::Lower, Op::Trans, Diag::Unit, alpha, L, B);
+
+    syrk() writes one triangle of the symmetric result, for about half the
+    work of gemm(); trmm() (B = alpha * op(A) * B) and trsm() (solves
+    op(A) * X = alpha * B) read one triangle of a square A and overwrite B,
+    or do the same from the right. gemm() itself notices a product of a
+    matrix by its own transpose (a * a.transpose()) and computes it as
+    syrk() plus a copy of the triangle.
+
+    The operators are sugar over these: a product is a node that calls
+    gemm() / gemv() when it is assigned (see Expression.h), so that
+
+        c.noalias() = a * b;    // same as gemm(1, a, b, 0, c)
+        c.noalias() -= a * b;   // same as gemm(-1, a, b, 1, c)
+
+    The operands of gemm(), gemv() and dot() may also hold different element
+    types, or the 16-bit formats of Numeric.h: the destination then holds
+    the promoted type of the operands, and the sums are computed in it, or
+    in float for the 16-bit formats (numeric::accumulator_t). Matrices of
+    16-bit elements are read straight into float by the SIMD gemv and dot
+    kernels, which halves the memory traffic of a float matrix-vector
+    product; gemm() converts its operands to the accumulator type first.
+*/
+
+namespace blas{
+
+    // Operand flags of the structured products, as in CBLAS: whether an
+    // operand is transposed, which triangle of it is referenced, on which
+    // side of B it multiplies, and whether its diagonal is all ones (and
+    // then not read)
+    enum class Op { NoTrans, Trans };
+    enum class Uplo { Lower, Upper };
+    enum class Side { Left, Right };
+    enum class Diag { NonUnit, Unit };
+
+}
+
+
+namespace kernel{
+
+    // C[M][N] = alpha * A[M][K] * B[K][N] + beta * C[M][N] with a plain
+    // i-k-j loop (for products too small to pay for the packing of gemm),
+    // element (i, j) of C being C[i*rsc + j*csc], and likewise for A and B
+    template<typename T>
+    void gemmUnpacked(
+        size_t M, size_t N, size_t K, T alpha,
+        const T* A, size_t rsa, size_t csa, const T* B, size_t rsb, size_t csb,
+        T beta, T* C, size_t rsc, size_t csc
+    ){
+        for (size_t i{}; i<M; ++i){
+
+            T* c {C + i*rsc};
+
+            if (beta == T{}){
+                for (size_t j{}; j<N; ++j){
+                    c[j*csc] = T{};
+                }
+            } else if (beta != T{1}){
+                for (size_t j{}; j<N; ++j){
+                    c[j*csc] = static_cast<T>(beta * c[j*csc]);
+                }
+            }
+
+            for (size_t k{}; k<K; ++k){
+
+                const T a {static_cast<T>(alpha * A[i*rsa + k*csa])};
+                const T* b {B + k*rsb};
+
+                // Unit strides get a loop of their own, for the compiler to
+                // vectorize
+                if (csb == 1 and csc == 1){
+                    for (size_t j{}; j<N; ++j){
+                        c[j] = static_cast<T>(c[j] + a * b[j]);
+                    }
+                } else {
+                    for (size_t j{}; j<N; ++j){
+                        c[j*csc] = static_cast<T>(c[j*csc] + a * b[j*csb]);
+                    }
+                }
+            }
+        }
+    }
+
+    // y[M] = alpha * A[M][N] * x[N] + beta * y[M], parallel over row blocks
+    template<typename T>
+    void gemv(
+        size_t M, size_t N, T alpha, const T* A, size_t lda, const T* x, T beta, T* y
+    ){
+        // y[0, m) = A[0, m) * x
+        auto product = [&](size_t m, const T* a, T* out){
+
+            if constexpr (simd::Accelerated<T>){
+                if (N >= simd::minLength){
+                    simd::gemv(m, N, a, lda, x, out);
+                    return;
+                }
+            }
+
+            for (size_t i{}; i<m; ++i){
+
+                T sum {};
+
+                for (size_t j{}; j<N; ++j){
+                    sum = static_cast<T>(sum + a[i*lda + j] * x[j]);
+                }
+
+                out[i] = sum;
+            }
+        };
+
+        const bool plain {alpha == T{1} and beta == T{}};
+
+        parallel::forBlocks(M, N, 4, [&](size_t begin, size_t end){
+
+            if (plain){
+                product(end - begin, A + begin*lda, y + begin);
+                return;
+            }
+
+            // Rows go through a small stack buffer, to be scaled and added
+            constexpr size_t chunk = 64;
+            T buffer[chunk];
+
+            for (size_t i{begin}; i<end; i+=chunk){
+
+                const size_t m {std::min(chunk, end - i)};
+
+                product(m, A + i*lda, buffer);
+
+                for (size_t r{}; r<m; ++r){
+                    y[i + r] = beta == T{}
+                        ? static_cast<T>(alpha * buffer[r])
+                        : static_cast<T>(alpha * buffer[r] + beta * y[i + r]);
+                }
+            }
+        });
+    }
+
+    // y[n] += alpha * x[n]
+    template<typename T>
+    void axpy(size_t n, T alpha, const T* x, T* y){
+
+        parallel::forBlocks(n, 1, 1, [&](size_t begin, size_t end){
+
+            if constexpr (simd::Accelerated<T>){
+                if (end - begin >= simd::minLength){
+                    simd::axpy(end - begin, alpha, x + begin, y + begin);
+                    return;
+                }
+            }
+
+            for (size_t i{begin}; i<end; ++i){
+                y[i] = static_cast<T>(y[i] + alpha * x[i]);
+            }
+        });
+    }
+
+    // y[i*incy] += alpha * x[i*incx], for i < n
+    template<typename T>
+    void axpy(size_t n, T alpha, const T* x, size_t incx, T* y, size_t incy){
+
+        if (incx == 1 and incy == 1){
+            axpy(n, alpha, x, y);
+            return;
+        }
+
+        parallel::forBlocks(n, 1, 1, [&](size_t begin, size_t end){
+            for (size_t i{begin}; i<end; ++i){
+                y[i*incy] = static_cast<T>(y[i*incy] + alpha * x[i*incx]);
+            }
+        });
+    }
+
+    // y[M] = alpha * A[M][N] * x[N] + beta * y[M], for any strides:
+    // element (i, j) of A at A[i*rsa + j*csa], x[j] at x[j*incx] and y[i]
+    // at y[i*incy]
+    template<typename T>
+    void gemv(
+        size_t M, size_t N, T alpha, const T* A, size_t rsa, size_t csa,
+        const T* x, size_t incx, T beta, T* y, size_t incy
+    ){
+        if (csa == 1 and incx == 1 and incy == 1){
+            gemv(M, N, alpha, A, rsa, x, beta, y);
+            return;
+        }
+
+        parallel::forBlocks(M, N, 4, [&](size_t begin, size_t end){
+
+            // Contiguous columns (a transposed matrix): y is accumulated
+            // column by column, each one an axpy
+            if (rsa == 1 and incy == 1){
+
+                T* out {y + begin};
+                const size_t m {end - begin};
+
+                for (size_t i{}; i<m; ++i){
+                    out[i] = beta == T{} ? T{} : static_cast<T>(beta * out[i]);
+                }
+
+                for (size_t j{}; j<N; ++j){
+
+                    const T scale {static_cast<T>(alpha * x[j*incx])};
+                    const T* a {A + begin + j*csa};
+
+                    if constexpr (simd::Accelerated<T>){
+                        if (m >= simd::minLength){
+                            simd::axpy(m, scale, a, out);
+                            continue;
+                        }
+                    }
+
+                    for (size_t i{}; i<m; ++i){
+                        out[i] = static_cast<T>(out[i] + scale * a[i]);
+                    }
+                }
+
+                return;
+            }
+
+            for (size_t i{begin}; i<end; ++i){
+
+                const T* a {A + i*rsa};
+                T sum {};
+
+                for (size_t j{}; j<N; ++j){
+                    sum = static_cast<T>(sum + a[j*csa] * x[j*incx]);
+                }
+
+                y[i*incy] = beta == T{}
+                    ? static_cast<T>(alpha * sum)
+                    : static_cast<T>(alpha * sum + beta * y[i*incy]);
+            }
+        });
+    }
+
+    // x[i*incx] *= alpha, for i < n
+    template<typename T>
+    void scal(size_t n, T alpha, T* x, size_t incx = 1){
+        parallel::forBlocks(n, 1, 1, [&](size_t begin, size_t end){
+            for (size_t i{begin}; i<end; ++i){
+                x[i*incx] = static_cast<T>(alpha * x[i*incx]);
+            }
+        });
+    }
+
+    // Sum of x[i*incx] * y[i*incy], for i < n, in the promoted type T of
+    // the elements (accumulated in float for the 16-bit formats)
+    template<typename X, typename Y, typename T = numeric::promote_t<X, Y>>
+    T dot(size_t n, const X* x, size_t incx, const Y* y, size_t incy){
+
+        using A = numeric::accumulator_t<T>;
+
+        constexpr bool vectorizable {std::same_as<X, Y> and simd::Vectorized<X>};
+
+        const bool vectorized {
+            vectorizable and incx == 1 and incy == 1 and n >= simd::minLength
+        };
+
+        return static_cast<T>(parallel::sum<A>(n, 1, [&](size_t begin, size_t end) -> A {
+
+            if constexpr (vectorizable){
+                if (vectorized){
+                    return simd::dot(x + begin, y + begin, end - begin);
+                }
+            }
+
+            A result {};
+
+            for (size_t i{begin}; i<end; ++i){
+                result = static_cast<A>(result + static_cast<A>(x[i*incx]) * static_cast<A>(y[i*incy]));
+            }
+
+            return result;
+        }));
+    }
+
+    // y[M] = alpha * A[M][N] * x[N] + beta * y[M] for elements of different
+    // types or of the 16-bit formats, summed in W: x is converted to W once,
+    // and rows of 16-bit elements are widened by the SIMD kernel as they
+    // are read (others element by element)
+    template<typename W, typename SA, typename SX, typename T>
+    void gemvWide(
+        size_t M, size_t N, W alpha, const SA* A, size_t rsa, size_t csa,
+        const SX* x, size_t incx, W beta, T* y, size_t incy
+    ){
+        AlignedBuffer<W> converted {N};
+        W* xs {converted.data()};
+
+        for (size_t j{}; j<N; ++j){
+            xs[j] = static_cast<W>(x[j*incx]);
+        }
+
+        // out[0, m) = A[0, m) * x
+        auto product = [&](size_t m, const SA* a, W* out){
+
+            if constexpr (numeric::Reduced<SA> and std::same_as<W, float>){
+                if (csa == 1 and N >= simd::minLength){
+                    simd::gemv(m, N, a, rsa, xs, out);
+                    return;
+                }
+            }
+
+            for (size_t i{}; i<m; ++i){
+
+                W sum {};
+
+                for (size_t j{}; j<N; ++j){
+                    sum = static_cast<W>(sum + static_cast<W>(a[i*rsa + j*csa]) * xs[j]);
+                }
+
+                out[i] = sum;
+            }
+        };
+
+        parallel::forBlocks(M, N, 4, [&](size_t begin, size_t end){
+
+            constexpr size_t chunk = 64;
+            W buffer[chunk];
+
+            for (size_t i{begin}; i<end; i+=chunk){
+
+                const size_t m {std::min(chunk, end - i)};
+
+                product(m, A + i*rsa, buffer);
+
+                for (size_t r{}; r<m; ++r){
+                    T& element {y[(i + r)*incy]};
+                    element = beta == W{}
+                        ? static_cast<T>(alpha * buffer[r])
+                        : static_cast<T>(alpha * buffer[r] + beta * static_cast<W>(element));
+                }
+            }
+        });
+    }
+
+    // C[M][N] = alpha * A[M][K] * B[K][N] + beta * C[M][N] for elements of
+    // different types or of the 16-bit formats, computed in W: A and B are
+    // converted to contiguous buffers of W, multiplied by the gemm of W,
+    // and the product added to C
+    template<typename W, typename SA, typename SB, typename T>
+    void gemmWide(
+        size_t M, size_t N, size_t K, W alpha,
+        const SA* A, size_t rsa, size_t csa, const SB* B, size_t rsb, size_t csb,
+        W beta, T* C, size_t rsc, size_t csc
+    ){
+        AlignedBuffer<W> a {M * K}, b {K * N}, c {M * N};
+
+        for (size_t i{}; i<M; ++i){
+            for (size_t k{}; k<K; ++k){
+                a.data()[i*K + k] = static_cast<W>(A[i*rsa + k*csa]);
+            }
+        }
+
+        for (size_t k{}; k<K; ++k){
+            for (size_t j{}; j<N; ++j){
+                b.data()[k*N + j] = static_cast<W>(B[k*rsb + j*csb]);
+            }
+        }
+
+        if (M * N * K <= fixedGemmLimit){
+            gemmUnpacked(M, N, K, W{1}, a.data(), K, 1, b.data(), N, 1, W{}, c.data(), N, 1);
+        } else {
+            gemm(M, N, K, a.data(), K, b.data(), N, c.data(), N);
+        }
+
+        for (size_t i{}; i<M; ++i){
+            for (size_t j{}; j<N; ++j){
+                T& element {C[i*rsc + j*csc]};
+                element = beta == W{}
+                    ? static_cast<T>(alpha * c.data()[i*N + j])
+                    : static_cast<T>(alpha * c.data()[i*N + j] + beta * static_cast<W>(element));
+            }
+        }
+    }
+
+    // Tiles of the transposes and of the diagonal blocks of syrk(), small
+    // enough for two of them to stay in L1
+    inline constexpr size_t transposeBlock = 32;
+
+    // Largest triangle of the triangular products and solves done by
+    // substitution, row by row: the triangles are O(n^2 * block) work, the
+    // gemm updates between them O(n^3)
+    inline constexpr size_t triangularBlock = 64;
+
+    namespace detail{
+
+        // Copies the rows of A[m][n] into tile[m][n]. The leaves of the
+        // transposes go through such tiles, so that memory is only read and
+        // written row by row: a column of a matrix whose rows are a power of
+        // two apart falls in a single cache set, and would be evicted
+        // before its next element is used.
+        template<typename T>
+        void load(size_t m, size_t n, const T* A, size_t lda, T* tile){
+            for (size_t i{}; i<m; ++i){
+                for (size_t j{}; j<n; ++j){
+                    tile[i*n + j] = A[i*lda + j];
+                }
+            }
+        }
+
+        // B[n][m] = tile[m][n]^T
+        template<typename T>
+        void storeTransposed(size_t m, size_t n, const T* tile, T* B, size_t ldb){
+            for (size_t j{}; j<n; ++j){
+                for (size_t i{}; i<m; ++i){
+                    B[j*ldb + i] = tile[i*n + j];
+                }
+            }
+        }
+
+        // Swaps A[m][n] with the transpose of B[n][m], halving the longer
+        // side until the blocks fit a tile (cache-oblivious)
+        template<typename T>
+        void swapTransposed(size_t m, size_t n, T* A, size_t lda, T* B, size_t ldb){
+
+            if (m <= transposeBlock and n <= transposeBlock){
+
+                T a[transposeBlock * transposeBlock];
+                T b[transposeBlock * transposeBlock];
+
+                load(m, n, A, lda, a);
+                load(n, m, B, ldb, b);
+                storeTransposed(n, m, b, A, lda);
+                storeTransposed(m, n, a, B, ldb);
+
+                return;
+            }
+
+            if (m >= n){
+                const size_t h {m / 2};
+                swapTransposed(h, n, A, lda, B, ldb);
+                swapTransposed(m - h, n, A + h*lda, lda, B + h, ldb);
+            } else {
+                const size_t h {n / 2};
+                swapTransposed(m, h, A, lda, B, ldb);
+                swapTransposed(m, n - h, A + h, lda, B + h*ldb, ldb);
+            }
+        }
+
+    }
+
+    // Transposes A[n][n] in place: the diagonal quadrants recursively, and
+    // the off-diagonal ones swapped with each other's transpose, so that
+    // every level of the memory hierarchy is used by blocks that fit it,
+    // whatever its size (cache-oblivious)
+    template<typename T>
+    void transpose(size_t n, T* A, size_t lda){
+
+        if (n <= transposeBlock){
+            T tile[transposeBlock * transposeBlock];
+            detail::load(n, n, A, lda, tile);
+            detail::storeTransposed(n, n, tile, A, lda);
+            return;
+        }
+
+        const size_t h {n / 2};
+
+        transpose(h, A, lda);
+        transpose(n - h, A + h*lda + h, lda);
+        detail::swapTransposed(h, n - h, A + h, lda, A + h*lda, lda);
+    }
+
+    // B[n][m] = A[m][n]^T, halving the longer side down to a tile
+    template<typename T>
+    void transpose(size_t m, size_t n, const T* A, size_t lda, T* B, size_t ldb){
+
+        if (m <= transposeBlock and n <= transposeBlock){
+            T tile[transposeBlock * transposeBlock];
+            detail::load(m, n, A, lda, tile);
+            detail::storeTransposed(m, n, tile, B, ldb);
+            return;
+        }
+
+        if (m >= n){
+            const size_t h {m / 2};
+            transpose(h, n, A, lda, B, ldb);
+            transpose(m - h, n, A + h*lda, lda, B + h, ldb);
+        } else {
+            const size_t h {n / 2};
+            transpose(m, h, A, lda, B, ldb);
+            transpose(m, n - h, A + h, lda, B + h*ldb, ldb);
+        }
+    }
+
+    // Copies the lower triangle of C[n][n] onto the upper one
+    template<typename T>
+    void symmetrize(size_t n, T* C, size_t ldc){
+
+        if (n <= transposeBlock){
+            for (size_t i{}; i<n; ++i){
+                for (size_t j{}; j<i; ++j){
+                    C[j*ldc + i] = C[i*ldc + j];
+                }
+            }
+            return;
+        }
+
+        const size_t h {n / 2};
+
+        symmetrize(h, C, ldc);
+        symmetrize(n - h, C + h*ldc + h, ldc);
+        transpose(n - h, h, C + h*ldc, ldc, C + h, ldc);
+    }
+
+    // The lower (or upper) triangle of C[n][n] = alpha * A[n][k] * A^T +
+    // beta * C, the other triangle not being touched. The off-diagonal
+    // quadrant is one gemm, the diagonal ones recurse, down to tiles
+    // computed whole by gemm (whose packing makes the rows of A contiguous
+    // whatever its strides) and copied triangle only: about half the work
+    // of the full product
+    template<typename T>
+    void syrk(
+        bool lower, size_t n, size_t k, T alpha, const T* A, size_t rsa, size_t csa,
+        T beta, T* C, size_t ldc
+    ){
+        if (n <= transposeBlock){
+
+            T tile[transposeBlock * transposeBlock];
+
+            gemm(n, n, k, alpha, A, rsa, csa, A, csa, rsa, T{}, tile, n);
+
+            for (size_t i{}; i<n; ++i){
+                for (size_t j{lower ? 0 : i}; j<(lower ? i + 1 : n); ++j){
+                    T& element {C[i*ldc + j]};
+                    element = beta == T{}
+                        ? tile[i*n + j]
+                        : static_cast<T>(tile[i*n + j] + beta * element);
+                }
+            }
+            return;
+        }
+
+        const size_t h {n / 2};
+
+        if (lower){
+            // C21 = alpha * A2 * A1^T + beta * C21
+            gemm(n - h, h, k, alpha, A + h*rsa, rsa, csa, A, csa, rsa, beta, C + h*ldc, ldc);
+        } else {
+            // C12 = alpha * A1 * A2^T + beta * C12
+            gemm(h, n - h, k, alpha, A, rsa, csa, A + h*rsa, csa, rsa, beta, C + h, ldc);
+        }
+
+        syrk(lower, h, k, alpha, A, rsa, csa, beta, C, ldc);
+        syrk(lower, n - h, k, alpha, A + h*rsa, rsa, csa, beta, C + h*ldc + h, ldc);
+    }
+
+    // C[M][N] = alpha * A[M][K] * B[K][N] + beta * C[M][N] for any strides
+    // (element (i, j) of C at C[i*rsc + j*csc]), by the unrolled, the
+    // Strassen-Winograd or the blocked kernel; a product A * A^T of one
+    // matrix by its own transpose computes one triangle by syrk() and
+    // copies it onto the other
+    template<typename T>
+    void gemmStrided(
+        size_t M, size_t N, size_t K, T alpha,
+        const T* A, size_t rsa, size_t csa, const T* B, size_t rsb, size_t csb,
+        T beta, T* C, size_t rsc, size_t csc
+    ){
+        if (M * N * K <= fixedGemmLimit){
+            gemmUnpacked(M, N, K, alpha, A, rsa, csa, B, rsb, csb, beta, C, rsc, csc);
+        } else if (
+            M == N and A == B and rsa == csb and csa == rsb and beta == T{}
+            and (csc == 1 or rsc == 1)
+        ){
+            // C is symmetric: its transpose is the same matrix
+            const size_t ldc {csc == 1 ? rsc : csc};
+            syrk(true, N, K, alpha, A, rsa, csa, T{}, C, ldc);
+            symmetrize(N, C, ldc);
+        } else if (csa == 1 and csb == 1 and csc == 1 and strassen::use(M, N, K)){
+            strassen::multiply(N, alpha, A, rsa, B, rsb, beta, C, rsc);
+        } else if (csc == 1){
+            gemm(M, N, K, alpha, A, rsa, csa, B, rsb, csb, beta, C, rsc);
+        } else if (rsc == 1){
+            // A transposed destination: C^T = B^T * A^T has contiguous rows
+            gemm(N, M, K, alpha, B, csb, rsb, A, csa, rsa, beta, C, csc);
+        } else {
+            // Neither rows nor columns of C are contiguous: go through a buffer
+            AlignedBuffer<T> buffer {M * N};
+
+            gemm(M, N, K, alpha, A, rsa, csa, B, rsb, csb, T{}, buffer.data(), N);
+
+            for (size_t i{}; i<M; ++i){
+                for (size_t j{}; j<N; ++j){
+                    T& element {C[i*rsc + j*csc]};
+                    element = beta == T{}
+                        ? buffer.data()[i*N + j]
+                        : static_cast<T>(buffer.data()[i*N + j] + beta * element);
+                }
+            }
+        }
+    }
+
+    // Solves L * X = B for X in place of B[n][w], L[n][n] lower triangular
+    // (with a unit diagonal that is not read if unit). The top half of X is
+    // solved for, folded into the bottom half of B with one gemm, and the
+    // bottom half solved for, recursively, down to blocks solved by
+    // substitution: the updates are few large products rather than many
+    // thin ones
+    template<typename T>
+    void trsmLower(
+        size_t n, size_t w, bool unit, const T* L, size_t rsl, size_t csl,
+        T* B, size_t rsb, size_t csb
+    ){
+        if (n <= triangularBlock){
+            for (size_t i{}; i<n; ++i){
+                for (size_t j{}; j<i; ++j){
+                    const T l {L[i*rsl + j*csl]};
+                    if (l != T{}) axpy(w, static_cast<T>(-l), B + j*rsb, csb, B + i*rsb, csb);
+                }
+                if (not unit) scal(w, static_cast<T>(T{1} / L[i*rsl + i*csl]), B + i*rsb, csb);
+            }
+            return;
+        }
+
+        const size_t h {n / 2};
+
+        trsmLower(h, w, unit, L, rsl, csl, B, rsb, csb);
+        gemmStrided(
+            n - h, w, h, T{-1}, L + h*rsl, rsl, csl, B, rsb, csb,
+            T{1}, B + h*rsb, rsb, csb
+        );
+        trsmLower(n - h, w, unit, L + h*rsl + h*csl, rsl, csl, B + h*rsb, rsb, csb);
+    }
+
+    // Solves U * X = B for X in place of B[n][w], U[n][n] upper triangular,
+    // the bottom half first
+    template<typename T>
+    void trsmUpper(
+        size_t n, size_t w, bool unit, const T* U, size_t rsu, size_t csu,
+        T* B, size_t rsb, size_t csb
+    ){
+        if (n <= triangularBlock){
+            for (size_t i{n}; i-- > 0; ){
+                for (size_t j{i + 1}; j<n; ++j){
+                    const T u {U[i*rsu + j*csu]};
+                    if (u != T{}) axpy(w, static_cast<T>(-u), B + j*rsb, csb, B + i*rsb, csb);
+                }
+                if (not unit) scal(w, static_cast<T>(T{1} / U[i*rsu + i*csu]), B + i*rsb, csb);
+            }
+            return;
+        }
+
+        const size_t h {n / 2};
+
+        trsmUpper(n - h, w, unit, U + h*rsu + h*csu, rsu, csu, B + h*rsb, rsb, csb);
+        gemmStrided(
+            h, w, n - h, T{-1}, U + h*csu, rsu, csu, B + h*rsb, rsb, csb,
+            T{1}, B, rsb, csb
+        );
+        trsmUpper(h, w, unit, U, rsu, csu, B, rsb, csb);
+    }
+
+    // B[n][w] = L * B, L[n][n] lower triangular (unit diagonal not read if
+    // unit): the bottom half of B is multiplied by its diagonal block and
+    // gets the top half, not yet overwritten, with one gemm, then the top
+    // half is multiplied by its own, recursively
+    template<typename T>
+    void trmmLower(
+        size_t n, size_t w, bool unit, const T* L, size_t rsl, size_t csl,
+        T* B, size_t rsb, size_t csb
+    ){
+        if (n <= triangularBlock){
+            for (size_t i{n}; i-- > 0; ){
+                if (not unit) scal(w, L[i*rsl + i*csl], B + i*rsb, csb);
+                for (size_t j{}; j<i; ++j){
+                    const T l {L[i*rsl + j*csl]};
+                    if (l != T{}) axpy(w, l, B + j*rsb, csb, B + i*rsb, csb);
+                }
+            }
+            return;
+        }
+
+        const size_t h {n / 2};
+
+        trmmLower(n - h, w, unit, L + h*rsl + h*csl, rsl, csl, B + h*rsb, rsb, csb);
+        gemmStrided(
+            n - h, w, h, T{1}, L + h*rsl, rsl, csl, B, rsb, csb,
+            T{1}, B + h*rsb, rsb, csb
+        );
+        trmmLower(h, w, unit, L, rsl, csl, B, rsb, csb);
+    }
+
+    // B[n][w] = U * B, U[n][n] upper triangular, the top half first
+    template<typename T>
+    void trmmUpper(
+        size_t n, size_t w, bool unit, const T* U, size_t rsu, size_t csu,
+        T* B, size_t rsb, size_t csb
+    ){
+        if (n <= triangularBlock){
+            for (size_t i{}; i<n; ++i){
+                if (not unit) scal(w, U[i*rsu + i*csu], B + i*rsb, csb);
+                for (size_t j{i + 1}; j<n; ++j){
+                    const T u {U[i*rsu + j*csu]};
+                    if (u != T{}) axpy(w, u, B + j*rsb, csb, B + i*rsb, csb);
+                }
+            }
+            return;
+        }
+
+        const size_t h {n / 2};
+
+        trmmUpper(h, w, unit, U, rsu, csu, B, rsb, csb);
+        gemmStrided(
+            h, w, n - h, T{1}, U + h*csu, rsu, csu, B + h*rsb, rsb, csb,
+            T{1}, B, rsb, csb
+        );
+        trmmUpper(n - h, w, unit, U + h*rsu + h*csu, rsu, csu, B + h*rsb, rsb, csb);
+    }
+
+}
+
+
+namespace expr{
+
+    // Whether the elements of a stored expression lie contiguously, row by
+    // row, from data()
+    template<Stored E>
+    constexpr bool contiguous(const E& e){
+
+        const auto extent {e.shape()};
+        const auto stride {e.strides()};
+
+        if constexpr (std::tuple_size_v<decltype(extent)> == 1){
+            return stride[0] == 1 or extent[0] <= 1;
+        } else {
+            return (stride[1] == 1 or extent[1] <= 1)
+                and (stride[0] == extent[1] or extent[0] <= 1);
+        }
+    }
+
+}
+
+
+/*************** BLAS-style In-place Operations ***************************/
+
+// C = alpha * A * B + beta * C
+template<expr::Strided<2> L, expr::Strided<2> R, typename D,
+         typename Destination = std::remove_cvref_t<D>>
+    requires (
+        expr::Strided<Destination, 2> and expr::Writable<Destination>
+        and expr::SameValueType<L, R, Destination>
+        and not numeric::Reduced<typename Destination::value_type>
+    )
+void gemm(
+    typename Destination::value_type alpha, const L& A, const R& B,
+    typename Destination::value_type beta, D&& C
+){
+    using T = typename Destination::value_type;
+
+    if constexpr (expr::FixedShape<L> and expr::FixedShape<R> and expr::FixedShape<Destination>){
+
+        constexpr size_t M = L::shape()[0], K = L::shape()[1], N = R::shape()[1];
+
+        static_assert(
+            R::shape()[0] == K and Destination::shape()[0] == M
+            and Destination::shape()[1] == N,
+            "Matrix dimensions do not match"
+        );
+
+        // Small fixed products use the kernels unrolled at compile time (the
+        // fixed-size classes are contiguous, fixed-shape views may not be)
+        if constexpr (
+            M * N * K <= kernel::fixedGemmLimit
+            and expr::Terminal<L> and expr::Terminal<R> and expr::Terminal<Destination>
+        ){
+
+            auto product = [&](T* out){
+                if constexpr (M * N * K <= kernel::smallGemmLimit){
+                    kernel::gemmSmall<T, M, K, N>(A.data(), B.data(), out);
+                } else {
+                    kernel::gemmFixed<T, M, K, N>(A.data(), B.data(), out);
+                }
+            };
+
+            if (alpha == T{1} and beta == T{}){
+                product(C.data());
+                return;
+            }
+
+            T buffer[M * N];
+            product(buffer);
+
+            T* c {C.data()};
+
+            for (size_t i{}; i<M*N; ++i){
+                c[i] = beta == T{}
+                    ? static_cast<T>(alpha * buffer[i])
+                    : static_cast<T>(alpha * buffer[i] + beta * c[i]);
+            }
+
+            return;
+        }
+
+    } else {
+
+        if (B.shape()[0] != A.shape()[1]
+            or C.shape() != std::array<size_t, 2>{A.shape()[0], B.shape()[1]}){
+            throw std::invalid_argument("Matrix dimensions do not match");
+        }
+
+    }
+
+    const auto [rsa, csa] = A.strides();
+    const auto [rsb, csb] = B.strides();
+    const auto [rsc, csc] = C.strides();
+
+    kernel::gemmStrided(
+        A.shape()[0], B.shape()[1], A.shape()[1], alpha, A.data(), rsa, csa,
+        B.data(), rsb, csb, beta, C.data(), rsc, csc
+    );
+}
+
+// y = alpha * A * x + beta * y
+template<expr::Strided<2> L, expr::Strided<1> V, typename D,
+         typename Destination = std::remove_cvref_t<D>>
+    requires (
+        expr::Strided<Destination, 1> and expr::Writable<Destination>
+        and expr::SameValueType<L, V, Destination>
+        and not numeric::Reduced<typename Destination::value_type>
+    )
+void gemv(
+    typename Destination::value_type alpha, const L& A, const V& x,
+    typename Destination::value_type beta, D&& y
+){
+    using T = typename Destination::value_type;
+
+    if constexpr (expr::FixedShape<L> and expr::FixedShape<V> and expr::FixedShape<Destination>){
+
+        constexpr size_t M = L::shape()[0], N = L::shape()[1];
+
+        static_assert(
+            V::shape()[0] == N and Destination::shape()[0] == M,
+            "Matrix dimensions do not match"
+        );
+
+        // Small fixed products skip the dispatch to the SIMD kernel and the
+        // thread pool (for the contiguous fixed-size classes)
+        if constexpr (
+            M * N < parallel::minimumWork and not (simd::Accelerated<T> and N >= simd::minLength)
+            and expr::Terminal<L> and expr::Terminal<V> and expr::Terminal<Destination>
+        ){
+
+            const T* a {A.data()};
+            const T* v {x.data()};
+            T* out {y.data()};
+
+            for (size_t i{}; i<M; ++i){
+
+                T sum {};
+
+                for (size_t j{}; j<N; ++j){
+                    sum = static_cast<T>(sum + a[i*N + j] * v[j]);
+                }
+
+                out[i] = beta == T{}
+                    ? static_cast<T>(alpha * sum)
+                    : static_cast<T>(alpha * sum + beta * out[i]);
+            }
+
+            return;
+        }
+
+    } else {
+
+        if (x.shape()[0] != A.shape()[1] or y.shape()[0] != A.shape()[0]){
+            throw std::invalid_argument("Matrix dimensions do not match");
+        }
+
+    }
+
+    const size_t M {A.shape()[0]}, N {A.shape()[1]};
+    const auto [rsa, csa] = A.strides();
+
+    kernel::gemv(
+        M, N, alpha, A.data(), rsa, csa, x.data(), x.strides()[0],
+        beta, y.data(), y.strides()[0]
+    );
+}
+
+// C = alpha * A * B + beta * C, for operands of different element types or
+// of the 16-bit formats, C holding their promoted type
+template<expr::Strided<2> L, expr::Strided<2> R, typename D,
+         typename Destination = std::remove_cvref_t<D>>
+    requires (
+        expr::Strided<Destination, 2> and expr::Writable<Destination>
+        and std::same_as<typename Destination::value_type, expr::Promoted<L, R>>
+        and (
+            not expr::SameValueType<L, R, Destination>
+            or numeric::Reduced<typename Destination::value_type>
+        )
+    )
+void gemm(
+    typename Destination::value_type alpha, const L& A, const R& B,
+    typename Destination::value_type beta, D&& C
+){
+    using W = numeric::accumulator_t<typename Destination::value_type>;
+
+    if constexpr (expr::FixedShape<L> and expr::FixedShape<R> and expr::FixedShape<Destination>){
+        static_assert(
+            R::shape()[0] == L::shape()[1] and Destination::shape()[0] == L::shape()[0]
+            and Destination::shape()[1] == R::shape()[1],
+            "Matrix dimensions do not match"
+        );
+    } else {
+        if (B.shape()[0] != A.shape()[1]
+            or C.shape() != std::array<size_t, 2>{A.shape()[0], B.shape()[1]}){
+            throw std::invalid_argument("Matrix dimensions do not match");
+        }
+    }
+
+    const auto [rsa, csa] = A.strides();
+    const auto [rsb, csb] = B.strides();
+    const auto [rsc, csc] = C.strides();
+
+    kernel::gemmWide(
+        A.shape()[0], B.shape()[1], A.shape()[1], static_cast<W>(alpha),
+        A.data(), rsa, csa, B.data(), rsb, csb, static_cast<W>(beta), C.data(), rsc, csc
+    );
+}
+
+// y = alpha * A * x + beta * y, for operands of different element types or
+// of the 16-bit formats, y holding their promoted type
+template<expr::Strided<2> L, expr::Strided<1> V, typename D,
+         typename Destination = std::remove_cvref_t<D>>
+    requires (
+        expr::Strided<Destination, 1> and expr::Writable<Destination>
+        and std::same_as<typename Destination::value_type, expr::Promoted<L, V>>
+        and (
+            not expr::SameValueType<L, V, Destination>
+            or numeric::Reduced<typename Destination::value_type>
+        )
+    )
+void gemv(
+    typename Destination::value_type alpha, const L& A, const V& x,
+    typename Destination::value_type beta, D&& y
+){
+    using W = numeric::accumulator_t<typename Destination::value_type>;
+
+    if constexpr (expr::FixedShape<L> and expr::FixedShape<V> and expr::FixedShape<Destination>){
+        static_assert(
+            V::shape()[0] == L::shape()[1] and Destination::shape()[0] == L::shape()[0],
+            "Matrix dimensions do not match"
+        );
+    } else {
+        if (x.shape()[0] != A.shape()[1] or y.shape()[0] != A.shape()[0]){
+            throw std::invalid_argument("Matrix dimensions do not match");
+        }
+    }
+
+    const auto [rsa, csa] = A.strides();
+
+    kernel::gemvWide(
+        A.shape()[0], A.shape()[1], static_cast<W>(alpha), A.data(), rsa, csa,
+        x.data(), x.strides()[0], static_cast<W>(beta), y.data(), y.strides()[0]
+    );
+}
+
+// y = alpha * x + y, for any two objects of the same shape
+template<expr::Stored X, typename Y, typename Destination = std::remove_cvref_t<Y>>
+    requires (expr::Writable<Destination> and expr::SameValueType<X, Destination>)
+void axpy(typename Destination::value_type alpha, const X& x, Y&& y){
+
+    if constexpr (expr::FixedShape<X> and expr::FixedShape<Destination>){
+        static_assert(X::shape() == Destination::shape(), "Dimensions do not match");
+    } else {
+        if (x.shape() != y.shape()){
+            throw std::invalid_argument("Dimensions do not match");
+        }
+    }
+
+    const auto extent {x.shape()};
+
+    if constexpr (std::tuple_size_v<decltype(extent)> == 1){
+
+        kernel::axpy(extent[0], alpha, x.data(), x.strides()[0], y.data(), y.strides()[0]);
+
+    } else if (expr::contiguous(x) and expr::contiguous(y)){
+
+        kernel::axpy(extent[0] * extent[1], alpha, x.data(), y.data());
+
+    } else {
+
+        const auto [rsx, csx] = x.strides();
+        const auto [rsy, csy] = y.strides();
+
+        for (size_t i{}; i<extent[0]; ++i){
+            kernel::axpy(extent[1], alpha, x.data() + i*rsx, csx, y.data() + i*rsy, csy);
+        }
+    }
+}
+
+// x = alpha * x
+template<typename X, typename Destination = std::remove_cvref_t<X>>
+    requires expr::Writable<Destination>
+void scal(typename Destination::value_type alpha, X&& x){
+
+    const auto extent {x.shape()};
+
+    if constexpr (std::tuple_size_v<decltype(extent)> == 1){
+
+        kernel::scal(extent[0], alpha, x.data(), x.strides()[0]);
+
+    } else if (expr::contiguous(x)){
+
+        kernel::scal(extent[0] * extent[1], alpha, x.data());
+
+    } else {
+
+        const auto [rsx, csx] = x.strides();
+
+        for (size_t i{}; i<extent[0]; ++i){
+            kernel::scal(extent[1], alpha, x.data() + i*rsx, csx);
+        }
+    }
+}
+
+// x . y, in the promoted element type of x and y
+template<expr::Strided<1> X, expr::Strided<1> Y>
+expr::Promoted<X, Y> dot(const X& x, const Y& y){
+
+    if constexpr (expr::FixedShape<X> and expr::FixedShape<Y>){
+        static_assert(X::shape() == Y::shape(), "Vector dimensions do not match");
+    } else {
+        if (x.shape() != y.shape()){
+            throw std::invalid_argument("Vector dimensions do not match");
+        }
+    }
+
+    return kernel::dot(x.shape()[0], x.data(), x.strides()[0], y.data(), y.strides()[0]);
+}
+
+// C = alpha * op(A) * op(B) + beta * C, op() transposing its operand for
+// blas::Op::Trans (a swap of its strides)
+template<expr::Strided<2> L, expr::Strided<2> R, typename D,
+         typename Destination = std::remove_cvref_t<D>>
+    requires (
+        expr::Strided<Destination, 2> and expr::Writable<Destination>
+        and expr::SameValueType<L, R, Destination>
+        and not numeric::Reduced<typename Destination::value_type>
+    )
+void gemm(
+    blas::Op opA, blas::Op opB, typename Destination::value_type alpha,
+    const L& A, const R& B, typename Destination::value_type beta, D&& C
+){
+    auto [M, K] = A.shape();
+    auto [rsa, csa] = A.strides();
+
+    if (opA == blas::Op::Trans){
+        std::swap(M, K);
+        std::swap(rsa, csa);
+    }
+
+    auto [KB, N] = B.shape();
+    auto [rsb, csb] = B.strides();
+
+    if (opB == blas::Op::Trans){
+        std::swap(KB, N);
+        std::swap(rsb, csb);
+    }
+
+    if (KB != K or C.shape() != std::array<size_t, 2>{M, N}){
+        throw std::invalid_argument("Matrix dimensions do not match");
+    }
+
+    const auto [rsc, csc] = C.strides();
+
+    kernel::gemmStrided(
+        M, N, K, alpha, A.data(), rsa, csa, B.data(), rsb, csb, beta, C.data(), rsc, csc
+    );
+}
+
+// The lower or upper triangle of C = alpha * op(A) * op(A)^T + beta * C, the
+// other triangle being left as it is: C[n][n] is symmetric, so that half of
+// the products are enough (blas::Op::Trans gives A^T * A)
+template<expr::Strided<2> L, typename D, typename Destination = std::remove_cvref_t<D>>
+    requires (
+        expr::Strided<Destination, 2> and expr::Writable<Destination>
+        and expr::SameValueType<L, Destination>
+        and not numeric::Reduced<typename Destination::value_type>
+    )
+void syrk(
+    blas::Uplo uplo, blas::Op op, typename Destination::value_type alpha,
+    const L& A, typename Destination::value_type beta, D&& C
+){
+    using T = typename Destination::value_type;
+
+    auto [n, k] = A.shape();
+    auto [rsa, csa] = A.strides();
+
+    if (op == blas::Op::Trans){
+        std::swap(n, k);
+        std::swap(rsa, csa);
+    }
+
+    if (C.shape() != std::array<size_t, 2>{n, n}){
+        throw std::invalid_argument("Matrix dimensions do not match");
+    }
+
+    const bool lower {uplo == blas::Uplo::Lower};
+    const auto [rsc, csc] = C.strides();
+
+    if (csc == 1){
+        kernel::syrk(lower, n, k, alpha, A.data(), rsa, csa, beta, C.data(), rsc);
+    } else if (rsc == 1){
+        // The lower triangle of C is the upper one of its row-major transpose
+        kernel::syrk(not lower, n, k, alpha, A.data(), rsa, csa, beta, C.data(), csc);
+    } else {
+        AlignedBuffer<T> buffer {n * n};
+        T* b {buffer.data()};
+
+        for (size_t i{}; i<n; ++i){
+            for (size_t j{}; j<n; ++j){
+                b[i*n + j] = C.data()[i*rsc + j*csc];
+            }
+        }
+
+        kernel::syrk(lower, n, k, alpha, A.data(), rsa, csa, beta, b, n);
+
+        for (size_t i{}; i<n; ++i){
+            for (size_t j{lower ? 0 : i}; j<(lower ? i + 1 : n); ++j){
+                C.data()[i*rsc + j*csc] = b[i*n + j];
+            }
+        }
+    }
+}
+
+namespace blas::detail{
+
+    // op(A) * B, or B * op(A) = (op(A)^T * B^T)^T, as the product from the
+    // left of B'[n][w] by the triangular A'[n][n] the kernels take
+    struct Triangular{
+        bool lower;
+        size_t n, w, rsa, csa, rsb, csb;
+    };
+
+    template<typename L, typename R>
+    Triangular triangular(Side side, Uplo uplo, Op op, const L& A, const R& B){
+
+        const auto [rows, columns] = B.shape();
+        const auto [rsa, csa] = A.strides();
+        const auto [rsb, csb] = B.strides();
+
+        // A' is op(A) on the left, op(A)^T on the right
+        const bool transposed {(op == Op::Trans) == (side == Side::Left)};
+
+        Triangular t {
+            (uplo == Uplo::Lower) != transposed,
+            rows, columns, rsa, csa, rsb, csb
+        };
+
+        if (transposed){
+            std::swap(t.rsa, t.csa);
+        }
+
+        if (side == Side::Right){
+            std::swap(t.n, t.w);
+            std::swap(t.rsb, t.csb);
+        }
+
+        if (A.shape() != std::array<size_t, 2>{t.n, t.n}){
+            throw std::invalid_argument("Matrix dimensions do not match");
+        }
+
+        return t;
+    }
+
+}
+
+// B = alpha * op(A) * B (blas::Side::Left) or alpha * B * op(A) (Right), A
+// square and triangular: only its uplo triangle is read, and the product is
+// done in place in half the multiply-adds of gemm()
+template<expr::Strided<2> L, typename D, typename Destination = std::remove_cvref_t<D>>
+    requires (
+        expr::Strided<Destination, 2> and expr::Writable<Destination>
+        and expr::SameValueType<L, Destination>
+        and not numeric::Reduced<typename Destination::value_type>
+    )
+void trmm(
+    blas::Side side, blas::Uplo uplo, blas::Op op, blas::Diag diag,
+    typename Destination::value_type alpha, const L& A, D&& B
+){
+    using T = typename Destination::value_type;
+
+    const blas::detail::Triangular t {blas::detail::triangular(side, uplo, op, A, B)};
+    const bool unit {diag == blas::Diag::Unit};
+
+    if (alpha != T{1}){
+        scal(alpha, B);
+    }
+
+    if (t.lower){
+        kernel::trmmLower(t.n, t.w, unit, A.data(), t.rsa, t.csa, B.data(), t.rsb, t.csb);
+    } else {
+        kernel::trmmUpper(t.n, t.w, unit, A.data(), t.rsa, t.csa, B.data(), t.rsb, t.csb);
+    }
+}
+
+// Solves op(A) * X = alpha * B (blas::Side::Left) or X * op(A) = alpha * B
+// (Right) for X in place of B, A square and triangular (only its uplo
+// triangle is read), by blocked substitution
+template<expr::Strided<2> L, typename D, typename Destination = std::remove_cvref_t<D>>
+    requires (
+        expr::Strided<Destination, 2> and expr::Writable<Destination>
+        and expr::SameValueType<L, Destination>
+        and not numeric::Reduced<typename Destination::value_type>
+    )
+void trsm(
+    blas::Side side, blas::Uplo uplo, blas::Op op, blas::Diag diag,
+    typename Destination::value_type alpha, const L& A, D&& B
+){
+    using T = typename Destination::value_type;
+
+    const blas::detail::Triangular t {blas::detail::triangular(side, uplo, op, A, B)};
+    const bool unit {diag == blas::Diag::Unit};
+
+    if (alpha != T{1}){
+        scal(alpha, B);
+    }
+
+    if (t.lower){
+        kernel::trsmLower(t.n, t.w, unit, A.data(), t.rsa, t.csa, B.data(), t.rsb, t.csb);
+    } else {
+        kernel::trsmUpper(t.n, t.w, unit, A.data(), t.rsa, t.csa, B.data(), t.rsb, t.csb);
+    }
+}
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef _BOUNDS_H_
+#define _BOUNDS_H_
+
+/*
+    Bounds checking policy of the element accessors of Vector, Matrix,
+    Tensor, DynVector, DynMatrix and the views:
+
+        at(i, ...)          always checked, throws std::out_of_range
+        operator[](i, ...)  checked only in a debug or hardened build,
+                            unchecked otherwise
+        eval(i, ...), data()
+                            never checked (what the expression templates
+                            and the kernels use)
+
+    Compile with -DMYMATH_BOUNDS_CHECK (or with -D_GLIBCXX_ASSERTIONS, which
+    hardens the standard containers the same way) to make operator[] check
+    its indices like at(). Either way, an index out of bounds of a
+    fixed-size class in a constant expression does not compile.
+*/
+
+#include <cstddef>
+#include <stdexcept>
+
+namespace bounds{
+
+    #if defined(MYMATH_BOUNDS_CHECK) || defined(_GLIBCXX_ASSERTIONS)
+    inline constexpr bool checked = true;
+    #else
+    inline constexpr bool checked = false;
+    #endif
+
+    // Throws unless index < extent, for at()
+    constexpr void check(size_t index, size_t extent){
+        if (index >= extent) throw std::out_of_range("Index out of bounds");
+    }
+
+    // Same check for operator[], compiled out unless bounds are checked
+    constexpr void debugCheck([[maybe_unused]] size_t index, [[maybe_unused]] size_t extent){
+        if constexpr (checked){
+            check(index, extent);
+        }
+    }
+
+}
+
+#endif
@@ -0,0 +1,231 @@
+#ifndef _COMPARE_H_
+#define _COMPARE_H_
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include "Simd.h"
+#include "Expression.h"
+
+/*
+    Equality of values, arrays and whole vectors or matrices, exact for
+    integers and within a tolerance for floating point values, under one of
+    the policies:
+
+        compare::Absolute {1e-6}    |x - y| <= 1e-6 (the default, used by
+                                    the == operators of every class)
+        compare::Relative {1e-9}    |x - y| <= 1e-9 * max(|x|, |y|)
+        compare::Ulp {4}            at most 4 representable values apart
+
+    as in
+
+        compare::equal(x, y);                       // two values
+        compare::equal(p, q, n, compare::Ulp{});    // two arrays of n values
+        compare::equal(a, b.view().transpose(), compare::Relative{1e-12});
+
+    Equal values (infinities included) always compare equal, and a NaN
+    never does. Arrays, and vectors or matrices stored contiguously, are
+    compared as a whole, stopping at the first mismatch: with SIMD for
+    float and double under the absolute and relative policies, as memory
+    for integers. The 16-bit formats of Numeric.h are compared as floats,
+    or by their own representable values under compare::Ulp.
+*/
+
+namespace compare{
+
+    // |x - y| <= tolerance
+    struct Absolute{
+        double tolerance {0.000001};
+    };
+
+    // |x - y| <= tolerance * max(|x|, |y|)
+    struct Relative{
+        double tolerance {0.000001};
+    };
+
+    // x and y at most tolerance representable values apart (float, double or
+    // a 16-bit format)
+    struct Ulp{
+        std::uint64_t tolerance {4};
+    };
+
+    template<typename P>
+    concept Policy = (
+        std::same_as<P, Absolute> or std::same_as<P, Relative> or std::same_as<P, Ulp>
+    );
+
+    // Policy of the == operators
+    using Default = Absolute;
+
+    namespace detail{
+
+        template<typename T>
+        constexpr T magnitude(T x){
+            return x < T{} ? -x : x;
+        }
+
+        // Integer of the same order as the floating point value x, in which
+        // consecutive values differ by one (and -0 is 0)
+        template<std::floating_point T>
+        constexpr auto ordered(T x){
+
+            static_assert(
+                sizeof(T) == 4 or sizeof(T) == 8, "ULP comparison needs float or double"
+            );
+
+            using I = std::conditional_t<sizeof(T) == 4, std::int32_t, std::int64_t>;
+
+            const I bits {std::bit_cast<I>(x)};
+
+            return bits < 0 ? static_cast<I>(std::numeric_limits<I>::min() - bits) : bits;
+        }
+
+        template<numeric::Reduced T>
+        constexpr std::int16_t ordered(T x){
+
+            using I = std::int16_t;
+
+            const I bits {std::bit_cast<I>(x)};
+
+            return bits < 0 ? static_cast<I>(std::numeric_limits<I>::min() - bits) : bits;
+        }
+
+    }
+
+    // Whether x and y are equal: exactly for integers, under policy for
+    // floating point values
+    template<typename T, Policy P = Default>
+        requires numeric::Element<T>
+    constexpr bool equal(T x, T y, P policy = {}){
+
+        if constexpr (std::integral<T>){
+
+            return x == y;
+
+        } else {
+
+            if (x == y){
+                return true;
+            }
+
+            if constexpr (numeric::Reduced<T> and not std::same_as<P, Ulp>){
+
+                return equal(static_cast<float>(x), static_cast<float>(y), policy);
+
+            } else if constexpr (std::same_as<P, Absolute>){
+
+                return detail::magnitude(x - y) <= static_cast<T>(policy.tolerance);
+
+            } else if constexpr (std::same_as<P, Relative>){
+
+                const T scale {std::max(detail::magnitude(x), detail::magnitude(y))};
+                return detail::magnitude(x - y) <= static_cast<T>(policy.tolerance) * scale;
+
+            } else {
+
+                if (x != x or y != y){
+                    return false;
+                }
+
+                const auto a {detail::ordered(x)}, b {detail::ordered(y)};
+                using U = std::make_unsigned_t<decltype(a)>;
+                const U distance {
+                    a < b ? static_cast<U>(static_cast<U>(b) - static_cast<U>(a))
+                          : static_cast<U>(static_cast<U>(a) - static_cast<U>(b))
+                };
+
+                return distance <= policy.tolerance;
+            }
+        }
+    }
+
+    // Whether x[i] and y[i] are equal for every i < n, stopping at the first
+    // pair that is not
+    template<typename T, Policy P = Default>
+        requires numeric::Element<T>
+    constexpr bool equal(const T* x, const T* y, size_t n, P policy = {}){
+
+        if constexpr (std::integral<T>){
+
+            return std::equal(x, x + n, y);
+
+        } else {
+
+            size_t i{};
+
+            if constexpr (simd::Accelerated<T> and not std::same_as<P, Ulp>){
+                if !consteval {
+                    if (n >= simd::minLength){
+                        const T tolerance {static_cast<T>(policy.tolerance)};
+                        i = std::same_as<P, Absolute>
+                            ? simd::close(x, y, n, tolerance, T{})
+                            : simd::close(x, y, n, T{}, tolerance);
+                    }
+                }
+            }
+
+            for (; i<n; ++i){
+                if (not equal(x[i], y[i], policy)){
+                    return false;
+                }
+            }
+
+            return true;
+        }
+    }
+
+    // Whether two vectors, matrices or views of the same shape are equal
+    // element by element (as whole arrays if both are contiguous)
+    template<expr::Stored A, expr::Stored B, Policy P = Default>
+        requires expr::SameValueType<A, B>
+    constexpr bool equal(const A& a, const B& b, P policy = {}){
+
+        const auto extent {a.shape()};
+
+        if constexpr (std::tuple_size_v<decltype(extent)> != std::tuple_size_v<decltype(b.shape())>){
+            return false;
+        } else {
+
+            if (extent != b.shape()){
+                return false;
+            }
+
+            const auto rowMajor = [&](const auto& stride){
+                if constexpr (std::tuple_size_v<decltype(extent)> == 1){
+                    return stride[0] == 1;
+                } else {
+                    return stride[1] == 1 and stride[0] == extent[1];
+                }
+            };
+
+            if (rowMajor(a.strides()) and rowMajor(b.strides())){
+                size_t count {1};
+                for (size_t e : extent){
+                    count *= e;
+                }
+                return equal(a.data(), b.data(), count, policy);
+            }
+
+            if constexpr (std::tuple_size_v<decltype(extent)> == 1){
+                for (size_t i{}; i<extent[0]; ++i){
+                    if (not equal(a.eval(i), b.eval(i), policy)) return false;
+                }
+            } else {
+                for (size_t i{}; i<extent[0]; ++i){
+                    for (size_t j{}; j<extent[1]; ++j){
+                        if (not equal(a.eval(i, j), b.eval(i, j), policy)) return false;
+                    }
+                }
+            }
+
+            return true;
+        }
+    }
+
+}
+
+#endif
@@ -0,0 +1,473 @@
+#ifndef _DYN_MATRIX_H_
+#define _DYN_MATRIX_H_
+
+#include <initializer_list>
+#include <iostream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "Compare.h"
+#include "Trace.h"
+#include "Bounds.h"
+#include "Expression.h"
+#include "AlignedBuffer.h"
+#include "ThreadPool.h"
+#include "Blas.h"
+#include "Matrix.h"
+#include "DynVector.h"
+#include "View.h"
+
+/*
+    Matrix whose dimensions are chosen at run time, stored row by row in a
+    64-byte aligned heap buffer (so moves only move a pointer), allocated
+    from the thread's current memory resource or the one given to the
+    constructor (Memory.h).
+
+    DynMatrix takes part in the expression templates like Matrix does, and
+    can be mixed with a Matrix of the same value type, the result being a
+    DynMatrix. Products accept any combination of fixed-size and dynamic
+    operands; their dimensions are checked at run time and a mismatch
+    throws std::invalid_argument. Products are evaluated by gemm() and
+    gemv() (Blas.h), which can also be called directly to write into an
+    existing matrix or vector.
+*/
+
+template<typename T>
+class DynMatrix : private trace::Traced<trace::Type::DynMatrix>{
+
+    static_assert(
+        numeric::Element<T>,
+        "DynMatrix class can only store integral or floating point values"
+    );
+
+    friend std::ostream& operator<<(std::ostream& os, const DynMatrix& matrix){
+        for (size_t i{}; i < matrix.rowCount; ++i){
+            for (size_t j{}; j < matrix.columnCount; ++j){
+                os << matrix.eval(i, j) << " ";
+            }
+            if (i + 1 != matrix.rowCount) {os << std::endl;}
+        }
+        return os;
+    }
+
+    template<typename Destination> friend class expr::NoAlias;
+
+    private:
+
+        size_t rowCount;
+        size_t columnCount;
+        AlignedBuffer<T> element;   // heap buffer to store matrix elements, row by row
+
+        // Evaluates an expression element by element into this matrix, in a
+        // single pass over the rows and without temporaries (a product is
+        // written as a whole by gemm()). Assignment takes the dimensions of
+        // the expression, the compound operations require them to match.
+        template<typename Op, typename E>
+        void evaluate(const E& expression){
+
+            const auto [rows, columns] = expression.shape();
+
+            if constexpr (std::same_as<Op, expr::Assign>){
+                if (rows != rowCount or columns != columnCount){
+                    // Into new elements, swapped in once the expression
+                    // (which may read the current ones) has been evaluated
+                    DynMatrix result(rows, columns, resource());
+                    result.evaluate<Op>(expression);
+                    element.swap(result.element);
+                    rowCount = rows;
+                    columnCount = columns;
+                    return;
+                }
+            } else {
+                checkShape(rows, columns);
+            }
+
+            if constexpr (expr::Evaluable<E>){
+
+                expression.template evaluateInto<Op>(*this);
+
+            } else if (expr::aliases(expression, *this)){
+
+                evaluate<Op>(typename E::result_type{expression});
+
+            } else {
+
+                T* p {data()};
+
+                parallel::forBlocks(rows, columns, 1, [&](size_t begin, size_t end){
+                    for (size_t i{begin}; i<end; ++i){
+                        for (size_t j{}; j<columns; ++j){
+                            Op::apply(p[i*columns + j], expression.eval(i, j));
+                        }
+                    }
+                });
+            }
+        }
+
+        void reshape(size_t rows, size_t columns){
+            element.reset(rows * columns);
+            rowCount = rows;
+            columnCount = columns;
+        }
+
+        void checkShape(size_t rows, size_t columns) const {
+            if (rows != rowCount or columns != columnCount){
+                throw std::invalid_argument("Matrix dimensions do not match");
+            }
+        }
+
+    public:
+
+    /******** Constructors - Assignment Operators - Destructor ***************/
+
+    // Default Constructor (empty matrix)
+    DynMatrix() noexcept : rowCount{0}, columnCount{0}, element{} {}
+
+    // Size Constructor (zero-initialized elements)
+    DynMatrix(size_t rows, size_t columns)
+    : rowCount{rows}, columnCount{columns}, element{rows * columns} {}
+
+    // Size Constructor allocating from resource (see Memory.h)
+    DynMatrix(size_t rows, size_t columns, std::pmr::memory_resource* resource)
+    : rowCount{rows}, columnCount{columns}, element{rows * columns, resource} {}
+
+    // Initializer List Constructor, one nested list per row
+    DynMatrix(std::initializer_list<std::initializer_list<T>> rows)
+    : rowCount{rows.size()},
+      columnCount{rows.size() == 0 ? 0 : rows.begin()->size()},
+      element{rowCount * columnCount} {
+
+        T* p {data()};
+
+        for (const auto& row : rows){
+
+            if (row.size() != columnCount){
+                throw std::invalid_argument("Each Row provided must have the same number of elements");
+            }
+
+            p = std::copy(row.begin(), row.end(), p);
+        }
+    }
+
+    // Converting Constructor from a fixed-size Matrix
+    template<size_t R, size_t C>
+    DynMatrix(const Matrix<T, R, C>& matrix)
+    : rowCount{R}, columnCount{C}, element{R * C} {
+        std::copy(matrix.data(), matrix.data() + R*C, data());
+    }
+
+    // Copy Constructor and Copy Assignment Operator (duplicate the buffer)
+    DynMatrix(const DynMatrix& source) = default;
+    DynMatrix& operator=(const DynMatrix& rhs) = default;
+
+    // Move Constructor (steals the buffer, leaving an empty 0 x 0 matrix)
+    DynMatrix(DynMatrix&& source) noexcept
+    : Traced{std::move(source)},
+      rowCount{std::exchange(source.rowCount, 0)},
+      columnCount{std::exchange(source.columnCount, 0)},
+      element{std::move(source.element)} {}
+
+    // Move Assignment Operator
+    DynMatrix& operator=(DynMatrix&& rhs) noexcept {
+        Traced::operator=(std::move(rhs));
+        rowCount = std::exchange(rhs.rowCount, 0);
+        columnCount = std::exchange(rhs.columnCount, 0);
+        element = std::move(rhs.element);
+        return *this;
+    }
+
+    // Expression Constructor (evaluates a whole expression in one pass)
+    template<expr::EvaluatesTo<DynMatrix> E>
+    DynMatrix(const E& expression): rowCount{0}, columnCount{0}, element{} {
+        evaluate<expr::Assign>(expression);
+    }
+
+    // Expression Assignment Operator
+    template<expr::EvaluatesTo<DynMatrix> E>
+    DynMatrix& operator=(const E& expression){
+        if constexpr (E::elementwise){
+            evaluate<expr::Assign>(expression);
+        } else {
+            *this = DynMatrix{expression};
+        }
+        return *this;
+    }
+
+    // Default destructor
+    ~DynMatrix() = default;
+
+    // Conversion to a fixed-size Matrix (throws if the dimensions differ)
+    template<size_t R, size_t C>
+    explicit operator Matrix<T, R, C>() const {
+        checkShape(R, C);
+        Matrix<T, R, C> matrix {};
+        std::copy(data(), data() + R*C, matrix.data());
+        return matrix;
+    }
+
+
+    /********************** Expression Interface **************************/
+
+    using result_type = DynMatrix;
+    using value_type = T;
+    static constexpr bool elementwise = true;
+
+    // Extents, as reported by every expression
+    std::array<size_t, 2> shape() const {
+        return {rowCount, columnCount};
+    }
+
+    // Distances between consecutive rows and between consecutive columns
+    std::array<size_t, 2> strides() const {
+        return {columnCount, 1};
+    }
+
+    // Unchecked element access used by expression evaluation
+    const T& eval(size_t rowIndex, size_t columnIndex) const {
+        return element.data()[rowIndex*columnCount + columnIndex];
+    }
+
+    // Assignment target that skips the aliasing safeguard of operator=
+    expr::NoAlias<DynMatrix> noalias(){
+        return expr::NoAlias<DynMatrix>{*this};
+    }
+
+    // Pointer to the rows()*columns() elements, stored contiguously row by
+    // row from a 64-byte aligned address
+    T* data() noexcept {
+        return element.data();
+    }
+
+    const T* data() const noexcept {
+        return element.data();
+    }
+
+    size_t rows() const noexcept {
+        return rowCount;
+    }
+
+    size_t columns() const noexcept {
+        return columnCount;
+    }
+
+    // Where the elements are allocated from
+    std::pmr::memory_resource* resource() const noexcept {
+        return element.resource();
+    }
+
+    // View of the whole matrix (view().transpose() for its transpose). The
+    // views below are not available on a temporary, which they would outlive
+    MatrixView<T> view() & noexcept {
+        return MatrixView<T>{data(), rowCount, columnCount};
+    }
+
+    MatrixView<const T> view() const& noexcept {
+        return MatrixView<const T>{data(), rowCount, columnCount};
+    }
+
+    MatrixView<const T> view() const&& = delete;
+
+    // View of the transpose, which moves nothing, and the transposition in
+    // place: cache-oblivious and without a buffer for a square matrix,
+    // through a new buffer (from the same resource) otherwise. Prefer
+    // transposeInPlace() to m = m.transpose(), which is correct but
+    // evaluates the overlapping view into a temporary first.
+    MatrixView<T> transpose() & noexcept {
+        return view().transpose();
+    }
+
+    MatrixView<const T> transpose() const& noexcept {
+        return view().transpose();
+    }
+
+    MatrixView<const T> transpose() const&& = delete;
+
+    void transposeInPlace(){
+
+        if (rowCount == columnCount){
+            kernel::transpose(rowCount, data(), columnCount);
+            return;
+        }
+
+        AlignedBuffer<T> transposed {rowCount * columnCount, element.resource()};
+
+        kernel::transpose(rowCount, columnCount, data(), columnCount, transposed.data(), rowCount);
+
+        element = std::move(transposed);
+        std::swap(rowCount, columnCount);
+    }
+
+    // Views of the i-th row, of the j-th column and of the rows x columns
+    // block whose top-left element is (i, j)
+    VectorView<T> row(size_t index) & {
+        return view().row(index);
+    }
+
+    VectorView<const T> row(size_t index) const& {
+        return view().row(index);
+    }
+
+    VectorView<const T> row(size_t index) const&& = delete;
+
+    VectorView<T> column(size_t index) & {
+        return view().column(index);
+    }
+
+    VectorView<const T> column(size_t index) const& {
+        return view().column(index);
+    }
+
+    VectorView<const T> column(size_t index) const&& = delete;
+
+    MatrixView<T> block(size_t i, size_t j, size_t rows, size_t columns) & {
+        return view().block(i, j, rows, columns);
+    }
+
+    MatrixView<const T> block(size_t i, size_t j, size_t rows, size_t columns) const& {
+        return view().block(i, j, rows, columns);
+    }
+
+    MatrixView<const T> block(size_t i, size_t j, size_t rows, size_t columns) const&& = delete;
+
+
+    /****************** Methods - Overloaded Operators ********************/
+
+    // Subscript or Array Index Operator (Const overload for read-only access),
+    // checked only when bounds are (see Bounds.h)
+    const T* operator[](size_t index) const {
+        /*
+            DynMatrix m;
+            m[i]; returns a pointer to the i-th row
+            m[i][j]; returns the element of i-th row and j-th column
+            (only the row index can be checked, use m[i, j] or m.at(i, j)
+            to check both) */
+
+        bounds::debugCheck(index, rowCount);
+
+        return data() + index*columnCount;
+    }
+
+    // Subscript or Array Index Operator (Non-const overload for read/write access)
+    T* operator[](size_t index) {
+        bounds::debugCheck(index, rowCount);
+        return data() + index*columnCount;
+    }
+
+    // Subscript or Array Index Operator (Const overload for read-only access)
+    const T& operator[](size_t rowIndex, size_t columnIndex) const {
+        bounds::debugCheck(rowIndex, rowCount);
+        bounds::debugCheck(columnIndex, columnCount);
+        return data()[rowIndex*columnCount + columnIndex];
+    }
+
+    // Subscript or Array Index Operator (Non-const overload for read/write access)
+    T& operator[](size_t rowIndex, size_t columnIndex) {
+        bounds::debugCheck(rowIndex, rowCount);
+        bounds::debugCheck(columnIndex, columnCount);
+        return data()[rowIndex*columnCount + columnIndex];
+    }
+
+    // Checked element access
+    const T& at(size_t rowIndex, size_t columnIndex) const {
+        bounds::check(rowIndex, rowCount);
+        bounds::check(columnIndex, columnCount);
+        return data()[rowIndex*columnCount + columnIndex];
+    }
+
+    T& at(size_t rowIndex, size_t columnIndex) {
+        bounds::check(rowIndex, rowCount);
+        bounds::check(columnIndex, columnCount);
+        return data()[rowIndex*columnCount + columnIndex];
+    }
+
+    // Resizes to rows x columns zero-initialized elements, discarding the
+    // current ones
+    void resize(size_t rows, size_t columns){
+        reshape(rows, columns);
+    }
+
+
+    // Equal-to Operator (==)
+    bool operator==(const DynMatrix& rhs) const {
+
+        if (rowCount != rhs.rowCount or columnCount != rhs.columnCount){
+            return false;
+        }
+
+        return compare::equal(data(), rhs.data(), rowCount*columnCount);
+    }
+
+    // Not-Equal-to Operator (!=)
+    bool operator!=(const DynMatrix& rhs) const {
+        return !(*this == rhs);
+    }
+
+    // Compound Assignment Operator (+=)
+    template<expr::Expression E>
+        requires expr::Compatible<DynMatrix, E>
+    void operator+=(const E& rhs) {
+        if constexpr (E::elementwise){
+            evaluate<expr::AddAssign>(rhs);
+        } else {
+            evaluate<expr::AddAssign>(typename E::result_type{rhs});
+        }
+    }
+
+    // Compound Assignment Operator (-=)
+    template<expr::Expression E>
+        requires expr::Compatible<DynMatrix, E>
+    void operator-=(const E& rhs) {
+        if constexpr (E::elementwise){
+            evaluate<expr::SubtractAssign>(rhs);
+        } else {
+            evaluate<expr::SubtractAssign>(typename E::result_type{rhs});
+        }
+    }
+
+    // Matrix Multiplication Operators
+    // Return product nodes, evaluated by gemm() straight into the matrix
+    // they are assigned to; the inner dimensions are checked at once
+    expr::Product<DynMatrix, DynMatrix, DynMatrix>
+    operator*(const DynMatrix& rhs) const {
+        return {*this, rhs};
+    }
+
+    template<size_t R, size_t C>
+    expr::Product<DynMatrix, Matrix<T, R, C>, DynMatrix>
+    operator*(const Matrix<T, R, C>& rhs) const {
+        return {*this, rhs};
+    }
+
+    template<size_t R, size_t C>
+    friend expr::Product<Matrix<T, R, C>, DynMatrix, DynMatrix>
+    operator*(const Matrix<T, R, C>& lhs, const DynMatrix& rhs){
+        return {lhs, rhs};
+    }
+
+    // Matrix-Vector Multiplication Operators (evaluated by gemv())
+    expr::Product<DynMatrix, DynVector<T>, DynVector<T>>
+    operator*(const DynVector<T>& rhsVector) const {
+        return {*this, rhsVector};
+    }
+
+    template<size_t N>
+    expr::Product<DynMatrix, Vector<T, N>, DynVector<T>>
+    operator*(const Vector<T, N>& rhsVector) const {
+        return {*this, rhsVector};
+    }
+
+};
+
+
+// Fixed-size Matrix times DynVector: the result dimension is known at
+// compile time, the inner one is checked at run time
+template<typename T, size_t R, size_t C>
+expr::Product<Matrix<T, R, C>, DynVector<T>, Vector<T, R>>
+operator*(const Matrix<T, R, C>& lhs, const DynVector<T>& rhsVector){
+    return {lhs, rhsVector};
+}
+
+static_assert(std::is_nothrow_move_constructible_v<DynMatrix<double>>);
+static_assert(std::is_nothrow_move_assignable_v<DynMatrix<double>>);
+
+#endif
@@ -0,0 +1,382 @@
+#ifndef _DYN_VECTOR_H_
+#define _DYN_VECTOR_H_
+
+#include <initializer_list>
+#include <iostream>
+#include <stdexcept>
+#include <type_traits>
+#include "Compare.h"
+#include "Trace.h"
+#include "Bounds.h"
+#include "Expression.h"
+#include "Simd.h"
+#include "AlignedBuffer.h"
+#include "ThreadPool.h"
+#include "Blas.h"
+#include "Vector.h"
+#include "View.h"
+
+/*
+    Vector whose dimension is chosen at run time, for problems too large to
+    live on the stack or whose size is only known once the program runs.
+
+    The components live in a 64-byte aligned heap buffer, so moving a
+    DynVector only moves a pointer. The buffer comes from the thread's
+    current memory resource, or the one given to the constructor
+    (Memory.h). DynVector takes part in the expression templates like
+    Vector does, and can be mixed with a Vector of the same value type: the
+    result of such an expression is a DynVector, and its dimensions are
+    checked at run time (std::invalid_argument on mismatch).
+*/
+
+template<typename T>
+class DynVector : private trace::Traced<trace::Type::DynVector>{
+
+    static_assert(
+        numeric::Element<T>,
+        "DynVector class can only store integral or floating point values"
+    );
+
+    friend std::ostream& operator<<(std::ostream& os, const DynVector& vector){
+        os << "[ ";
+        for (size_t i{}; i<vector.size(); ++i){
+            os << vector.component.data()[i] << " ";
+        }
+        os << "]";
+        return os;
+    }
+
+    template<typename Destination> friend class expr::NoAlias;
+
+private:
+
+    AlignedBuffer<T> component; // heap buffer to store vector components
+
+    // Evaluates an expression element by element into this vector, in a
+    // single loop and without temporaries (a product is written as a whole
+    // by gemv()). Assignment takes the dimension of the expression, the
+    // compound operations require it to match.
+    template<typename Op, typename E>
+    void evaluate(const E& expression){
+
+        const size_t n {expression.shape()[0]};
+
+        if constexpr (std::same_as<Op, expr::Assign>){
+            if (n != size()){
+                // Into new components, swapped in once the expression (which
+                // may read the current ones) has been evaluated
+                DynVector result(n, resource());
+                result.evaluate<Op>(expression);
+                component.swap(result.component);
+                return;
+            }
+        } else {
+            checkSize(n);
+        }
+
+        if constexpr (expr::Evaluable<E>){
+
+            expression.template evaluateInto<Op>(*this);
+
+        } else if (expr::aliases(expression, *this)){
+
+            evaluate<Op>(typename E::result_type{expression});
+
+        } else {
+
+            T* p {data()};
+
+            parallel::forBlocks(n, 1, 1, [&](size_t begin, size_t end){
+                for (size_t i{begin}; i<end; ++i){
+                    Op::apply(p[i], expression.eval(i));
+                }
+            });
+        }
+    }
+
+    void checkSize(size_t n) const {
+        if (n != size()) throw std::invalid_argument("Vector dimensions do not match");
+    }
+
+    bool useSimd() const {
+        return simd::Accelerated<T> and size() >= simd::minLength;
+    }
+
+    // Dot product with size() contiguous components (accumulated in float
+    // for the 16-bit formats)
+    T dotProduct(const T* rhs) const {
+
+        using A = numeric::accumulator_t<T>;
+
+        const T* p {data()};
+        const bool vectorized {simd::Vectorized<T> and size() >= simd::minLength};
+
+        return static_cast<T>(parallel::sum<A>(size(), 1, [&](size_t begin, size_t end) -> A {
+
+            if constexpr (simd::Vectorized<T>){
+                if (vectorized){
+                    return simd::dot(p + begin, rhs + begin, end - begin);
+                }
+            }
+
+            A result {};
+
+            for (size_t i{begin}; i<end; ++i){
+                result += static_cast<A>(p[i]) * static_cast<A>(rhs[i]);
+            }
+
+            return result;
+        }));
+    }
+
+public:
+
+    /******** Constructors - Assignment Operators - Destructor ***************/
+
+    // Default Constructor (empty vector)
+    DynVector() noexcept : component{} {}
+
+    // Size Constructor (zero-initialized components)
+    explicit DynVector(size_t n): component{n} {}
+
+    // Size Constructor allocating from resource (see Memory.h)
+    DynVector(size_t n, std::pmr::memory_resource* resource): component{n, resource} {}
+
+    // Initializer List Constructor
+    DynVector(std::initializer_list<T> values): component{values.size()} {
+        std::copy(values.begin(), values.end(), data());
+    }
+
+    // Converting Constructor from a fixed-size Vector
+    template<size_t N>
+    DynVector(const Vector<T, N>& vector): component{N} {
+        std::copy(vector.data(), vector.data() + N, data());
+    }
+
+    // Copy and Move Constructors, Copy and Move Assignment Operators
+    // Defaulted: copies duplicate the buffer, moves steal it (noexcept)
+    DynVector(const DynVector& source) = default;
+    DynVector(DynVector&& source) noexcept = default;
+    DynVector& operator=(const DynVector& rhs) = default;
+    DynVector& operator=(DynVector&& rhs) noexcept = default;
+
+    // Expression Constructor (evaluates a whole expression in one pass)
+    template<expr::EvaluatesTo<DynVector> E>
+    DynVector(const E& expression): component{} {
+        evaluate<expr::Assign>(expression);
+    }
+
+    // Expression Assignment Operator
+    template<expr::EvaluatesTo<DynVector> E>
+    DynVector& operator=(const E& expression){
+        if constexpr (E::elementwise){
+            evaluate<expr::Assign>(expression);
+        } else {
+            *this = DynVector{expression};
+        }
+        return *this;
+    }
+
+    // Default destructor
+    ~DynVector() = default;
+
+    // Conversion to a fixed-size Vector (throws if the dimensions differ)
+    template<size_t N>
+    explicit operator Vector<T, N>() const {
+        checkSize(N);
+        Vector<T, N> vector {};
+        std::copy(data(), data() + N, vector.data());
+        return vector;
+    }
+
+
+    /********************** Expression Interface **************************/
+
+    using result_type = DynVector;
+    using value_type = T;
+    static constexpr bool elementwise = true;
+
+    // Extents, as reported by every expression
+    std::array<size_t, 1> shape() const {
+        return {size()};
+    }
+
+    // Distance between consecutive components
+    static constexpr std::array<size_t, 1> strides(){
+        return {1};
+    }
+
+    // Unchecked element access used by expression evaluation
+    const T& eval(size_t index) const {
+        return component.data()[index];
+    }
+
+    // Assignment target that skips the aliasing safeguard of operator=
+    expr::NoAlias<DynVector> noalias(){
+        return expr::NoAlias<DynVector>{*this};
+    }
+
+    // Pointer to the size() contiguous, 64-byte aligned components
+    T* data() noexcept {
+        return component.data();
+    }
+
+    const T* data() const noexcept {
+        return component.data();
+    }
+
+    size_t size() const noexcept {
+        return component.size();
+    }
+
+    // Where the components are allocated from
+    std::pmr::memory_resource* resource() const noexcept {
+        return component.resource();
+    }
+
+    // View of the whole vector. The views below are not available on a
+    // temporary, which they would outlive
+    VectorView<T> view() & noexcept {
+        return VectorView<T>{data(), size()};
+    }
+
+    VectorView<const T> view() const& noexcept {
+        return VectorView<const T>{data(), size()};
+    }
+
+    VectorView<const T> view() const&& = delete;
+
+    // View of the n components from begin
+    VectorView<T> segment(size_t begin, size_t n) & {
+        return view().segment(begin, n);
+    }
+
+    VectorView<const T> segment(size_t begin, size_t n) const& {
+        return view().segment(begin, n);
+    }
+
+    VectorView<const T> segment(size_t begin, size_t n) const&& = delete;
+
+
+    /****************** Methods - Overloaded Operators ********************/
+
+    // Subscript or Array Index Operator (Const overload for read-only access),
+    // checked only when bounds are (see Bounds.h)
+    const T& operator[](size_t index) const {
+        bounds::debugCheck(index, size());
+        return data()[index];
+    }
+
+    // Subscript or Array Index Operator (Non-const overload for read/write access)
+    T& operator[](size_t index) {
+        bounds::debugCheck(index, size());
+        return data()[index];
+    }
+
+    // Checked element access
+    const T& at(size_t index) const {
+        bounds::check(index, size());
+        return data()[index];
+    }
+
+    T& at(size_t index) {
+        bounds::check(index, size());
+        return data()[index];
+    }
+
+    // Resizes to n zero-initialized components, discarding the current ones
+    void resize(size_t n){
+        component.reset(n);
+    }
+
+
+    // Equal-to Operator (==)
+    bool operator==(const DynVector& rhs) const {
+
+        if (size() != rhs.size()){
+            return false;
+        }
+
+        return compare::equal(data(), rhs.data(), size());
+    }
+
+    // Not-Equal-to Operator (!=)
+    bool operator!=(const DynVector& rhs) const {
+        return !(*this == rhs);
+    }
+
+    // Compound Assignment Operator (+=)
+    template<expr::Expression E>
+        requires expr::Compatible<DynVector, E>
+    void operator+=(const E& rhs) {
+        if constexpr (std::same_as<E, DynVector> and simd::Accelerated<T>){
+            checkSize(rhs.size());
+            if (useSimd()){
+                T* p {data()};
+                const T* q {rhs.data()};
+                parallel::forBlocks(size(), 1, 1, [&](size_t begin, size_t end){
+                    simd::axpy(end - begin, T{1}, q + begin, p + begin);
+                });
+                return;
+            }
+        }
+
+        if constexpr (E::elementwise){
+            evaluate<expr::AddAssign>(rhs);
+        } else {
+            evaluate<expr::AddAssign>(typename E::result_type{rhs});
+        }
+    }
+
+    // Compound Assignment Operator (-=)
+    template<expr::Expression E>
+        requires expr::Compatible<DynVector, E>
+    void operator-=(const E& rhs) {
+        if constexpr (E::elementwise){
+            evaluate<expr::SubtractAssign>(rhs);
+        } else {
+            evaluate<expr::SubtractAssign>(typename E::result_type{rhs});
+        }
+    }
+
+    void operator *=(const T& scalar) {
+        T* p {data()};
+        for (size_t i{}; i<size(); ++i){
+            p[i] *= scalar;
+        }
+    }
+
+    // Dot Product Method
+    T dot(const DynVector& rhs) const {
+        checkSize(rhs.size());
+        return dotProduct(rhs.data());
+    }
+
+    template<size_t N>
+    T dot(const Vector<T, N>& rhs) const {
+        checkSize(N);
+        return dotProduct(rhs.data());
+    }
+
+    T operator*(const DynVector& rhs) const {
+        return (*this).dot(rhs);
+    }
+
+    template<size_t N>
+    T operator*(const Vector<T, N>& rhs) const {
+        return (*this).dot(rhs);
+    }
+
+};
+
+
+// Dot product of a fixed-size Vector with a DynVector
+template<typename T, size_t N>
+T operator*(const Vector<T, N>& lhs, const DynVector<T>& rhs){
+    return rhs.dot(lhs);
+}
+
+static_assert(std::is_nothrow_move_constructible_v<DynVector<double>>);
+static_assert(std::is_nothrow_move_assignable_v<DynVector<double>>);
+
+#endif
@@ -0,0 +1,757 @@
+#ifndef _EXPRESSION_H_
+#define _EXPRESSION_H_
+
+#include <array>
+#include <concepts>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "Numeric.h"
+
+/*
+    Expression templates for element-wise arithmetic.
+
+    operator+, operator- and scalar operator* on Vector, Matrix and Tensor
+    (and on the expressions built from them) compute nothing: they return a
+    lightweight node that records the operation and refers to its operands.
+    The whole tree is evaluated element by element, in one fused loop, when
+    it is assigned to (or used to construct) a Vector, Matrix or Tensor:
+
+        Vector<double, 1000> r = a + b * 2.0 - c;  // one pass, no temporaries
+
+    Nodes hold their Vector/Matrix/Tensor operands by reference, so an
+    expression must not outlive the objects it refers to. Do not keep one
+    in an auto variable; assign it to a concrete type instead.
+
+    Element-wise expressions may safely read their own destination, as in
+    a = a + b, since every element is read before it is written. One that
+    reads it through a view laid out differently (a = a.view().transpose(),
+    v = v.segment(1, 2)) is evaluated into a temporary first, see aliases().
+    Any expression that is not element-wise is evaluated into a temporary
+    before it is assigned, unless the destination is wrapped with noalias():
+
+        c.noalias() = expression;   // promise: c is not read by expression
+
+    Products (matrix-matrix, matrix-vector) are expressions too, but not
+    element-wise ones: a Product node is evaluated as a whole, straight into
+    its destination, by the BLAS-style gemm() / gemv() of Blas.h. Hence
+
+        c.noalias() = a * b;        // gemm into c, no temporary
+        c.noalias() += a * b;       // gemm accumulating into c
+
+    while a product that appears inside a larger expression is evaluated
+    once, into a temporary held by that expression.
+
+    Every expression also reports its shape() (a std::array of extents).
+    For the fixed-size classes it is a compile-time constant; an expression
+    involving a DynVector or DynMatrix checks at construction that its
+    operands agree and throws std::invalid_argument otherwise. A fixed-size
+    operand may be mixed with a dynamic one of the same rank, the result
+    being dynamic (see Common).
+
+    Operands of different element types may be added, subtracted and
+    multiplied too, the result holding the promoted type (see Numeric.h):
+
+        Vector<double, 3> r = f + d;    // f of floats, d of doubles
+
+    but an expression is only assigned to an object of its own element
+    type; convert<U>(expression) converts the elements explicitly:
+
+        Matrix<numeric::bfloat16, 64, 64> h = convert<numeric::bfloat16>(m);
+
+    The views of View.h (rows, columns, blocks and transposes of existing
+    objects) are expressions of run-time shape as well. They can be read
+    from and assigned to like the concrete classes, and are multiplied by
+    the same gemm() / gemv(), straight from the viewed elements.
+*/
+
+namespace expr{
+
+    // Element-wise operations
+    struct Add{
+        template<typename A, typename B>
+        static constexpr auto apply(const A& a, const B& b){ return a + b; }
+    };
+
+    struct Subtract{
+        template<typename A, typename B>
+        static constexpr auto apply(const A& a, const B& b){ return a - b; }
+    };
+
+    struct Multiply{
+        template<typename A, typename B>
+        static constexpr auto apply(const A& a, const B& b){ return a * b; }
+    };
+
+    // Ways of storing an evaluated element into its destination
+    struct Assign{
+        template<typename D, typename S>
+        static constexpr void apply(D& d, const S& s){ d = s; }
+    };
+
+    struct AddAssign{
+        template<typename D, typename S>
+        static constexpr void apply(D& d, const S& s){ d += s; }
+    };
+
+    struct SubtractAssign{
+        template<typename D, typename S>
+        static constexpr void apply(D& d, const S& s){ d -= s; }
+    };
+
+
+    // An expression knows the concrete type it evaluates to (result_type)
+    // and yields its elements through eval(index...)
+    template<typename E>
+    concept Expression = requires {
+        typename E::result_type;
+        typename E::value_type;
+        { E::elementwise } -> std::convertible_to<bool>;
+    };
+
+    // A terminal is a concrete Vector, Matrix or Tensor
+    template<typename E>
+    concept Terminal = Expression<E> && std::same_as<E, typename E::result_type>;
+
+    // An expression node (not a terminal) that evaluates to Result
+    template<typename E, typename Result>
+    concept EvaluatesTo = (
+        Expression<E> && not Terminal<E>
+        && std::same_as<typename E::result_type, Result>
+    );
+
+    // Result type of an element-wise operation between expressions that
+    // evaluate to A and B. Only defined when they can be combined: for equal
+    // types, for a fixed-size class with its dynamic counterpart (the
+    // specializations live in View.h, since views evaluate to DynVector and
+    // DynMatrix), and for tensors whose shapes broadcast (Tensor.h).
+    template<typename A, typename B>
+    struct Common{};
+
+    template<typename A>
+    struct Common<A, A>{
+        using type = A;
+    };
+
+    template<typename L, typename R>
+    concept Compatible = (
+        Expression<L> && Expression<R>
+        && requires {
+            typename Common<typename L::result_type, typename R::result_type>::type;
+        }
+    );
+
+    // Result type R with elements of type U instead (Vector<T, N> becomes
+    // Vector<U, N>, DynMatrix<T> becomes DynMatrix<U>, ...)
+    template<typename R, typename U>
+    struct Rebind{};
+
+    template<template<typename, size_t...> class Class, typename T, size_t... N, typename U>
+    struct Rebind<Class<T, N...>, U>{
+        using type = Class<U, N...>;
+    };
+
+    template<template<typename> class Class, typename T, typename U>
+    struct Rebind<Class<T>, U>{
+        using type = Class<U>;
+    };
+
+    template<typename R, typename U>
+    using Rebound = typename Rebind<R, U>::type;
+
+    // Element type of an operation between L and R
+    template<typename L, typename R>
+    using Promoted = numeric::promote_t<typename L::value_type, typename R::value_type>;
+
+    // Expressions that can be combined element-wise, whatever their element
+    // types: their result types, holding the promoted type, have a Common one
+    template<typename L, typename R>
+    concept Combinable = (
+        Expression<L> && Expression<R>
+        && requires {
+            typename Common<
+                Rebound<typename L::result_type, Promoted<L, R>>,
+                Rebound<typename R::result_type, Promoted<L, R>>
+            >::type;
+        }
+    );
+
+    // Expressions whose shape is a compile-time constant (the fixed-size
+    // classes, and the expressions built from them only)
+    template<typename E>
+    concept FixedShape = requires {
+        std::integral_constant<size_t, E::result_type::shape()[0]>{};
+    };
+
+    // Expressions whose elements are stored in memory, element (i, j) of a
+    // rank 2 one being data()[i*strides()[0] + j*strides()[1]]: the
+    // concrete classes (which are contiguous) and the views of View.h
+    template<typename E, size_t Rank>
+    concept Strided = (
+        Expression<E>
+        && requires(const E& e){
+            { e.data() } -> std::convertible_to<const typename E::value_type*>;
+            { e.strides() } -> std::same_as<std::array<size_t, Rank>>;
+        }
+    );
+
+    template<typename E>
+    concept Stored = Strided<E, 1> || Strided<E, 2>;
+
+    // Stored expressions whose elements can be written through data()
+    template<typename E>
+    concept Writable = (
+        Stored<E>
+        && requires(E& e){
+            { e.data() } -> std::same_as<typename E::value_type*>;
+        }
+    );
+
+    template<typename First, typename... Rest>
+    concept SameValueType = (
+        std::same_as<typename First::value_type, typename Rest::value_type> && ...
+    );
+
+    // Terminals are held by reference, element-wise nodes and views (which
+    // are small) by value, and other nodes (products) are evaluated into
+    // their result
+    template<typename E>
+    using Operand = std::conditional_t<
+        Terminal<E>, const E&,
+        std::conditional_t<E::elementwise, const E, const typename E::result_type>
+    >;
+
+    // Evaluates an expression node into its result type; anything else (a
+    // scalar, a terminal) is returned as it is
+    template<typename V>
+    constexpr auto concrete(const V& value){
+        if constexpr (Expression<V> and not Terminal<V>){
+            return typename V::result_type{value};
+        } else {
+            return value;
+        }
+    }
+
+
+    // Expressions stored in memory whatever their rank, with the data() and
+    // strides() of Strided (concrete classes, views and tensor views)
+    template<typename E>
+    concept Addressed = (
+        Expression<E>
+        && requires(const E& e){
+            { e.data() } -> std::convertible_to<const typename E::value_type*>;
+            { e.strides() } -> std::convertible_to<decltype(e.shape())>;
+        }
+    );
+
+    namespace detail{
+
+        // First byte of the elements of a stored expression and the byte
+        // past its last one (the same when it is empty)
+        template<Addressed E>
+        std::array<const unsigned char*, 2> footprint(const E& e){
+
+            const auto* first {reinterpret_cast<const unsigned char*>(e.data())};
+            const auto extent {e.shape()};
+            const auto step {e.strides()};
+
+            size_t last {};
+
+            for (size_t axis{}; axis<extent.size(); ++axis){
+                if (extent[axis] == 0){
+                    return {first, first};
+                }
+                last += (extent[axis] - 1) * step[axis];
+            }
+
+            return {first, first + (last + 1) * sizeof(typename E::value_type)};
+        }
+
+        // Whether the stored operand and destination share elements, other
+        // than through the same layout (the destination itself, in a = a + b)
+        template<Addressed S, Addressed D>
+        bool overlaps(const S& operand, const D& destination){
+
+            if constexpr (
+                sizeof(typename S::value_type) == sizeof(typename D::value_type)
+                and std::same_as<decltype(operand.shape()), decltype(destination.shape())>
+            ){
+                if (
+                    static_cast<const void*>(operand.data()) == static_cast<const void*>(destination.data())
+                    and operand.shape() == destination.shape()
+                    and operand.strides() == destination.strides()
+                ){
+                    return false;
+                }
+            }
+
+            const auto [first, end] = footprint(operand);
+            const auto [destinationFirst, destinationEnd] = footprint(destination);
+            const std::less<const unsigned char*> before {};
+
+            return before(first, destinationEnd) and before(destinationFirst, end);
+        }
+
+    }
+
+    // Whether evaluating an element-wise expression element by element into
+    // destination may read an element it has already written: whether one
+    // of its stored operands is a view, or is viewed by the destination,
+    // overlapping the destination's elements in another layout. Assignments
+    // then evaluate the expression into its result type first. Constant
+    // evaluation, where views of a Matrix are not usable, is not checked.
+    template<typename E, typename D>
+    constexpr bool aliases(const E& expression, const D& destination){
+
+        if constexpr (Terminal<E> and Terminal<D>){
+            // Distinct objects, or the same one
+            return false;
+        } else if constexpr (Addressed<E> and Addressed<D>){
+            if consteval {
+                return false;
+            } else {
+                return detail::overlaps(expression, destination);
+            }
+        } else if constexpr (requires { expression.aliases(destination); }){
+            return expression.aliases(destination);
+        } else {
+            return false;
+        }
+    }
+
+
+    // Expressions that can also be evaluated by position in row-major
+    // order, evalLinear(i), so that a whole tree over contiguous operands
+    // of the same shape is evaluated in one flat loop
+    template<typename E>
+    concept Linear = requires(const E& e, size_t i){
+        e.evalLinear(i);
+    };
+
+    namespace detail{
+
+        // Whether extents a and b can be broadcast against each other, as in
+        // NumPy: aligned on their last axis, each pair of extents is equal
+        // or one of them is 1 (and is then repeated along that axis)
+        template<size_t M, size_t N>
+        constexpr bool broadcastable(
+            const std::array<size_t, M>& a, const std::array<size_t, N>& b
+        ){
+            for (size_t i{}; i<M and i<N; ++i){
+
+                const size_t x {a[M - 1 - i]}, y {b[N - 1 - i]};
+
+                if (x != y and x != 1 and y != 1){
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        // Extents of the result of broadcasting a against b
+        template<size_t M, size_t N>
+        constexpr auto broadcast(
+            const std::array<size_t, M>& a, const std::array<size_t, N>& b
+        ){
+            std::array<size_t, (M > N ? M : N)> result {};
+
+            for (size_t i{}; i<result.size(); ++i){
+
+                const size_t x {i < M ? a[M - 1 - i] : 1};
+                const size_t y {i < N ? b[N - 1 - i] : 1};
+
+                result[result.size() - 1 - i] = x == 1 ? y : x;
+            }
+
+            return result;
+        }
+
+        // Element of a fixed-shape operand at an index of the (larger)
+        // shape it is broadcast to
+        template<typename E, typename... Index>
+        constexpr auto broadcastEval(const E& operand, Index... index){
+
+            constexpr auto extent {E::result_type::shape()};
+            constexpr size_t rank {extent.size()};
+            constexpr size_t offset {sizeof...(Index) - rank};
+
+            const std::array<size_t, sizeof...(Index)> full {
+                static_cast<size_t>(index)...
+            };
+
+            return [&]<size_t... I>(std::index_sequence<I...>){
+                return operand.eval((extent[I] == 1 ? size_t{0} : full[offset + I])...);
+            }(std::make_index_sequence<rank>{});
+        }
+
+    }
+
+
+    // Element-wise operation between two expressions of the same shape, or
+    // of fixed shapes that broadcast to a common one (see Common), computed
+    // in their promoted element type
+    template<typename Op, typename L, typename R>
+    class Binary{
+
+        public:
+
+            using value_type = Promoted<L, R>;
+            using result_type = typename Common<
+                Rebound<typename L::result_type, value_type>,
+                Rebound<typename R::result_type, value_type>
+            >::type;
+            static constexpr bool elementwise = (
+                std::remove_cvref_t<Operand<L>>::elementwise
+                && std::remove_cvref_t<Operand<R>>::elementwise
+            );
+
+        private:
+
+            Operand<L> lhs;
+            Operand<R> rhs;
+
+            static constexpr bool fixed = FixedShape<L> && FixedShape<R>;
+
+            // Whether operand E is broadcast to the shape of the result
+            template<typename E>
+            static constexpr bool broadcast = (
+                fixed && not std::same_as<Rebound<typename E::result_type, value_type>, result_type>
+            );
+
+            template<typename E, typename Stored, typename... Index>
+            static constexpr value_type at(const Stored& operand, Index... index){
+                if constexpr (broadcast<E>){
+                    return static_cast<value_type>(detail::broadcastEval(operand, index...));
+                } else {
+                    return static_cast<value_type>(operand.eval(index...));
+                }
+            }
+
+        public:
+
+            constexpr Binary(const L& lhs, const R& rhs): lhs{lhs}, rhs{rhs} {
+                if constexpr (not fixed){
+                    if (lhs.shape() != rhs.shape()){
+                        throw std::invalid_argument("Operands have different dimensions");
+                    }
+                }
+            }
+
+            constexpr auto shape() const {
+                if constexpr (fixed){
+                    return result_type::shape();
+                } else {
+                    return lhs.shape();
+                }
+            }
+
+            template<typename... Index>
+            constexpr value_type eval(Index... index) const {
+                return static_cast<value_type>(
+                    Op::apply(at<L>(lhs, index...), at<R>(rhs, index...))
+                );
+            }
+
+            template<typename D>
+            constexpr bool aliases(const D& destination) const {
+                return expr::aliases(lhs, destination) or expr::aliases(rhs, destination);
+            }
+
+            constexpr value_type evalLinear(size_t index) const
+                requires (
+                    Linear<std::remove_cvref_t<Operand<L>>>
+                    and Linear<std::remove_cvref_t<Operand<R>>>
+                    and not broadcast<L> and not broadcast<R>
+                )
+            {
+                return static_cast<value_type>(Op::apply(
+                    static_cast<value_type>(lhs.evalLinear(index)),
+                    static_cast<value_type>(rhs.evalLinear(index))
+                ));
+            }
+    };
+
+    // Element-wise operation between an expression and a scalar
+    template<typename Op, typename E>
+    class Scalar{
+
+        private:
+
+            using T = typename E::value_type;
+
+            Operand<E> expression;
+            T scalar;
+
+        public:
+
+            using result_type = typename E::result_type;
+            using value_type = T;
+            static constexpr bool elementwise = (
+                std::remove_cvref_t<Operand<E>>::elementwise
+            );
+
+            constexpr Scalar(const E& expression, const T& scalar)
+            : expression{expression}, scalar{scalar} {}
+
+            constexpr auto shape() const {
+                return expression.shape();
+            }
+
+            template<typename... Index>
+            constexpr value_type eval(Index... index) const {
+                return static_cast<value_type>(
+                    Op::apply(expression.eval(index...), scalar)
+                );
+            }
+
+            template<typename D>
+            constexpr bool aliases(const D& destination) const {
+                return expr::aliases(expression, destination);
+            }
+
+            constexpr value_type evalLinear(size_t index) const
+                requires Linear<std::remove_cvref_t<Operand<E>>>
+            {
+                return static_cast<value_type>(
+                    Op::apply(expression.evalLinear(index), scalar)
+                );
+            }
+    };
+
+
+    // Elements of an expression converted to type U
+    template<typename U, typename E>
+    class Cast{
+
+        private:
+
+            Operand<E> expression;
+
+        public:
+
+            using result_type = Rebound<typename E::result_type, U>;
+            using value_type = U;
+            static constexpr bool elementwise = (
+                std::remove_cvref_t<Operand<E>>::elementwise
+            );
+
+            explicit constexpr Cast(const E& expression): expression{expression} {}
+
+            constexpr auto shape() const {
+                return expression.shape();
+            }
+
+            template<typename... Index>
+            constexpr value_type eval(Index... index) const {
+                return static_cast<value_type>(expression.eval(index...));
+            }
+
+            template<typename D>
+            constexpr bool aliases(const D& destination) const {
+                return expr::aliases(expression, destination);
+            }
+
+            constexpr value_type evalLinear(size_t index) const
+                requires Linear<std::remove_cvref_t<Operand<E>>>
+            {
+                return static_cast<value_type>(expression.evalLinear(index));
+            }
+    };
+
+
+    // Matrix-matrix (R of rank 2) or matrix-vector (R of rank 1) product of
+    // two stored operands (terminals or views), evaluated as a whole into
+    // its destination by gemm() or gemv(), found by argument-dependent
+    // lookup. The operands may hold different element types, that of
+    // Result being the promoted one.
+    template<typename L, typename R, typename Result>
+    class Product{
+
+        private:
+
+            Operand<L> lhs;
+            Operand<R> rhs;
+
+            static constexpr bool matrixProduct = (
+                std::tuple_size_v<decltype(std::declval<const R&>().shape())> == 2
+            );
+
+        public:
+
+            using result_type = Result;
+            using value_type = typename Result::value_type;
+            static constexpr bool elementwise = false;
+
+            constexpr Product(const L& lhs, const R& rhs): lhs{lhs}, rhs{rhs} {
+                if (lhs.shape()[1] != rhs.shape()[0]){
+                    throw std::invalid_argument("Matrix dimensions do not match");
+                }
+            }
+
+            constexpr auto shape() const {
+                if constexpr (matrixProduct){
+                    return std::array<size_t, 2>{lhs.shape()[0], rhs.shape()[1]};
+                } else {
+                    return std::array<size_t, 1>{lhs.shape()[0]};
+                }
+            }
+
+            // destination = lhs * rhs, destination += lhs * rhs or
+            // destination -= lhs * rhs, depending on Op
+            template<typename Op, typename Destination>
+            constexpr void evaluateInto(Destination& destination) const {
+
+                using T = value_type;
+                using A = numeric::accumulator_t<T>;
+
+                // gemm() and gemv() work through data(), which a Matrix does
+                // not allow in constant evaluation (its rows are separate
+                // arrays): plain loops over the elements instead
+                if consteval {
+
+                    const auto [M, K] = lhs.shape();
+
+                    if constexpr (matrixProduct){
+                        for (size_t i{}; i<M; ++i){
+                            for (size_t j{}; j<rhs.shape()[1]; ++j){
+                                A sum {};
+                                for (size_t k{}; k<K; ++k){
+                                    sum = static_cast<A>(
+                                        sum + static_cast<A>(lhs.eval(i, k)) * static_cast<A>(rhs.eval(k, j))
+                                    );
+                                }
+                                Op::apply(destination[i, j], static_cast<T>(sum));
+                            }
+                        }
+                    } else {
+                        for (size_t i{}; i<M; ++i){
+                            A sum {};
+                            for (size_t k{}; k<K; ++k){
+                                sum = static_cast<A>(
+                                    sum + static_cast<A>(lhs.eval(i, k)) * static_cast<A>(rhs.eval(k))
+                                );
+                            }
+                            Op::apply(destination[i], static_cast<T>(sum));
+                        }
+                    }
+
+                    return;
+                }
+
+                const T alpha {std::same_as<Op, SubtractAssign> ? static_cast<T>(T{} - T{1}) : T{1}};
+                const T beta {std::same_as<Op, Assign> ? T{} : T{1}};
+
+                if constexpr (matrixProduct){
+                    gemm(alpha, lhs, rhs, beta, destination);
+                } else {
+                    gemv(alpha, lhs, rhs, beta, destination);
+                }
+            }
+    };
+
+    // Products write to their destination as a whole
+    template<typename E>
+    concept Evaluable = requires(const E& expression, typename E::result_type& destination){
+        expression.template evaluateInto<Assign>(destination);
+    };
+
+
+    // Assignment proxy returned by noalias(): evaluates straight into the
+    // destination, even when the expression is not element-wise
+    template<typename Destination>
+    class NoAlias{
+
+        private:
+
+            Destination& destination;
+
+        public:
+
+            explicit constexpr NoAlias(Destination& destination)
+            : destination{destination} {}
+
+            template<Expression E> requires Compatible<Destination, E>
+            constexpr NoAlias& operator=(const E& expression){
+                destination.template evaluate<Assign>(expression);
+                return *this;
+            }
+
+            template<Expression E> requires Compatible<Destination, E>
+            constexpr NoAlias& operator+=(const E& expression){
+                destination.template evaluate<AddAssign>(expression);
+                return *this;
+            }
+
+            template<Expression E> requires Compatible<Destination, E>
+            constexpr NoAlias& operator-=(const E& expression){
+                destination.template evaluate<SubtractAssign>(expression);
+                return *this;
+            }
+    };
+
+}
+
+
+/*************** Element-wise Arithmetic Operators ***********************/
+
+// Addition Arithmetic Operator (+)
+template<typename L, typename R> requires expr::Combinable<L, R>
+constexpr auto operator+(const L& lhs, const R& rhs){
+    return expr::Binary<expr::Add, L, R>{lhs, rhs};
+}
+
+// Subtraction Arithmetic Operator (-)
+template<typename L, typename R> requires expr::Combinable<L, R>
+constexpr auto operator-(const L& lhs, const R& rhs){
+    return expr::Binary<expr::Subtract, L, R>{lhs, rhs};
+}
+
+// Element Type Conversion (an expression of the elements converted to U)
+template<numeric::Element U, expr::Expression E>
+constexpr auto convert(const E& expression){
+    return expr::Cast<U, E>{expression};
+}
+
+// scalar Multiplication Operator
+template<expr::Expression E>
+constexpr auto operator*(const E& expression, const typename E::value_type& scalar){
+    return expr::Scalar<expr::Multiply, E>{expression, scalar};
+}
+
+template<expr::Expression E>
+constexpr auto operator*(const typename E::value_type& scalar, const E& expression){
+    return expr::Scalar<expr::Multiply, E>{expression, scalar};
+}
+
+// Products (dot, matrix-vector, matrix-matrix) are not element-wise: an
+// operand that is not stored in memory is evaluated into its result type
+// first, and so is the product, which would otherwise refer to that
+// temporary
+template<expr::Expression L, typename R>
+    requires (
+        not expr::Stored<L>
+        and not std::convertible_to<R, typename L::value_type>
+    )
+constexpr auto operator*(const L& lhs, const R& rhs)
+-> decltype(expr::concrete(std::declval<const typename L::result_type&>() * rhs)) {
+    const typename L::result_type evaluated {lhs};
+    return expr::concrete(evaluated * rhs);
+}
+
+template<expr::Stored L, expr::Expression R> requires (not expr::Stored<R>)
+constexpr auto operator*(const L& lhs, const R& rhs)
+-> decltype(expr::concrete(lhs * std::declval<const typename R::result_type&>())) {
+    const typename R::result_type evaluated {rhs};
+    return expr::concrete(lhs * evaluated);
+}
+
+// Prints an unevaluated expression by evaluating it first
+template<expr::Expression E> requires (not expr::Terminal<E>)
+std::ostream& operator<<(std::ostream& os, const E& expression){
+    return os << typename E::result_type{expression};
+}
+
+#endif
@@ -0,0 +1,959 @@
+#ifndef _FACTORIZATION_H_
+#define _FACTORIZATION_H_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <concepts>
+#include <memory_resource>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Expression.h"
+#include "AlignedBuffer.h"
+#include "Blas.h"
+#include "View.h"
+#include "Vector.h"
+#include "Matrix.h"
+#include "DynVector.h"
+#include "DynMatrix.h"
+
+/*
+    Dense factorizations of floating point matrices, and the solvers built
+    on them. In place, on a Matrix, a DynMatrix or any writable view:
+
+        lu(a, pivots);      a = P * L * U with partial pivoting (false if
+                            a is singular)
+        cholesky(a);        a = L * L^T, L in the lower triangle (false if
+                            a is not positive definite)
+        qr(a, tau);         a = Q * R with Householder reflections, R in the
+                            upper triangle, the reflectors below it
+
+    and on a copy of a Matrix or DynMatrix:
+
+        LU f {a};           f.solve(b), f.determinant(), f.inverse()
+        Cholesky f {a};     f.solve(b), f.determinant()
+        QR f {a};           f.solve(b), least squares when a has more rows
+                            than columns
+
+        determinant(a);  inverse(a);  solve(a, b);
+
+    where b is a vector or a matrix of right-hand sides. The factorizations
+    are blocked like LAPACK: a panel of a few dozen columns is factored with
+    plain loops, and the update of the rest of the matrix, where the O(n^3)
+    work is, goes through gemm(). determinant(), inverse() and solve() of
+    a fixed Matrix up to 4x4 use closed forms (cofactors) instead.
+
+    Solving with, inverting or taking the determinant of a singular matrix
+    throws std::domain_error (so does a Cholesky factorization of a matrix
+    that is not positive definite), and mismatched dimensions throw
+    std::invalid_argument.
+*/
+
+
+/************************** Factorization Kernels *************************/
+
+namespace kernel{
+
+    // Columns per panel of the blocked factorizations: the triangular
+    // solves and the panels are O(n^2 * block), the gemm updates O(n^3)
+    inline constexpr size_t factorBlock = 64;
+
+    // Householder panels are narrower, their T factor is O(block^2) work
+    // per column
+    inline constexpr size_t householderBlock = 32;
+
+    // Swaps x[i*inc] and y[i*inc], for i < n
+    template<typename T>
+    void swap(size_t n, T* x, T* y, size_t inc){
+        for (size_t i{}; i<n; ++i){
+            std::swap(x[i*inc], y[i*inc]);
+        }
+    }
+
+    // Unblocked LU with partial pivoting of A[m][n] (m >= n), right-looking:
+    // row pivots[j] was swapped with row j. Returns false on a zero pivot,
+    // whose column is then left as it is
+    template<typename T>
+    bool getf2(size_t m, size_t n, T* A, size_t rsa, size_t csa, size_t* pivots){
+
+        bool regular {true};
+
+        for (size_t j{}; j<n; ++j){
+
+            size_t p {j};
+
+            for (size_t i{j + 1}; i<m; ++i){
+                if (std::abs(A[i*rsa + j*csa]) > std::abs(A[p*rsa + j*csa])) p = i;
+            }
+
+            pivots[j] = p;
+
+            if (p != j){
+                swap(n, A + j*rsa, A + p*rsa, csa);
+            }
+
+            const T pivot {A[j*rsa + j*csa]};
+
+            if (pivot == T{}){
+                regular = false;
+                continue;
+            }
+
+            // Multipliers, and the rank one update of the rows below
+            for (size_t i{j + 1}; i<m; ++i){
+                T& l {A[i*rsa + j*csa]};
+                l = static_cast<T>(l / pivot);
+                if (l != T{}){
+                    axpy(
+                        n - j - 1, static_cast<T>(-l), A + j*rsa + (j + 1)*csa, csa,
+                        A + i*rsa + (j + 1)*csa, csa
+                    );
+                }
+            }
+        }
+
+        return regular;
+    }
+
+    // Blocked LU with partial pivoting of A[n][n]: each panel of
+    // factorBlock columns is factored by getf2, its row swaps applied to
+    // the columns on either side, then U12 = L11^-1 * A12 and
+    // A22 -= L21 * U12 (gemm)
+    template<typename T>
+    bool getrf(size_t n, T* A, size_t rsa, size_t csa, size_t* pivots){
+
+        if (n <= factorBlock){
+            return getf2(n, n, A, rsa, csa, pivots);
+        }
+
+        bool regular {true};
+
+        for (size_t k{}; k<n; k += factorBlock){
+
+            const size_t b {std::min(factorBlock, n - k)};
+            const size_t rest {n - k - b};
+            T* panel {A + k*rsa + k*csa};
+
+            regular = getf2(n - k, b, panel, rsa, csa, pivots + k) and regular;
+
+            for (size_t j{k}; j<k+b; ++j){
+                pivots[j] += k;
+                if (pivots[j] != j){
+                    swap(k, A + j*rsa, A + pivots[j]*rsa, csa);
+                    swap(rest, A + j*rsa + (k + b)*csa, A + pivots[j]*rsa + (k + b)*csa, csa);
+                }
+            }
+
+            if (rest > 0){
+                T* A12 {A + k*rsa + (k + b)*csa};
+                trsmLower(b, rest, true, panel, rsa, csa, A12, rsa, csa);
+                ::gemm(
+                    T{-1}, MatrixView<const T>{A + (k + b)*rsa + k*csa, rest, b, rsa, csa},
+                    MatrixView<const T>{A12, b, rest, rsa, csa},
+                    T{1}, MatrixView<T>{A + (k + b)*rsa + (k + b)*csa, rest, rest, rsa, csa}
+                );
+            }
+        }
+
+        return regular;
+    }
+
+    // Solves A * X = B in place of B[n][w], from the factors of getrf
+    template<typename T>
+    void getrs(
+        size_t n, size_t w, const T* LU, size_t rsa, size_t csa, const size_t* pivots,
+        T* B, size_t rsb, size_t csb
+    ){
+        for (size_t i{}; i<n; ++i){
+            if (pivots[i] != i) swap(w, B + i*rsb, B + pivots[i]*rsb, csb);
+        }
+        trsmLower(n, w, true, LU, rsa, csa, B, rsb, csb);
+        trsmUpper(n, w, false, LU, rsa, csa, B, rsb, csb);
+    }
+
+    // Unblocked Cholesky of the panel A[m][n] (m >= n), left-looking:
+    // column j of L from dot products of row j with itself and with the
+    // rows below, reading only the lower triangle. Returns false unless the
+    // leading n x n block is positive definite
+    template<typename T>
+    bool potf2(size_t m, size_t n, T* A, size_t rsa, size_t csa){
+
+        for (size_t j{}; j<n; ++j){
+
+            T* row {A + j*rsa};
+            const T d {static_cast<T>(row[j*csa] - dot(j, row, csa, row, csa))};
+
+            if (not (d > T{})){
+                return false;
+            }
+
+            const T diagonal {std::sqrt(d)};
+            row[j*csa] = diagonal;
+
+            for (size_t i{j + 1}; i<m; ++i){
+                T* other {A + i*rsa};
+                other[j*csa] = static_cast<T>(
+                    (other[j*csa] - dot(j, other, csa, row, csa)) / diagonal
+                );
+            }
+        }
+
+        return true;
+    }
+
+    // Blocked Cholesky of A[n][n], left-looking: each panel of factorBlock
+    // columns first gets the contribution of the columns on its left,
+    // A(k:n, k:k+b) -= L(k:n, 0:k) * L(k:k+b, 0:k)^T (one gemm), then its
+    // diagonal block is factored by potf2 and L21 = A21 * L11^-T
+    template<typename T>
+    bool potrf(size_t n, T* A, size_t rsa, size_t csa){
+
+        if (n <= factorBlock){
+            return potf2(n, n, A, rsa, csa);
+        }
+
+        AlignedBuffer<T> work {};
+
+        for (size_t k{}; k<n; k += factorBlock){
+
+            const size_t b {std::min(factorBlock, n - k)};
+            const size_t rest {n - k - b};
+            T* panel {A + k*rsa + k*csa};
+
+            if (k > 0){
+                ::gemm(
+                    T{-1}, MatrixView<const T>{A + k*rsa, n - k, k, rsa, csa},
+                    MatrixView<const T>{A + k*rsa, b, k, rsa, csa}.transpose(),
+                    T{1}, MatrixView<T>{panel, n - k, b, rsa, csa}
+                );
+            }
+
+            if (not potf2(b, b, panel, rsa, csa)){
+                return false;
+            }
+
+            if (rest > 0){
+                // L21^T = L11^-1 * A21^T, on a copy of A21^T so that the row
+                // operations of the solve run along contiguous memory
+                MatrixView<T> A21 {panel + b*rsa, rest, b, rsa, csa};
+                work.reset(b * rest);
+                MatrixView<T> X {work.data(), b, rest};
+                X = A21.transpose();
+                trsmLower(b, rest, false, panel, rsa, csa, X.data(), rest, size_t{1});
+                A21 = X.transpose();
+            }
+        }
+
+        return true;
+    }
+
+    // Solves A * X = B in place of B[n][w], from the L of potrf
+    template<typename T>
+    void potrs(size_t n, size_t w, const T* L, size_t rsl, size_t csl, T* B, size_t rsb, size_t csb){
+        trsmLower(n, w, false, L, rsl, csl, B, rsb, csb);
+        trsmUpper(n, w, false, L, csl, rsl, B, rsb, csb);
+    }
+
+    // Householder reflector H = I - tau * v * v^T with H * x = (beta, 0...),
+    // for x[n] at stride inc: x[0] becomes beta and the rest of x becomes
+    // v (whose first component, 1, is not stored). Returns tau
+    template<typename T>
+    T householder(size_t n, T* x, size_t inc){
+
+        if (n <= 1){
+            return T{};
+        }
+
+        const T alpha {x[0]};
+        const T tail {std::sqrt(dot(n - 1, x + inc, inc, x + inc, inc))};
+
+        if (tail == T{}){
+            return T{};
+        }
+
+        const T beta {static_cast<T>(-std::copysign(std::hypot(alpha, tail), alpha))};
+
+        scal(n - 1, static_cast<T>(T{1} / (alpha - beta)), x + inc, inc);
+        x[0] = beta;
+
+        return static_cast<T>((beta - alpha) / beta);
+    }
+
+    // Applies H = I - tau * v * v^T to C[m][n] from the left, v[m] at
+    // stride incv with v[0] = 1 implied
+    template<typename T>
+    void reflect(
+        size_t m, size_t n, T tau, const T* v, size_t incv, T* C, size_t rsc, size_t csc
+    ){
+        if (tau == T{}){
+            return;
+        }
+
+        for (size_t j{}; j<n; ++j){
+            T* column {C + j*csc};
+            const T w {static_cast<T>(tau * (column[0] + dot(m - 1, v + incv, incv, column + rsc, rsc)))};
+            column[0] = static_cast<T>(column[0] - w);
+            axpy(m - 1, static_cast<T>(-w), v + incv, incv, column + rsc, rsc);
+        }
+    }
+
+    // Unblocked Householder QR of A[m][n] (m >= n)
+    template<typename T>
+    void geqr2(size_t m, size_t n, T* A, size_t rsa, size_t csa, T* tau){
+        for (size_t j{}; j<n; ++j){
+            T* x {A + j*rsa + j*csa};
+            tau[j] = householder(m - j, x, rsa);
+            reflect(m - j, n - j - 1, tau[j], x, rsa, x + csa, rsa, csa);
+        }
+    }
+
+    // Blocked Householder QR of A[m][n] (m >= n): each panel of
+    // householderBlock reflectors H1 * ... * Hb = I - V * T * V^T is applied
+    // to the columns on its right as C -= V * (T^T * (V^T * C)), three gemms
+    // (the triangular T^T one is small)
+    template<typename T>
+    void geqrf(size_t m, size_t n, T* A, size_t rsa, size_t csa, T* tau){
+
+        if (n <= householderBlock){
+            geqr2(m, n, A, rsa, csa, tau);
+            return;
+        }
+
+        AlignedBuffer<T> v {}, t {}, work {};
+
+        for (size_t k{}; k<n; k += householderBlock){
+
+            const size_t b {std::min(householderBlock, n - k)};
+            const size_t rows {m - k}, rest {n - k - b};
+            T* panel {A + k*rsa + k*csa};
+
+            geqr2(rows, b, panel, rsa, csa, tau + k);
+
+            if (rest == 0){
+                break;
+            }
+
+            // V[rows][b] with its unit diagonal and zeros above it
+            v.reset(rows * b);
+            T* V {v.data()};
+            for (size_t i{}; i<rows; ++i){
+                for (size_t j{}; j<b and j<=i; ++j){
+                    V[i*b + j] = i == j ? T{1} : panel[i*rsa + j*csa];
+                }
+            }
+
+            // Upper triangular T[b][b]: column i is -tau[i] * T * V^T * v_i
+            // above the diagonal, tau[i] on it
+            t.reset(b * b);
+            T* F {t.data()};
+            for (size_t i{}; i<b; ++i){
+                const T tauI {tau[k + i]};
+                for (size_t p{}; p<i; ++p){
+                    F[p*b + i] = dot(rows - i, V + i*b + p, b, V + i*b + i, b);
+                }
+                for (size_t p{}; p<i; ++p){
+                    T sum {};
+                    for (size_t q{p}; q<i; ++q){
+                        sum = static_cast<T>(sum + F[p*b + q] * F[q*b + i]);
+                    }
+                    F[p*b + i] = static_cast<T>(-tauI * sum);
+                }
+                F[i*b + i] = tauI;
+            }
+
+            const MatrixView<const T> Vview {V, rows, b};
+            const MatrixView<T> C {panel + b*csa, rows, rest, rsa, csa};
+
+            work.reset(b * rest);
+            const MatrixView<T> W {work.data(), b, rest};
+
+            ::gemm(T{1}, Vview.transpose(), C, T{}, W);
+
+            // W = T^T * W, from the last row up
+            for (size_t i{b}; i-- > 0; ){
+                scal(rest, F[i*b + i], W.data() + i*rest);
+                for (size_t p{}; p<i; ++p){
+                    axpy(rest, F[p*b + i], W.data() + p*rest, 1, W.data() + i*rest, 1);
+                }
+            }
+
+            ::gemm(T{-1}, Vview, MatrixView<const T>{W}, T{1}, C);
+        }
+    }
+
+    // Applies Q^T = Hn * ... * H1 of geqrf to B[m][w]
+    template<typename T>
+    void ormqr(
+        size_t m, size_t n, size_t w, const T* QR, size_t rsa, size_t csa, const T* tau,
+        T* B, size_t rsb, size_t csb
+    ){
+        for (size_t j{}; j<n; ++j){
+            reflect(m - j, w, tau[j], QR + j*rsa + j*csa, rsa, B + j*rsb, rsb, csb);
+        }
+    }
+
+}
+
+
+/**************** Helpers for the Factorization Classes *******************/
+
+namespace factor{
+
+    // Matrices that the factorization classes work on (a copy of)
+    template<typename M>
+    concept Factorable = (
+        expr::Terminal<M> and expr::Strided<M, 2> and expr::Writable<M>
+        and std::floating_point<typename M::value_type>
+    );
+
+    // Right-hand sides of solve(): a vector or a matrix, stored and writable
+    template<typename B, typename M>
+    concept RightHandSide = (
+        expr::Terminal<B> and expr::Writable<B> and expr::SameValueType<B, M>
+        and (expr::FixedShape<B> == expr::FixedShape<M>)
+    );
+
+    namespace detail{
+
+        // Container of N values: an array for fixed shapes, a vector otherwise
+        template<typename T, typename M>
+        auto array(size_t n){
+            if constexpr (expr::FixedShape<M>){
+                return std::array<T, M::shape()[1]>{};
+            } else {
+                return std::pmr::vector<T>(n, memory::resource());
+            }
+        }
+
+        // A vector or matrix right-hand side, as a matrix of columns
+        template<expr::Writable B>
+        MatrixView<typename B::value_type> columns(B& b){
+            if constexpr (expr::Strided<B, 1>){
+                return {b.data(), b.shape()[0], 1, b.strides()[0], 1};
+            } else {
+                const auto [rows, cols] = b.shape();
+                const auto [rs, cs] = b.strides();
+                return {b.data(), rows, cols, rs, cs};
+            }
+        }
+
+        // B with Rows rows (or rows rows at run time) instead of its own
+        template<typename B, size_t Rows>
+        struct Resized { using type = B; };
+
+        template<typename T, size_t N, size_t Rows>
+        struct Resized<Vector<T, N>, Rows> { using type = Vector<T, Rows>; };
+
+        template<typename T, size_t R, size_t C, size_t Rows>
+        struct Resized<Matrix<T, R, C>, Rows> { using type = Matrix<T, Rows, C>; };
+
+        template<typename B, size_t Rows>
+        typename Resized<B, Rows>::type resized(const B& b, size_t rows){
+            if constexpr (expr::FixedShape<B>){
+                return {};
+            } else if constexpr (expr::Strided<B, 1>){
+                return B(rows);
+            } else {
+                return B(rows, b.shape()[1]);
+            }
+        }
+
+        // Identity matrix with n rows
+        template<typename M>
+        M identity(size_t n){
+
+            M result {[n]{
+                if constexpr (expr::FixedShape<M>){
+                    return M{};
+                } else {
+                    return M(n, n);
+                }
+            }()};
+
+            for (size_t i{}; i<n; ++i){
+                result.data()[i*result.strides()[0] + i] = typename M::value_type{1};
+            }
+
+            return result;
+        }
+
+    }
+
+}
+
+
+/******************* In-place Factorizations ******************************/
+
+// a = P * L * U: the unit lower L below the diagonal of a, U on and above
+// it, and row i was swapped with row pivots[i], in that order. Returns false
+// if a is singular (the factors are still valid, U has a zero pivot)
+template<typename D, typename Destination = std::remove_cvref_t<D>>
+    requires (
+        expr::Strided<Destination, 2> and expr::Writable<Destination>
+        and std::floating_point<typename Destination::value_type>
+    )
+bool lu(D&& a, std::span<size_t> pivots){
+
+    const auto [n, columns] = a.shape();
+
+    if (n != columns or pivots.size() != n){
+        throw std::invalid_argument("Matrix dimensions do not match");
+    }
+
+    const auto [rs, cs] = a.strides();
+
+    return kernel::getrf(n, a.data(), rs, cs, pivots.data());
+}
+
+// a = L * L^T for a symmetric a, of which only the lower triangle is read:
+// L replaces it, and the strict upper triangle is zeroed. Returns false if
+// a is not positive definite (a is then partially overwritten)
+template<typename D, typename Destination = std::remove_cvref_t<D>>
+    requires (
+        expr::Strided<Destination, 2> and expr::Writable<Destination>
+        and std::floating_point<typename Destination::value_type>
+    )
+bool cholesky(D&& a){
+
+    using T = typename Destination::value_type;
+
+    const auto [n, columns] = a.shape();
+
+    if (n != columns){
+        throw std::invalid_argument("Matrix dimensions do not match");
+    }
+
+    const auto [rs, cs] = a.strides();
+    T* p {a.data()};
+
+    if (not kernel::potrf(n, p, rs, cs)){
+        return false;
+    }
+
+    for (size_t i{}; i<n; ++i){
+        for (size_t j{i + 1}; j<n; ++j){
+            p[i*rs + j*cs] = T{};
+        }
+    }
+
+    return true;
+}
+
+// a = Q * R for a with at least as many rows as columns: R on and above the
+// diagonal of a, and Q = H1 * ... * Hn with Hj = I - tau[j] * vj * vj^T,
+// vj below the diagonal of column j (and 1 on it)
+template<typename D, typename Destination = std::remove_cvref_t<D>>
+    requires (
+        expr::Strided<Destination, 2> and expr::Writable<Destination>
+        and std::floating_point<typename Destination::value_type>
+    )
+void qr(D&& a, std::span<typename Destination::value_type> tau){
+
+    const auto [m, n] = a.shape();
+
+    if (m < n or tau.size() != n){
+        throw std::invalid_argument("Matrix dimensions do not match");
+    }
+
+    const auto [rs, cs] = a.strides();
+
+    kernel::geqrf(m, n, a.data(), rs, cs, tau.data());
+}
+
+
+/*********************** Factorization Classes ****************************/
+
+// LU factorization with partial pivoting of a copy of a square matrix
+template<factor::Factorable M>
+class LU{
+
+    using T = typename M::value_type;
+
+private:
+
+    M matrix;                                                   // L and U
+    decltype(factor::detail::array<size_t, M>(0)) pivots;       // row swaps
+    bool regular;                                               // no zero pivot
+
+    size_t size() const {
+        return matrix.shape()[0];
+    }
+
+    void checkRegular() const {
+        if (not regular) throw std::domain_error("Matrix is singular");
+    }
+
+public:
+
+    explicit LU(const M& a)
+    : matrix{a}, pivots{factor::detail::array<size_t, M>(a.shape()[0])},
+      regular{lu(matrix, std::span<size_t>{pivots})} {}
+
+    // L below the diagonal (unit diagonal not stored), U on and above it
+    const M& factors() const noexcept {
+        return matrix;
+    }
+
+    // Row i was swapped with row permutation()[i], for i in increasing order
+    std::span<const size_t> permutation() const noexcept {
+        return pivots;
+    }
+
+    bool singular() const noexcept {
+        return not regular;
+    }
+
+    T determinant() const {
+
+        T result {1};
+
+        for (size_t i{}; i<size(); ++i){
+            result = static_cast<T>(result * matrix.data()[i*matrix.strides()[0] + i]);
+            if (pivots[i] != i) result = -result;
+        }
+
+        return result;
+    }
+
+    // x with a * x = b, for a vector or a matrix of right-hand sides b
+    template<factor::RightHandSide<M> B>
+    B solve(const B& b) const {
+
+        checkRegular();
+
+        if (b.shape()[0] != size()){
+            throw std::invalid_argument("Matrix dimensions do not match");
+        }
+
+        B x {b};
+        const MatrixView<T> X {factor::detail::columns(x)};
+        const auto [rsx, csx] = X.strides();
+
+        kernel::getrs(
+            size(), X.columns(), matrix.data(), matrix.strides()[0], 1, pivots.data(),
+            X.data(), rsx, csx
+        );
+
+        return x;
+    }
+
+    M inverse() const {
+        return solve(factor::detail::identity<M>(size()));
+    }
+
+};
+
+// Cholesky factorization a = L * L^T of a copy of a symmetric positive
+// definite matrix (only its lower triangle is read)
+template<factor::Factorable M>
+class Cholesky{
+
+    using T = typename M::value_type;
+
+private:
+
+    M matrix;               // L, zero above the diagonal
+    bool positive;          // whether a is positive definite
+
+    size_t size() const {
+        return matrix.shape()[0];
+    }
+
+    void checkPositive() const {
+        if (not positive) throw std::domain_error("Matrix is not positive definite");
+    }
+
+public:
+
+    explicit Cholesky(const M& a): matrix{a}, positive{cholesky(matrix)} {}
+
+    // L (meaningless unless positiveDefinite())
+    const M& factors() const noexcept {
+        return matrix;
+    }
+
+    bool positiveDefinite() const noexcept {
+        return positive;
+    }
+
+    T determinant() const {
+
+        checkPositive();
+
+        T result {1};
+
+        for (size_t i{}; i<size(); ++i){
+            const T diagonal {matrix.data()[i*matrix.strides()[0] + i]};
+            result = static_cast<T>(result * diagonal * diagonal);
+        }
+
+        return result;
+    }
+
+    template<factor::RightHandSide<M> B>
+    B solve(const B& b) const {
+
+        checkPositive();
+
+        if (b.shape()[0] != size()){
+            throw std::invalid_argument("Matrix dimensions do not match");
+        }
+
+        B x {b};
+        const MatrixView<T> X {factor::detail::columns(x)};
+        const auto [rsx, csx] = X.strides();
+
+        kernel::potrs(
+            size(), X.columns(), matrix.data(), matrix.strides()[0], 1,
+            X.data(), rsx, csx
+        );
+
+        return x;
+    }
+
+};
+
+// Householder QR factorization of a copy of a matrix with at least as many
+// rows as columns
+template<factor::Factorable M>
+class QR{
+
+    using T = typename M::value_type;
+
+private:
+
+    M matrix;                                           // R and the reflectors
+    decltype(factor::detail::array<T, M>(0)) scales;    // tau of each reflector
+
+    static const M& checked(const M& a){
+        if (a.shape()[0] < a.shape()[1]){
+            throw std::invalid_argument("Matrix dimensions do not match");
+        }
+        return a;
+    }
+
+public:
+
+    explicit QR(const M& a)
+    : matrix{checked(a)}, scales{factor::detail::array<T, M>(a.shape()[1])} {
+        qr(matrix, std::span<T>{scales});
+    }
+
+    // R on and above the diagonal, the Householder vectors below it
+    const M& factors() const noexcept {
+        return matrix;
+    }
+
+    std::span<const T> tau() const noexcept {
+        return scales;
+    }
+
+    // Whether R has a zero on its diagonal (a has dependent columns)
+    bool rankDeficient() const {
+        for (size_t i{}; i<matrix.shape()[1]; ++i){
+            if (matrix.data()[i*matrix.strides()[0] + i] == T{}) return true;
+        }
+        return false;
+    }
+
+    // x minimizing |a * x - b| (a * x = b if a is square), for a vector or a
+    // matrix of right-hand sides b with as many rows as a
+    template<factor::RightHandSide<M> B>
+    auto solve(const B& b) const {
+
+        const auto [m, n] = matrix.shape();
+
+        if (b.shape()[0] != m){
+            throw std::invalid_argument("Matrix dimensions do not match");
+        }
+
+        if (rankDeficient()){
+            throw std::domain_error("Matrix is singular");
+        }
+
+        B work {b};
+        const MatrixView<T> W {factor::detail::columns(work)};
+        const auto [rsw, csw] = W.strides();
+        const size_t rsa {matrix.strides()[0]};
+
+        kernel::ormqr(m, n, W.columns(), matrix.data(), rsa, 1, scales.data(), W.data(), rsw, csw);
+        kernel::trsmUpper(n, W.columns(), false, matrix.data(), rsa, 1, W.data(), rsw, csw);
+
+        if constexpr (expr::FixedShape<M>){
+            auto x {factor::detail::resized<B, M::shape()[1]>(b, n)};
+            factor::detail::columns(x) = W.block(0, 0, n, W.columns());
+            return x;
+        } else {
+            auto x {factor::detail::resized<B, 0>(b, n)};
+            factor::detail::columns(x) = W.block(0, 0, n, W.columns());
+            return x;
+        }
+    }
+
+};
+
+
+/************** Determinant, Inverse and Linear Systems ******************/
+
+namespace factor::detail{
+
+    // Determinant of the 2x2 matrix of elements (a, b; c, d)
+    template<typename T>
+    constexpr T det2(T a, T b, T c, T d){
+        return static_cast<T>(a * d - b * c);
+    }
+
+    template<typename T, size_t N>
+    constexpr T closedDeterminant(const Matrix<T, N, N>& m){
+        if constexpr (N == 1){
+            return m[0, 0];
+        } else if constexpr (N == 2){
+            return det2(m[0, 0], m[0, 1], m[1, 0], m[1, 1]);
+        } else if constexpr (N == 3){
+            return static_cast<T>(
+                m[0, 0] * det2(m[1, 1], m[1, 2], m[2, 1], m[2, 2])
+                - m[0, 1] * det2(m[1, 0], m[1, 2], m[2, 0], m[2, 2])
+                + m[0, 2] * det2(m[1, 0], m[1, 1], m[2, 0], m[2, 1])
+            );
+        } else {
+            // Laplace expansion along the first two rows
+            return static_cast<T>(
+                det2(m[0, 0], m[0, 1], m[1, 0], m[1, 1]) * det2(m[2, 2], m[2, 3], m[3, 2], m[3, 3])
+                - det2(m[0, 0], m[0, 2], m[1, 0], m[1, 2]) * det2(m[2, 1], m[2, 3], m[3, 1], m[3, 3])
+                + det2(m[0, 0], m[0, 3], m[1, 0], m[1, 3]) * det2(m[2, 1], m[2, 2], m[3, 1], m[3, 2])
+                + det2(m[0, 1], m[0, 2], m[1, 1], m[1, 2]) * det2(m[2, 0], m[2, 3], m[3, 0], m[3, 3])
+                - det2(m[0, 1], m[0, 3], m[1, 1], m[1, 3]) * det2(m[2, 0], m[2, 2], m[3, 0], m[3, 2])
+                + det2(m[0, 2], m[0, 3], m[1, 2], m[1, 3]) * det2(m[2, 0], m[2, 1], m[3, 0], m[3, 1])
+            );
+        }
+    }
+
+    // Inverse as the adjugate over the determinant
+    template<typename T, size_t N>
+    constexpr Matrix<T, N, N> closedInverse(const Matrix<T, N, N>& m){
+
+        Matrix<T, N, N> result {};
+
+        if constexpr (N == 1){
+            if (m[0, 0] == T{}) throw std::domain_error("Matrix is singular");
+            result[0, 0] = static_cast<T>(T{1} / m[0, 0]);
+            return result;
+        } else if constexpr (N == 2){
+            const T det {closedDeterminant(m)};
+            if (det == T{}) throw std::domain_error("Matrix is singular");
+            result[0, 0] = m[1, 1];
+            result[0, 1] = -m[0, 1];
+            result[1, 0] = -m[1, 0];
+            result[1, 1] = m[0, 0];
+            result = result * static_cast<T>(T{1} / det);
+            return result;
+        } else if constexpr (N == 3){
+            result[0, 0] = det2(m[1, 1], m[1, 2], m[2, 1], m[2, 2]);
+            result[0, 1] = det2(m[0, 2], m[0, 1], m[2, 2], m[2, 1]);
+            result[0, 2] = det2(m[0, 1], m[0, 2], m[1, 1], m[1, 2]);
+            result[1, 0] = det2(m[1, 2], m[1, 0], m[2, 2], m[2, 0]);
+            result[1, 1] = det2(m[0, 0], m[0, 2], m[2, 0], m[2, 2]);
+            result[1, 2] = det2(m[0, 2], m[0, 0], m[1, 2], m[1, 0]);
+            result[2, 0] = det2(m[1, 0], m[1, 1], m[2, 0], m[2, 1]);
+            result[2, 1] = det2(m[0, 1], m[0, 0], m[2, 1], m[2, 0]);
+            result[2, 2] = det2(m[0, 0], m[0, 1], m[1, 0], m[1, 1]);
+            const T det {static_cast<T>(
+                m[0, 0] * result[0, 0] + m[0, 1] * result[1, 0] + m[0, 2] * result[2, 0]
+            )};
+            if (det == T{}) throw std::domain_error("Matrix is singular");
+            result = result * static_cast<T>(T{1} / det);
+            return result;
+        } else {
+            // 2x2 minors of the top two rows (s) and of the bottom two (c)
+            const T s0 {det2(m[0, 0], m[0, 1], m[1, 0], m[1, 1])};
+            const T s1 {det2(m[0, 0], m[0, 2], m[1, 0], m[1, 2])};
+            const T s2 {det2(m[0, 0], m[0, 3], m[1, 0], m[1, 3])};
+            const T s3 {det2(m[0, 1], m[0, 2], m[1, 1], m[1, 2])};
+            const T s4 {det2(m[0, 1], m[0, 3], m[1, 1], m[1, 3])};
+            const T s5 {det2(m[0, 2], m[0, 3], m[1, 2], m[1, 3])};
+            const T c5 {det2(m[2, 2], m[2, 3], m[3, 2], m[3, 3])};
+            const T c4 {det2(m[2, 1], m[2, 3], m[3, 1], m[3, 3])};
+            const T c3 {det2(m[2, 1], m[2, 2], m[3, 1], m[3, 2])};
+            const T c2 {det2(m[2, 0], m[2, 3], m[3, 0], m[3, 3])};
+            const T c1 {det2(m[2, 0], m[2, 2], m[3, 0], m[3, 2])};
+            const T c0 {det2(m[2, 0], m[2, 1], m[3, 0], m[3, 1])};
+
+            const T det {static_cast<T>(s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0)};
+            if (det == T{}) throw std::domain_error("Matrix is singular");
+
+            result[0, 0] = static_cast<T>( m[1, 1] * c5 - m[1, 2] * c4 + m[1, 3] * c3);
+            result[0, 1] = static_cast<T>(-m[0, 1] * c5 + m[0, 2] * c4 - m[0, 3] * c3);
+            result[0, 2] = static_cast<T>( m[3, 1] * s5 - m[3, 2] * s4 + m[3, 3] * s3);
+            result[0, 3] = static_cast<T>(-m[2, 1] * s5 + m[2, 2] * s4 - m[2, 3] * s3);
+            result[1, 0] = static_cast<T>(-m[1, 0] * c5 + m[1, 2] * c2 - m[1, 3] * c1);
+            result[1, 1] = static_cast<T>( m[0, 0] * c5 - m[0, 2] * c2 + m[0, 3] * c1);
+            result[1, 2] = static_cast<T>(-m[3, 0] * s5 + m[3, 2] * s2 - m[3, 3] * s1);
+            result[1, 3] = static_cast<T>( m[2, 0] * s5 - m[2, 2] * s2 + m[2, 3] * s1);
+            result[2, 0] = static_cast<T>( m[1, 0] * c4 - m[1, 1] * c2 + m[1, 3] * c0);
+            result[2, 1] = static_cast<T>(-m[0, 0] * c4 + m[0, 1] * c2 - m[0, 3] * c0);
+            result[2, 2] = static_cast<T>( m[3, 0] * s4 - m[3, 1] * s2 + m[3, 3] * s0);
+            result[2, 3] = static_cast<T>(-m[2, 0] * s4 + m[2, 1] * s2 - m[2, 3] * s0);
+            result[3, 0] = static_cast<T>(-m[1, 0] * c3 + m[1, 1] * c1 - m[1, 2] * c0);
+            result[3, 1] = static_cast<T>( m[0, 0] * c3 - m[0, 1] * c1 + m[0, 2] * c0);
+            result[3, 2] = static_cast<T>(-m[3, 0] * s3 + m[3, 1] * s1 - m[3, 2] * s0);
+            result[3, 3] = static_cast<T>( m[2, 0] * s3 - m[2, 1] * s1 + m[2, 2] * s0);
+
+            result = result * static_cast<T>(T{1} / det);
+            return result;
+        }
+    }
+
+}
+
+// Determinant of a square matrix (closed form up to 4x4, and then usable in
+// constant expressions, LU otherwise)
+template<std::floating_point T, size_t N>
+constexpr T determinant(const Matrix<T, N, N>& m){
+    if constexpr (N <= 4){
+        return factor::detail::closedDeterminant(m);
+    } else {
+        return LU{m}.determinant();
+    }
+}
+
+template<std::floating_point T>
+T determinant(const DynMatrix<T>& m){
+    return LU{m}.determinant();
+}
+
+// Inverse of a square matrix (adjugate up to 4x4, LU otherwise), throws
+// std::domain_error if it is singular
+template<std::floating_point T, size_t N>
+constexpr Matrix<T, N, N> inverse(const Matrix<T, N, N>& m){
+    if constexpr (N <= 4){
+        return factor::detail::closedInverse(m);
+    } else {
+        return LU{m}.inverse();
+    }
+}
+
+template<std::floating_point T>
+DynMatrix<T> inverse(const DynMatrix<T>& m){
+    return LU{m}.inverse();
+}
+
+// x with a * x = b, for a vector or a matrix of right-hand sides b
+template<std::floating_point T, size_t N, factor::RightHandSide<Matrix<T, N, N>> B>
+constexpr B solve(const Matrix<T, N, N>& a, const B& b){
+    if constexpr (N <= 4){
+        static_assert(B::shape()[0] == N, "Matrix dimensions do not match");
+        return B{factor::detail::closedInverse(a) * b};
+    } else {
+        return LU{a}.solve(b);
+    }
+}
+
+template<std::floating_point T, factor::RightHandSide<DynMatrix<T>> B>
+B solve(const DynMatrix<T>& a, const B& b){
+    return LU{a}.solve(b);
+}
+
+#endif
@@ -0,0 +1,325 @@
+#ifndef _GEMM_H_
+#define _GEMM_H_
+
+#include <algorithm>
+#include <utility>
+#include "AlignedBuffer.h"
+#include "ThreadPool.h"
+
+/*
+    Matrix-matrix multiplication kernels, C = A * B on row-major storage
+    (C = alpha * A * B + beta * C for the blocked one).
+
+    gemm() (Blas.h) picks one of three paths, at compile time when the
+    dimensions of its operands are fixed:
+
+    - gemmSmall: every loop is unrolled at compile time; used for the tiny
+      products (3x3, 4x4, ...) where any loop or packing overhead dominates.
+    - gemmFixed: plain loops with compile-time bounds over the raw arrays,
+      which the compiler unrolls and vectorizes as it sees fit; used while
+      the whole product stays in L1 and packing would not pay off.
+    - gemm: the blocked algorithm, for everything larger. B is packed into
+      KC x NC panels (sized for L3) and A into MC x KC panels (sized for
+      L2), each split into slivers of NR columns / MR rows that are
+      contiguous in memory. A register-tiled MR x NR micro-kernel then runs
+      over the slivers, keeping a whole tile of C in registers while
+      streaming through L1. Above the serial cutoff of the thread pool, the
+      rows of C are split into blocks (multiples of MR) that are multiplied
+      in parallel, each thread packing into its own buffers.
+
+    Large square products may instead be split recursively by
+    Strassen-Winograd (Strassen.h), down to blocks that this kernel
+    multiplies.
+*/
+
+namespace kernel{
+
+    // Calls function(std::integral_constant<size_t, I>{}) for I = 0 ... N-1,
+    // unrolled at compile time
+    template<size_t N, typename Function>
+    constexpr void unroll(Function&& function){
+        [&]<size_t... I>(std::index_sequence<I...>){
+            (function(std::integral_constant<size_t, I>{}), ...);
+        }(std::make_index_sequence<N>{});
+    }
+
+    // Register tile (MR x NR) and cache blocks (MC, KC, NC) of the blocked
+    // kernel. A row of the tile is 64 bytes wide, i.e. two ymm registers,
+    // so that the accumulators take half of the 16 registers of AVX2; with
+    // the 32 registers of AVX-512 the tile is twice as wide.
+    #ifdef __AVX512F__
+    inline constexpr size_t gemmTileRowBytes = 128;
+    #else
+    inline constexpr size_t gemmTileRowBytes = 64;
+    #endif
+
+    template<typename T>
+    struct GemmBlocking{
+        static constexpr size_t MR = 4;
+        static constexpr size_t NR = gemmTileRowBytes / sizeof(T);
+        static constexpr size_t KC = 256;
+        static constexpr size_t MC = (256 * 1024) / (KC * sizeof(T)) / MR * MR;
+        static constexpr size_t NC = 2048;
+    };
+
+    // Products up to this many multiply-adds are fully unrolled
+    inline constexpr size_t smallGemmLimit = 6 * 6 * 6;
+
+    // Products up to this many multiply-adds skip packing
+    inline constexpr size_t fixedGemmLimit = 16 * 16 * 16;
+
+
+    // C[R][CR] = A[R][C] * B[C][CR], fully unrolled (contiguous row-major
+    // operands)
+    template<typename T, size_t R, size_t C, size_t CR>
+    constexpr void gemmSmall(const T* A, const T* B, T* Cout){
+        unroll<R>([&](auto i){
+            unroll<CR>([&](auto j){
+                Cout[i*CR + j] = [&]<size_t... K>(std::index_sequence<K...>){
+                    return static_cast<T>(((A[i*C + K] * B[K*CR + j]) + ...));
+                }(std::make_index_sequence<C>{});
+            });
+        });
+    }
+
+    // C[R][CR] = A[R][C] * B[C][CR], with compile-time loop bounds
+    // (contiguous row-major operands)
+    template<typename T, size_t R, size_t C, size_t CR>
+    constexpr void gemmFixed(const T* A, const T* B, T* Cout){
+        for (size_t i{}; i<R; ++i){
+            for (size_t j{}; j<CR; ++j){
+
+                T sum {};
+
+                for (size_t k{}; k<C; ++k){
+                    sum = static_cast<T>(sum + A[i*C + k] * B[k*CR + j]);
+                }
+
+                Cout[i*CR + j] = sum;
+            }
+        }
+    }
+
+
+    namespace detail{
+
+        // Packs rows [0, mc) x columns [0, kc) of A (element (i, p) at
+        // A[i*rsa + p*csa]) into slivers of MR rows, each stored column by
+        // column (kc x MR), zero-padding the last one
+        template<typename T>
+        void packA(size_t mc, size_t kc, const T* A, size_t rsa, size_t csa, T* packed){
+
+            constexpr size_t MR = GemmBlocking<T>::MR;
+
+            for (size_t ir{}; ir<mc; ir+=MR){
+
+                const size_t mr {std::min(MR, mc - ir)};
+
+                for (size_t p{}; p<kc; ++p){
+                    for (size_t i{}; i<MR; ++i){
+                        *packed++ = i < mr ? A[(ir + i)*rsa + p*csa] : T{};
+                    }
+                }
+            }
+        }
+
+        // Packs rows [0, kc) x columns [0, nc) of B (element (p, j) at
+        // B[p*rsb + j*csb]) into slivers of NR columns, each stored row by
+        // row (kc x NR), zero-padding the last one
+        template<typename T>
+        void packB(size_t kc, size_t nc, const T* B, size_t rsb, size_t csb, T* packed){
+
+            constexpr size_t NR = GemmBlocking<T>::NR;
+
+            for (size_t jr{}; jr<nc; jr+=NR){
+
+                const size_t nr {std::min(NR, nc - jr)};
+
+                for (size_t p{}; p<kc; ++p){
+
+                    const T* b {B + p*rsb + jr*csb};
+
+                    if (csb == 1){
+                        for (size_t j{}; j<NR; ++j){
+                            *packed++ = j < nr ? b[j] : T{};
+                        }
+                    } else {
+                        for (size_t j{}; j<NR; ++j){
+                            *packed++ = j < nr ? b[j*csb] : T{};
+                        }
+                    }
+                }
+            }
+        }
+
+        // C[mr][nr] += alpha * A-sliver * B-sliver, accumulating an MR x NR
+        // tile in registers over the whole kc depth
+        template<typename T>
+        void microKernel(
+            size_t kc, T alpha, const T* a, const T* b, T* C, size_t ldc,
+            size_t mr, size_t nr
+        ){
+            constexpr size_t MR = GemmBlocking<T>::MR;
+            constexpr size_t NR = GemmBlocking<T>::NR;
+
+            T accumulator[MR][NR] {};
+
+            for (size_t p{}; p<kc; ++p){
+
+                unroll<MR>([&](auto i){
+
+                    const T ai {a[i]};
+
+                    for (size_t j{}; j<NR; ++j){
+                        accumulator[i][j] = static_cast<T>(
+                            accumulator[i][j] + ai * b[j]
+                        );
+                    }
+                });
+
+                a += MR;
+                b += NR;
+            }
+
+            if (mr == MR and nr == NR){
+                unroll<MR>([&](auto i){
+                    for (size_t j{}; j<NR; ++j){
+                        C[i*ldc + j] = static_cast<T>(C[i*ldc + j] + alpha * accumulator[i][j]);
+                    }
+                });
+            } else {
+                for (size_t i{}; i<mr; ++i){
+                    for (size_t j{}; j<nr; ++j){
+                        C[i*ldc + j] = static_cast<T>(C[i*ldc + j] + alpha * accumulator[i][j]);
+                    }
+                }
+            }
+        }
+
+        // Per-thread packing buffers, grown on demand and reused across calls
+        // (from the heap, whatever the current resource, since they outlive
+        // scopes)
+        template<typename T>
+        T* packBuffer(size_t index, size_t size){
+            thread_local AlignedBuffer<T> buffer[2] {
+                AlignedBuffer<T>{memory::heap()}, AlignedBuffer<T>{memory::heap()}
+            };
+            if (buffer[index].size() < size){
+                buffer[index].reset(size);
+            }
+            return buffer[index].data();
+        }
+
+        // C[M][N] = alpha * A[M][K] * B[K][N] + beta * C[M][N] on the
+        // calling thread (C is not read when beta is zero)
+        template<typename T>
+        void gemmBlocked(
+            size_t M, size_t N, size_t K, T alpha,
+            const T* A, size_t rsa, size_t csa, const T* B, size_t rsb, size_t csb,
+            T beta, T* C, size_t ldc
+        ){
+            using Blocking = GemmBlocking<T>;
+            constexpr size_t MR = Blocking::MR, NR = Blocking::NR;
+            constexpr size_t MC = Blocking::MC, KC = Blocking::KC, NC = Blocking::NC;
+
+            for (size_t i{}; i<M; ++i){
+
+                T* c {C + i*ldc};
+
+                if (beta == T{}){
+                    std::fill(c, c + N, T{});
+                } else if (beta != T{1}){
+                    for (size_t j{}; j<N; ++j){
+                        c[j] = static_cast<T>(beta * c[j]);
+                    }
+                }
+            }
+
+            T* packedA {packBuffer<T>(0, MC * KC)};
+            T* packedB {packBuffer<T>(1, KC * (std::min(NC, N) + NR))};
+
+            for (size_t jc{}; jc<N; jc+=NC){
+
+                const size_t nc {std::min(NC, N - jc)};
+
+                for (size_t pc{}; pc<K; pc+=KC){
+
+                    const size_t kc {std::min(KC, K - pc)};
+
+                    packB(kc, nc, B + pc*rsb + jc*csb, rsb, csb, packedB);
+
+                    for (size_t ic{}; ic<M; ic+=MC){
+
+                        const size_t mc {std::min(MC, M - ic)};
+
+                        packA(mc, kc, A + ic*rsa + pc*csa, rsa, csa, packedA);
+
+                        for (size_t jr{}; jr<nc; jr+=NR){
+
+                            for (size_t ir{}; ir<mc; ir+=MR){
+
+                                microKernel(
+                                    kc, alpha, packedA + ir*kc, packedB + jr*kc,
+                                    C + (ic + ir)*ldc + jc + jr, ldc,
+                                    std::min(MR, mc - ir), std::min(NR, nc - jr)
+                                );
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+    }
+
+    // C[M][N] = alpha * A[M][K] * B[K][N] + beta * C[M][N], blocked for the
+    // cache hierarchy, with packed operands and a register-tiled
+    // micro-kernel, parallel over row blocks of C. A and B may have any
+    // strides (rows and columns), since they are packed anyway: a
+    // transposed operand costs nothing more.
+    template<typename T>
+    void gemm(
+        size_t M, size_t N, size_t K, T alpha,
+        const T* A, size_t rsa, size_t csa, const T* B, size_t rsb, size_t csb,
+        T beta, T* C, size_t ldc
+    ){
+        constexpr size_t MR = GemmBlocking<T>::MR;
+
+        // About one block per thread, since every block packs its own copy
+        // of the panels of B
+        const size_t threads {
+            M * N * K < parallel::serialCutoff() ? 1 : parallel::threadCount()
+        };
+        const size_t rows {(M + threads - 1) / threads};
+        const size_t block {std::max(MR, (rows + MR - 1) / MR * MR)};
+
+        parallel::forBlocks(M, N * K, block, [&](size_t begin, size_t end){
+            detail::gemmBlocked(
+                end - begin, N, K, alpha, A + begin*rsa, rsa, csa, B, rsb, csb,
+                beta, C + begin*ldc, ldc
+            );
+        });
+    }
+
+    // C[M][N] = alpha * A[M][K] * B[K][N] + beta * C[M][N], row-major
+    // operands with leading dimensions lda, ldb and ldc
+    template<typename T>
+    void gemm(
+        size_t M, size_t N, size_t K, T alpha,
+        const T* A, size_t lda, const T* B, size_t ldb, T beta, T* C, size_t ldc
+    ){
+        gemm(M, N, K, alpha, A, lda, size_t{1}, B, ldb, size_t{1}, beta, C, ldc);
+    }
+
+    // C[M][N] = A[M][K] * B[K][N]
+    template<typename T>
+    void gemm(
+        size_t M, size_t N, size_t K,
+        const T* A, size_t lda, const T* B, size_t ldb, T* C, size_t ldc
+    ){
+        gemm(M, N, K, T{1}, A, lda, B, ldb, T{}, C, ldc);
+    }
+
+}
+
+#endif
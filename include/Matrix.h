@@ -3,14 +3,20 @@
 
 #include <iostream>
 #include <type_traits>
-#include "core.h"
+#include "Compare.h"
+#include "Trace.h"
+#include "Bounds.h"
+#include "Expression.h"
+#include "ThreadPool.h"
+#include "Blas.h"
 #include "Vector.h"
+#include "View.h"
 
 template<typename T, size_t R, size_t C>
-class Matrix{
+class Matrix : private trace::Traced<trace::Type::Matrix>{
 
     static_assert(
-        std::is_arithmetic<T>::value,
+        numeric::Element<T>,
         "Matrix class can only store integral or floating point values"
     );
 
@@ -35,19 +41,57 @@ class Matrix{
         return os;
     }
 
-    friend Matrix operator*(const T&& scalar, const Matrix& matrix){
-        return matrix * scalar;
-    }
+    template<typename Destination> friend class expr::NoAlias;
 
-    friend Matrix operator*(const T& scalar, const Matrix& matrix){
-        return matrix * scalar;
-    }
+    template<typename U, size_t Rows, size_t Columns> friend class Matrix;
 
 
     private:
 
         T element[R][C];    // array to store matrix elements
 
+        // Evaluates an expression element by element into this matrix, in a
+        // single pass over the rows and without temporaries (split into
+        // row blocks across the thread pool for large matrices). A product
+        // is written as a whole by gemm().
+        template<typename Op, typename E>
+        constexpr void evaluate(const E& expression){
+
+            if constexpr (not expr::FixedShape<E>){
+                if (expression.shape() != shape()){
+                    throw std::invalid_argument("Matrix dimensions do not match");
+                }
+            }
+
+            if constexpr (expr::Evaluable<E>){
+
+                expression.template evaluateInto<Op>(*this);
+
+            } else if (expr::aliases(expression, *this)){
+
+                evaluate<Op>(typename E::result_type{expression});
+
+            } else {
+
+                auto rows = [&](size_t begin, size_t end){
+                    for (size_t i{begin}; i<end; ++i){
+                        for (size_t j{}; j<C; ++j){
+                            Op::apply(element[i][j], expression.eval(i, j));
+                        }
+                    }
+                };
+
+                if constexpr (R * C >= parallel::minimumWork){
+                    if !consteval {
+                        parallel::forBlocks(R, C, 1, rows);
+                        return;
+                    }
+                }
+
+                rows(0, R);
+            }
+        }
+
 
         // template<typename CstyleArray>
         // void assignRow(size_t rowIndex, const CstyleArray& row) {
@@ -69,13 +113,11 @@ class Matrix{
     /******** Constructors - Assignment Operators - Destructor ***************/
 
     // Default Constructor
-    Matrix(): element{} {
-        std::cout << "Matrix's default constructor called" << std::endl;
-    }
+    constexpr Matrix() noexcept : element{} {}
 
     // Variadic Template Constructor
     template<size_t ... Cs>
-    Matrix(const T (&...rows)[Cs]): Matrix{} {
+    constexpr Matrix(const T (&...rows)[Cs]) noexcept : Matrix{} {
 
         static_assert(
             sizeof...(Cs) == R,
@@ -85,7 +127,7 @@ class Matrix{
         static_assert(((Cs == C) && ...),
             "Each Row provided must have exactly C elements");
 
-        std::cout << "Matrix's variadic constructor called" << std::endl;
+        // construction already traced by the delegated default constructor
         
         const T* ptrElement[R] {rows...};
 
@@ -111,78 +153,151 @@ class Matrix{
         // );
     }
 
-    // Copy Constructor
-    Matrix(const Matrix& source){
+    // Copy and Move Constructors, Copy and Move Assignment Operators
+    // Defaulted, so that Matrix is trivially copyable and its moves are
+    // noexcept
+    constexpr Matrix(const Matrix& source) = default;
+    constexpr Matrix(Matrix&& source) = default;
+    constexpr Matrix& operator=(const Matrix& rhs) = default;
+    constexpr Matrix& operator=(Matrix&& rhs) = default;
+
+    // Expression Constructor (evaluates a whole expression in one pass)
+    template<expr::EvaluatesTo<Matrix> E>
+    constexpr Matrix(const E& expression): element{} {
+        evaluate<expr::Assign>(expression);
+    }
+
+    // Converting Constructor from an expression of run-time dimensions (a
+    // view, an expression involving a DynMatrix), which are checked
+    template<expr::Expression E>
+        requires (
+            not expr::Terminal<E> and not expr::FixedShape<E>
+            and expr::Compatible<Matrix, E>
+        )
+    constexpr explicit Matrix(const E& expression): element{} {
+        evaluate<expr::Assign>(expression);
+    }
 
-        std::cout << "Matrix's copy constructor called" << std::endl;
+    // Expression Assignment Operator
+    template<expr::Expression E>
+        requires (not expr::Terminal<E> and expr::Compatible<Matrix, E>)
+    constexpr Matrix& operator=(const E& expression){
+        if constexpr (E::elementwise){
+            evaluate<expr::Assign>(expression);
+        } else {
+            *this = Matrix{expression};
+        }
+        return *this;
+    }
 
-        for (size_t i{}; i<R; ++i){
+    // Default destructor
+    ~Matrix() = default;
 
-            for (size_t j{}; j<C; ++j){
-                element[i][j] = source.element[i][j];
-            }
 
-        }
+    /********************** Expression Interface **************************/
+
+    using result_type = Matrix;
+    using value_type = T;
+    static constexpr bool elementwise = true;
+
+    // Extents, as reported by every expression
+    static constexpr std::array<size_t, 2> shape(){
+        return {R, C};
     }
-    
-    // Move Constructor
-    Matrix(const Matrix&& source){
 
-        std::cout << "Matrix's move constructor called" << std::endl;
+    // Distances between consecutive rows and between consecutive columns
+    static constexpr std::array<size_t, 2> strides(){
+        return {C, 1};
+    }
 
-        for (size_t i{}; i<R; ++i){
+    // Unchecked element access used by expression evaluation
+    constexpr const T& eval(size_t rowIndex, size_t columnIndex) const {
+        return element[rowIndex][columnIndex];
+    }
 
-            for (size_t j{}; j<C; ++j){
+    // Assignment target that skips the aliasing safeguard of operator=
+    constexpr expr::NoAlias<Matrix> noalias(){
+        return expr::NoAlias<Matrix>{*this};
+    }
 
-                element[i][j] = source.element[i][j];
-            }
+    // Pointer to the R*C elements, stored contiguously row by row
+    T* data(){
+        return &element[0][0];
+    }
 
-        }
+    const T* data() const {
+        return &element[0][0];
+    }
 
+    // View of the whole matrix (view().transpose() for its transpose). The
+    // views below are not available on a temporary, which they would outlive
+    constexpr MatrixView<T> view() & {
+        return MatrixView<T>{&element[0][0], R, C};
     }
 
-    // Copy Assignment Operator
-    Matrix& operator=(const Matrix& rhs){
+    constexpr MatrixView<const T> view() const& {
+        return MatrixView<const T>{&element[0][0], R, C};
+    }
 
-        std::cout << "Matrix's copy assignment operator called" << std::endl;
+    MatrixView<const T> view() const&& = delete;
 
-        if (this == &rhs){
-            return *this;
-        }
+    // View of the transpose, which moves nothing, and the transposition of
+    // a square matrix in place (cache-oblivious, see kernel::transpose).
+    // m = m.transpose() is correct but goes through a temporary (the view
+    // overlaps m); transposeInPlace() moves the elements within m.
+    constexpr MatrixView<T> transpose() & {
+        return view().transpose();
+    }
 
-        for (size_t i{}; i<R; ++i){
+    constexpr MatrixView<const T> transpose() const& {
+        return view().transpose();
+    }
 
-            for (size_t j{}; j<C; ++j){
-                element[i][j] = rhs.element[i][j];
-            }
+    MatrixView<const T> transpose() const&& = delete;
 
+    constexpr void transposeInPlace() requires (R == C) {
+        if consteval {
+            for (size_t i{}; i<R; ++i){
+                for (size_t j{i + 1}; j<C; ++j){
+                    std::swap(element[i][j], element[j][i]);
+                }
+            }
+        } else {
+            kernel::transpose(R, &element[0][0], C);
         }
+    }
 
-        return *this;
+    // Views of the i-th row, of the j-th column and of the rows x columns
+    // block whose top-left element is (i, j)
+    constexpr VectorView<T> row(size_t index) & {
+        return view().row(index);
     }
 
-    // Move Assignment Operator
-    Matrix& operator=(const Matrix&& rhs){
+    constexpr VectorView<const T> row(size_t index) const& {
+        return view().row(index);
+    }
 
-        std::cout << "Matrix's move assignment operator called" << std::endl;
+    VectorView<const T> row(size_t index) const&& = delete;
 
-        if (this == &rhs){
-            return *this;
-        }
+    constexpr VectorView<T> column(size_t index) & {
+        return view().column(index);
+    }
 
-        for (size_t i{}; i<R; ++i){
+    constexpr VectorView<const T> column(size_t index) const& {
+        return view().column(index);
+    }
 
-            for (size_t j{}; j<C; ++j){
-                element[i][j] = rhs.element[i][j];
-            }
+    VectorView<const T> column(size_t index) const&& = delete;
 
-        }
+    constexpr MatrixView<T> block(size_t i, size_t j, size_t rows, size_t columns) & {
+        return view().block(i, j, rows, columns);
+    }
 
-        return *this;
+    constexpr MatrixView<const T> block(size_t i, size_t j, size_t rows, size_t columns) const& {
+        return view().block(i, j, rows, columns);
     }
 
-    // Default destructor
-    ~Matrix() = default;
+    MatrixView<const T> block(size_t i, size_t j, size_t rows, size_t columns) const&& = delete;
 
 
     /****************** Methods - Overloaded Operators ********************/
@@ -199,14 +314,14 @@ class Matrix{
     // }
 
     // Subscript or Array Index Operator (Const overload for read-only access)
-    const T ( & operator[](size_t index) const  )[C] {
+    constexpr const T ( & operator[](size_t index) const  )[C] {
         // just a fancy definition of the above operator overload
         /*
             Matrix m;
             m[i]; returns reference of i-th row
             m[i][j]; returns the element of i-th row and j-th column    */
 
-        if (index >= R) throw std::out_of_range("Index out of bounds");
+        bounds::debugCheck(index, R);
 
         return element[index];
     }
@@ -222,7 +337,7 @@ class Matrix{
     // }
 
     // Subscript or Array Index Operator, (Non-const overload for read/write access)
-    T ( & operator[](size_t index) )[C] {
+    constexpr T ( & operator[](size_t index) )[C] {
         // just a fancy definition of the above operator overload
 
         /*
@@ -230,179 +345,117 @@ class Matrix{
             m[i]; returns reference of i-th row
             m[i][j]; returns the element of i-th row and j-th column    */
 
-        if (index >= R) throw std::out_of_range("Index out of bounds");
+        bounds::debugCheck(index, R);
 
         return element[index];
     }
 
     // Subscript or Array Index Operator (Const overload for read-only access)
-    const T&  operator[](size_t rowIndex, size_t columnIndex) const {
+    constexpr const T&  operator[](size_t rowIndex, size_t columnIndex) const {
         /*
             Matrix m;
-            m[i, j]; returns the element of i-th row and j-th column    */
+            m[i, j]; returns the element of i-th row and j-th column
+            (checked only when bounds are, see Bounds.h, and by m.at(i, j)) */
 
-        if (rowIndex >= R or columnIndex >= C) throw std::out_of_range("Index out of bounds");
+        bounds::debugCheck(rowIndex, R);
+        bounds::debugCheck(columnIndex, C);
 
         return element[rowIndex][columnIndex];
     }
 
     // Subscript or Array Index Operator (Non-const overload for read/write access)
-    T&  operator[](size_t rowIndex, size_t columnIndex) {
+    constexpr T&  operator[](size_t rowIndex, size_t columnIndex) {
         /*
             Matrix m;
             m[i, j]; returns the element of i-th row and j-th column    */
         
-        if (rowIndex >= R or columnIndex >= C) throw std::out_of_range("Index out of bounds");
+        bounds::debugCheck(rowIndex, R);
+        bounds::debugCheck(columnIndex, C);
 
         return element[rowIndex][columnIndex];  
     }
+
+    // Checked element access
+    constexpr const T& at(size_t rowIndex, size_t columnIndex) const {
+        bounds::check(rowIndex, R);
+        bounds::check(columnIndex, C);
+        return element[rowIndex][columnIndex];
+    }
+
+    constexpr T& at(size_t rowIndex, size_t columnIndex) {
+        bounds::check(rowIndex, R);
+        bounds::check(columnIndex, C);
+        return element[rowIndex][columnIndex];
+    }
    
 
-    // Equal-to Operator (==)
-    bool operator==(const Matrix& rhs) const {
+    // Equal-to Operator (==), comparing all R*C elements as one array (row by
+    // row in constant evaluation, where data() cannot cross rows)
+    constexpr bool operator==(const Matrix& rhs) const {
 
-        for (size_t i{}; i<R; ++i){
+        if consteval {
 
-            for (size_t j{}; j<C; ++j){
+            for (size_t i{}; i<R; ++i){
 
-                if ( not isEqual(element[i][j], rhs.element[i][j]) ){
+                if ( not compare::equal(element[i], rhs.element[i], C) ){
                     return false;
                 }
 
             }
 
+            return true;
         }
 
-        return true;
+        return compare::equal(data(), rhs.data(), R * C);
     }
 
     // Not-Equal-to Operator (!=)
-    bool operator!=(const Matrix& rhs) const {
+    constexpr bool operator!=(const Matrix& rhs) const {
         return !(*this == rhs);
     }
 
-    // Addition Arithmetic Operator (+)
-    Matrix operator+(const Matrix& rhs) const {
-        
-        Matrix temp{};
-
-        for (size_t i{}; i<R; ++i){
-
-            for (size_t j{}; j<C; ++j){
-
-                temp.element[i][j] = element[i][j] + rhs.element[i][j];
-
-            }
-        
-        }
-
-        return temp;
-    }
-
-    // Subtraction Arithmetic Operator (+)
-    Matrix operator-(const Matrix& rhs) const {
-        
-        Matrix temp{};
-
-        for (size_t i{}; i<R; ++i){
-
-            for (size_t j{}; j<C; ++j){
-
-                temp.element[i][j] = element[i][j] - rhs.element[i][j];
-
-            }
-        
-        }
-
-        return temp;
-    }
-
     // Compound Assignment Operator (+=)
-    void operator+=(const Matrix& rhs) {
-
-        for (size_t i{}; i<R; ++i){
-
-            for (size_t j{}; j<C; ++j){
-
-                element[i][j] += rhs.element[i][j];
-
-            }
-        
+    template<expr::Expression E> requires expr::Compatible<Matrix, E>
+    constexpr void operator+=(const E& rhs) {
+        if constexpr (E::elementwise){
+            evaluate<expr::AddAssign>(rhs);
+        } else {
+            evaluate<expr::AddAssign>(Matrix{rhs});
         }
     }
 
     // Compound Assignment Operator (-=)
-    void operator-=(const Matrix& rhs) {
-        
-        for (size_t i{}; i<R; ++i){
-
-            for (size_t j{}; j<C; ++j){
-
-                element[i][j] -= rhs.element[i][j];
-
-            }
-        
+    template<expr::Expression E> requires expr::Compatible<Matrix, E>
+    constexpr void operator-=(const E& rhs) {
+        if constexpr (E::elementwise){
+            evaluate<expr::SubtractAssign>(rhs);
+        } else {
+            evaluate<expr::SubtractAssign>(Matrix{rhs});
         }
     }
 
-    // scalar Multiplication Operator
-    Matrix operator*(const T& scalar) const {
-        Matrix scaledMatrix {*this};
-
+    constexpr void operator *=(const T& scalar) {
         for (size_t i{}; i<R; ++i){
-
             for (size_t j{}; j<C; ++j){
-
-                scaledMatrix.element[i][j] *= scalar;
-
+                element[i][j] *= scalar;
             }
-        
         }
-
-        return scaledMatrix;
     }
 
+    // Matrix Multiplication Operator
+    // Returns a product node, evaluated by gemm() (and so by the kernel
+    // chosen at compile time from the dimensions, see Gemm.h) straight into
+    // the matrix it is assigned to
     template<size_t C_rhs>
-    Matrix<T, R, C_rhs> operator*(const Matrix<T, C, C_rhs>& rhs) const {
-        
-        Matrix<T, R, C_rhs> resMat {};
-        
-        for (size_t i{}; i<R; ++i){
-
-            for (size_t j{}; j<C_rhs; ++j){
-
-                for (size_t k{}; k<C; ++k){
-
-                    resMat[i][j] += element[i][k] * rhs[k][j];
-
-                    //or
-                    // resMat[i, j] += element[i][k] * rhs[k, j];
-
-                }
-
-            }
-
-        }
-
-        return resMat;
-
+    constexpr expr::Product<Matrix, Matrix<T, C, C_rhs>, Matrix<T, R, C_rhs>>
+    operator*(const Matrix<T, C, C_rhs>& rhs) const {
+        return {*this, rhs};
     }
 
-    Vector<T, R> operator*(const Vector<T, C>& rhsVector) const {
-
-        Vector<T, R> lhsVector{};
-
-        for (size_t i{}; i<R; ++i){
-            
-            for (size_t j{}; j<C; ++j){
-
-                lhsVector[i] += element[i][j] * rhsVector[j];
-
-            }
-        }
-
-        return lhsVector;
-
+    // Matrix-Vector Multiplication Operator (evaluated by gemv())
+    constexpr expr::Product<Matrix, Vector<T, C>, Vector<T, R>>
+    operator*(const Vector<T, C>& rhsVector) const {
+        return {*this, rhsVector};
     }
 
 };
@@ -410,4 +463,10 @@ class Matrix{
 template<typename T, size_t ... Cs>
 Matrix(const T (&...arr)[Cs]) -> Matrix<T, sizeof...(arr), (Cs + ... + 0)/sizeof...(Cs)>;
 
+#ifndef MYMATH_ENABLE_TRACE
+static_assert(std::is_trivially_copyable_v<Matrix<double, 3, 3>>);
+static_assert(sizeof(Matrix<double, 3, 3>) == 9 * sizeof(double));
+#endif
+static_assert(std::is_nothrow_move_constructible_v<Matrix<double, 3, 3>>);
+
 #endif
@@ -0,0 +1,319 @@
+#ifndef _MEMORY_H_
+#define _MEMORY_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <utility>
+#include <vector>
+
+/*
+    Where the heap buffers of DynVector, DynMatrix, SparseMatrix, the
+    batches and the temporaries of the library come from.
+
+    Every buffer draws from a std::pmr::memory_resource: the one given to
+    its constructor, or else the current resource of the thread that
+    creates it, memory::resource(). By default that is memory::heap(),
+    aligned operator new and delete, counting what it does:
+
+        memory::resetStats();
+        ...
+        memory::stats().allocations        // heap allocations since
+
+    A memory::Arena is a bump allocator over a few large chunks: allocating
+    moves a pointer, and deallocating does nothing, the memory is given back
+    in bulk by rewinding the arena. A memory::Scope makes an arena the
+    current resource of the thread and rewinds it when it ends, so that
+    every temporary created inside comes from the arena:
+
+        memory::Arena arena {};
+        for (...){
+            memory::Scope scope {arena};
+            x = solver.solve(b - a * x);    // temporaries in the arena
+        }
+
+    Once the arena has grown to what an iteration needs, the loop allocates
+    nothing. An object must not outlive the scope its buffer was allocated
+    in (declare the results before the scope, as x above): moving into an
+    object whose buffer comes from another resource copies the elements
+    instead of stealing them, as std::pmr containers do, but moving into a
+    new object takes the buffer along.
+
+    The arena and the current resource are per thread: the thread pool's
+    workers allocate from the heap, and an Arena must only be used by one
+    thread at a time. The heap statistics are global.
+
+    Buffers that outlive any scope, the per-thread packing buffers of gemm()
+    and Strassen and the task queues of the thread pool, always come from
+    memory::heap(): they are counted when they grow (in every thread of the
+    pool, on the first product large enough), and then reused. The
+    statistics do not cover the standard containers of setup and I/O: the
+    threads and queue objects the pool creates once, the scratch arrays of
+    a SparseMatrix built from triplets, the strings and buffers of
+    Serialize.h, and the blocks and producer thread of Pipeline::run().
+*/
+
+namespace memory{
+
+    // Snapshot of the heap counters
+    struct Stats{
+        size_t allocations;
+        size_t deallocations;
+        size_t bytesInUse;
+        size_t peakBytes;     // most bytes in use at once since the last reset
+    };
+
+    namespace detail{
+
+        inline std::atomic<size_t> allocations {};
+        inline std::atomic<size_t> deallocations {};
+        inline std::atomic<size_t> bytesInUse {};
+        inline std::atomic<size_t> peakBytes {};
+
+        inline thread_local std::pmr::memory_resource* current {nullptr};
+
+    }
+
+    // Aligned operator new and delete, counted
+    class Heap final : public std::pmr::memory_resource{
+
+        private:
+
+            void* do_allocate(size_t bytes, size_t alignment) override {
+
+                void* pointer {::operator new(bytes, std::align_val_t{alignment})};
+
+                detail::allocations.fetch_add(1, std::memory_order_relaxed);
+
+                const size_t inUse {detail::bytesInUse.fetch_add(bytes, std::memory_order_relaxed) + bytes};
+                size_t peak {detail::peakBytes.load(std::memory_order_relaxed)};
+                while (peak < inUse and not detail::peakBytes.compare_exchange_weak(peak, inUse, std::memory_order_relaxed)){}
+
+                return pointer;
+            }
+
+            void do_deallocate(void* pointer, size_t bytes, size_t alignment) override {
+                ::operator delete(pointer, std::align_val_t{alignment});
+                detail::deallocations.fetch_add(1, std::memory_order_relaxed);
+                detail::bytesInUse.fetch_sub(bytes, std::memory_order_relaxed);
+            }
+
+            bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+                return this == &other;
+            }
+
+    };
+
+    inline Heap* heap() noexcept {
+        static Heap instance {};
+        return &instance;
+    }
+
+    // Current resource of the calling thread
+    inline std::pmr::memory_resource* resource() noexcept {
+        return detail::current != nullptr ? detail::current : heap();
+    }
+
+    // Returns the heap counters
+    inline Stats stats() noexcept {
+        return Stats{
+            detail::allocations.load(std::memory_order_relaxed),
+            detail::deallocations.load(std::memory_order_relaxed),
+            detail::bytesInUse.load(std::memory_order_relaxed),
+            detail::peakBytes.load(std::memory_order_relaxed)
+        };
+    }
+
+    // Clears the allocation counters (the bytes in use are kept)
+    inline void resetStats() noexcept {
+        detail::allocations.store(0, std::memory_order_relaxed);
+        detail::deallocations.store(0, std::memory_order_relaxed);
+        detail::peakBytes.store(detail::bytesInUse.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+
+    /*************************** Arena *******************************/
+
+    // Bump allocator over chunks taken from upstream, each twice as large as
+    // the previous one. Deallocation does nothing; rewind() and reset() make
+    // the memory allocated since a mark available again, keeping the chunks,
+    // and release() returns the chunks.
+    class Arena final : public std::pmr::memory_resource{
+
+        private:
+
+            struct Chunk{
+                std::byte* begin;
+                size_t size;
+            };
+
+            static constexpr size_t chunkAlignment = 64;
+
+            std::pmr::memory_resource* upstream;
+            std::vector<Chunk> chunks;
+            size_t chunk;           // the chunk allocated from
+            size_t offset;          // first free byte of that chunk
+            size_t firstSize;
+            size_t highWater;
+
+            static size_t alignUp(size_t offset, size_t alignment){
+                return (offset + alignment - 1) / alignment * alignment;
+            }
+
+            void* do_allocate(size_t bytes, size_t alignment) override {
+
+                while (chunk < chunks.size()){
+
+                    const size_t begin {alignUp(offset, alignment)};
+
+                    if (begin + bytes <= chunks[chunk].size){
+                        offset = begin + bytes;
+                        highWater = std::max(highWater, used());
+                        return chunks[chunk].begin + begin;
+                    }
+
+                    if (chunk + 1 == chunks.size()){
+                        break;
+                    }
+
+                    ++chunk;
+                    offset = 0;
+                }
+
+                // no chunk left that fits: add one at the end
+                const size_t size {std::max({
+                    firstSize,
+                    chunks.empty() ? size_t{} : 2 * chunks.back().size,
+                    alignUp(bytes, chunkAlignment) + std::max(alignment, chunkAlignment)
+                })};
+
+                chunks.push_back(Chunk{
+                    static_cast<std::byte*>(upstream->allocate(size, std::max(alignment, chunkAlignment))),
+                    size
+                });
+
+                chunk = chunks.size() - 1;
+                offset = bytes;
+                highWater = std::max(highWater, used());
+
+                return chunks.back().begin;
+            }
+
+            void do_deallocate(void*, size_t, size_t) override {}
+
+            bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+                return this == &other;
+            }
+
+        public:
+
+        // Position of the arena, to rewind to
+        struct Mark{
+            size_t chunk;
+            size_t offset;
+        };
+
+        /******** Constructors - Assignment Operators - Destructor ***********/
+
+        // Constructor (the first chunk, of firstSize bytes or more, is
+        // allocated on first use)
+        explicit Arena(size_t firstSize = size_t{1} << 20, std::pmr::memory_resource* upstream = heap())
+        : upstream{upstream}, chunks{}, chunk{0}, offset{0}, firstSize{firstSize}, highWater{0} {}
+
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        // Destructor (returns the chunks)
+        ~Arena(){
+            release();
+        }
+
+
+        /******************** Methods *****************************/
+
+        Mark mark() const noexcept {
+            return Mark{chunk, offset};
+        }
+
+        // Frees everything allocated since mark (taken from this arena)
+        void rewind(Mark mark) noexcept {
+            chunk = mark.chunk;
+            offset = mark.offset;
+        }
+
+        // Frees everything, keeping the chunks for what comes next
+        void reset() noexcept {
+            rewind(Mark{0, 0});
+        }
+
+        // Frees everything and returns the chunks upstream
+        void release() noexcept {
+            for (const Chunk& c : chunks){
+                upstream->deallocate(c.begin, c.size, chunkAlignment);
+            }
+            chunks.clear();
+            reset();
+        }
+
+        // Bytes allocated and not rewound (including alignment padding, and
+        // the ends of the chunks skipped)
+        size_t used() const noexcept {
+            size_t result {offset};
+            for (size_t i{}; i<chunk and i<chunks.size(); ++i){
+                result += chunks[i].size;
+            }
+            return result;
+        }
+
+        // Most bytes used at once
+        size_t peak() const noexcept {
+            return highWater;
+        }
+
+        // Bytes held in chunks
+        size_t capacity() const noexcept {
+            size_t result {};
+            for (const Chunk& c : chunks){
+                result += c.size;
+            }
+            return result;
+        }
+
+    };
+
+    // Makes a resource the current one of the calling thread, until the
+    // scope ends. The scope of an arena also rewinds it when it ends,
+    // freeing everything allocated inside.
+    class Scope{
+
+        private:
+
+            Arena* arena;
+            Arena::Mark start;
+            std::pmr::memory_resource* previous;
+
+        public:
+
+        explicit Scope(Arena& arena) noexcept
+        : arena{&arena}, start{arena.mark()}, previous{std::exchange(detail::current, &arena)} {}
+
+        explicit Scope(std::pmr::memory_resource* resource) noexcept
+        : arena{nullptr}, start{}, previous{std::exchange(detail::current, resource)} {}
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        ~Scope(){
+            detail::current = previous;
+            if (arena != nullptr){
+                arena->rewind(start);
+            }
+        }
+
+    };
+
+}
+
+#endif
@@ -0,0 +1,171 @@
+#ifndef _NUMERIC_H_
+#define _NUMERIC_H_
+
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <ostream>
+#include <type_traits>
+
+/*
+    Element types of the vectors, matrices and tensors: the built-in
+    arithmetic types, and two 16-bit floating point storage formats that
+    halve the memory traffic of float:
+
+        numeric::half       IEEE binary16 (_Float16: 11 significant bits,
+                            up to 65504), where the compiler supports it
+                            (GCC 12 and Clang 15 on x86-64, among others;
+                            MYMATH_HAS_FLOAT16 is then defined)
+        numeric::bfloat16   the upper half of a float (8 significant bits,
+                            the range of float)
+
+    Their arithmetic goes through float, and the sums of dot(), gemv() and
+    gemm() accumulate in float (numeric::accumulator_t) before the result
+    is rounded back, so that long sums do not lose what 16-bit partial sums
+    would:
+
+        Matrix<numeric::bfloat16, 512, 512> a {...};   // half the bytes
+        Vector<float, 512> y = a * x;                   // read as bfloat16,
+                                                        // summed in float
+
+    Operands of different element types combine into the promoted type
+    (numeric::promote_t), as the built-in types do: float and double give
+    double, an integer and a floating point type the floating point type,
+    and the 16-bit formats with float give float.
+*/
+
+#if defined(__FLT16_MAX__)
+#define MYMATH_HAS_FLOAT16
+#endif
+
+namespace numeric{
+
+    #ifdef MYMATH_HAS_FLOAT16
+    using half = _Float16;
+    #endif
+
+    // bfloat16: a float rounded (to nearest even) to its upper 16 bits.
+    // Converts implicitly from and to float, through which its arithmetic
+    // is done.
+    class bfloat16{
+
+        private:
+
+            std::uint16_t bits;
+
+            static constexpr std::uint16_t round(float x) noexcept {
+
+                const std::uint32_t u {std::bit_cast<std::uint32_t>(x)};
+
+                // NaN stays a (quiet) NaN rather than rounding to infinity
+                if ((u & 0x7FFFFFFFu) > 0x7F800000u){
+                    return static_cast<std::uint16_t>((u >> 16) | 0x40u);
+                }
+
+                return static_cast<std::uint16_t>((u + 0x7FFFu + ((u >> 16) & 1u)) >> 16);
+            }
+
+        public:
+
+        constexpr bfloat16() noexcept : bits{0} {}
+
+        constexpr bfloat16(float x) noexcept : bits{round(x)} {}
+
+        template<typename U>
+            requires (std::is_arithmetic_v<U> and not std::same_as<U, float>)
+        constexpr bfloat16(U x) noexcept : bits{round(static_cast<float>(x))} {}
+
+        #ifdef MYMATH_HAS_FLOAT16
+        constexpr bfloat16(half x) noexcept : bits{round(static_cast<float>(x))} {}
+        #endif
+
+        constexpr operator float() const noexcept {
+            return std::bit_cast<float>(static_cast<std::uint32_t>(bits) << 16);
+        }
+
+        // The 16 bits, and the bfloat16 made of them
+        constexpr std::uint16_t raw() const noexcept {
+            return bits;
+        }
+
+        static constexpr bfloat16 fromRaw(std::uint16_t bits) noexcept {
+            bfloat16 result {};
+            result.bits = bits;
+            return result;
+        }
+
+        constexpr bfloat16& operator+=(float rhs) noexcept {
+            return *this = bfloat16{static_cast<float>(*this) + rhs};
+        }
+
+        constexpr bfloat16& operator-=(float rhs) noexcept {
+            return *this = bfloat16{static_cast<float>(*this) - rhs};
+        }
+
+        constexpr bfloat16& operator*=(float rhs) noexcept {
+            return *this = bfloat16{static_cast<float>(*this) * rhs};
+        }
+
+        constexpr bfloat16& operator/=(float rhs) noexcept {
+            return *this = bfloat16{static_cast<float>(*this) / rhs};
+        }
+
+        friend std::ostream& operator<<(std::ostream& os, bfloat16 x){
+            return os << static_cast<float>(x);
+        }
+
+    };
+
+    static_assert(sizeof(bfloat16) == 2 and std::is_trivially_copyable_v<bfloat16>);
+
+    // The 16-bit storage formats
+    template<typename T>
+    concept Reduced = (
+        std::same_as<T, bfloat16>
+        #ifdef MYMATH_HAS_FLOAT16
+        or std::same_as<T, half>
+        #endif
+    );
+
+    // Types the vectors, matrices and tensors can hold
+    template<typename T>
+    concept Element = std::is_arithmetic_v<T> or Reduced<T>;
+
+    // Type in which sums of T are accumulated
+    template<typename T>
+    using accumulator_t = std::conditional_t<Reduced<T>, float, T>;
+
+    // Element type of an operation between elements of types A and B
+    template<typename A, typename B>
+    struct Promote{
+        using type = std::common_type_t<A, B>;
+    };
+
+    template<typename A>
+    struct Promote<A, A>{
+        using type = A;
+    };
+
+    template<typename A> requires (not std::same_as<A, bfloat16>)
+    struct Promote<bfloat16, A>{
+        using type = std::conditional_t<
+            std::integral<A>, bfloat16, std::common_type_t<float, A>
+        >;
+    };
+
+    template<typename A> requires (not std::same_as<A, bfloat16>)
+    struct Promote<A, bfloat16> : Promote<bfloat16, A> {};
+
+    template<typename A, typename B>
+    using promote_t = typename Promote<A, B>::type;
+
+}
+
+#ifdef MYMATH_HAS_FLOAT16
+// Prints a half as the float of the same value
+inline std::ostream& operator<<(std::ostream& os, _Float16 x){
+    return os << static_cast<float>(x);
+}
+#endif
+
+#endif
@@ -0,0 +1,483 @@
+#ifndef _PIPELINE_H_
+#define _PIPELINE_H_
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Simd.h"
+#include "AlignedBuffer.h"
+#include "ThreadPool.h"
+#include "Vector.h"
+#include "Matrix.h"
+#include "Batch.h"
+
+/*
+    Pipelines of fixed transforms applied to large sets of small vectors,
+    streamed through the cache a chunk at a time instead of one stage at a
+    time over the whole set:
+
+        const auto pipeline {
+            stream::Pipeline<double, 3>{}
+                .then(rotation)             // Matrix<double, 3, 3>
+                .translate(offset)          // Vector<double, 3>
+                .then(projection)           // Matrix<double, 2, 3>
+                .each([](std::array<double*, 2> xy, size_t n){ ... })
+        };
+
+        pipeline.process(points, projected);    // spans of Vector<double, 3>
+                                                // and of Vector<double, 2>
+        pipeline.run(source, sink);             // streamed, see run()
+
+    Consecutive matrices and translations are folded when the pipeline is
+    built, into one affine stage y = A * x + b: the three stages above the
+    each() cost one matrix, one vector and one pass. each() takes any
+    function of a chunk, given as the arrays of its components (component c
+    of vector i at components[c][i], as in Batch.h) and its size, which it
+    transforms in place.
+
+    The vectors are taken a chunk at a time, whose copies in every stage fit
+    in L2 (chunkBytes), and converted to structure of arrays so that the SIMD
+    kernels of Simd.h process a pack of vectors per instruction. Then every
+    stage runs over the chunk before the next chunk is read, and the chunks
+    are spread across the thread pool. Nothing the size of the input is
+    ever allocated, where applying the stages one after the other would
+    write (and read again) every intermediate set in full.
+*/
+
+namespace stream{
+
+    // Bytes of a chunk in all its stages, half of a typical L2, so that the
+    // chunk and the tables and stacks of the stage functions fit together
+    inline constexpr size_t chunkBytes = 128 * 1024;
+
+    // y = linear * x + offset, for vectors of C components into vectors of R
+    // (either part being skipped when it is the identity)
+    template<typename T, size_t R, size_t C>
+    struct Affine{
+
+        static constexpr size_t inputs = C;
+        static constexpr size_t outputs = R;
+
+        Matrix<T, R, C> linear {};
+        Vector<T, R> offset {};
+        bool scales {true};
+        bool translates {false};
+
+        // From x[c][i] into y[r][i], for i < n (y may be x if R == C)
+        void apply(const std::array<T*, C>& x, const std::array<T*, R>& y, size_t n) const {
+
+            if (scales){
+                if constexpr (simd::Accelerated<T>){
+                    simd::transform<T, R, C>(linear.data(), x.data(), y.data(), n);
+                } else {
+                    simd::scalar::transform<T, R, C>(linear.data(), x.data(), y.data(), n);
+                }
+            } else if constexpr (R == C){
+                for (size_t r{}; r<R; ++r){
+                    if (y[r] != x[r]) std::memcpy(y[r], x[r], n * sizeof(T));
+                }
+            }
+
+            if (translates){
+                for (size_t r{}; r<R; ++r){
+                    const T b {offset[r]};
+                    T* p {y[r]};
+                    for (size_t i{}; i<n; ++i){
+                        p[i] += b;
+                    }
+                }
+            }
+        }
+    };
+
+    // function(x, n), transforming the n vectors of x in place
+    template<typename T, size_t N, typename Function>
+    struct Each{
+
+        static constexpr size_t inputs = N;
+        static constexpr size_t outputs = N;
+
+        Function function;
+
+        void apply(const std::array<T*, N>& x, const std::array<T*, N>&, size_t n) const {
+            function(x, n);
+        }
+    };
+
+    namespace detail{
+
+        template<typename Stage>
+        inline constexpr bool isAffine = false;
+
+        template<typename T, size_t R, size_t C>
+        inline constexpr bool isAffine<Affine<T, R, C>> = true;
+
+        // The stages but the last
+        template<typename... Stages, size_t... I>
+        auto leading(const std::tuple<Stages...>& stages, std::index_sequence<I...>){
+            return std::tuple{std::get<I>(stages)...};
+        }
+
+        // Components of the arrays each stage writes into its own buffer
+        // (each() works in place, in the buffer of the stage before it)
+        template<typename Stage>
+        constexpr size_t buffered(){
+            return isAffine<Stage> ? Stage::outputs : 0;
+        }
+
+        // Arrays of n elements each, from base and stride elements apart
+        template<typename T, size_t N>
+        std::array<T*, N> arrays(T* base, size_t stride){
+            std::array<T*, N> result {};
+            for (size_t c{}; c<N; ++c){
+                result[c] = base + c*stride;
+            }
+            return result;
+        }
+
+    }
+
+    template<typename T, size_t In, size_t Out = In, typename... Stages>
+    class Pipeline{
+
+        static_assert(
+            std::is_arithmetic<T>::value,
+            "Pipeline class can only process integral or floating point values"
+        );
+
+        template<typename U, size_t I, size_t O, typename... S> friend class Pipeline;
+
+        private:
+
+            std::tuple<Stages...> stages;
+
+            static constexpr size_t lane {batch::detail::lane<T>};
+
+            // Whether then() and translate() fold into the last stage
+            static constexpr bool endsAffine {[]{
+                if constexpr (sizeof...(Stages) == 0) return false;
+                else return detail::isAffine<std::tuple_element_t<sizeof...(Stages) - 1, std::tuple<Stages...>>>;
+            }()};
+
+            // Components stored per vector of a chunk: the input, the output
+            // of every stage with a buffer of its own, and the vectors read
+            // and written one after the other
+            static constexpr size_t footprint {2 * In + Out + (detail::buffered<Stages>() + ... + 0)};
+
+            explicit Pipeline(std::tuple<Stages...> stages) : stages{std::move(stages)} {}
+
+            template<typename Stage>
+            auto append(Stage stage) const {
+                return Pipeline<T, In, Stage::outputs, Stages..., Stage>{
+                    std::tuple_cat(stages, std::tuple{std::move(stage)})
+                };
+            }
+
+            // Replaces the last stage, an affine one, by stage
+            template<typename Stage>
+            auto replaceLast(Stage stage) const {
+                return appendAll(
+                    std::tuple_cat(
+                        detail::leading(stages, std::make_index_sequence<sizeof...(Stages) - 1>{}),
+                        std::tuple{std::move(stage)}
+                    )
+                );
+            }
+
+            template<typename... S>
+            static auto appendAll(std::tuple<S...> stages){
+                constexpr size_t out {std::tuple_element_t<sizeof...(S) - 1, std::tuple<S...>>::outputs};
+                return Pipeline<T, In, out, S...>{std::move(stages)};
+            }
+
+            // Runs the stages from the I-th on x, the arrays of the chunk's n
+            // vectors, with buffers carved from scratch (chunk elements per
+            // array), and returns the arrays of the result
+            template<size_t I, size_t N>
+            std::array<T*, Out> apply(std::array<T*, N> x, size_t n, T* scratch, size_t chunk) const {
+
+                if constexpr (I == sizeof...(Stages)){
+                    static_assert(N == Out);
+                    return x;
+                } else {
+
+                    using Stage = std::tuple_element_t<I, std::tuple<Stages...>>;
+                    constexpr size_t R {Stage::outputs};
+
+                    std::array<T*, R> y {};
+                    if constexpr (detail::buffered<Stage>() == 0){
+                        y = x;
+                    } else {
+                        y = detail::arrays<T, R>(scratch, chunk);
+                    }
+
+                    std::get<I>(stages).apply(x, y, n);
+
+                    return apply<I + 1>(y, n, scratch + detail::buffered<Stage>() * chunk, chunk);
+                }
+            }
+
+            // out[i] = the stages applied to in[i], for the n <= chunk vectors
+            // of one chunk, through the buffers of scratch
+            void processChunk(const Vector<T, In>* in, Vector<T, Out>* out, size_t n, T* scratch, size_t chunk) const {
+
+                const std::array<T*, In> x {detail::arrays<T, In>(scratch, chunk)};
+
+                for (size_t i{}; i<n; ++i){
+                    const T* v {in[i].data()};
+                    for (size_t c{}; c<In; ++c){
+                        x[c][i] = v[c];
+                    }
+                }
+
+                const std::array<T*, Out> y {apply<0>(x, n, scratch + In * chunk, chunk)};
+
+                for (size_t i{}; i<n; ++i){
+                    T* v {out[i].data()};
+                    for (size_t c{}; c<Out; ++c){
+                        v[c] = y[c][i];
+                    }
+                }
+            }
+
+        public:
+
+        /******** Constructors - Assignment Operators - Destructor ***************/
+
+        // Default Constructor: the identity, to which stages are added
+        Pipeline() requires (sizeof...(Stages) == 0 and In == Out) : stages{} {}
+
+        Pipeline(const Pipeline& source) = default;
+        Pipeline(Pipeline&& source) noexcept = default;
+        Pipeline& operator=(const Pipeline& rhs) = default;
+        Pipeline& operator=(Pipeline&& rhs) noexcept = default;
+
+        ~Pipeline() = default;
+
+
+        /**************************** Stages ******************************/
+
+        // x -> m * x, folded into the stage before it if that is affine
+        template<size_t R>
+        auto then(const Matrix<T, R, Out>& m) const {
+
+            if constexpr (endsAffine){
+
+                using Last = std::tuple_element_t<sizeof...(Stages) - 1, std::tuple<Stages...>>;
+                const Last& last {std::get<sizeof...(Stages) - 1>(stages)};
+
+                Affine<T, R, Last::inputs> folded {};
+                folded.linear = last.scales ? Matrix<T, R, Last::inputs>{m * last.linear} : m;
+                folded.offset = Vector<T, R>{m * last.offset};
+                folded.translates = last.translates;
+
+                return replaceLast(folded);
+
+            } else {
+
+                Affine<T, R, Out> stage {};
+                stage.linear = m;
+
+                return append(stage);
+            }
+        }
+
+        // x -> x + offset, folded into the stage before it if that is affine
+        auto translate(const Vector<T, Out>& offset) const {
+
+            if constexpr (endsAffine){
+
+                auto folded {std::get<sizeof...(Stages) - 1>(stages)};
+                folded.offset = Vector<T, Out>{folded.offset + offset};
+                folded.translates = true;
+
+                return replaceLast(folded);
+
+            } else {
+
+                Affine<T, Out, Out> stage {};
+                stage.offset = offset;
+                stage.scales = false;
+                stage.translates = true;
+
+                return append(stage);
+            }
+        }
+
+        // function(components, n) on every chunk, which it transforms in
+        // place: components[c][i] is component c of vector i, for i < n
+        template<typename Function>
+            requires std::invocable<const Function&, const std::array<T*, Out>&, size_t>
+        auto each(Function function) const {
+            return append(Each<T, Out, Function>{std::move(function)});
+        }
+
+        // Number of stages left once folded
+        static constexpr size_t size() noexcept {
+            return sizeof...(Stages);
+        }
+
+        // Vectors per chunk: as many as fit in chunkBytes in every stage, a
+        // multiple of 64 bytes per array
+        static constexpr size_t chunkSize() noexcept {
+            const size_t vectors {chunkBytes / (footprint * sizeof(T))};
+            return std::max(lane, vectors / lane * lane);
+        }
+
+
+        /*************************** Processing ****************************/
+
+        // out[i] = the pipeline applied to in[i], chunk by chunk, the chunks
+        // split across the thread pool (out must hold as many vectors as in,
+        // and must not overlap it)
+        void process(std::span<const Vector<T, In>> in, std::span<Vector<T, Out>> out) const {
+
+            if (in.size() != out.size()){
+                throw std::invalid_argument("Batch sizes do not match");
+            }
+
+            constexpr size_t chunk {chunkSize()};
+            const size_t chunks {(in.size() + chunk - 1) / chunk};
+            const size_t arrays {footprint - In - Out};
+
+            parallel::forBlocks(chunks, chunk * In * Out, 1, [&](size_t begin, size_t end){
+
+                AlignedBuffer<T> scratch {arrays * chunk};
+
+                for (size_t k{begin}; k<end; ++k){
+                    const size_t first {k * chunk};
+                    const size_t n {std::min(chunk, in.size() - first)};
+                    processChunk(in.data() + first, out.data() + first, n, scratch.data(), chunk);
+                }
+            });
+        }
+
+        // Streams the vectors source produces through the pipeline into
+        // sink, block by block:
+        //
+        //     size_t source(std::span<Vector<T, In>> block);
+        //         fills the start of block, returns how many it wrote (0 at
+        //         the end of the input)
+        //     void sink(std::span<const Vector<T, Out>> results);
+        //         receives the results, in the order of the input
+        //
+        // source runs on a thread of its own, filling one block while the
+        // other is processed (double buffering), so that reading the input
+        // overlaps the computation; each block is processed as process()
+        // does. An exception thrown by source or sink stops the stream and
+        // is rethrown here. source must not use the thread pool, which the
+        // blocks are processed on.
+        template<typename Source, typename Sink>
+            requires (
+                std::is_invocable_r_v<size_t, Source&, std::span<Vector<T, In>>>
+                and std::invocable<Sink&, std::span<const Vector<T, Out>>>
+            )
+        void run(Source&& source, Sink&& sink, size_t blockSize = 0) const {
+
+            const size_t block {
+                blockSize > 0 ? blockSize : 4 * chunkSize() * parallel::threadCount()
+            };
+
+            std::array<std::vector<Vector<T, In>>, 2> input {
+                std::vector<Vector<T, In>>(block), std::vector<Vector<T, In>>(block)
+            };
+            std::vector<Vector<T, Out>> output(block);
+
+            // filled[b]: vectors in input[b], or 0 while it is free
+            std::array<size_t, 2> filled {};
+            bool finished {false};
+            bool stopped {false};
+            std::exception_ptr failure {};
+            std::mutex mutex;
+            std::condition_variable changed;
+
+            std::thread producer {[&]{
+                try {
+                    for (size_t b{}; ; b ^= 1){
+                        {
+                            std::unique_lock lock {mutex};
+                            changed.wait(lock, [&]{ return filled[b] == 0 or stopped; });
+                            if (stopped) return;
+                        }
+
+                        const size_t n {std::min(block, source(std::span{input[b]}))};
+
+                        std::lock_guard lock {mutex};
+                        filled[b] = n;
+                        finished = n == 0;
+                        changed.notify_all();
+                        if (finished) return;
+                    }
+                } catch (...){
+                    std::lock_guard lock {mutex};
+                    failure = std::current_exception();
+                    finished = true;
+                    changed.notify_all();
+                }
+            }};
+
+            // Stops and joins the producer however this function is left
+            struct Join{
+                std::thread& thread;
+                std::mutex& mutex;
+                std::condition_variable& changed;
+                bool& stopped;
+                ~Join(){
+                    {
+                        std::lock_guard lock {mutex};
+                        stopped = true;
+                    }
+                    changed.notify_all();
+                    thread.join();
+                }
+            } join {producer, mutex, changed, stopped};
+
+            for (size_t b{}; ; b ^= 1){
+
+                size_t n {};
+
+                {
+                    std::unique_lock lock {mutex};
+                    changed.wait(lock, [&]{ return filled[b] > 0 or finished; });
+                    if (filled[b] == 0){
+                        break;
+                    }
+                    n = filled[b];
+                }
+
+                process(
+                    std::span<const Vector<T, In>>{input[b].data(), n},
+                    std::span<Vector<T, Out>>{output.data(), n}
+                );
+
+                {
+                    std::lock_guard lock {mutex};
+                    filled[b] = 0;
+                }
+                changed.notify_all();
+
+                sink(std::span<const Vector<T, Out>>{output.data(), n});
+            }
+
+            std::lock_guard lock {mutex};
+            if (failure){
+                std::rethrow_exception(failure);
+            }
+        }
+
+    };
+
+}
+
+#endif
@@ -0,0 +1,542 @@
+#ifndef _REDUCTION_H_
+#define _REDUCTION_H_
+
+#include <array>
+#include <cmath>
+#include <concepts>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include "Simd.h"
+#include "Expression.h"
+#include "ThreadPool.h"
+#include "Blas.h"
+
+/*
+    Reductions of whole vectors, matrices and tensors, or of any view of
+    one, to a value:
+
+        reduce::sum(m);                 // sum of the elements
+        reduce::min(v);  reduce::max(t);
+        reduce::argmin(v);  reduce::argmax(m);
+                                        // index of the first smallest or
+                                        // largest element, counted in
+                                        // row-major order (NumPy's argmax)
+        reduce::norm2(v);               // Euclidean norm, Frobenius norm of
+                                        // a matrix or tensor
+        reduce::normalize(v);           // v /= norm2(v), returns the norm
+        reduce::dotAndNorms(u, v);      // {u . v, norm2(u), norm2(v)}
+
+    Elements stored contiguously are reduced as one array, otherwise along
+    the rows of the last axis, by the SIMD kernels of Simd.h for float,
+    double and int32 (with four accumulators, so that the additions of
+    consecutive packs do not wait for each other), split into blocks across
+    the thread pool for large objects (ThreadPool.h, whose deterministic
+    mode also fixes the order of these sums). The 16-bit formats are summed
+    in float, and integers in their own type, as dot() does.
+
+    norm2() sums the squares as they are, and only when that sum overflows,
+    or is small enough to have lost elements whose squares underflowed, sums
+    them again scaled by a power of two near the largest element, so that
+    the norm of any finite object is accurate without costing a division
+    per element. dotAndNorms() computes the three sums from a single pass
+    over both objects, for cosine similarities and projections.
+
+    min(), max() and their arguments skip NaN elements (unless all of them
+    are NaN), and throw std::invalid_argument for an empty object, as do
+    the binary reductions for objects whose shapes differ.
+*/
+
+namespace reduce{
+
+    // Objects whose elements are stored in memory, element (i, j, ...) being
+    // data()[i*strides()[0] + j*strides()[1] + ...]: vectors, matrices,
+    // tensors and their views
+    template<typename E>
+    concept Reducible = (
+        expr::Expression<E>
+        and requires(const E& e){
+            { e.data() } -> std::convertible_to<const typename E::value_type*>;
+            e.strides();
+            e.shape();
+        }
+    );
+
+    // Reducible objects of floating point elements (or of a 16-bit format)
+    template<typename E>
+    concept Real = Reducible<E> and not std::integral<typename E::value_type>;
+
+    template<typename T>
+    struct DotNorms{
+        T dot;      // u . v
+        T u;        // norm2(u)
+        T v;        // norm2(v)
+    };
+
+    namespace detail{
+
+        // Elements per block of min() and max(): the block's extremum is
+        // found with SIMD and the block, still in L1, scanned for its index
+        // only when it beats the extremum so far
+        inline constexpr size_t extremumBlock = 1024;
+
+        template<typename E>
+        constexpr size_t rank(){
+            return std::tuple_size_v<decltype(std::declval<const E&>().shape())>;
+        }
+
+        // The three sums of dotAndNorms()
+        template<typename W>
+        struct Products{
+
+            W dot {};
+            W u {};
+            W v {};
+
+            Products& operator+=(const Products& rhs){
+                dot += rhs.dot;
+                u += rhs.u;
+                v += rhs.v;
+                return *this;
+            }
+        };
+
+        template<typename E>
+        size_t count(const E& x){
+            size_t total {1};
+            for (size_t extent : x.shape()){
+                total *= extent;
+            }
+            return total;
+        }
+
+        // Whether the elements of x lie contiguously in row-major order
+        template<typename E>
+        bool contiguous(const E& x){
+
+            const auto extent {x.shape()};
+            const auto stride {x.strides()};
+
+            size_t expected {1};
+
+            for (size_t axis {rank<E>()}; axis-- > 0; ){
+                if (extent[axis] > 1 and stride[axis] != expected){
+                    return false;
+                }
+                expected *= extent[axis];
+            }
+
+            return true;
+        }
+
+        // Calls line(offsets, index) for every row of the last axis of the
+        // shape extent (index being the row-major position of its first
+        // element), offsets holding the position of that element in each of
+        // the objects whose strides are given
+        template<size_t Rank, size_t K, typename Line>
+        void forEachLine(
+            const std::array<size_t, Rank>& extent,
+            const std::array<std::array<size_t, Rank>, K>& strides, const Line& line
+        ){
+            std::array<size_t, Rank> position {};
+            std::array<size_t, K> offsets {};
+
+            const size_t length {extent[Rank - 1]};
+            size_t lines {1};
+
+            for (size_t axis{}; axis + 1 < Rank; ++axis){
+                lines *= extent[axis];
+            }
+
+            for (size_t l{}; l<lines; ++l){
+
+                line(offsets, l * length);
+
+                // Next position of the leading axes, last one fastest
+                for (size_t axis {Rank - 1}; axis-- > 0; ){
+                    for (size_t k{}; k<K; ++k){
+                        offsets[k] += strides[k][axis];
+                    }
+                    if (++position[axis] < extent[axis]){
+                        break;
+                    }
+                    for (size_t k{}; k<K; ++k){
+                        offsets[k] -= position[axis] * strides[k][axis];
+                    }
+                    position[axis] = 0;
+                }
+            }
+        }
+
+        // Calls run(pointer, n, stride, index) over runs of the elements of
+        // x: all of them if contiguous, the rows of the last axis otherwise
+        // (pointer being writable if x is)
+        template<typename E, typename Run>
+        void forEachRun(E& x, const Run& run){
+
+            if (count(x) == 0){
+                return;
+            }
+
+            if (contiguous(x)){
+                run(x.data(), count(x), size_t{1}, size_t{0});
+                return;
+            }
+
+            constexpr size_t R {rank<std::remove_const_t<E>>()};
+            const auto extent {x.shape()};
+            const size_t stride {x.strides()[R - 1]};
+
+            forEachLine(extent, std::array<std::array<size_t, R>, 1>{x.strides()}, [&](const auto& offsets, size_t index){
+                run(x.data() + offsets[0], extent[R - 1], stride, index);
+            });
+        }
+
+        // Sum of the n elements p[i*stride]
+        template<typename T>
+        auto sum(const T* p, size_t n, size_t stride){
+
+            using A = numeric::accumulator_t<T>;
+
+            return parallel::sum<A>(n, 1, [&](size_t begin, size_t end) -> A {
+
+                if constexpr (simd::Accelerated<T>){
+                    if (stride == 1 and end - begin >= simd::minLength){
+                        return simd::sum(p + begin, end - begin);
+                    }
+                }
+
+                A total {};
+
+                for (size_t i{begin}; i<end; ++i){
+                    total += static_cast<A>(p[i*stride]);
+                }
+
+                return total;
+            });
+        }
+
+        // The largest (or smallest) element found so far and its index.
+        // Combining two keeps the lower index of equal values, so that the
+        // result does not depend on how the elements were split.
+        template<typename T, bool Largest>
+        struct Extremum{
+
+            T value {};
+            size_t index {};
+            bool found {false};
+
+            static bool better(T x, T y){
+                return Largest ? x > y : x < y;
+            }
+
+            void consider(T x, size_t i){
+                if (x != x){
+                    return;
+                }
+                if (not found or better(x, value) or (x == value and i < index)){
+                    value = x;
+                    index = i;
+                    found = true;
+                }
+            }
+
+            Extremum& operator+=(const Extremum& rhs){
+                if (rhs.found){
+                    consider(rhs.value, rhs.index);
+                }
+                return *this;
+            }
+        };
+
+        // Extremum of the n elements p[i*stride], the first of them being
+        // element first of the object
+        template<bool Largest, typename T>
+        Extremum<T, Largest> extremum(const T* p, size_t n, size_t stride, size_t first){
+
+            using X = Extremum<T, Largest>;
+
+            return parallel::sum<X>(n, 1, [&](size_t begin, size_t end){
+
+                X best {};
+
+                if constexpr (simd::Accelerated<T>){
+                    if (stride == 1){
+
+                        for (size_t b{begin}; b<end; b+=extremumBlock){
+
+                            const size_t e {std::min(end, b + extremumBlock)};
+                            const T candidate {
+                                Largest ? simd::maximum(p + b, e - b) : simd::minimum(p + b, e - b)
+                            };
+
+                            if (best.found and not X::better(candidate, best.value)){
+                                continue;
+                            }
+
+                            for (size_t i{b}; i<e; ++i){
+                                if (p[i] == candidate){
+                                    best.consider(p[i], first + i);
+                                    break;
+                                }
+                            }
+                        }
+
+                        return best;
+                    }
+                }
+
+                for (size_t i{begin}; i<end; ++i){
+                    best.consider(p[i*stride], first + i);
+                }
+
+                return best;
+            });
+        }
+
+        template<bool Largest, typename E>
+        auto extremum(const E& x){
+
+            using T = typename E::value_type;
+
+            Extremum<T, Largest> best {};
+
+            forEachRun(x, [&](const T* p, size_t n, size_t stride, size_t index){
+                best += extremum<Largest>(p, n, stride, index);
+            });
+
+            if (count(x) == 0){
+                throw std::invalid_argument("Reduction of an empty object");
+            }
+
+            // Only NaN elements: the first one
+            if (not best.found){
+                best.value = x.data()[0];
+                best.index = 0;
+            }
+
+            return best;
+        }
+
+        // Sum of (scale * p[i*stride])^2, in the accumulator type W
+        template<typename W, typename T>
+        W sumSquares(const T* p, size_t n, size_t stride, W scale){
+            return parallel::sum<W>(n, 1, [&](size_t begin, size_t end) -> W {
+
+                if constexpr (simd::Accelerated<T>){
+                    if (stride == 1 and end - begin >= simd::minLength){
+                        return simd::sumSquares(p + begin, end - begin, scale);
+                    }
+                }
+
+                W total {};
+
+                for (size_t i{begin}; i<end; ++i){
+                    const W y {scale * static_cast<W>(p[i*stride])};
+                    total += y * y;
+                }
+
+                return total;
+            });
+        }
+
+        // Sums of u[i*su] * v[i*sv], u[i*su]^2 and v[i*sv]^2, in the
+        // accumulator type W
+        template<typename W, typename T>
+        Products<W> products(const T* u, size_t su, const T* v, size_t sv, size_t n){
+            return parallel::sum<Products<W>>(n, 1, [&](size_t begin, size_t end){
+
+                Products<W> total {};
+
+                if constexpr (simd::Accelerated<T>){
+                    if (su == 1 and sv == 1 and end - begin >= simd::minLength){
+                        W sums[3];
+                        simd::dotNorms(u + begin, v + begin, end - begin, sums);
+                        return Products<W>{sums[0], sums[1], sums[2]};
+                    }
+                }
+
+                for (size_t i{begin}; i<end; ++i){
+                    const W x {static_cast<W>(u[i*su])}, y {static_cast<W>(v[i*sv])};
+                    total.dot += x * y;
+                    total.u += x * x;
+                    total.v += y * y;
+                }
+
+                return total;
+            });
+        }
+
+        // Square root of sum, the sum of squares of the elements of x as they
+        // are, if it neither overflowed nor lost underflowed squares;
+        // otherwise the norm from the squares scaled near the largest element
+        template<typename E, typename W>
+        W norm(const E& x, W sum){
+
+            using T = typename E::value_type;
+
+            if (sum != sum or (std::isfinite(sum) and sum >= std::numeric_limits<W>::min() / std::numeric_limits<W>::epsilon())){
+                return std::sqrt(sum);
+            }
+
+            W largest {};
+
+            forEachRun(x, [&](const T* p, size_t n, size_t stride, size_t){
+                for (size_t i{}; i<n; ++i){
+                    largest = std::max(largest, std::abs(static_cast<W>(p[i*stride])));
+                }
+            });
+
+            if (largest == W{} or not std::isfinite(largest)){
+                return largest;
+            }
+
+            // A power of two, so that scaling is exact, whose inverse is finite
+            const int exponent {std::max(std::ilogb(largest), std::numeric_limits<W>::min_exponent - 1)};
+            const W scale {std::ldexp(W{1}, -exponent)};
+
+            W scaled {};
+
+            forEachRun(x, [&](const T* p, size_t n, size_t stride, size_t){
+                scaled += sumSquares(p, n, stride, scale);
+            });
+
+            return std::ldexp(std::sqrt(scaled), exponent);
+        }
+
+    }
+
+    // Sum of the elements
+    template<Reducible E>
+    typename E::value_type sum(const E& x){
+
+        using T = typename E::value_type;
+
+        numeric::accumulator_t<T> total {};
+
+        detail::forEachRun(x, [&](const T* p, size_t n, size_t stride, size_t){
+            total += detail::sum(p, n, stride);
+        });
+
+        return static_cast<T>(total);
+    }
+
+    // Smallest and largest elements
+    template<Reducible E>
+    typename E::value_type min(const E& x){
+        return detail::extremum<false>(x).value;
+    }
+
+    template<Reducible E>
+    typename E::value_type max(const E& x){
+        return detail::extremum<true>(x).value;
+    }
+
+    // Row-major index of the first smallest and of the first largest element
+    template<Reducible E>
+    size_t argmin(const E& x){
+        return detail::extremum<false>(x).index;
+    }
+
+    template<Reducible E>
+    size_t argmax(const E& x){
+        return detail::extremum<true>(x).index;
+    }
+
+    // Square root of the sum of the squares of the elements (the Euclidean
+    // norm of a vector, the Frobenius norm of a matrix), without overflow or
+    // underflow in the squares
+    template<Real E>
+    typename E::value_type norm2(const E& x){
+
+        using T = typename E::value_type;
+        using W = numeric::accumulator_t<T>;
+
+        W sum {};
+
+        detail::forEachRun(x, [&](const T* p, size_t n, size_t stride, size_t){
+            sum += detail::sumSquares(p, n, stride, W{1});
+        });
+
+        return static_cast<T>(detail::norm(x, sum));
+    }
+
+    // Divides x by its norm, leaving a zero x as it is, and returns the norm
+    template<typename E, typename Object = std::remove_cvref_t<E>>
+        requires (
+            Real<Object>
+            and requires(Object& x){ { x.data() } -> std::same_as<typename Object::value_type*>; }
+        )
+    typename Object::value_type normalize(E&& x){
+
+        using T = typename Object::value_type;
+        using W = numeric::accumulator_t<T>;
+
+        const W norm {static_cast<W>(norm2(x))};
+
+        if (norm == W{} or not std::isfinite(norm)){
+            return static_cast<T>(norm);
+        }
+
+        // Multiplied by the inverse, unless the norm is so small that the
+        // inverse overflows
+        const W inverse {W{1} / norm};
+
+        detail::forEachRun(x, [&](T* p, size_t n, size_t stride, size_t){
+            if constexpr (std::same_as<T, W>){
+                if (std::isfinite(inverse)){
+                    kernel::scal(n, inverse, p, stride);
+                    return;
+                }
+            }
+            for (size_t i{}; i<n; ++i){
+                T& element {p[i*stride]};
+                element = static_cast<T>(static_cast<W>(element) / norm);
+            }
+        });
+
+        return static_cast<T>(norm);
+    }
+
+    // u . v and the norms of u and v, from one pass over both
+    template<Real A, Real B>
+        requires (expr::SameValueType<A, B> and detail::rank<A>() == detail::rank<B>())
+    DotNorms<typename A::value_type> dotAndNorms(const A& u, const B& v){
+
+        using T = typename A::value_type;
+        using W = numeric::accumulator_t<T>;
+
+        if (u.shape() != v.shape()){
+            throw std::invalid_argument("Dimensions do not match");
+        }
+
+        detail::Products<W> total {};
+
+        if (detail::count(u) == 0){
+            // Nothing to sum
+        } else if (detail::contiguous(u) and detail::contiguous(v)){
+            total = detail::products<W>(u.data(), 1, v.data(), 1, detail::count(u));
+        } else {
+            constexpr size_t R {detail::rank<A>()};
+            const auto extent {u.shape()};
+            const size_t su {u.strides()[R - 1]}, sv {v.strides()[R - 1]};
+
+            const std::array<std::array<size_t, R>, 2> strides {u.strides(), v.strides()};
+
+            detail::forEachLine(extent, strides, [&](const auto& offsets, size_t){
+                total += detail::products<W>(
+                    u.data() + offsets[0], su, v.data() + offsets[1], sv, extent[R - 1]
+                );
+            });
+        }
+
+        return {
+            static_cast<T>(total.dot),
+            static_cast<T>(detail::norm(u, total.u)),
+            static_cast<T>(detail::norm(v, total.v))
+        };
+    }
+
+}
+
+#endif
@@ -0,0 +1,701 @@
+#ifndef _SERIALIZE_H_
+#define _SERIALIZE_H_
+
+#include <array>
+#include <bit>
+#include <charconv>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <ios>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Expression.h"
+#include "DynMatrix.h"
+#include "Tensor.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*
+    Binary files of Vector, Matrix, Tensor, DynVector and DynMatrix, and
+    a parser of the text their operator<< writes.
+
+        io::save("a.bin", m);                       // any of them, or a view
+        auto m {io::load<DynMatrix<double>>("a.bin")};
+
+        io::MappedFile file {"a.bin"};              // nothing read yet
+        MatrixView<const double> v {file.matrix<double>()};
+
+        auto t {io::parse<DynMatrix<double>>("1 2 3\n4 5 6")};
+        auto u {io::loadText<Vector<double, 3>>("u.txt")};
+
+    A binary file is a 64-byte header (io::Header: magic, version, element
+    type, byte order, rank, extents and the offset of the elements) followed
+    by the elements in row-major order, starting at a multiple of 64 bytes.
+    They are written and read in one block. MappedFile maps a file into
+    memory instead (mmap, or MapViewOfFile on Windows) and returns views,
+    a span or tensor views of its elements, so that only the pages used are
+    ever read, and a dataset larger than memory can be used in place. The
+    views are valid while the MappedFile lives.
+
+    Files written on a host of the other byte order, or with another element
+    type than the one requested, are rejected (std::invalid_argument), as is
+    a shape that does not fit a fixed-size destination. A file that is not
+    one of ours or is truncated throws std::runtime_error, and a file that
+    cannot be opened std::system_error.
+
+    The text parser reads numbers with std::from_chars, and takes the
+    layout from the destination: the "[ 1 2 3 ]" of the vectors, the rows
+    of the matrices (one per line, for a DynMatrix to take its dimensions
+    from), and the elements of a tensor in row-major order.
+*/
+
+namespace io{
+
+    // Largest rank stored in a file
+    inline constexpr size_t maxRank = 5;
+
+    // Alignment of the elements within a file
+    inline constexpr size_t alignment = 64;
+
+    enum class DType : std::uint8_t {
+        Int8 = 1, UInt8, Int16, UInt16, Int32, UInt32, Int64, UInt64, Float32, Float64,
+        Float16, BFloat16
+    };
+
+    // Element type code of T
+    template<typename T>
+    constexpr DType dtype(){
+
+        static_assert(
+            numeric::Reduced<T> or (
+                std::is_arithmetic_v<T> and not std::same_as<T, bool>
+                and (std::integral<T> or sizeof(T) == 4 or sizeof(T) == 8)
+            ),
+            "io can only store integral values, float, double and the 16-bit formats"
+        );
+
+        if constexpr (std::same_as<T, numeric::bfloat16>){
+            return DType::BFloat16;
+        } else if constexpr (numeric::Reduced<T>){
+            return DType::Float16;
+        } else if constexpr (std::floating_point<T>){
+            return sizeof(T) == 4 ? DType::Float32 : DType::Float64;
+        } else {
+            constexpr std::uint8_t size {static_cast<std::uint8_t>(std::bit_width(sizeof(T)) - 1)};
+            return static_cast<DType>(1 + 2*size + (std::is_signed_v<T> ? 0 : 1));
+        }
+    }
+
+    struct Header{
+        char magic[6];                  // "MYMATH"
+        std::uint8_t version;
+        DType type;
+        std::uint8_t littleEndian;
+        std::uint8_t rank;
+        std::uint16_t alignment;        // of dataOffset
+        std::uint32_t reserved;
+        std::uint64_t dataOffset;       // of the elements, from the start of the file
+        std::uint64_t extent[maxRank];  // extents, the unused ones 1
+    };
+
+    static_assert(sizeof(Header) == 64 and std::is_trivially_copyable_v<Header>);
+
+    namespace detail{
+
+        inline constexpr char magic[6] {'M', 'Y', 'M', 'A', 'T', 'H'};
+        inline constexpr std::uint8_t version {1};
+
+        template<typename E>
+        constexpr size_t rank = std::tuple_size_v<decltype(std::declval<const E&>().shape())>;
+
+        template<typename T, typename Shape>
+        Header header(const Shape& shape){
+
+            Header result {};
+
+            std::memcpy(result.magic, magic, sizeof magic);
+            result.version = version;
+            result.type = dtype<T>();
+            result.littleEndian = std::endian::native == std::endian::little;
+            result.rank = static_cast<std::uint8_t>(shape.size());
+            result.alignment = alignment;
+            result.dataOffset = (sizeof(Header) + alignment - 1) / alignment * alignment;
+
+            for (size_t axis{}; axis<maxRank; ++axis){
+                result.extent[axis] = axis < shape.size() ? shape[axis] : 1;
+            }
+
+            return result;
+        }
+
+        // Number of elements (of a validated header, whose product of the
+        // extents is known not to overflow)
+        inline size_t count(const Header& header){
+            size_t result {1};
+            for (size_t axis{}; axis<header.rank; ++axis){
+                result *= static_cast<size_t>(header.extent[axis]);
+            }
+            return result;
+        }
+
+        // a * b, or false if it overflows size_t
+        inline bool multiply(size_t a, size_t b, size_t& result){
+            if (b != 0 and a > std::numeric_limits<size_t>::max() / b){
+                return false;
+            }
+            result = a * b;
+            return true;
+        }
+
+        // Size in bytes of an element of type code (0 if unknown)
+        inline size_t size(DType type){
+            switch (type){
+                case DType::Int8: case DType::UInt8: return 1;
+                case DType::Int16: case DType::UInt16: case DType::Float16: case DType::BFloat16: return 2;
+                case DType::Int32: case DType::UInt32: case DType::Float32: return 4;
+                case DType::Int64: case DType::UInt64: case DType::Float64: return 8;
+            }
+            return 0;
+        }
+
+        // Throws unless header starts a file of ours, written on a host of
+        // the same byte order, whose elements take a number of bytes that
+        // size_t holds (the extents of a corrupt header may not), from an
+        // aligned offset
+        inline void validate(const Header& header){
+
+            if (std::memcmp(header.magic, magic, sizeof magic) != 0 or header.version != version
+                or header.rank > maxRank or header.dataOffset < sizeof(Header)
+                or header.dataOffset % alignment != 0 or size(header.type) == 0){
+                throw std::runtime_error("Not a mymath binary file");
+            }
+
+            size_t bytes {size(header.type)};
+
+            for (size_t axis{}; axis<header.rank; ++axis){
+
+                if constexpr (sizeof(size_t) < sizeof(std::uint64_t)){
+                    if (header.extent[axis] > std::numeric_limits<size_t>::max()){
+                        throw std::runtime_error("Not a mymath binary file");
+                    }
+                }
+
+                if (not multiply(bytes, static_cast<size_t>(header.extent[axis]), bytes)){
+                    throw std::runtime_error("Not a mymath binary file");
+                }
+            }
+
+            if (header.littleEndian != (std::endian::native == std::endian::little)){
+                throw std::invalid_argument("File written with another byte order");
+            }
+        }
+
+        // Throws unless header describes elements of type T and rank Rank
+        template<typename T, size_t Rank>
+        void expect(const Header& header){
+
+            if (header.type != dtype<T>()){
+                throw std::invalid_argument("Element types do not match");
+            }
+
+            if (header.rank != Rank){
+                throw std::invalid_argument("Matrix dimensions do not match");
+            }
+        }
+
+        // Vector, Matrix, Tensor, DynVector or DynMatrix of the given
+        // extents (checked against those of a fixed-size class)
+        template<typename R, size_t Rank>
+        R make(const std::array<size_t, Rank>& extent){
+
+            if constexpr (expr::FixedShape<R>){
+
+                if (R::shape() != extent){
+                    throw std::invalid_argument("Matrix dimensions do not match");
+                }
+
+                return R{};
+
+            } else if constexpr (Rank == 1){
+                return R(extent[0]);
+            } else {
+                return R(extent[0], extent[1]);
+            }
+        }
+
+        template<size_t Rank>
+        std::array<size_t, Rank> extents(const Header& header){
+            std::array<size_t, Rank> result {};
+            for (size_t axis{}; axis<Rank; ++axis){
+                result[axis] = static_cast<size_t>(header.extent[axis]);
+            }
+            return result;
+        }
+
+        inline bool space(char c){
+            return c == ' ' or c == '\t' or c == '\r' or c == '[' or c == ']';
+        }
+
+    }
+
+    // The classes a file or a text is read into
+    template<typename R>
+    concept Readable = (
+        expr::Terminal<R> and requires(R& r){
+            { r.data() } -> std::same_as<typename R::value_type*>;
+        }
+    );
+
+
+    /************************* Binary Files ***************************/
+
+    // Writes object (a vector, matrix or tensor, a view or any expression,
+    // evaluated first unless its elements are contiguous) to os, header and
+    // elements
+    template<expr::Expression E>
+    void write(std::ostream& os, const E& object){
+
+        using T = std::remove_const_t<typename E::value_type>;
+
+        static_assert(detail::rank<E> <= maxRank, "io can store tensors of rank 5 at most");
+
+        bool bulk {expr::Terminal<E>};
+        if constexpr (expr::Stored<E>){
+            bulk = expr::contiguous(object);
+        }
+
+        if constexpr (expr::Terminal<E> or expr::Stored<E>){
+
+            if (bulk){
+
+                const Header header {detail::header<T>(object.shape())};
+
+                os.write(reinterpret_cast<const char*>(&header), sizeof header);
+
+                const char padding[alignment] {};
+                os.write(padding, static_cast<std::streamsize>(header.dataOffset - sizeof header));
+
+                os.write(
+                    reinterpret_cast<const char*>(object.data()),
+                    static_cast<std::streamsize>(detail::count(header) * sizeof(T))
+                );
+
+                if (not os){
+                    throw std::runtime_error("Could not write the elements");
+                }
+
+                return;
+            }
+        }
+
+        const typename E::result_type evaluated {object};
+        write(os, evaluated);
+    }
+
+    // Writes object to the file at path, replacing it
+    template<expr::Expression E>
+    void save(const std::string& path, const E& object){
+
+        std::ofstream file {path, std::ios::binary | std::ios::trunc};
+
+        if (not file){
+            throw std::system_error(errno, std::generic_category(), path);
+        }
+
+        write(file, object);
+    }
+
+    // Reads the vector, matrix or tensor written by write() from is into
+    // destination (resized when dynamic)
+    template<Readable R>
+    void read(std::istream& is, R& destination){
+
+        using T = typename R::value_type;
+        constexpr size_t rank {detail::rank<R>};
+
+        Header header {};
+
+        if (not is.read(reinterpret_cast<char*>(&header), sizeof header)){
+            throw std::runtime_error("Not a mymath binary file");
+        }
+
+        detail::validate(header);
+        detail::expect<T, rank>(header);
+
+        constexpr auto largest {static_cast<std::uint64_t>(std::numeric_limits<std::streamsize>::max())};
+        const size_t bytes {detail::count(header) * sizeof(T)};
+
+        if (header.dataOffset > largest or bytes > largest){
+            throw std::runtime_error("Truncated file");
+        }
+
+        destination = detail::make<R>(detail::extents<rank>(header));
+
+        const auto padding {static_cast<std::streamsize>(header.dataOffset - sizeof header)};
+
+        if (
+            not is.ignore(padding) or is.gcount() != padding
+            or not is.read(reinterpret_cast<char*>(destination.data()), static_cast<std::streamsize>(bytes))
+        ){
+            throw std::runtime_error("Truncated file");
+        }
+    }
+
+    template<Readable R>
+    R read(std::istream& is){
+        R result {};
+        read(is, result);
+        return result;
+    }
+
+    // Reads the file at path
+    template<Readable R>
+    void load(const std::string& path, R& destination){
+
+        std::ifstream file {path, std::ios::binary};
+
+        if (not file){
+            throw std::system_error(errno, std::generic_category(), path);
+        }
+
+        read(file, destination);
+    }
+
+    template<Readable R>
+    R load(const std::string& path){
+        R result {};
+        load(path, result);
+        return result;
+    }
+
+
+    /************************* Memory Mapping *************************/
+
+    // Read-only mapping of a file written by save(), whose elements are
+    // viewed in place (no copy, nothing read until used)
+    class MappedFile{
+
+        private:
+
+            const std::byte* address;
+            size_t length;
+            Header info;
+
+            template<typename T, size_t Rank>
+            const T* elements() const {
+                detail::expect<T, Rank>(info);
+                return reinterpret_cast<const T*>(address + info.dataOffset);
+            }
+
+            void unmap() noexcept {
+                if (address != nullptr){
+                    #if defined(_WIN32)
+                    UnmapViewOfFile(address);
+                    #else
+                    munmap(const_cast<std::byte*>(address), length);
+                    #endif
+                }
+            }
+
+        public:
+
+        /******** Constructors - Assignment Operators - Destructor ***********/
+
+        // Maps the file at path (throws if it cannot be, or if it is not a
+        // complete file of ours)
+        explicit MappedFile(const std::string& path)
+        : address{nullptr}, length{0}, info{} {
+
+            #if defined(_WIN32)
+
+            const HANDLE file {CreateFileA(
+                path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                FILE_ATTRIBUTE_NORMAL, nullptr
+            )};
+
+            if (file == INVALID_HANDLE_VALUE){
+                throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), path);
+            }
+
+            LARGE_INTEGER size {};
+            GetFileSizeEx(file, &size);
+            length = static_cast<size_t>(size.QuadPart);
+
+            const HANDLE mapping {
+                length < sizeof(Header) ? nullptr
+                    : CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr)
+            };
+
+            if (mapping != nullptr){
+                address = static_cast<const std::byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                CloseHandle(mapping);
+            }
+
+            const DWORD error {GetLastError()};
+            CloseHandle(file);
+
+            if (length >= sizeof(Header) and address == nullptr){
+                throw std::system_error(static_cast<int>(error), std::system_category(), path);
+            }
+
+            #else
+
+            const int file {::open(path.c_str(), O_RDONLY)};
+
+            if (file < 0){
+                throw std::system_error(errno, std::generic_category(), path);
+            }
+
+            struct stat status {};
+            ::fstat(file, &status);
+            length = static_cast<size_t>(status.st_size);
+
+            if (length >= sizeof(Header)){
+                void* mapped {::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, file, 0)};
+                if (mapped == MAP_FAILED){
+                    const int error {errno};
+                    ::close(file);
+                    throw std::system_error(error, std::generic_category(), path);
+                }
+                address = static_cast<const std::byte*>(mapped);
+            }
+
+            ::close(file);
+
+            #endif
+
+            if (length < sizeof(Header)){
+                throw std::runtime_error("Not a mymath binary file");
+            }
+
+            std::memcpy(&info, address, sizeof info);
+
+            try {
+                detail::validate(info);
+                if (
+                    info.dataOffset > length
+                    or detail::count(info) * detail::size(info.type) > length - info.dataOffset
+                ){
+                    throw std::runtime_error("Truncated file");
+                }
+            } catch (...) {
+                unmap();
+                throw;
+            }
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        // Move Constructor (takes the mapping over)
+        MappedFile(MappedFile&& source) noexcept
+        : address{std::exchange(source.address, nullptr)},
+          length{std::exchange(source.length, 0)},
+          info{source.info} {}
+
+        // Move Assignment Operator
+        MappedFile& operator=(MappedFile&& rhs) noexcept {
+            if (this != &rhs){
+                unmap();
+                address = std::exchange(rhs.address, nullptr);
+                length = std::exchange(rhs.length, 0);
+                info = rhs.info;
+            }
+            return *this;
+        }
+
+        // Destructor (unmaps the file, invalidating the views)
+        ~MappedFile(){
+            unmap();
+        }
+
+
+        /******************** Methods *****************************/
+
+        const Header& header() const noexcept {
+            return info;
+        }
+
+        DType type() const noexcept {
+            return info.type;
+        }
+
+        size_t rank() const noexcept {
+            return info.rank;
+        }
+
+        // Extent along axis (1 beyond the rank)
+        size_t extent(size_t axis) const {
+            bounds::check(axis, maxRank);
+            return static_cast<size_t>(info.extent[axis]);
+        }
+
+        // Number of elements
+        size_t size() const noexcept {
+            return detail::count(info);
+        }
+
+        // The elements, whatever the rank (throws unless they are of type T)
+        template<typename T>
+        std::span<const T> data() const {
+
+            if (info.type != dtype<T>()){
+                throw std::invalid_argument("Element types do not match");
+            }
+
+            return {reinterpret_cast<const T*>(address + info.dataOffset), size()};
+        }
+
+        // View of a saved vector (throws unless of type T and rank 1)
+        template<typename T>
+        VectorView<const T> vector() const {
+            return VectorView<const T>{elements<T, 1>(), extent(0)};
+        }
+
+        // View of a saved matrix (throws unless of type T and rank 2)
+        template<typename T>
+        MatrixView<const T> matrix() const {
+            return MatrixView<const T>{elements<T, 2>(), extent(0), extent(1)};
+        }
+
+        // View of a saved tensor (throws unless of type T and extents Dims)
+        template<typename T, size_t... Dims>
+        TensorView<const T, Dims...> tensor() const {
+
+            const T* pointer {elements<T, sizeof...(Dims)>()};
+
+            if (detail::extents<sizeof...(Dims)>(info) != std::array<size_t, sizeof...(Dims)>{Dims...}){
+                throw std::invalid_argument("Matrix dimensions do not match");
+            }
+
+            return TensorView<const T, Dims...>{pointer};
+        }
+
+    };
+
+
+    /*************************** Text *********************************/
+
+    // Parses the text written by operator<< into a vector, matrix or tensor:
+    // the whitespace (and the brackets of the vectors) separated numbers, in
+    // row-major order. A DynVector takes as many elements as there are
+    // numbers and a DynMatrix one row per nonempty line; the fixed-size
+    // classes require exactly as many numbers as they hold.
+    template<Readable R>
+    R parse(std::string_view text){
+
+        using T = typename R::value_type;
+        constexpr size_t rank {detail::rank<R>};
+
+        std::vector<T> values {};
+        values.reserve(text.size() / 4);
+
+        size_t rows {}, columns {}, inLine {};
+
+        const char* p {text.data()};
+        const char* const end {text.data() + text.size()};
+
+        const auto endLine = [&]{
+            if (inLine != 0){
+                if (rows == 0){
+                    columns = inLine;
+                } else if (inLine != columns){
+                    throw std::invalid_argument("Each Row provided must have the same number of elements");
+                }
+                ++rows;
+                inLine = 0;
+            }
+        };
+
+        while (p != end){
+
+            if (detail::space(*p)){
+                ++p;
+                continue;
+            }
+
+            if (*p == '\n'){
+                endLine();
+                ++p;
+                continue;
+            }
+
+            // The 16-bit formats are read as floats and rounded
+            std::conditional_t<numeric::Reduced<T>, float, T> value {};
+            const auto [next, error] = std::from_chars(p, end, value);
+
+            if (error != std::errc{}){
+                throw std::invalid_argument("Not a number: " + std::string{p, std::min<size_t>(16, static_cast<size_t>(end - p))});
+            }
+
+            values.push_back(static_cast<T>(value));
+            ++inLine;
+            p = next;
+        }
+
+        endLine();
+
+        R result {};
+
+        if constexpr (rank == 2 and not expr::FixedShape<R>){
+            result = detail::make<R>(std::array<size_t, 2>{rows, columns});
+        } else if constexpr (rank == 1 and not expr::FixedShape<R>){
+            result = detail::make<R>(std::array<size_t, 1>{values.size()});
+        }
+
+        size_t count {1};
+        for (size_t extent : result.shape()){
+            count *= extent;
+        }
+
+        if (values.size() != count){
+            throw std::invalid_argument("Matrix dimensions do not match");
+        }
+
+        std::copy(values.begin(), values.end(), result.data());
+
+        return result;
+    }
+
+    // Parses the text file at path, read in one block
+    template<Readable R>
+    R loadText(const std::string& path){
+
+        std::ifstream file {path, std::ios::binary | std::ios::ate};
+
+        if (not file){
+            throw std::system_error(errno, std::generic_category(), path);
+        }
+
+        std::string text(static_cast<size_t>(file.tellg()), '\0');
+        file.seekg(0);
+        file.read(text.data(), static_cast<std::streamsize>(text.size()));
+
+        return parse<R>(text);
+    }
+
+}
+
+#endif
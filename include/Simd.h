@@ -0,0 +1,778 @@
+#ifndef _SIMD_H_
+#define _SIMD_H_
+
+#include <concepts>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include "Numeric.h"
+
+/*
+    Explicitly vectorized dot, axpy and gemv kernels for float, double and
+    int32, with runtime dispatch, dot and gemv kernels reading the 16-bit
+    formats of Numeric.h and accumulating in float, the reductions of
+    Reduction.h (sum, minimum, maximum, sum of squares, and a dot product
+    fused with both squared norms), the gathered dot product of the rows
+    of a sparse matrix (Sparse.h), the approximate comparison of float and
+    double arrays (Compare.h), and batched kernels applying small
+    matrices, dot and cross products to vectors stored as structure of
+    arrays (Batch.h).
+
+    Every kernel is compiled once per instruction set (SSE4.2, AVX2+FMA+F16C,
+    AVX-512F) from the same source (SimdKernels.inl), plus a portable scalar
+    version. On first use the CPU is queried (CPUID) and the best supported
+    set is selected, so a single binary runs the AVX-512 kernels on AVX-512
+    hosts and the AVX2 ones elsewhere. Setting the environment variable
+    MYMATH_SIMD to scalar, sse4.2, avx2 or avx512 lowers the selection,
+    e.g. to compare instruction sets on the same host.
+
+    The x86 kernels need GCC (for the target pragmas, which Clang does not
+    implement, and __builtin_cpu_supports); other compilers, Clang
+    included, and other architectures get the scalar kernels only.
+*/
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && !defined(__clang__)
+#define MYMATH_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace simd{
+
+    enum class Isa { Scalar, SSE42, AVX2, AVX512 };
+
+    inline constexpr const char* name(Isa isa){
+        switch (isa){
+            case Isa::SSE42: return "sse4.2";
+            case Isa::AVX2: return "avx2";
+            case Isa::AVX512: return "avx512";
+            default: return "scalar";
+        }
+    }
+
+    // Element types with vectorized kernels
+    template<typename T>
+    concept Accelerated = (
+        std::same_as<T, float> || std::same_as<T, double>
+        || std::same_as<T, std::int32_t>
+    );
+
+    // Element types of the vectorized dot() and gemv(): those above, and the
+    // 16-bit formats, summed in float
+    template<typename T>
+    concept Vectorized = Accelerated<T> || numeric::Reduced<T>;
+
+    // Callers keep plain loops below this length, where the indirect call
+    // would cost more than it saves
+    inline constexpr size_t minLength = 16;
+
+
+    /************************* Portable fallback *************************/
+
+    namespace scalar{
+
+        template<typename T>
+        struct Pack{
+            static constexpr size_t width = 1;
+            static T zero(){ return T{}; }
+            static T broadcast(T x){ return x; }
+            static T load(const T* p){ return *p; }
+            template<typename S>
+            static T load(const S* p){ return static_cast<T>(*p); }
+            static void store(T* p, T r){ *p = r; }
+            static T gather(const T* p, const std::uint32_t* index){ return p[*index]; }
+            static T add(T a, T b){ return static_cast<T>(a + b); }
+            static T subtract(T a, T b){ return static_cast<T>(a - b); }
+            static T multiply(T a, T b){ return static_cast<T>(a * b); }
+            static T multiplyAdd(T a, T b, T c){ return static_cast<T>(a * b + c); }
+            static T absolute(T r){ return r < T{} ? static_cast<T>(-r) : r; }
+            // The second operand when either is a NaN, as on x86
+            static T maximum(T a, T b){ return a > b ? a : b; }
+            static T minimum(T a, T b){ return a < b ? a : b; }
+            static bool allLessEqual(T a, T b){ return a <= b; }
+            static T sum(T r){ return r; }
+        };
+
+        #include "SimdKernels.inl"
+
+    }
+
+
+    #ifdef MYMATH_SIMD_X86
+
+    /****************************** SSE4.2 *******************************/
+
+    #pragma GCC push_options
+    #pragma GCC target("sse4.2")
+
+    namespace sse42{
+
+        template<typename T> struct Pack;
+
+        template<>
+        struct Pack<double>{
+            static constexpr size_t width = 2;
+            static __m128d zero(){ return _mm_setzero_pd(); }
+            static __m128d broadcast(double x){ return _mm_set1_pd(x); }
+            static __m128d load(const double* p){ return _mm_loadu_pd(p); }
+            static void store(double* p, __m128d r){ _mm_storeu_pd(p, r); }
+            static __m128d gather(const double* p, const std::uint32_t* index){
+                return _mm_set_pd(p[index[1]], p[index[0]]);
+            }
+            static __m128d add(__m128d a, __m128d b){ return _mm_add_pd(a, b); }
+            static __m128d subtract(__m128d a, __m128d b){ return _mm_sub_pd(a, b); }
+            static __m128d multiply(__m128d a, __m128d b){ return _mm_mul_pd(a, b); }
+            static __m128d multiplyAdd(__m128d a, __m128d b, __m128d c){
+                return _mm_add_pd(_mm_mul_pd(a, b), c);
+            }
+            static __m128d absolute(__m128d r){ return _mm_andnot_pd(_mm_set1_pd(-0.0), r); }
+            static __m128d maximum(__m128d a, __m128d b){ return _mm_max_pd(a, b); }
+            static __m128d minimum(__m128d a, __m128d b){ return _mm_min_pd(a, b); }
+            static bool allLessEqual(__m128d a, __m128d b){
+                return _mm_movemask_pd(_mm_cmple_pd(a, b)) == 0x3;
+            }
+            static double sum(__m128d r){
+                return _mm_cvtsd_f64(_mm_add_sd(r, _mm_unpackhi_pd(r, r)));
+            }
+        };
+
+        template<>
+        struct Pack<float>{
+            static constexpr size_t width = 4;
+            static __m128 zero(){ return _mm_setzero_ps(); }
+            static __m128 broadcast(float x){ return _mm_set1_ps(x); }
+            static __m128 load(const float* p){ return _mm_loadu_ps(p); }
+            static __m128 load(const numeric::bfloat16* p){
+                return _mm_castsi128_ps(_mm_slli_epi32(
+                    _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p))), 16
+                ));
+            }
+            #ifdef MYMATH_HAS_FLOAT16
+            static __m128 load(const numeric::half* p){
+                return _mm_set_ps(
+                    static_cast<float>(p[3]), static_cast<float>(p[2]),
+                    static_cast<float>(p[1]), static_cast<float>(p[0])
+                );
+            }
+            #endif
+            static void store(float* p, __m128 r){ _mm_storeu_ps(p, r); }
+            static __m128 gather(const float* p, const std::uint32_t* index){
+                return _mm_set_ps(p[index[3]], p[index[2]], p[index[1]], p[index[0]]);
+            }
+            static __m128 add(__m128 a, __m128 b){ return _mm_add_ps(a, b); }
+            static __m128 subtract(__m128 a, __m128 b){ return _mm_sub_ps(a, b); }
+            static __m128 multiply(__m128 a, __m128 b){ return _mm_mul_ps(a, b); }
+            static __m128 multiplyAdd(__m128 a, __m128 b, __m128 c){
+                return _mm_add_ps(_mm_mul_ps(a, b), c);
+            }
+            static __m128 absolute(__m128 r){ return _mm_andnot_ps(_mm_set1_ps(-0.0f), r); }
+            static __m128 maximum(__m128 a, __m128 b){ return _mm_max_ps(a, b); }
+            static __m128 minimum(__m128 a, __m128 b){ return _mm_min_ps(a, b); }
+            static bool allLessEqual(__m128 a, __m128 b){
+                return _mm_movemask_ps(_mm_cmple_ps(a, b)) == 0xF;
+            }
+            static float sum(__m128 r){
+                const __m128 s {_mm_add_ps(r, _mm_movehl_ps(r, r))};
+                return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, 1)));
+            }
+        };
+
+        template<>
+        struct Pack<std::int32_t>{
+            static constexpr size_t width = 4;
+            static __m128i zero(){ return _mm_setzero_si128(); }
+            static __m128i broadcast(std::int32_t x){ return _mm_set1_epi32(x); }
+            static __m128i load(const std::int32_t* p){
+                return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            }
+            static void store(std::int32_t* p, __m128i r){
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(p), r);
+            }
+            static __m128i gather(const std::int32_t* p, const std::uint32_t* index){
+                return _mm_set_epi32(p[index[3]], p[index[2]], p[index[1]], p[index[0]]);
+            }
+            static __m128i add(__m128i a, __m128i b){ return _mm_add_epi32(a, b); }
+            static __m128i subtract(__m128i a, __m128i b){ return _mm_sub_epi32(a, b); }
+            static __m128i multiply(__m128i a, __m128i b){ return _mm_mullo_epi32(a, b); }
+            static __m128i multiplyAdd(__m128i a, __m128i b, __m128i c){
+                return _mm_add_epi32(_mm_mullo_epi32(a, b), c);
+            }
+            static __m128i maximum(__m128i a, __m128i b){ return _mm_max_epi32(a, b); }
+            static __m128i minimum(__m128i a, __m128i b){ return _mm_min_epi32(a, b); }
+            static std::int32_t sum(__m128i r){
+                const __m128i s {_mm_add_epi32(r, _mm_shuffle_epi32(r, 0x4E))};
+                return _mm_cvtsi128_si32(_mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1)));
+            }
+        };
+
+        #include "SimdKernels.inl"
+
+    }
+
+    #pragma GCC pop_options
+
+
+    /**************************** AVX2 + FMA *****************************/
+
+    #pragma GCC push_options
+    #pragma GCC target("avx2,fma,f16c")
+
+    namespace avx2{
+
+        template<typename T> struct Pack;
+
+        template<>
+        struct Pack<double>{
+            static constexpr size_t width = 4;
+            static __m256d zero(){ return _mm256_setzero_pd(); }
+            static __m256d broadcast(double x){ return _mm256_set1_pd(x); }
+            static __m256d load(const double* p){ return _mm256_loadu_pd(p); }
+            static void store(double* p, __m256d r){ _mm256_storeu_pd(p, r); }
+            static __m256d gather(const double* p, const std::uint32_t* index){
+                return _mm256_mask_i32gather_pd(
+                    _mm256_setzero_pd(), p, _mm_loadu_si128(reinterpret_cast<const __m128i*>(index)),
+                    _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), 8
+                );
+            }
+            static __m256d add(__m256d a, __m256d b){ return _mm256_add_pd(a, b); }
+            static __m256d subtract(__m256d a, __m256d b){ return _mm256_sub_pd(a, b); }
+            static __m256d multiply(__m256d a, __m256d b){ return _mm256_mul_pd(a, b); }
+            static __m256d multiplyAdd(__m256d a, __m256d b, __m256d c){
+                return _mm256_fmadd_pd(a, b, c);
+            }
+            static __m256d absolute(__m256d r){ return _mm256_andnot_pd(_mm256_set1_pd(-0.0), r); }
+            static __m256d maximum(__m256d a, __m256d b){ return _mm256_max_pd(a, b); }
+            static __m256d minimum(__m256d a, __m256d b){ return _mm256_min_pd(a, b); }
+            static bool allLessEqual(__m256d a, __m256d b){
+                return _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_LE_OQ)) == 0xF;
+            }
+            static double sum(__m256d r){
+                const __m128d s {
+                    _mm_add_pd(_mm256_castpd256_pd128(r), _mm256_extractf128_pd(r, 1))
+                };
+                return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+            }
+        };
+
+        template<>
+        struct Pack<float>{
+            static constexpr size_t width = 8;
+            static __m256 zero(){ return _mm256_setzero_ps(); }
+            static __m256 broadcast(float x){ return _mm256_set1_ps(x); }
+            static __m256 load(const float* p){ return _mm256_loadu_ps(p); }
+            static __m256 load(const numeric::bfloat16* p){
+                return _mm256_castsi256_ps(_mm256_slli_epi32(
+                    _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))), 16
+                ));
+            }
+            #ifdef MYMATH_HAS_FLOAT16
+            static __m256 load(const numeric::half* p){
+                return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+            }
+            #endif
+            static void store(float* p, __m256 r){ _mm256_storeu_ps(p, r); }
+            static __m256 gather(const float* p, const std::uint32_t* index){
+                return _mm256_mask_i32gather_ps(
+                    _mm256_setzero_ps(), p, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(index)),
+                    _mm256_castsi256_ps(_mm256_set1_epi32(-1)), 4
+                );
+            }
+            static __m256 add(__m256 a, __m256 b){ return _mm256_add_ps(a, b); }
+            static __m256 subtract(__m256 a, __m256 b){ return _mm256_sub_ps(a, b); }
+            static __m256 multiply(__m256 a, __m256 b){ return _mm256_mul_ps(a, b); }
+            static __m256 multiplyAdd(__m256 a, __m256 b, __m256 c){
+                return _mm256_fmadd_ps(a, b, c);
+            }
+            static __m256 absolute(__m256 r){ return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), r); }
+            static __m256 maximum(__m256 a, __m256 b){ return _mm256_max_ps(a, b); }
+            static __m256 minimum(__m256 a, __m256 b){ return _mm256_min_ps(a, b); }
+            static bool allLessEqual(__m256 a, __m256 b){
+                return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LE_OQ)) == 0xFF;
+            }
+            static float sum(__m256 r){
+                __m128 s {
+                    _mm_add_ps(_mm256_castps256_ps128(r), _mm256_extractf128_ps(r, 1))
+                };
+                s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+                return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, 1)));
+            }
+        };
+
+        template<>
+        struct Pack<std::int32_t>{
+            static constexpr size_t width = 8;
+            static __m256i zero(){ return _mm256_setzero_si256(); }
+            static __m256i broadcast(std::int32_t x){ return _mm256_set1_epi32(x); }
+            static __m256i load(const std::int32_t* p){
+                return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            }
+            static void store(std::int32_t* p, __m256i r){
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), r);
+            }
+            static __m256i gather(const std::int32_t* p, const std::uint32_t* index){
+                return _mm256_mask_i32gather_epi32(
+                    _mm256_setzero_si256(), p, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(index)),
+                    _mm256_set1_epi32(-1), 4
+                );
+            }
+            static __m256i add(__m256i a, __m256i b){ return _mm256_add_epi32(a, b); }
+            static __m256i subtract(__m256i a, __m256i b){ return _mm256_sub_epi32(a, b); }
+            static __m256i multiply(__m256i a, __m256i b){ return _mm256_mullo_epi32(a, b); }
+            static __m256i multiplyAdd(__m256i a, __m256i b, __m256i c){
+                return _mm256_add_epi32(_mm256_mullo_epi32(a, b), c);
+            }
+            static __m256i maximum(__m256i a, __m256i b){ return _mm256_max_epi32(a, b); }
+            static __m256i minimum(__m256i a, __m256i b){ return _mm256_min_epi32(a, b); }
+            static std::int32_t sum(__m256i r){
+                __m128i s {
+                    _mm_add_epi32(_mm256_castsi256_si128(r), _mm256_extracti128_si256(r, 1))
+                };
+                s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+                return _mm_cvtsi128_si32(_mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1)));
+            }
+        };
+
+        #include "SimdKernels.inl"
+
+    }
+
+    #pragma GCC pop_options
+
+
+    /***************************** AVX-512F ******************************/
+
+    // The horizontal sums split registers with the maskz extracts rather
+    // than _mm512_reduce_add_* or the 512-to-256 casts, whose use of the
+    // _mm256_undefined_* intrinsics trips -Wuninitialized in GCC 12 (as
+    // do _mm512_abs_*, _mm512_max_* and the unmasked gathers of AVX2 and
+    // AVX-512, hence the masking of the sign bit by hand, the maskz
+    // maximum, conversions and shifts, and the masked gathers)
+
+    #pragma GCC push_options
+    #pragma GCC target("avx512f")
+
+    namespace avx512{
+
+        template<typename T> struct Pack;
+
+        template<>
+        struct Pack<double>{
+            static constexpr size_t width = 8;
+            static __m512d zero(){ return _mm512_setzero_pd(); }
+            static __m512d broadcast(double x){ return _mm512_set1_pd(x); }
+            static __m512d load(const double* p){ return _mm512_loadu_pd(p); }
+            static void store(double* p, __m512d r){ _mm512_storeu_pd(p, r); }
+            static __m512d gather(const double* p, const std::uint32_t* index){
+                return _mm512_mask_i32gather_pd(
+                    _mm512_setzero_pd(), 0xFF,
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(index)), p, 8
+                );
+            }
+            static __m512d add(__m512d a, __m512d b){ return _mm512_add_pd(a, b); }
+            static __m512d subtract(__m512d a, __m512d b){ return _mm512_sub_pd(a, b); }
+            static __m512d multiply(__m512d a, __m512d b){ return _mm512_mul_pd(a, b); }
+            static __m512d multiplyAdd(__m512d a, __m512d b, __m512d c){
+                return _mm512_fmadd_pd(a, b, c);
+            }
+            static __m512d absolute(__m512d r){
+                return _mm512_castsi512_pd(_mm512_and_epi64(
+                    _mm512_castpd_si512(r), _mm512_set1_epi64(0x7FFFFFFFFFFFFFFF)
+                ));
+            }
+            static __m512d maximum(__m512d a, __m512d b){ return _mm512_maskz_max_pd(0xFF, a, b); }
+            static __m512d minimum(__m512d a, __m512d b){ return _mm512_maskz_min_pd(0xFF, a, b); }
+            static bool allLessEqual(__m512d a, __m512d b){
+                return _mm512_cmp_pd_mask(a, b, _CMP_LE_OQ) == 0xFF;
+            }
+            static double sum(__m512d r){
+                const __m256d h {
+                    _mm256_add_pd(
+                        _mm512_maskz_extractf64x4_pd(0xFF, r, 0), _mm512_maskz_extractf64x4_pd(0xFF, r, 1)
+                    )
+                };
+                const __m128d s {
+                    _mm_add_pd(_mm256_castpd256_pd128(h), _mm256_extractf128_pd(h, 1))
+                };
+                return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+            }
+        };
+
+        template<>
+        struct Pack<float>{
+            static constexpr size_t width = 16;
+            static __m512 zero(){ return _mm512_setzero_ps(); }
+            static __m512 broadcast(float x){ return _mm512_set1_ps(x); }
+            static __m512 load(const float* p){ return _mm512_loadu_ps(p); }
+            static __m512 load(const numeric::bfloat16* p){
+                return _mm512_castsi512_ps(_mm512_maskz_slli_epi32(
+                    0xFFFF, _mm512_maskz_cvtepu16_epi32(0xFFFF, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))), 16
+                ));
+            }
+            #ifdef MYMATH_HAS_FLOAT16
+            static __m512 load(const numeric::half* p){
+                return _mm512_maskz_cvtph_ps(0xFFFF, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+            }
+            #endif
+            static void store(float* p, __m512 r){ _mm512_storeu_ps(p, r); }
+            static __m512 gather(const float* p, const std::uint32_t* index){
+                return _mm512_mask_i32gather_ps(
+                    _mm512_setzero_ps(), 0xFFFF, _mm512_loadu_si512(index), p, 4
+                );
+            }
+            static __m512 add(__m512 a, __m512 b){ return _mm512_add_ps(a, b); }
+            static __m512 subtract(__m512 a, __m512 b){ return _mm512_sub_ps(a, b); }
+            static __m512 multiply(__m512 a, __m512 b){ return _mm512_mul_ps(a, b); }
+            static __m512 multiplyAdd(__m512 a, __m512 b, __m512 c){
+                return _mm512_fmadd_ps(a, b, c);
+            }
+            static __m512 absolute(__m512 r){
+                return _mm512_castsi512_ps(_mm512_and_epi32(
+                    _mm512_castps_si512(r), _mm512_set1_epi32(0x7FFFFFFF)
+                ));
+            }
+            static __m512 maximum(__m512 a, __m512 b){ return _mm512_maskz_max_ps(0xFFFF, a, b); }
+            static __m512 minimum(__m512 a, __m512 b){ return _mm512_maskz_min_ps(0xFFFF, a, b); }
+            static bool allLessEqual(__m512 a, __m512 b){
+                return _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ) == 0xFFFF;
+            }
+            static float sum(__m512 r){
+                const __m512d d {_mm512_castps_pd(r)};
+                const __m256 h {
+                    _mm256_add_ps(
+                        _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0xFF, d, 0)),
+                        _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0xFF, d, 1))
+                    )
+                };
+                __m128 s {
+                    _mm_add_ps(_mm256_castps256_ps128(h), _mm256_extractf128_ps(h, 1))
+                };
+                s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+                return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, 1)));
+            }
+        };
+
+        template<>
+        struct Pack<std::int32_t>{
+            static constexpr size_t width = 16;
+            static __m512i zero(){ return _mm512_setzero_si512(); }
+            static __m512i broadcast(std::int32_t x){ return _mm512_set1_epi32(x); }
+            static __m512i load(const std::int32_t* p){ return _mm512_loadu_si512(p); }
+            static void store(std::int32_t* p, __m512i r){ _mm512_storeu_si512(p, r); }
+            static __m512i gather(const std::int32_t* p, const std::uint32_t* index){
+                return _mm512_mask_i32gather_epi32(
+                    _mm512_setzero_si512(), 0xFFFF, _mm512_loadu_si512(index), p, 4
+                );
+            }
+            static __m512i add(__m512i a, __m512i b){ return _mm512_add_epi32(a, b); }
+            static __m512i subtract(__m512i a, __m512i b){ return _mm512_sub_epi32(a, b); }
+            static __m512i multiply(__m512i a, __m512i b){ return _mm512_mullo_epi32(a, b); }
+            static __m512i multiplyAdd(__m512i a, __m512i b, __m512i c){
+                return _mm512_add_epi32(_mm512_mullo_epi32(a, b), c);
+            }
+            static __m512i maximum(__m512i a, __m512i b){ return _mm512_maskz_max_epi32(0xFFFF, a, b); }
+            static __m512i minimum(__m512i a, __m512i b){ return _mm512_maskz_min_epi32(0xFFFF, a, b); }
+            static std::int32_t sum(__m512i r){
+                const __m256i h {
+                    _mm256_add_epi32(
+                        _mm512_maskz_extracti64x4_epi64(0xFF, r, 0), _mm512_maskz_extracti64x4_epi64(0xFF, r, 1)
+                    )
+                };
+                __m128i s {
+                    _mm_add_epi32(_mm256_castsi256_si128(h), _mm256_extracti128_si256(h, 1))
+                };
+                s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+                return _mm_cvtsi128_si32(_mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1)));
+            }
+        };
+
+        #include "SimdKernels.inl"
+
+    }
+
+    #pragma GCC pop_options
+
+    #endif
+
+
+    /***************************** Dispatch ******************************/
+
+    namespace detail{
+
+        inline Isa detect(){
+
+            Isa best {Isa::Scalar};
+
+            #ifdef MYMATH_SIMD_X86
+            __builtin_cpu_init();
+
+            if (__builtin_cpu_supports("avx512f")){
+                best = Isa::AVX512;
+            } else if (__builtin_cpu_supports("avx2") and __builtin_cpu_supports("fma")
+                       and __builtin_cpu_supports("f16c")){
+                best = Isa::AVX2;
+            } else if (__builtin_cpu_supports("sse4.2")){
+                best = Isa::SSE42;
+            }
+            #endif
+
+            // MYMATH_SIMD may only lower the selection below what the CPU supports
+            if (const char* requested {std::getenv("MYMATH_SIMD")}){
+                for (Isa isa : {Isa::Scalar, Isa::SSE42, Isa::AVX2, Isa::AVX512}){
+                    if (std::strcmp(requested, name(isa)) == 0 and isa < best){
+                        best = isa;
+                    }
+                }
+            }
+
+            return best;
+        }
+
+        template<typename T>
+        struct Kernels{
+            T (*dot)(const T*, const T*, size_t);
+            void (*axpy)(size_t, T, const T*, T*);
+            void (*gemv)(size_t, size_t, const T*, size_t, const T*, T*);
+            T (*gatherDot)(const T*, const std::uint32_t*, const T*, size_t);
+            T (*sum)(const T*, size_t);
+            T (*minimum)(const T*, size_t);
+            T (*maximum)(const T*, size_t);
+        };
+
+        // Kernels reading a 16-bit format S and computing in float
+        template<typename S>
+        struct WideKernels{
+            float (*dot)(const S*, const S*, size_t);
+            void (*gemv)(size_t, size_t, const S*, size_t, const float*, float*);
+        };
+
+        template<typename S>
+        WideKernels<S> selectWide(Isa isa){
+            switch (isa){
+                #ifdef MYMATH_SIMD_X86
+                case Isa::AVX512:
+                    return {&avx512::dot<float, S>, &avx512::gemv<float, S>};
+                case Isa::AVX2:
+                    return {&avx2::dot<float, S>, &avx2::gemv<float, S>};
+                case Isa::SSE42:
+                    return {&sse42::dot<float, S>, &sse42::gemv<float, S>};
+                #endif
+                default:
+                    return {&scalar::dot<float, S>, &scalar::gemv<float, S>};
+            }
+        }
+
+        template<typename T>
+        Kernels<T> select(Isa isa){
+            switch (isa){
+                #ifdef MYMATH_SIMD_X86
+                case Isa::AVX512:
+                    return {
+                        &avx512::dot<T>, &avx512::axpy<T>, &avx512::gemv<T>, &avx512::gatherDot<T>,
+                        &avx512::sum<T>, &avx512::extremum<T, false>, &avx512::extremum<T, true>
+                    };
+                case Isa::AVX2:
+                    return {
+                        &avx2::dot<T>, &avx2::axpy<T>, &avx2::gemv<T>, &avx2::gatherDot<T>,
+                        &avx2::sum<T>, &avx2::extremum<T, false>, &avx2::extremum<T, true>
+                    };
+                case Isa::SSE42:
+                    return {
+                        &sse42::dot<T>, &sse42::axpy<T>, &sse42::gemv<T>, &sse42::gatherDot<T>,
+                        &sse42::sum<T>, &sse42::extremum<T, false>, &sse42::extremum<T, true>
+                    };
+                #endif
+                default:
+                    return {
+                        &scalar::dot<T>, &scalar::axpy<T>, &scalar::gemv<T>, &scalar::gatherDot<T>,
+                        &scalar::sum<T>, &scalar::extremum<T, false>, &scalar::extremum<T, true>
+                    };
+            }
+        }
+
+    }
+
+    // Instruction set used by the kernels, selected on first use
+    inline Isa isa(){
+        static const Isa selected {detail::detect()};
+        return selected;
+    }
+
+    namespace detail{
+
+        template<typename T>
+        const Kernels<T>& kernels(){
+            static const Kernels<T> table {select<T>(isa())};
+            return table;
+        }
+
+        template<typename S>
+        const WideKernels<S>& wideKernels(){
+            static const WideKernels<S> table {selectWide<S>(isa())};
+            return table;
+        }
+
+    }
+
+    // Sum of a[i] * b[i] for i < n
+    template<Accelerated T>
+    T dot(const T* a, const T* b, size_t n){
+        return detail::kernels<T>().dot(a, b, n);
+    }
+
+    // y[i] += alpha * x[i] for i < n
+    template<Accelerated T>
+    void axpy(size_t n, T alpha, const T* x, T* y){
+        detail::kernels<T>().axpy(n, alpha, x, y);
+    }
+
+    // y = A * x, for A of m rows and n columns stored row by row with a
+    // distance of lda elements between consecutive rows
+    template<Accelerated T>
+    void gemv(size_t m, size_t n, const T* A, size_t lda, const T* x, T* y){
+        detail::kernels<T>().gemv(m, n, A, lda, x, y);
+    }
+
+    // Sum of a[i] * b[i] for i < n, 16-bit elements summed in float
+    template<numeric::Reduced S>
+    float dot(const S* a, const S* b, size_t n){
+        return detail::wideKernels<S>().dot(a, b, n);
+    }
+
+    // y = A * x, for A of 16-bit elements (stored as for gemv above) and x
+    // and y of floats
+    template<numeric::Reduced S>
+    void gemv(size_t m, size_t n, const S* A, size_t lda, const float* x, float* y){
+        detail::wideKernels<S>().gemv(m, n, A, lda, x, y);
+    }
+
+    // Sum of a[k] * x[index[k]] for k < n (a row of a sparse matrix times
+    // a dense vector), every index below 2^31
+    template<Accelerated T>
+    T gatherDot(const T* a, const std::uint32_t* index, const T* x, size_t n){
+        return detail::kernels<T>().gatherDot(a, index, x, n);
+    }
+
+    // Sum of a[i] for i < n
+    template<Accelerated T>
+    T sum(const T* a, size_t n){
+        return detail::kernels<T>().sum(a, n);
+    }
+
+    // Smallest and largest of a[i] for i < n (n > 0), NaN elements being
+    // skipped unless all of them are NaN
+    template<Accelerated T>
+    T minimum(const T* a, size_t n){
+        return detail::kernels<T>().minimum(a, n);
+    }
+
+    template<Accelerated T>
+    T maximum(const T* a, size_t n){
+        return detail::kernels<T>().maximum(a, n);
+    }
+
+    // Sum of (scale * a[i])^2 for i < n
+    template<Accelerated T> requires std::floating_point<T>
+    T sumSquares(const T* a, size_t n, T scale){
+        switch (isa()){
+            #ifdef MYMATH_SIMD_X86
+            case Isa::AVX512: return avx512::sumSquares(a, n, scale);
+            case Isa::AVX2: return avx2::sumSquares(a, n, scale);
+            case Isa::SSE42: return sse42::sumSquares(a, n, scale);
+            #endif
+            default: return scalar::sumSquares(a, n, scale);
+        }
+    }
+
+    // a . b, a . a and b . b for i < n, into out[0], out[1] and out[2], in
+    // one pass over a and b
+    template<Accelerated T> requires std::floating_point<T>
+    void dotNorms(const T* a, const T* b, size_t n, T* out){
+        switch (isa()){
+            #ifdef MYMATH_SIMD_X86
+            case Isa::AVX512: return avx512::dotNorms(a, b, n, out);
+            case Isa::AVX2: return avx2::dotNorms(a, b, n, out);
+            case Isa::SSE42: return sse42::dotNorms(a, b, n, out);
+            #endif
+            default: return scalar::dotNorms(a, b, n, out);
+        }
+    }
+
+    // Number of leading elements, a whole number of packs, for which
+    // |a[i] - b[i]| <= absolute + relative * max(|a[i]|, |b[i]|): the scan
+    // stops at the first pack with an element that is not (or a NaN), which
+    // is left to the caller along with the tail
+    template<Accelerated T> requires std::floating_point<T>
+    size_t close(const T* a, const T* b, size_t n, T absolute, T relative){
+        switch (isa()){
+            #ifdef MYMATH_SIMD_X86
+            case Isa::AVX512: return avx512::close(a, b, n, absolute, relative);
+            case Isa::AVX2: return avx2::close(a, b, n, absolute, relative);
+            case Isa::SSE42: return sse42::close(a, b, n, absolute, relative);
+            #endif
+            default: return scalar::close(a, b, n, absolute, relative);
+        }
+    }
+
+
+    /************************** Batched Kernels **************************/
+
+    // Kernels over n vectors stored as structure of arrays (v[c][i] is
+    // component c of vector i), see SimdKernels.inl. They are instantiated
+    // per dimension, so they switch on the instruction set at each call
+    // instead of going through a table.
+
+    // out[.][i] = m * in[.][i], m being R x C and stored row by row
+    template<Accelerated T, size_t R, size_t C>
+    void transform(const T* m, const T* const* in, T* const* out, size_t n){
+        switch (isa()){
+            #ifdef MYMATH_SIMD_X86
+            case Isa::AVX512: return avx512::transform<T, R, C>(m, in, out, n);
+            case Isa::AVX2: return avx2::transform<T, R, C>(m, in, out, n);
+            case Isa::SSE42: return sse42::transform<T, R, C>(m, in, out, n);
+            #endif
+            default: return scalar::transform<T, R, C>(m, in, out, n);
+        }
+    }
+
+    // out[.][i] = m[.][i] * in[.][i], m[r*C + c][i] being element (r, c)
+    // of matrix i
+    template<Accelerated T, size_t R, size_t C>
+    void transformEach(const T* const* m, const T* const* in, T* const* out, size_t n){
+        switch (isa()){
+            #ifdef MYMATH_SIMD_X86
+            case Isa::AVX512: return avx512::transformEach<T, R, C>(m, in, out, n);
+            case Isa::AVX2: return avx2::transformEach<T, R, C>(m, in, out, n);
+            case Isa::SSE42: return sse42::transformEach<T, R, C>(m, in, out, n);
+            #endif
+            default: return scalar::transformEach<T, R, C>(m, in, out, n);
+        }
+    }
+
+    // out[i] = a[.][i] . b[.][i], for vectors of N components
+    template<Accelerated T, size_t N>
+    void dotEach(const T* const* a, const T* const* b, T* out, size_t n){
+        switch (isa()){
+            #ifdef MYMATH_SIMD_X86
+            case Isa::AVX512: return avx512::dotEach<T, N>(a, b, out, n);
+            case Isa::AVX2: return avx2::dotEach<T, N>(a, b, out, n);
+            case Isa::SSE42: return sse42::dotEach<T, N>(a, b, out, n);
+            #endif
+            default: return scalar::dotEach<T, N>(a, b, out, n);
+        }
+    }
+
+    // out[.][i] = a[.][i] x b[.][i], for 3 dimensional vectors
+    template<Accelerated T>
+    void crossEach(const T* const* a, const T* const* b, T* const* out, size_t n){
+        switch (isa()){
+            #ifdef MYMATH_SIMD_X86
+            case Isa::AVX512: return avx512::crossEach<T>(a, b, out, n);
+            case Isa::AVX2: return avx2::crossEach<T>(a, b, out, n);
+            case Isa::SSE42: return sse42::crossEach<T>(a, b, out, n);
+            #endif
+            default: return scalar::crossEach<T>(a, b, out, n);
+        }
+    }
+
+}
+
+#endif
@@ -0,0 +1,524 @@
+// SIMD kernels, written once against the Pack<T> interface of the
+// enclosing namespace.
+//
+// Simd.h includes this file once per instruction set, inside a namespace
+// that defines Pack<T> for that instruction set and within the matching
+// "#pragma GCC target" region, so that every kernel below is compiled (and
+// its intrinsics inlined) for that instruction set. There is deliberately
+// no include guard.
+
+// Sum of a[i] * b[i], with four independent accumulators to hide the
+// latency of the multiply-add. The elements may be stored as SA and SB
+// (the 16-bit formats), which are widened to T as they are loaded.
+template<typename T, typename SA = T, typename SB = SA>
+T dot(const SA* a, const SB* b, size_t n){
+
+    using P = Pack<T>;
+    constexpr size_t W = P::width;
+
+    auto s0 {P::zero()}, s1 {P::zero()}, s2 {P::zero()}, s3 {P::zero()};
+
+    size_t i{};
+
+    for (; i + 4*W <= n; i += 4*W){
+        s0 = P::multiplyAdd(P::load(a + i), P::load(b + i), s0);
+        s1 = P::multiplyAdd(P::load(a + i + W), P::load(b + i + W), s1);
+        s2 = P::multiplyAdd(P::load(a + i + 2*W), P::load(b + i + 2*W), s2);
+        s3 = P::multiplyAdd(P::load(a + i + 3*W), P::load(b + i + 3*W), s3);
+    }
+
+    for (; i + W <= n; i += W){
+        s0 = P::multiplyAdd(P::load(a + i), P::load(b + i), s0);
+    }
+
+    T result {P::sum(P::add(P::add(s0, s1), P::add(s2, s3)))};
+
+    for (; i<n; ++i){
+        result += static_cast<T>(a[i]) * static_cast<T>(b[i]);
+    }
+
+    return result;
+}
+
+// Sum of a[k] * x[index[k]], the elements of x gathered a pack at a time,
+// with two accumulators (the gathers, not the multiply-adds, are the
+// bottleneck)
+template<typename T>
+T gatherDot(const T* a, const std::uint32_t* index, const T* x, size_t n){
+
+    using P = Pack<T>;
+    constexpr size_t W = P::width;
+
+    auto s0 {P::zero()}, s1 {P::zero()};
+
+    size_t k{};
+
+    for (; k + 2*W <= n; k += 2*W){
+        s0 = P::multiplyAdd(P::load(a + k), P::gather(x, index + k), s0);
+        s1 = P::multiplyAdd(P::load(a + k + W), P::gather(x, index + k + W), s1);
+    }
+
+    for (; k + W <= n; k += W){
+        s0 = P::multiplyAdd(P::load(a + k), P::gather(x, index + k), s0);
+    }
+
+    T result {P::sum(P::add(s0, s1))};
+
+    for (; k<n; ++k){
+        result += a[k] * x[index[k]];
+    }
+
+    return result;
+}
+
+// y[i] += alpha * x[i]
+template<typename T>
+void axpy(size_t n, T alpha, const T* x, T* y){
+
+    using P = Pack<T>;
+    constexpr size_t W = P::width;
+
+    const auto a {P::broadcast(alpha)};
+
+    size_t i{};
+
+    for (; i + 2*W <= n; i += 2*W){
+        P::store(y + i, P::multiplyAdd(a, P::load(x + i), P::load(y + i)));
+        P::store(y + i + W, P::multiplyAdd(a, P::load(x + i + W), P::load(y + i + W)));
+    }
+
+    for (; i + W <= n; i += W){
+        P::store(y + i, P::multiplyAdd(a, P::load(x + i), P::load(y + i)));
+    }
+
+    for (; i<n; ++i){
+        y[i] += alpha * x[i];
+    }
+}
+
+// Sum of a[i], with four accumulators, as dot() above
+template<typename T>
+T sum(const T* a, size_t n){
+
+    using P = Pack<T>;
+    constexpr size_t W = P::width;
+
+    auto s0 {P::zero()}, s1 {P::zero()}, s2 {P::zero()}, s3 {P::zero()};
+
+    size_t i{};
+
+    for (; i + 4*W <= n; i += 4*W){
+        s0 = P::add(P::load(a + i), s0);
+        s1 = P::add(P::load(a + i + W), s1);
+        s2 = P::add(P::load(a + i + 2*W), s2);
+        s3 = P::add(P::load(a + i + 3*W), s3);
+    }
+
+    for (; i + W <= n; i += W){
+        s0 = P::add(P::load(a + i), s0);
+    }
+
+    T result {P::sum(P::add(P::add(s0, s1), P::add(s2, s3)))};
+
+    for (; i<n; ++i){
+        result += a[i];
+    }
+
+    return result;
+}
+
+// Largest (or smallest) of a[i], n > 0, with four accumulators. The minimum
+// and maximum instructions return their second operand when either is a
+// NaN, which here is the accumulator: NaN elements are skipped, and the
+// accumulators start from the first element that is not one.
+template<typename T, bool Largest>
+T extremum(const T* a, size_t n){
+
+    using P = Pack<T>;
+    constexpr size_t W = P::width;
+
+    size_t i{};
+
+    while (i + 1 < n and a[i] != a[i]){
+        ++i;
+    }
+
+    const auto select = [](auto x, auto y){
+        if constexpr (Largest){
+            return P::maximum(x, y);
+        } else {
+            return P::minimum(x, y);
+        }
+    };
+
+    const auto start {P::broadcast(a[i])};
+    auto s0 {start}, s1 {start}, s2 {start}, s3 {start};
+
+    for (; i + 4*W <= n; i += 4*W){
+        s0 = select(P::load(a + i), s0);
+        s1 = select(P::load(a + i + W), s1);
+        s2 = select(P::load(a + i + 2*W), s2);
+        s3 = select(P::load(a + i + 3*W), s3);
+    }
+
+    for (; i + W <= n; i += W){
+        s0 = select(P::load(a + i), s0);
+    }
+
+    T lanes[W];
+    P::store(lanes, select(select(s0, s1), select(s2, s3)));
+
+    T result {lanes[0]};
+
+    for (size_t k{1}; k<W; ++k){
+        if (Largest ? lanes[k] > result : lanes[k] < result) result = lanes[k];
+    }
+
+    for (; i<n; ++i){
+        if (Largest ? a[i] > result : a[i] < result) result = a[i];
+    }
+
+    return result;
+}
+
+// Sum of (scale * a[i])^2, with four accumulators
+template<typename T>
+T sumSquares(const T* a, size_t n, T scale){
+
+    using P = Pack<T>;
+    constexpr size_t W = P::width;
+
+    const auto s {P::broadcast(scale)};
+
+    auto s0 {P::zero()}, s1 {P::zero()}, s2 {P::zero()}, s3 {P::zero()};
+
+    size_t i{};
+
+    for (; i + 4*W <= n; i += 4*W){
+        const auto x0 {P::multiply(s, P::load(a + i))};
+        const auto x1 {P::multiply(s, P::load(a + i + W))};
+        const auto x2 {P::multiply(s, P::load(a + i + 2*W))};
+        const auto x3 {P::multiply(s, P::load(a + i + 3*W))};
+        s0 = P::multiplyAdd(x0, x0, s0);
+        s1 = P::multiplyAdd(x1, x1, s1);
+        s2 = P::multiplyAdd(x2, x2, s2);
+        s3 = P::multiplyAdd(x3, x3, s3);
+    }
+
+    for (; i + W <= n; i += W){
+        const auto x {P::multiply(s, P::load(a + i))};
+        s0 = P::multiplyAdd(x, x, s0);
+    }
+
+    T result {P::sum(P::add(P::add(s0, s1), P::add(s2, s3)))};
+
+    for (; i<n; ++i){
+        const T x {scale * a[i]};
+        result += x * x;
+    }
+
+    return result;
+}
+
+// a . b, a . a and b . b into out[0], out[1] and out[2]: three sums from
+// each pair of loads, two accumulators each
+template<typename T>
+void dotNorms(const T* a, const T* b, size_t n, T* out){
+
+    using P = Pack<T>;
+    constexpr size_t W = P::width;
+
+    auto ab0 {P::zero()}, ab1 {P::zero()};
+    auto aa0 {P::zero()}, aa1 {P::zero()};
+    auto bb0 {P::zero()}, bb1 {P::zero()};
+
+    size_t i{};
+
+    for (; i + 2*W <= n; i += 2*W){
+        const auto x0 {P::load(a + i)}, y0 {P::load(b + i)};
+        const auto x1 {P::load(a + i + W)}, y1 {P::load(b + i + W)};
+        ab0 = P::multiplyAdd(x0, y0, ab0);
+        aa0 = P::multiplyAdd(x0, x0, aa0);
+        bb0 = P::multiplyAdd(y0, y0, bb0);
+        ab1 = P::multiplyAdd(x1, y1, ab1);
+        aa1 = P::multiplyAdd(x1, x1, aa1);
+        bb1 = P::multiplyAdd(y1, y1, bb1);
+    }
+
+    for (; i + W <= n; i += W){
+        const auto x {P::load(a + i)}, y {P::load(b + i)};
+        ab0 = P::multiplyAdd(x, y, ab0);
+        aa0 = P::multiplyAdd(x, x, aa0);
+        bb0 = P::multiplyAdd(y, y, bb0);
+    }
+
+    T ab {P::sum(P::add(ab0, ab1))};
+    T aa {P::sum(P::add(aa0, aa1))};
+    T bb {P::sum(P::add(bb0, bb1))};
+
+    for (; i<n; ++i){
+        ab += a[i] * b[i];
+        aa += a[i] * a[i];
+        bb += b[i] * b[i];
+    }
+
+    out[0] = ab;
+    out[1] = aa;
+    out[2] = bb;
+}
+
+// Number of leading elements, in whole packs, within
+// absolute + relative * max(|a[i]|, |b[i]|) of each other. One branch per
+// pack, so that a mismatch early in long arrays ends the scan early
+template<typename T>
+size_t close(const T* a, const T* b, size_t n, T absolute, T relative){
+
+    using P = Pack<T>;
+    constexpr size_t W = P::width;
+
+    const auto tolerance {P::broadcast(absolute)};
+    const auto scale {P::broadcast(relative)};
+
+    size_t i{};
+
+    for (; i + W <= n; i += W){
+        const auto x {P::load(a + i)}, y {P::load(b + i)};
+        const auto bound {
+            P::multiplyAdd(scale, P::maximum(P::absolute(x), P::absolute(y)), tolerance)
+        };
+        if (not P::allLessEqual(P::absolute(P::subtract(x, y)), bound)){
+            break;
+        }
+    }
+
+    return i;
+}
+
+// y[m] = A[m][n] * x[n], A row-major with leading dimension lda. Four rows
+// are processed together so that every load of x feeds four multiply-adds.
+// A may be stored as S, widened to T as it is loaded.
+template<typename T, typename S = T>
+void gemv(size_t m, size_t n, const S* A, size_t lda, const T* x, T* y){
+
+    using P = Pack<T>;
+    constexpr size_t W = P::width;
+
+    size_t i{};
+
+    for (; i + 4 <= m; i += 4){
+
+        const S* a0 {A + i*lda};
+        const S* a1 {a0 + lda};
+        const S* a2 {a1 + lda};
+        const S* a3 {a2 + lda};
+
+        auto s0 {P::zero()}, s1 {P::zero()}, s2 {P::zero()}, s3 {P::zero()};
+
+        size_t j{};
+
+        for (; j + W <= n; j += W){
+            const auto xj {P::load(x + j)};
+            s0 = P::multiplyAdd(P::load(a0 + j), xj, s0);
+            s1 = P::multiplyAdd(P::load(a1 + j), xj, s1);
+            s2 = P::multiplyAdd(P::load(a2 + j), xj, s2);
+            s3 = P::multiplyAdd(P::load(a3 + j), xj, s3);
+        }
+
+        T y0 {P::sum(s0)}, y1 {P::sum(s1)}, y2 {P::sum(s2)}, y3 {P::sum(s3)};
+
+        for (; j<n; ++j){
+            y0 += static_cast<T>(a0[j]) * x[j];
+            y1 += static_cast<T>(a1[j]) * x[j];
+            y2 += static_cast<T>(a2[j]) * x[j];
+            y3 += static_cast<T>(a3[j]) * x[j];
+        }
+
+        y[i] = y0;
+        y[i + 1] = y1;
+        y[i + 2] = y2;
+        y[i + 3] = y3;
+    }
+
+    for (; i<m; ++i){
+        y[i] = dot<T, S, T>(A + i*lda, x, n);
+    }
+}
+
+
+// Batched kernels over vectors stored as structure of arrays: component c of
+// vector i is v[c][i], so that a pack holds the same component of W
+// consecutive vectors and each lane computes one vector. Every pack of
+// inputs is loaded before any output of the same vectors is stored, so the
+// outputs may be the inputs.
+
+// out[r][i] = sum over c of m[r*C + c] * in[c][i]: one R x C matrix, whose
+// elements stay broadcast in registers, applied to n vectors
+template<typename T, size_t R, size_t C>
+void transform(const T* m, const T* const* in, T* const* out, size_t n){
+
+    using P = Pack<T>;
+    constexpr size_t W = P::width;
+
+    decltype(P::zero()) element[R][C];
+
+    for (size_t r{}; r<R; ++r){
+        for (size_t c{}; c<C; ++c){
+            element[r][c] = P::broadcast(m[r*C + c]);
+        }
+    }
+
+    size_t i{};
+
+    for (; i + W <= n; i += W){
+
+        decltype(P::zero()) x[C], y[R];
+
+        for (size_t c{}; c<C; ++c){
+            x[c] = P::load(in[c] + i);
+        }
+
+        for (size_t r{}; r<R; ++r){
+            y[r] = P::multiply(element[r][0], x[0]);
+            for (size_t c{1}; c<C; ++c){
+                y[r] = P::multiplyAdd(element[r][c], x[c], y[r]);
+            }
+        }
+
+        for (size_t r{}; r<R; ++r){
+            P::store(out[r] + i, y[r]);
+        }
+    }
+
+    for (; i<n; ++i){
+
+        T x[C], y[R];
+
+        for (size_t c{}; c<C; ++c){
+            x[c] = in[c][i];
+        }
+
+        for (size_t r{}; r<R; ++r){
+            y[r] = T{};
+            for (size_t c{}; c<C; ++c){
+                y[r] = static_cast<T>(y[r] + m[r*C + c] * x[c]);
+            }
+        }
+
+        for (size_t r{}; r<R; ++r){
+            out[r][i] = y[r];
+        }
+    }
+}
+
+// out[r][i] = sum over c of m[r*C + c][i] * in[c][i]: matrix i, itself
+// stored as structure of arrays, applied to vector i
+template<typename T, size_t R, size_t C>
+void transformEach(const T* const* m, const T* const* in, T* const* out, size_t n){
+
+    using P = Pack<T>;
+    constexpr size_t W = P::width;
+
+    size_t i{};
+
+    for (; i + W <= n; i += W){
+
+        decltype(P::zero()) x[C], y[R];
+
+        for (size_t c{}; c<C; ++c){
+            x[c] = P::load(in[c] + i);
+        }
+
+        for (size_t r{}; r<R; ++r){
+            y[r] = P::multiply(P::load(m[r*C] + i), x[0]);
+            for (size_t c{1}; c<C; ++c){
+                y[r] = P::multiplyAdd(P::load(m[r*C + c] + i), x[c], y[r]);
+            }
+        }
+
+        for (size_t r{}; r<R; ++r){
+            P::store(out[r] + i, y[r]);
+        }
+    }
+
+    for (; i<n; ++i){
+
+        T x[C], y[R];
+
+        for (size_t c{}; c<C; ++c){
+            x[c] = in[c][i];
+        }
+
+        for (size_t r{}; r<R; ++r){
+            y[r] = T{};
+            for (size_t c{}; c<C; ++c){
+                y[r] = static_cast<T>(y[r] + m[r*C + c][i] * x[c]);
+            }
+        }
+
+        for (size_t r{}; r<R; ++r){
+            out[r][i] = y[r];
+        }
+    }
+}
+
+// out[i] = sum over c of a[c][i] * b[c][i]
+template<typename T, size_t N>
+void dotEach(const T* const* a, const T* const* b, T* out, size_t n){
+
+    using P = Pack<T>;
+    constexpr size_t W = P::width;
+
+    size_t i{};
+
+    for (; i + W <= n; i += W){
+
+        auto s {P::multiply(P::load(a[0] + i), P::load(b[0] + i))};
+
+        for (size_t c{1}; c<N; ++c){
+            s = P::multiplyAdd(P::load(a[c] + i), P::load(b[c] + i), s);
+        }
+
+        P::store(out + i, s);
+    }
+
+    for (; i<n; ++i){
+
+        T s {};
+
+        for (size_t c{}; c<N; ++c){
+            s = static_cast<T>(s + a[c][i] * b[c][i]);
+        }
+
+        out[i] = s;
+    }
+}
+
+// out[.][i] = a[.][i] x b[.][i], for 3 dimensional vectors
+template<typename T>
+void crossEach(const T* const* a, const T* const* b, T* const* out, size_t n){
+
+    using P = Pack<T>;
+    constexpr size_t W = P::width;
+
+    size_t i{};
+
+    for (; i + W <= n; i += W){
+
+        const auto ax {P::load(a[0] + i)}, ay {P::load(a[1] + i)}, az {P::load(a[2] + i)};
+        const auto bx {P::load(b[0] + i)}, by {P::load(b[1] + i)}, bz {P::load(b[2] + i)};
+
+        P::store(out[0] + i, P::subtract(P::multiply(ay, bz), P::multiply(az, by)));
+        P::store(out[1] + i, P::subtract(P::multiply(az, bx), P::multiply(ax, bz)));
+        P::store(out[2] + i, P::subtract(P::multiply(ax, by), P::multiply(ay, bx)));
+    }
+
+    for (; i<n; ++i){
+
+        const T ax {a[0][i]}, ay {a[1][i]}, az {a[2][i]};
+        const T bx {b[0][i]}, by {b[1][i]}, bz {b[2][i]};
+
+        out[0][i] = static_cast<T>(ay * bz - az * by);
+        out[1][i] = static_cast<T>(az * bx - ax * bz);
+        out[2][i] = static_cast<T>(ax * by - ay * bx);
+    }
+}
@@ -0,0 +1,770 @@
+#ifndef _SPARSE_H_
+#define _SPARSE_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <iostream>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Compare.h"
+#include "Trace.h"
+#include "Bounds.h"
+#include "Expression.h"
+#include "AlignedBuffer.h"
+#include "Simd.h"
+#include "ThreadPool.h"
+#include "DynMatrix.h"
+
+/*
+    Sparse matrices, storing only their nonzero elements, in compressed
+    sparse row (CSR) or compressed sparse column (CSC) format:
+
+        CsrMatrix<double> a(rows, columns, {{0, 0, 4.0}, {0, 2, -1.0}, {1, 1, 3.0}});
+        CscMatrix<double> b {a};                // the same matrix, by columns
+
+    A matrix is built from (row, column, value) triplets in any order, as
+    collected by an assembly loop (duplicates are summed and zeros
+    dropped), or from a dense matrix. CSR keeps, for every row, the columns
+    and values of its nonzero elements in increasing column order, plus the
+    offset of each row into those arrays; CSC does the same by columns.
+    Indices are 32-bit, so that more of them fit in cache and the SIMD
+    gathers can use them directly: the number of columns of a CSR matrix
+    (rows of a CSC one) must stay below 2^31.
+
+    Products with dense vectors and matrices (Vector, DynVector, Matrix,
+    DynMatrix and their views) are expressions evaluated by spmv() and
+    spmm(), which can also be called directly like gemv() and gemm():
+
+        y.noalias() = a * x;                    // spmv(1, a, x, 0, y)
+        c.noalias() += a * d;                   // spmm(1, a, d, 1, c)
+        DynVector<double> r = b - a * x;
+
+    CSR products are split over the thread pool in blocks of rows holding
+    about the same number of nonzero elements, and the rows long enough
+    gather x a SIMD register at a time (simd::gatherDot). CSC products
+    scatter into the result column by column: spmm() splits the columns of
+    the dense operand over the threads, spmv() runs on one thread. For
+    repeated matrix-vector products, prefer CSR.
+*/
+
+namespace sparse{
+
+    // Index of a column of a CSR matrix, or of a row of a CSC matrix
+    using Index = std::uint32_t;
+
+    // Indices stay below 2^31, for the signed 32-bit gathers
+    inline constexpr size_t maxExtent = size_t{1} << 31;
+
+    enum class Format { CSR, CSC };
+
+    // One element of a matrix in coordinate (COO) format
+    template<typename T>
+    struct Triplet{
+        size_t row;
+        size_t column;
+        T value;
+    };
+
+    template<typename S, typename R>
+    class Product;
+
+}
+
+template<typename T, sparse::Format F = sparse::Format::CSR>
+class SparseMatrix;
+
+template<typename T>
+using CsrMatrix = SparseMatrix<T, sparse::Format::CSR>;
+
+template<typename T>
+using CscMatrix = SparseMatrix<T, sparse::Format::CSC>;
+
+
+namespace kernel{
+
+    // Calls function(begin, end) over blocks of the rows [0, M) of a CSR
+    // matrix, offset being its M + 1 row offsets. The blocks hold about the
+    // same number of nonzero elements (rather than of rows), each costing
+    // workPerElement, so that a few dense rows do not leave all the work to
+    // one thread.
+    template<typename Function>
+    void forSparseRows(size_t M, const size_t* offset, size_t workPerElement, const Function& function){
+
+        const size_t nonZeros {M == 0 ? 0 : offset[M]};
+
+        parallel::forBlocks(nonZeros, workPerElement, 1, [&](size_t begin, size_t end){
+
+            // The rows that start within [begin, end), the last block taking
+            // the empty rows at the end
+            const size_t first {static_cast<size_t>(std::lower_bound(offset, offset + M, begin) - offset)};
+            const size_t last {
+                end == nonZeros ? M : static_cast<size_t>(std::lower_bound(offset, offset + M, end) - offset)
+            };
+
+            if (first < last){
+                function(first, last);
+            }
+        });
+    }
+
+    // Sum of value[k] * x[index[k]*incx] for k < n: a row of a CSR matrix
+    // times a dense vector
+    template<typename T>
+    T sparseDot(size_t n, const T* value, const sparse::Index* index, const T* x, size_t incx){
+
+        if constexpr (simd::Accelerated<T>){
+            if (incx == 1 and n >= simd::minLength){
+                return simd::gatherDot(value, index, x, n);
+            }
+        }
+
+        T sum {};
+
+        if (incx == 1){
+            for (size_t k{}; k<n; ++k){
+                sum = static_cast<T>(sum + value[k] * x[index[k]]);
+            }
+        } else {
+            for (size_t k{}; k<n; ++k){
+                sum = static_cast<T>(sum + value[k] * x[index[k] * incx]);
+            }
+        }
+
+        return sum;
+    }
+
+    // y[M] = alpha * A * x + beta * y, A being a CSR matrix of M rows
+    // (offset, index, value), x[j] at x[j*incx] and y[i] at y[i*incy]
+    template<typename T>
+    void csrmv(
+        size_t M, const size_t* offset, const sparse::Index* index, const T* value,
+        T alpha, const T* x, size_t incx, T beta, T* y, size_t incy
+    ){
+        forSparseRows(M, offset, 2, [&](size_t begin, size_t end){
+
+            for (size_t i{begin}; i<end; ++i){
+
+                const size_t first {offset[i]};
+                const T sum {sparseDot(offset[i + 1] - first, value + first, index + first, x, incx)};
+
+                y[i*incy] = beta == T{}
+                    ? static_cast<T>(alpha * sum)
+                    : static_cast<T>(alpha * sum + beta * y[i*incy]);
+            }
+        });
+    }
+
+    // y[M] = alpha * A * x + beta * y, A being a CSC matrix of M rows and
+    // N columns: every column is scattered into y, on the calling thread
+    template<typename T>
+    void cscmv(
+        size_t M, size_t N, const size_t* offset, const sparse::Index* index, const T* value,
+        T alpha, const T* x, size_t incx, T beta, T* y, size_t incy
+    ){
+        for (size_t i{}; i<M; ++i){
+            y[i*incy] = beta == T{} ? T{} : static_cast<T>(beta * y[i*incy]);
+        }
+
+        for (size_t j{}; j<N; ++j){
+
+            const T scale {static_cast<T>(alpha * x[j*incx])};
+
+            if (scale == T{}){
+                continue;
+            }
+
+            for (size_t k{offset[j]}; k<offset[j + 1]; ++k){
+                T& element {y[index[k] * incy]};
+                element = static_cast<T>(element + value[k] * scale);
+            }
+        }
+    }
+
+    // c[n*incc] += alpha * b[n*incb], with the SIMD axpy when contiguous
+    template<typename T>
+    void axpyRow(size_t n, T alpha, const T* b, size_t incb, T* c, size_t incc){
+
+        if constexpr (simd::Accelerated<T>){
+            if (incb == 1 and incc == 1 and n >= simd::minLength){
+                simd::axpy(n, alpha, b, c);
+                return;
+            }
+        }
+
+        for (size_t j{}; j<n; ++j){
+            c[j*incc] = static_cast<T>(c[j*incc] + alpha * b[j*incb]);
+        }
+    }
+
+    // C[M][N] = alpha * A * B + beta * C, A being a CSR matrix of M rows:
+    // row i of C accumulates the rows of B selected by row i of A. Element
+    // (k, j) of B is B[k*rsb + j*csb], and likewise for C.
+    template<typename T>
+    void csrmm(
+        size_t M, size_t N, const size_t* offset, const sparse::Index* index, const T* value,
+        T alpha, const T* B, size_t rsb, size_t csb, T beta, T* C, size_t rsc, size_t csc
+    ){
+        forSparseRows(M, offset, 2 * N, [&](size_t begin, size_t end){
+
+            for (size_t i{begin}; i<end; ++i){
+
+                T* c {C + i*rsc};
+
+                for (size_t j{}; j<N; ++j){
+                    c[j*csc] = beta == T{} ? T{} : static_cast<T>(beta * c[j*csc]);
+                }
+
+                for (size_t k{offset[i]}; k<offset[i + 1]; ++k){
+                    axpyRow(N, static_cast<T>(alpha * value[k]), B + index[k]*rsb, csb, c, csc);
+                }
+            }
+        });
+    }
+
+    // C[M][N] = alpha * A * B + beta * C, A being a CSC matrix of M rows
+    // and K columns: column k of A scatters row k of B into the rows of C.
+    // The columns of B and C are split over the threads, which thus never
+    // write the same element.
+    template<typename T>
+    void cscmm(
+        size_t M, size_t N, size_t K, const size_t* offset, const sparse::Index* index, const T* value,
+        T alpha, const T* B, size_t rsb, size_t csb, T beta, T* C, size_t rsc, size_t csc
+    ){
+        const size_t nonZeros {K == 0 ? 0 : offset[K]};
+
+        parallel::forBlocks(N, 2 * nonZeros + M, 16, [&](size_t begin, size_t end){
+
+            const size_t n {end - begin};
+
+            for (size_t i{}; i<M; ++i){
+                T* c {C + i*rsc + begin*csc};
+                for (size_t j{}; j<n; ++j){
+                    c[j*csc] = beta == T{} ? T{} : static_cast<T>(beta * c[j*csc]);
+                }
+            }
+
+            for (size_t k{}; k<K; ++k){
+                for (size_t p{offset[k]}; p<offset[k + 1]; ++p){
+                    axpyRow(
+                        n, static_cast<T>(alpha * value[p]), B + k*rsb + begin*csb, csb,
+                        C + index[p]*rsc + begin*csc, csc
+                    );
+                }
+            }
+        });
+    }
+
+}
+
+
+template<typename T, sparse::Format F>
+class SparseMatrix : private trace::Traced<trace::Type::SparseMatrix>{
+
+    static_assert(
+        std::is_arithmetic<T>::value,
+        "SparseMatrix class can only store integral or floating point values"
+    );
+
+    // Prints the stored elements, one "(row, column) value" per line
+    friend std::ostream& operator<<(std::ostream& os, const SparseMatrix& matrix){
+        for (size_t major{}; major<matrix.majorCount(); ++major){
+            for (size_t k{matrix.offset.data()[major]}; k<matrix.offset.data()[major + 1]; ++k){
+                const size_t minor {matrix.index.data()[k]};
+                os << "(" << (rowMajor ? major : minor) << ", " << (rowMajor ? minor : major) << ") "
+                   << matrix.element.data()[k];
+                if (k + 1 != matrix.nonZeros()) {os << std::endl;}
+            }
+        }
+        return os;
+    }
+
+    template<typename, sparse::Format> friend class SparseMatrix;
+
+    private:
+
+        static constexpr bool rowMajor = F == sparse::Format::CSR;
+
+        static constexpr sparse::Format transposed = (
+            rowMajor ? sparse::Format::CSC : sparse::Format::CSR
+        );
+
+        size_t rowCount;
+        size_t columnCount;
+        AlignedBuffer<size_t> offset;           // where each row (CSC: column) starts, plus the end
+        AlignedBuffer<sparse::Index> index;     // column (CSC: row) of each stored element
+        AlignedBuffer<T> element;               // stored elements, row (CSC: column) by row
+
+        // Rows of CSR, columns of CSC
+        size_t majorCount() const noexcept {
+            return rowMajor ? rowCount : columnCount;
+        }
+
+        size_t minorCount() const noexcept {
+            return rowMajor ? columnCount : rowCount;
+        }
+
+        void checkExtent() const {
+            if (minorCount() > sparse::maxExtent){
+                throw std::length_error("Sparse matrix dimensions exceed the 32-bit index range");
+            }
+        }
+
+        // The stored element at (row, column), or nullptr if it is zero
+        const T* find(size_t row, size_t column) const {
+
+            const size_t major {rowMajor ? row : column}, minor {rowMajor ? column : row};
+
+            const sparse::Index* first {index.data() + offset.data()[major]};
+            const sparse::Index* last {index.data() + offset.data()[major + 1]};
+            const sparse::Index* position {std::lower_bound(first, last, minor)};
+
+            if (position == last or *position != minor){
+                return nullptr;
+            }
+
+            return element.data() + (position - index.data());
+        }
+
+        // Fills the arrays from triplets: a counting sort by row (CSC: by
+        // column), then a stable sort of each row by column, so that
+        // duplicates are summed in the order they were given
+        void assemble(std::span<const sparse::Triplet<T>> triplets){
+
+            size_t* start {offset.data()};
+
+            for (const auto& triplet : triplets){
+                bounds::check(triplet.row, rowCount);
+                bounds::check(triplet.column, columnCount);
+                ++start[(rowMajor ? triplet.row : triplet.column) + 1];
+            }
+
+            for (size_t major{}; major<majorCount(); ++major){
+                start[major + 1] += start[major];
+            }
+
+            std::vector<std::pair<sparse::Index, T>> entries(triplets.size());
+            std::vector<size_t> cursor(start, start + majorCount());
+
+            for (const auto& triplet : triplets){
+                const size_t major {rowMajor ? triplet.row : triplet.column};
+                const size_t minor {rowMajor ? triplet.column : triplet.row};
+                entries[cursor[major]++] = {static_cast<sparse::Index>(minor), triplet.value};
+            }
+
+            // Sorts, sums and drops the zeros row by row, compacting entries
+            size_t stored {};
+
+            for (size_t major{}; major<majorCount(); ++major){
+
+                const auto first {entries.begin() + static_cast<std::ptrdiff_t>(start[major])};
+                const auto last {entries.begin() + static_cast<std::ptrdiff_t>(start[major + 1])};
+
+                std::stable_sort(first, last, [](const auto& a, const auto& b){
+                    return a.first < b.first;
+                });
+
+                start[major] = stored;
+
+                for (auto entry {first}; entry != last; ){
+
+                    auto sum {*entry};
+
+                    for (++entry; entry != last and entry->first == sum.first; ++entry){
+                        sum.second = static_cast<T>(sum.second + entry->second);
+                    }
+
+                    if (sum.second != T{}){
+                        entries[stored++] = sum;
+                    }
+                }
+            }
+
+            start[majorCount()] = stored;
+
+            index.reset(stored);
+            element.reset(stored);
+
+            for (size_t k{}; k<stored; ++k){
+                index.data()[k] = entries[k].first;
+                element.data()[k] = entries[k].second;
+            }
+        }
+
+    public:
+
+    /******** Constructors - Assignment Operators - Destructor ***************/
+
+    // Default Constructor (empty 0 x 0 matrix)
+    SparseMatrix() noexcept
+    : rowCount{0}, columnCount{0}, offset{}, index{}, element{} {}
+
+    // Size Constructor (zero matrix, nothing stored)
+    SparseMatrix(size_t rows, size_t columns)
+    : rowCount{rows}, columnCount{columns},
+      offset{(rowMajor ? rows : columns) + 1}, index{}, element{} {
+        checkExtent();
+    }
+
+    // Triplets Constructor: the sum of the values given for each element,
+    // in any order (throws std::out_of_range for an element outside the
+    // matrix)
+    SparseMatrix(size_t rows, size_t columns, std::span<const sparse::Triplet<T>> triplets)
+    : SparseMatrix(rows, columns) {
+        assemble(triplets);
+    }
+
+    SparseMatrix(size_t rows, size_t columns, std::initializer_list<sparse::Triplet<T>> triplets)
+    : SparseMatrix(rows, columns, std::span<const sparse::Triplet<T>>{triplets.begin(), triplets.size()}) {}
+
+    // Dense Constructor: the nonzero elements of a Matrix, DynMatrix or
+    // matrix view
+    template<expr::Strided<2> E>
+        requires std::same_as<typename E::value_type, T>
+    explicit SparseMatrix(const E& dense)
+    : SparseMatrix(dense.shape()[0], dense.shape()[1]) {
+
+        const auto at = [&](size_t major, size_t minor){
+            return rowMajor ? dense.eval(major, minor) : dense.eval(minor, major);
+        };
+
+        size_t stored {};
+
+        for (size_t major{}; major<majorCount(); ++major){
+            for (size_t minor{}; minor<minorCount(); ++minor){
+                stored += at(major, minor) != T{};
+            }
+        }
+
+        index.reset(stored);
+        element.reset(stored);
+        stored = 0;
+
+        for (size_t major{}; major<majorCount(); ++major){
+            offset.data()[major] = stored;
+            for (size_t minor{}; minor<minorCount(); ++minor){
+                if (const T value {at(major, minor)}; value != T{}){
+                    index.data()[stored] = static_cast<sparse::Index>(minor);
+                    element.data()[stored++] = value;
+                }
+            }
+        }
+
+        offset.data()[majorCount()] = stored;
+    }
+
+    // Converting Constructor from the other format (CSR from CSC and the
+    // reverse), a counting sort of the stored elements
+    explicit SparseMatrix(const SparseMatrix<T, transposed>& source)
+    : SparseMatrix(source.rowCount, source.columnCount) {
+
+        const size_t stored {source.nonZeros()};
+        size_t* start {offset.data()};
+
+        for (size_t k{}; k<stored; ++k){
+            ++start[source.index.data()[k] + 1];
+        }
+
+        for (size_t major{}; major<majorCount(); ++major){
+            start[major + 1] += start[major];
+        }
+
+        index.reset(stored);
+        element.reset(stored);
+
+        std::vector<size_t> cursor(start, start + majorCount());
+
+        for (size_t minor{}; minor<source.majorCount(); ++minor){
+            for (size_t k{source.offset.data()[minor]}; k<source.offset.data()[minor + 1]; ++k){
+                const size_t position {cursor[source.index.data()[k]]++};
+                index.data()[position] = static_cast<sparse::Index>(minor);
+                element.data()[position] = source.element.data()[k];
+            }
+        }
+    }
+
+    // Copy Constructor and Copy Assignment Operator (duplicate the arrays)
+    SparseMatrix(const SparseMatrix& source) = default;
+    SparseMatrix& operator=(const SparseMatrix& rhs) = default;
+
+    // Move Constructor (steals the arrays, leaving an empty 0 x 0 matrix)
+    SparseMatrix(SparseMatrix&& source) noexcept
+    : Traced{std::move(source)},
+      rowCount{std::exchange(source.rowCount, 0)},
+      columnCount{std::exchange(source.columnCount, 0)},
+      offset{std::move(source.offset)},
+      index{std::move(source.index)},
+      element{std::move(source.element)} {}
+
+    // Move Assignment Operator
+    SparseMatrix& operator=(SparseMatrix&& rhs) noexcept {
+        Traced::operator=(std::move(rhs));
+        rowCount = std::exchange(rhs.rowCount, 0);
+        columnCount = std::exchange(rhs.columnCount, 0);
+        offset = std::move(rhs.offset);
+        index = std::move(rhs.index);
+        element = std::move(rhs.element);
+        return *this;
+    }
+
+    // Default destructor
+    ~SparseMatrix() = default;
+
+
+    /****************** Methods - Overloaded Operators ********************/
+
+    using value_type = T;
+    static constexpr sparse::Format format = F;
+
+    size_t rows() const noexcept {
+        return rowCount;
+    }
+
+    size_t columns() const noexcept {
+        return columnCount;
+    }
+
+    // Number of stored (nonzero) elements
+    size_t nonZeros() const noexcept {
+        return element.size();
+    }
+
+    // The compressed arrays: for row i (CSC: column i), the stored elements
+    // values()[k] in column indices()[k] (CSC: row), for k from offsets()[i]
+    // to offsets()[i + 1]. The values can be updated in place, keeping the
+    // pattern of nonzero elements.
+    std::span<const size_t> offsets() const noexcept {
+        return {offset.data(), offset.size()};
+    }
+
+    std::span<const sparse::Index> indices() const noexcept {
+        return {index.data(), index.size()};
+    }
+
+    std::span<const T> values() const noexcept {
+        return {element.data(), element.size()};
+    }
+
+    std::span<T> values() noexcept {
+        return {element.data(), element.size()};
+    }
+
+    // Element (row, column), zero if not stored: a binary search within its
+    // row (CSC: column), checked only when bounds are (see Bounds.h)
+    T operator[](size_t row, size_t column) const {
+        bounds::debugCheck(row, rowCount);
+        bounds::debugCheck(column, columnCount);
+        const T* found {find(row, column)};
+        return found ? *found : T{};
+    }
+
+    // Checked element access
+    T at(size_t row, size_t column) const {
+        bounds::check(row, rowCount);
+        bounds::check(column, columnCount);
+        const T* found {find(row, column)};
+        return found ? *found : T{};
+    }
+
+    // Dense copy of the matrix
+    DynMatrix<T> dense() const {
+
+        DynMatrix<T> matrix(rowCount, columnCount);
+
+        for (size_t major{}; major<majorCount(); ++major){
+            for (size_t k{offset.data()[major]}; k<offset.data()[major + 1]; ++k){
+                const size_t minor {index.data()[k]};
+                (rowMajor ? matrix[major, minor] : matrix[minor, major]) = element.data()[k];
+            }
+        }
+
+        return matrix;
+    }
+
+    // Transpose, in the other format: the same arrays, read the other way
+    SparseMatrix<T, transposed> transpose() const {
+        SparseMatrix<T, transposed> result {};
+        result.rowCount = columnCount;
+        result.columnCount = rowCount;
+        result.offset = offset;
+        result.index = index;
+        result.element = element;
+        return result;
+    }
+
+    // Equal-to Operator (==): same dimensions and nonzero elements, the
+    // values compared as by compare::equal
+    bool operator==(const SparseMatrix& rhs) const {
+
+        if (rowCount != rhs.rowCount or columnCount != rhs.columnCount){
+            return false;
+        }
+
+        return nonZeros() == rhs.nonZeros()
+            and std::equal(offset.data(), offset.data() + offset.size(), rhs.offset.data())
+            and std::equal(index.data(), index.data() + nonZeros(), rhs.index.data())
+            and compare::equal(element.data(), rhs.element.data(), nonZeros());
+    }
+
+    // Not-Equal-to Operator (!=)
+    bool operator!=(const SparseMatrix& rhs) const {
+        return !(*this == rhs);
+    }
+
+    // Products with a dense vector or matrix (or a view of one, or an
+    // expression, evaluated first), evaluated by spmv() / spmm() into the
+    // DynVector or DynMatrix they are assigned to
+    template<expr::Expression R>
+        requires (
+            std::same_as<typename R::value_type, T>
+            and std::tuple_size_v<decltype(std::declval<const R&>().shape())> <= 2
+        )
+    sparse::Product<SparseMatrix, R> operator*(const R& rhs) const {
+        return {*this, rhs};
+    }
+
+};
+
+
+/*************** BLAS-style Sparse Operations *****************************/
+
+// y = alpha * A * x + beta * y, A sparse (see kernel::csrmv, kernel::cscmv)
+template<typename T, sparse::Format F, expr::Strided<1> V, typename D,
+         typename Destination = std::remove_cvref_t<D>>
+    requires (
+        expr::Strided<Destination, 1> and expr::Writable<Destination>
+        and std::same_as<typename V::value_type, T> and expr::SameValueType<V, Destination>
+    )
+void spmv(
+    std::type_identity_t<T> alpha, const SparseMatrix<T, F>& A, const V& x,
+    std::type_identity_t<T> beta, D&& y
+){
+    if (x.shape()[0] != A.columns() or y.shape()[0] != A.rows()){
+        throw std::invalid_argument("Matrix dimensions do not match");
+    }
+
+    if constexpr (F == sparse::Format::CSR){
+        kernel::csrmv(
+            A.rows(), A.offsets().data(), A.indices().data(), A.values().data(),
+            alpha, x.data(), x.strides()[0], beta, y.data(), y.strides()[0]
+        );
+    } else {
+        kernel::cscmv(
+            A.rows(), A.columns(), A.offsets().data(), A.indices().data(), A.values().data(),
+            alpha, x.data(), x.strides()[0], beta, y.data(), y.strides()[0]
+        );
+    }
+}
+
+// C = alpha * A * B + beta * C, A sparse and B, C dense (see kernel::csrmm,
+// kernel::cscmm)
+template<typename T, sparse::Format F, expr::Strided<2> R, typename D,
+         typename Destination = std::remove_cvref_t<D>>
+    requires (
+        expr::Strided<Destination, 2> and expr::Writable<Destination>
+        and std::same_as<typename R::value_type, T> and expr::SameValueType<R, Destination>
+    )
+void spmm(
+    std::type_identity_t<T> alpha, const SparseMatrix<T, F>& A, const R& B,
+    std::type_identity_t<T> beta, D&& C
+){
+    const size_t N {B.shape()[1]};
+
+    if (B.shape()[0] != A.columns() or C.shape()[0] != A.rows() or C.shape()[1] != N){
+        throw std::invalid_argument("Matrix dimensions do not match");
+    }
+
+    const auto [rsb, csb] = B.strides();
+    const auto [rsc, csc] = C.strides();
+
+    if constexpr (F == sparse::Format::CSR){
+        kernel::csrmm(
+            A.rows(), N, A.offsets().data(), A.indices().data(), A.values().data(),
+            alpha, B.data(), rsb, csb, beta, C.data(), rsc, csc
+        );
+    } else {
+        kernel::cscmm(
+            A.rows(), N, A.columns(), A.offsets().data(), A.indices().data(), A.values().data(),
+            alpha, B.data(), rsb, csb, beta, C.data(), rsc, csc
+        );
+    }
+}
+
+
+namespace sparse{
+
+    namespace detail{
+
+        // Dense operands are held like those of expr::Product, other
+        // expressions are evaluated first, for spmv() and spmm() to read
+        // them from memory
+        template<typename R>
+        using Operand = std::conditional_t<
+            expr::Stored<R>, expr::Operand<R>, const typename R::result_type
+        >;
+
+    }
+
+    // Product of a sparse matrix by a dense vector or matrix, evaluated as
+    // a whole into its destination like expr::Product
+    template<typename S, typename R>
+    class Product{
+
+        private:
+
+            const S& lhs;
+            detail::Operand<R> rhs;
+
+            static constexpr bool matrixProduct = (
+                std::tuple_size_v<decltype(std::declval<const R&>().shape())> == 2
+            );
+
+        public:
+
+            using value_type = typename S::value_type;
+            using result_type = std::conditional_t<
+                matrixProduct, DynMatrix<value_type>, DynVector<value_type>
+            >;
+            static constexpr bool elementwise = false;
+
+            Product(const S& lhs, const R& rhs): lhs{lhs}, rhs{rhs} {
+                if (lhs.columns() != this->rhs.shape()[0]){
+                    throw std::invalid_argument("Matrix dimensions do not match");
+                }
+            }
+
+            auto shape() const {
+                if constexpr (matrixProduct){
+                    return std::array<size_t, 2>{lhs.rows(), rhs.shape()[1]};
+                } else {
+                    return std::array<size_t, 1>{lhs.rows()};
+                }
+            }
+
+            // destination = lhs * rhs, destination += lhs * rhs or
+            // destination -= lhs * rhs, depending on Op
+            template<typename Op, typename Destination>
+            void evaluateInto(Destination& destination) const {
+
+                using T = value_type;
+
+                const T alpha {std::same_as<Op, expr::SubtractAssign> ? T{} - T{1} : T{1}};
+                const T beta {std::same_as<Op, expr::Assign> ? T{} : T{1}};
+
+                if constexpr (matrixProduct){
+                    spmm(alpha, lhs, rhs, beta, destination);
+                } else {
+                    spmv(alpha, lhs, rhs, beta, destination);
+                }
+            }
+    };
+
+}
+
+static_assert(std::is_nothrow_move_constructible_v<CsrMatrix<double>>);
+static_assert(std::is_nothrow_move_assignable_v<CsrMatrix<double>>);
+
+#endif
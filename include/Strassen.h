@@ -0,0 +1,254 @@
+#ifndef _STRASSEN_H_
+#define _STRASSEN_H_
+
+#include <algorithm>
+#include <atomic>
+#include "AlignedBuffer.h"
+#include "Gemm.h"
+#include "Memory.h"
+
+/*
+    Strassen-Winograd multiplication of large square matrices: 7 products
+    of half the size and 15 additions instead of 8 products, applied
+    recursively down to a crossover size, below which the blocked kernel
+    (kernel::gemm) takes over. This costs O(n^2.81) multiply-adds instead
+    of O(n^3).
+
+    gemm() (Blas.h), and so every product of the operators, uses it for
+    square operands with contiguous rows, under the global policy:
+
+        strassen::setPolicy(strassen::Policy::Never);   // never
+        strassen::setPolicy(strassen::Policy::Auto);    // n >= threshold() (default)
+        strassen::setPolicy(strassen::Policy::Always);  // n > crossover()
+        strassen::setThreshold(4096);
+
+    or directly:
+
+        strassen::multiply(n, alpha, A, lda, B, ldb, beta, C, ldc);
+
+    Each level of the recursion needs two temporaries of a quarter of its
+    size (the schedule of Douglas et al., which keeps the other partial
+    results in the quadrants of C), about 2/3 n^2 elements in all. They are
+    carved out of one buffer per thread, grown on demand and reused by
+    every later call, so that a multiplication allocates nothing once the
+    buffer is large enough. An odd size is split into an even one, handled
+    recursively, and a row and column of thin products (dynamic peeling).
+
+    The crossover and threshold defaults come from bench/strassen_bench.cpp.
+    The result differs from the classic product by rounding only, but by
+    more of it: the error bound grows as n^log2(12) rather than n, which is
+    why the policy is a setting.
+*/
+
+namespace strassen{
+
+    enum class Policy { Never, Auto, Always };
+
+    namespace detail{
+
+        inline std::atomic<Policy> policy {Policy::Auto};
+        inline std::atomic<size_t> threshold {1024};
+        inline std::atomic<size_t> crossover {256};
+
+        // Z[m][m] = X + Y and Z = X - Y, for Z equal to X or Y or apart
+        template<typename T>
+        void add(size_t m, const T* X, size_t ldx, const T* Y, size_t ldy, T* Z, size_t ldz){
+            for (size_t i{}; i<m; ++i){
+                for (size_t j{}; j<m; ++j){
+                    Z[i*ldz + j] = static_cast<T>(X[i*ldx + j] + Y[i*ldy + j]);
+                }
+            }
+        }
+
+        template<typename T>
+        void subtract(size_t m, const T* X, size_t ldx, const T* Y, size_t ldy, T* Z, size_t ldz){
+            for (size_t i{}; i<m; ++i){
+                for (size_t j{}; j<m; ++j){
+                    Z[i*ldz + j] = static_cast<T>(X[i*ldx + j] - Y[i*ldy + j]);
+                }
+            }
+        }
+
+        // C[n][n] = A * B, with the temporaries in work
+        template<typename T>
+        void product(
+            size_t n, const T* A, size_t lda, const T* B, size_t ldb,
+            T* C, size_t ldc, T* work, size_t crossover
+        ){
+            if (n <= crossover){
+                kernel::gemm(n, n, n, A, lda, B, ldb, C, ldc);
+                return;
+            }
+
+            if (n % 2 == 1){
+
+                const size_t p {n - 1};
+
+                product(p, A, lda, B, ldb, C, ldc, work, crossover);
+
+                // C[0, p)[0, p) += A[0, p)[p] * B[p][0, p)
+                kernel::gemm(p, p, 1, T{1}, A + p, lda, B + p*ldb, ldb, T{1}, C, ldc);
+                // C[0, p)[p] = A[0, p) * B[][p]
+                kernel::gemm(p, 1, n, T{1}, A, lda, B + p, ldb, T{}, C + p, ldc);
+                // C[p] = A[p] * B
+                kernel::gemm(1, n, n, T{1}, A + p*lda, lda, B, ldb, T{}, C + p*ldc, ldc);
+
+                return;
+            }
+
+            const size_t m {n / 2};
+
+            const T* A11 {A};
+            const T* A12 {A + m};
+            const T* A21 {A + m*lda};
+            const T* A22 {A + m*lda + m};
+
+            const T* B11 {B};
+            const T* B12 {B + m};
+            const T* B21 {B + m*ldb};
+            const T* B22 {B + m*ldb + m};
+
+            T* C11 {C};
+            T* C12 {C + m};
+            T* C21 {C + m*ldc};
+            T* C22 {C + m*ldc + m};
+
+            T* X {work};
+            T* Y {work + m*m};
+            T* next {work + 2*m*m};
+
+            auto multiply = [&](const T* P, size_t ldp, const T* Q, size_t ldq, T* R){
+                product(m, P, ldp, Q, ldq, R, ldc, next, crossover);
+            };
+
+            subtract(m, A11, lda, A21, lda, X, m);         // S3 = A11 - A21
+            subtract(m, B22, ldb, B12, ldb, Y, m);         // T3 = B22 - B12
+            multiply(X, m, Y, m, C21);                      // P7 = S3 * T3
+            add(m, A21, lda, A22, lda, X, m);              // S1 = A21 + A22
+            subtract(m, B12, ldb, B11, ldb, Y, m);         // T1 = B12 - B11
+            multiply(X, m, Y, m, C22);                      // P5 = S1 * T1
+            subtract(m, X, m, A11, lda, X, m);             // S2 = S1 - A11
+            subtract(m, B22, ldb, Y, m, Y, m);             // T2 = B22 - T1
+            multiply(X, m, Y, m, C12);                      // P6 = S2 * T2
+            subtract(m, A12, lda, X, m, X, m);             // S4 = A12 - S2
+            multiply(X, m, B22, ldb, C11);                  // P3 = S4 * B22
+            product(m, A11, lda, B11, ldb, X, m, next, crossover);   // P1 = A11 * B11
+            add(m, X, m, C12, ldc, C12, ldc);              // U2 = P1 + P6
+            add(m, C12, ldc, C21, ldc, C21, ldc);          // U3 = U2 + P7
+            add(m, C12, ldc, C22, ldc, C12, ldc);          // U4 = U2 + P5
+            add(m, C21, ldc, C22, ldc, C22, ldc);          // C22 = U3 + P5
+            add(m, C12, ldc, C11, ldc, C12, ldc);          // C12 = U4 + P3
+            subtract(m, Y, m, B21, ldb, Y, m);             // T4 = T2 - B21
+            multiply(A22, lda, Y, m, C11);                  // P4 = A22 * T4
+            subtract(m, C21, ldc, C11, ldc, C21, ldc);     // C21 = U3 - P4
+            multiply(A12, lda, B21, ldb, C11);              // P2 = A12 * B21
+            add(m, X, m, C11, ldc, C11, ldc);              // C11 = P1 + P2
+        }
+
+        // Buffer of the calling thread, holding at least size elements (from
+        // the heap, whatever the current resource, since it outlives scopes)
+        template<typename T>
+        T* workspace(size_t size){
+            thread_local AlignedBuffer<T> buffer {memory::heap()};
+            if (buffer.size() < size){
+                buffer.reset(size);
+            }
+            return buffer.data();
+        }
+
+    }
+
+    /*************************** Settings ****************************/
+
+    inline Policy policy() noexcept {
+        return detail::policy.load(std::memory_order_relaxed);
+    }
+
+    inline void setPolicy(Policy policy) noexcept {
+        detail::policy.store(policy, std::memory_order_relaxed);
+    }
+
+    // Size from which Policy::Auto multiplies with Strassen-Winograd
+    inline size_t threshold() noexcept {
+        return detail::threshold.load(std::memory_order_relaxed);
+    }
+
+    inline void setThreshold(size_t n) noexcept {
+        detail::threshold.store(n, std::memory_order_relaxed);
+    }
+
+    // Size up to which the recursion multiplies with the blocked kernel
+    inline size_t crossover() noexcept {
+        return detail::crossover.load(std::memory_order_relaxed);
+    }
+
+    inline void setCrossover(size_t n) noexcept {
+        detail::crossover.store(std::max(n, size_t{16}), std::memory_order_relaxed);
+    }
+
+    // Whether gemm() multiplies M x K by K x N matrices with Strassen-Winograd
+    inline bool use(size_t M, size_t N, size_t K) noexcept {
+
+        if (M != N or N != K){
+            return false;
+        }
+
+        switch (policy()){
+            case Policy::Always: return N > crossover();
+            case Policy::Auto: return N >= threshold() and N > crossover();
+            case Policy::Never: return false;
+        }
+
+        return false;
+    }
+
+    // Elements of temporaries the recursion needs for size n
+    inline size_t workspaceSize(size_t n, size_t crossover) noexcept {
+
+        size_t size {};
+
+        while (n > crossover){
+            n /= 2;             // an odd size recurses on n - 1, of the same half
+            size += 2 * n * n;
+        }
+
+        return size;
+    }
+
+
+    /**************************** Product ******************************/
+
+    // C[n][n] = alpha * A[n][n] * B[n][n] + beta * C[n][n], row-major
+    // operands with leading dimensions lda, ldb and ldc (C is not read when
+    // beta is zero, and must not overlap A or B)
+    template<typename T>
+    void multiply(
+        size_t n, T alpha, const T* A, size_t lda, const T* B, size_t ldb,
+        T beta, T* C, size_t ldc
+    ){
+        const size_t leaf {crossover()};
+        const size_t size {workspaceSize(n, leaf)};
+
+        if (alpha == T{1} and beta == T{}){
+            detail::product(n, A, lda, B, ldb, C, ldc, detail::workspace<T>(size), leaf);
+            return;
+        }
+
+        // Otherwise the product goes through a temporary, ahead of the rest
+        T* product {detail::workspace<T>(n * n + size)};
+
+        detail::product(n, A, lda, B, ldb, product, n, product + n * n, leaf);
+
+        for (size_t i{}; i<n; ++i){
+            for (size_t j{}; j<n; ++j){
+                T& element {C[i*ldc + j]};
+                element = beta == T{}
+                    ? static_cast<T>(alpha * product[i*n + j])
+                    : static_cast<T>(alpha * product[i*n + j] + beta * element);
+            }
+        }
+    }
+
+}
+
+#endif
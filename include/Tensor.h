@@ -1,57 +1,592 @@
 #ifndef _TENSOR_H_
 #define _TENSOR_H_
 
+#include <array>
 #include <iostream>
+#include <stdexcept>
 #include <type_traits>
+#include <utility>
+#include "Trace.h"
+#include "Bounds.h"
+#include "Expression.h"
+#include "Compare.h"
 #include "Vector.h"
+#include "ThreadPool.h"
+#include "Blas.h"
+#include "View.h"
 
-template<typename T, size_t R, size_t C>
-class Tensor{
+/*
+    Tensor<T, Dims...> holds the product of its extents Dims elements in one
+    contiguous array, in row-major order (the last index varies fastest):
+
+        Tensor<double, 2, 3, 4> t;     // t[i, j, k] == t.data()[i*12 + j*4 + k]
+        Tensor<double, 2, 2> m {{1, 2}, {3, 4}};
+        Tensor<double, 4> v {{1, 2, 3, 4}};
+
+    TensorView<T, Dims...> refers to the elements of a tensor through
+    arbitrary strides, so that
+
+        t.reshape<6, 4>();             // same elements, other extents
+        t.permute<2, 0, 1>();          // axes reordered, nothing moved
+
+    are made without copying anything. Both take part in the expression
+    templates. Operands whose shapes differ are broadcast as in NumPy:
+    aligned on their last axis, an extent of 1 (or a missing leading axis)
+    is repeated to match the other operand,
+
+        Tensor<double, 3, 4> a;  Tensor<double, 4> b;  Tensor<double, 3, 1> c;
+        a = a + b;                     // b added to every row of a
+        a += c;                        // c[i, 0] added to every element of row i
+
+    and contract<AxisA, AxisB>(a, b) sums the products of the elements of a
+    and b along one axis of each, as a series of gemm() calls on views of
+    a and b (tensordot in NumPy).
+
+    An expression whose operands are all tensors of the result's shape is
+    evaluated in a single flat loop over the elements; broadcasting and
+    views are evaluated along the rows of the last axis. A view that reads
+    the destination's elements in another order, as in t = t.permute<1, 0>(),
+    is evaluated into a temporary first (see expr::aliases).
+*/
+
+template<typename T, size_t... Dims> class Tensor;
+template<typename T, size_t... Dims> class TensorView;
+
+namespace expr{
+
+    namespace detail{
+
+        // Distances between consecutive indices along each axis, for
+        // elements stored in row-major order
+        template<size_t N>
+        constexpr std::array<size_t, N> rowMajorStrides(std::array<size_t, N> extent){
+
+            std::array<size_t, N> stride {};
+            size_t step {1};
+
+            for (size_t axis{N}; axis-- > 0;){
+                stride[axis] = step;
+                step *= extent[axis];
+            }
+
+            return stride;
+        }
+
+        // Product of the extents of the axes [begin, end)
+        template<size_t N>
+        constexpr size_t extentProduct(std::array<size_t, N> extent, size_t begin, size_t end){
+
+            size_t product {1};
+
+            for (size_t axis{begin}; axis<end; ++axis){
+                product *= extent[axis];
+            }
+
+            return product;
+        }
+
+        // Extents without the given axis, and two lists of extents joined
+        template<size_t Axis, size_t N>
+        constexpr std::array<size_t, N - 1> removeAxis(std::array<size_t, N> extent){
+
+            std::array<size_t, N - 1> result {};
+
+            for (size_t axis{}, i{}; axis<N; ++axis){
+                if (axis != Axis){
+                    result[i++] = extent[axis];
+                }
+            }
+
+            return result;
+        }
+
+        template<size_t M, size_t N>
+        constexpr std::array<size_t, M + N> join(std::array<size_t, M> a, std::array<size_t, N> b){
+
+            std::array<size_t, M + N> result {};
+
+            for (size_t i{}; i<M; ++i){ result[i] = a[i]; }
+            for (size_t i{}; i<N; ++i){ result[M + i] = b[i]; }
+
+            return result;
+        }
+
+        // Tensor<T, extent[0], extent[1], ...>
+        template<typename T, auto extent, typename = std::make_index_sequence<extent.size()>>
+        struct TensorOf;
+
+        template<typename T, auto extent, size_t... I>
+        struct TensorOf<T, extent, std::index_sequence<I...>>{
+            using type = Tensor<T, extent[I]...>;
+        };
+
+        // Calls function(i0, i1, ..., iN-1) for every index of the rows
+        // [begin, end) of the given extents, a row being a run along the
+        // last axis, in row-major order
+        template<size_t N, typename Function>
+        constexpr void forEachIndex(
+            std::array<size_t, N> extent, size_t begin, size_t end, const Function& function
+        ){
+            std::array<size_t, N> index {};
+
+            for (size_t row{begin}; row<end; ++row){
+
+                size_t rest {row};
+
+                for (size_t axis{N - 1}; axis-- > 0;){
+                    index[axis] = rest % extent[axis];
+                    rest /= extent[axis];
+                }
+
+                for (size_t j{}; j<extent[N - 1]; ++j){
+                    index[N - 1] = j;
+                    [&]<size_t... I>(std::index_sequence<I...>){
+                        function(index[I]...);
+                    }(std::make_index_sequence<N>{});
+                }
+            }
+        }
+
+        // Element of an expression at an index of Result, which it is
+        // broadcast to when it evaluates to a tensor of another shape
+        template<typename Result, typename E, typename... Index>
+        constexpr auto evalAs(const E& expression, Index... index){
+            if constexpr (std::same_as<typename E::result_type, Result>){
+                return expression.eval(index...);
+            } else {
+                return broadcastEval(expression, index...);
+            }
+        }
+
+    }
+
+    // Tensors whose shapes broadcast evaluate to a tensor of the broadcast
+    // extents
+    template<typename T, size_t... A, size_t... B>
+        requires (
+            not std::same_as<Tensor<T, A...>, Tensor<T, B...>>
+            and detail::broadcastable(
+                std::array<size_t, sizeof...(A)>{A...}, std::array<size_t, sizeof...(B)>{B...}
+            )
+        )
+    struct Common<Tensor<T, A...>, Tensor<T, B...>>{
+        using type = typename detail::TensorOf<
+            T,
+            detail::broadcast(
+                std::array<size_t, sizeof...(A)>{A...}, std::array<size_t, sizeof...(B)>{B...}
+            )
+        >::type;
+    };
+
+    // Expressions that can be evaluated into (or added to) Destination,
+    // broadcasting them when their shape differs
+    template<typename Destination, typename E>
+    concept BroadcastsTo = (
+        Expression<E>
+        && requires {
+            requires std::same_as<
+                typename Common<Destination, typename E::result_type>::type,
+                Destination
+            >;
+        }
+    );
+
+}
+
+
+template<typename T, size_t... Dims>
+class TensorView{
 
     static_assert(
-        std::is_arithmetic<T>::value,
+        numeric::Element<std::remove_const_t<T>>,
+        "TensorView class can only refer to integral or floating point values"
+    );
+
+    template<typename Destination> friend class expr::NoAlias;
+
+    public:
+
+        static constexpr size_t rank = sizeof...(Dims);
+
+    private:
+
+        static constexpr std::array<size_t, rank> extent {Dims...};
+        static constexpr size_t count = (Dims * ...);
+
+        T* pointer;
+        std::array<size_t, rank> step;
+
+        template<typename... Index>
+        constexpr size_t offset(Index... index) const {
+            const std::array<size_t, rank> position {static_cast<size_t>(index)...};
+            size_t result {};
+            for (size_t axis{}; axis<rank; ++axis){
+                result += position[axis] * step[axis];
+            }
+            return result;
+        }
+
+        template<typename... Index>
+        static constexpr void checkIndex(Index... index){
+            const std::array<size_t, rank> position {static_cast<size_t>(index)...};
+            for (size_t axis{}; axis<rank; ++axis){
+                bounds::check(position[axis], extent[axis]);
+            }
+        }
+
+        // Evaluates an expression element by element into the viewed
+        // elements: flat when both are laid out like a tensor, along the
+        // rows of the last axis otherwise (a product is written as a whole
+        // by gemm() / gemv())
+        template<typename Op, typename E>
+        void evaluate(const E& expression){
+
+            using Result = Tensor<value_type, Dims...>;
+
+            if constexpr (expr::Evaluable<E>){
+
+                expression.template evaluateInto<Op>(*this);
+
+            } else if (expr::aliases(expression, *this)){
+
+                evaluate<Op>(typename E::result_type{expression});
+
+            } else {
+
+                if constexpr (expr::Linear<E> and std::same_as<typename E::result_type, Result>){
+                    if (contiguous()){
+                        parallel::forBlocks(count, 1, 1, [&](size_t begin, size_t end){
+                            for (size_t i{begin}; i<end; ++i){
+                                Op::apply(pointer[i], expression.evalLinear(i));
+                            }
+                        });
+                        return;
+                    }
+                }
+
+                parallel::forBlocks(count / extent[rank - 1], extent[rank - 1], 1, [&](size_t begin, size_t end){
+                    expr::detail::forEachIndex(extent, begin, end, [&](auto... index){
+                        Op::apply(pointer[offset(index...)], expr::detail::evalAs<Result>(expression, index...));
+                    });
+                });
+            }
+        }
+
+        // Evaluates an expression that is not element-wise into a
+        // temporary first, in case it reads the viewed elements
+        template<typename Op, typename E>
+        void evaluateAliased(const E& expression){
+            const Tensor<value_type, Dims...> temporary {expression};
+            evaluate<Op>(temporary);
+        }
+
+    public:
+
+    /******** Constructors - Assignment Operators - Destructor ***************/
+
+    // Pointer Constructor: elements stored in row-major order unless
+    // strides are given
+    constexpr explicit TensorView(T* pointer) noexcept
+    : pointer{pointer}, step{expr::detail::rowMajorStrides(extent)} {}
+
+    constexpr TensorView(T* pointer, const std::array<size_t, rank>& strides) noexcept
+    : pointer{pointer}, step{strides} {}
+
+    // Converting Constructor from a view of mutable elements
+    template<typename U> requires (std::same_as<const U, T> and not std::same_as<U, T>)
+    constexpr TensorView(const TensorView<U, Dims...>& view) noexcept
+    : pointer{view.data()}, step{view.strides()} {}
+
+    // Copy Constructor (refers to the same elements)
+    constexpr TensorView(const TensorView& source) = default;
+
+    // Copy Assignment Operator (copies the elements of rhs into the viewed
+    // elements)
+    TensorView& operator=(const TensorView& rhs)
+        requires (not std::is_const_v<T>)
+    {
+        evaluate<expr::Assign>(rhs);
+        return *this;
+    }
+
+    // Expression Assignment Operator
+    template<expr::Expression E>
+        requires (
+            not std::is_const_v<T>
+            and expr::BroadcastsTo<Tensor<std::remove_const_t<T>, Dims...>, E>
+        )
+    TensorView& operator=(const E& expression){
+        if constexpr (E::elementwise){
+            evaluate<expr::Assign>(expression);
+        } else {
+            evaluateAliased<expr::Assign>(expression);
+        }
+        return *this;
+    }
+
+    // Default destructor
+    ~TensorView() = default;
+
+
+    /********************** Expression Interface **************************/
+
+    using value_type = std::remove_const_t<T>;
+    using result_type = Tensor<value_type, Dims...>;
+    static constexpr bool elementwise = true;
+
+    // Extents, as reported by every expression
+    static constexpr std::array<size_t, rank> shape(){
+        return extent;
+    }
+
+    // Distances between consecutive indices along each axis
+    constexpr std::array<size_t, rank> strides() const {
+        return step;
+    }
+
+    // Unchecked element access used by expression evaluation
+    template<typename... Index> requires (sizeof...(Index) == rank)
+    constexpr const T& eval(Index... index) const {
+        return pointer[offset(index...)];
+    }
+
+    // Assignment target that skips the aliasing safeguard of operator=
+    expr::NoAlias<TensorView> noalias() requires (not std::is_const_v<T>) {
+        return expr::NoAlias<TensorView>{*this};
+    }
+
+    constexpr T* data() const noexcept {
+        return pointer;
+    }
+
+    // Whether the viewed elements are stored like those of a Tensor
+    constexpr bool contiguous() const noexcept {
+        return step == expr::detail::rowMajorStrides(extent);
+    }
+
+
+    /****************** Methods - Overloaded Operators ********************/
+
+    // Subscript or Array Index Operator, checked only when bounds are (see
+    // Bounds.h)
+    template<typename... Index>
+        requires (sizeof...(Index) == rank and (std::convertible_to<Index, size_t> and ...))
+    constexpr T& operator[](Index... index) const {
+        if constexpr (bounds::checked){
+            checkIndex(index...);
+        }
+        return pointer[offset(index...)];
+    }
+
+    // Checked element access
+    template<typename... Index>
+        requires (sizeof...(Index) == rank and (std::convertible_to<Index, size_t> and ...))
+    constexpr T& at(Index... index) const {
+        checkIndex(index...);
+        return pointer[offset(index...)];
+    }
+
+    // View of the same elements with other extents (the viewed elements
+    // must be contiguous)
+    template<size_t... NewDims>
+    constexpr TensorView<T, NewDims...> reshape() const {
+
+        static_assert(
+            (NewDims * ...) == count, "Reshaped Tensor must have the same number of elements"
+        );
+
+        if (not contiguous()){
+            throw std::invalid_argument("Only a contiguous Tensor view can be reshaped");
+        }
+
+        return TensorView<T, NewDims...>{pointer};
+    }
+
+    // View with its axes reordered: axis i of the result is axis Axes[i]
+    template<size_t... Axes>
+    constexpr TensorView<T, extent[Axes]...> permute() const {
+
+        static_assert(
+            sizeof...(Axes) == rank and ((Axes < rank) and ...),
+            "permute() takes each axis of the Tensor once"
+        );
+
+        static_assert(
+            [](std::array<size_t, rank> axes){
+                for (size_t i{}; i<rank; ++i){
+                    for (size_t j{i + 1}; j<rank; ++j){
+                        if (axes[i] == axes[j]) return false;
+                    }
+                }
+                return true;
+            }({Axes...}),
+            "permute() takes each axis of the Tensor once"
+        );
+
+        return TensorView<T, extent[Axes]...>{pointer, {step[Axes]...}};
+    }
+
+    // View of the transpose, for rank 2
+    constexpr auto transpose() const requires (rank == 2) {
+        return permute<1, 0>();
+    }
+
+    // Equal-to Operator (==)
+    template<typename E>
+        requires (
+            expr::Expression<E>
+            and std::same_as<typename E::result_type, result_type>
+        )
+    bool operator==(const E& rhs) const {
+
+        bool equal {true};
+
+        expr::detail::forEachIndex(extent, 0, count / extent[rank - 1], [&](auto... index){
+            if ( not compare::equal(eval(index...), rhs.eval(index...)) ){
+                equal = false;
+            }
+        });
+
+        return equal;
+    }
+
+    // Compound Assignment Operator (+=)
+    template<expr::Expression E>
+        requires (not std::is_const_v<T> and expr::BroadcastsTo<result_type, E>)
+    void operator+=(const E& rhs) {
+        if constexpr (E::elementwise){
+            evaluate<expr::AddAssign>(rhs);
+        } else {
+            evaluateAliased<expr::AddAssign>(rhs);
+        }
+    }
+
+    // Compound Assignment Operator (-=)
+    template<expr::Expression E>
+        requires (not std::is_const_v<T> and expr::BroadcastsTo<result_type, E>)
+    void operator-=(const E& rhs) {
+        if constexpr (E::elementwise){
+            evaluate<expr::SubtractAssign>(rhs);
+        } else {
+            evaluateAliased<expr::SubtractAssign>(rhs);
+        }
+    }
+
+};
+
+
+template<typename T, size_t... Dims>
+class Tensor : private trace::Traced<trace::Type::Tensor>{
+
+    static_assert(
+        numeric::Element<T>,
         "Tensor class can only store integral or floating point values"
     );
 
     static_assert(
-        R >= 2, "Number of Tensor Rows R should be higher or equal to 2"
+        sizeof...(Dims) >= 1, "Tensor should have at least one axis"
     );
 
     static_assert(
-        C >= 2, "Number of Matrix Columns C should be higher or equal to 2"
+        ((Dims >= 1) and ...), "Every extent of a Tensor should be higher or equal to 1"
     );
 
+    // Prints the rows of the last axis on separate lines, and a blank line
+    // between consecutive matrices of a tensor of rank 3 or more
     friend std::ostream& operator<<(
-        std::ostream& os, const Tensor& tensor    //const Vecotr<T, N>& vector
+        std::ostream& os, const Tensor& tensor
     ){
-        for (size_t i{}; i < R; ++i){
-            for (size_t j{}; j < C; ++j){
-                os << tensor.rowVec[i][j] << " ";
+        constexpr size_t columns {extent[rank - 1]};
+        constexpr size_t rows {count / columns};
+        constexpr size_t matrixRows {extent[rank >= 2 ? rank - 2 : 0]};
+
+        for (size_t i{}; i < rows; ++i){
+            for (size_t j{}; j < columns; ++j){
+                os << tensor.element[i*columns + j] << " ";
+            }
+            if (i != rows - 1){
+                os << std::endl;
+                if (rank > 2 and (i + 1) % matrixRows == 0) {os << std::endl;}
             }
-            if (i != R-1) {os << std::endl;}
         }
         return os;
     }
 
-    friend Tensor operator*(const T&& scalar, const Tensor& tensor){
-        return tensor * scalar;
-    }
+    template<typename Destination> friend class expr::NoAlias;
 
-    friend Tensor operator*(const T& scalar, const Tensor& tensor){
-        return tensor * scalar;
-    }
+    public:
+
+        static constexpr size_t rank = sizeof...(Dims);
 
     private:
 
-        
-        Vector<T, C> rowVec[R]; // array to store matrix elements
+        static constexpr std::array<size_t, rank> extent {Dims...};
+        static constexpr size_t count = (Dims * ...);
+
+        T element[count]; // elements, in row-major order
+
+        template<typename... Index>
+        static constexpr size_t offset(Index... index){
+            const std::array<size_t, rank> position {static_cast<size_t>(index)...};
+            size_t result {};
+            for (size_t axis{}; axis<rank; ++axis){
+                result = result * extent[axis] + position[axis];
+            }
+            return result;
+        }
+
+        // Evaluates an expression element by element into this tensor, in a
+        // single pass and without temporaries: one flat loop over the
+        // elements when every operand is a tensor of this shape, along the
+        // rows of the last axis otherwise (split into blocks across the
+        // thread pool for large tensors)
+        template<typename Op, typename E>
+        constexpr void evaluate(const E& expression){
+
+            if constexpr (expr::Evaluable<E>){
+
+                expression.template evaluateInto<Op>(*this);
 
-        Vector<T, C> createVector(const T (&row)[C]){
-            Vector<T, C> vector{};
-            for (size_t i{}; i<C; ++i){
-                vector[i] = row[i];
+            } else if (expr::aliases(expression, *this)){
+
+                evaluate<Op>(typename E::result_type{expression});
+
+            } else if constexpr (expr::Linear<E> and std::same_as<typename E::result_type, Tensor>){
+
+                auto range = [&](size_t begin, size_t end){
+                    for (size_t i{begin}; i<end; ++i){
+                        Op::apply(element[i], expression.evalLinear(i));
+                    }
+                };
+
+                if constexpr (count >= parallel::minimumWork){
+                    if !consteval {
+                        parallel::forBlocks(count, 1, 1, range);
+                        return;
+                    }
+                }
+
+                range(0, count);
+
+            } else {
+
+                constexpr size_t columns {extent[rank - 1]};
+
+                auto rows = [&](size_t begin, size_t end){
+                    expr::detail::forEachIndex(extent, begin, end, [&](auto... index){
+                        Op::apply(element[offset(index...)], expr::detail::evalAs<Tensor>(expression, index...));
+                    });
+                };
+
+                if constexpr (count >= parallel::minimumWork){
+                    if !consteval {
+                        parallel::forBlocks(count / columns, columns, 1, rows);
+                        return;
+                    }
+                }
+
+                rows(0, count / columns);
             }
-            return vector;
         }
 
     public:
@@ -59,244 +594,377 @@ class Tensor{
     /******** Constructors - Assignment Operators - Destructor ***************/
 
     // Default Constructor
-    Tensor(): rowVec{} {
-        std::cout << "Tensor's default constructor called" << std::endl;
+    constexpr Tensor() noexcept : element{} {}
+
+    // Elements Constructor, in row-major order
+    constexpr Tensor(const T (&values)[(Dims * ... * 1)]) noexcept : element{} {
+        for (size_t i{}; i<count; ++i){
+            element[i] = values[i];
+        }
     }
 
-    
-    template<size_t ... Cs>
-    Tensor(const T (&...arr)[Cs]): rowVec{createVector(arr)...} {
+    // Variadic Template Constructor, row by row for rank 2
+    template<size_t ... Cs> requires (sizeof...(Dims) == 2)
+    constexpr Tensor(const T (&...arr)[Cs]) noexcept : element{} {
 
         static_assert(
-            sizeof...(Cs) == R,
+            sizeof...(Cs) == extent[0],
             "Number of Rows must be equal to Tensor's Rows R"
         );
-        
+
         // Assert each row size matches C
-        static_assert(((Cs == C) && ...),
+        static_assert(((Cs == extent[1]) && ...),
             "Each Row provided must have exactly C elements");
 
-        std::cout << "Tensor's variadic constructor called" << std::endl;
-
+        size_t i {};
+        ((copyRow(arr, i++)), ...);
     }
 
-    // Copy Constructor
-    Tensor(const Tensor& source){
+    // Copy and Move Constructors, Copy and Move Assignment Operators
+    // Defaulted, so that Tensor is trivially copyable and its moves are
+    // noexcept
+    constexpr Tensor(const Tensor& source) = default;
+    constexpr Tensor(Tensor&& source) = default;
+    constexpr Tensor& operator=(const Tensor& rhs) = default;
+    constexpr Tensor& operator=(Tensor&& rhs) = default;
+
+    // Expression Constructor (evaluates a whole expression in one pass)
+    template<expr::EvaluatesTo<Tensor> E>
+    constexpr Tensor(const E& expression): element{} {
+        evaluate<expr::Assign>(expression);
+    }
 
-        std::cout << "Tensor's copy constructor called" << std::endl;
+    // Expression Assignment Operator (an expression of another shape is
+    // broadcast to this one)
+    template<expr::Expression E>
+        requires (not std::same_as<E, Tensor> and expr::BroadcastsTo<Tensor, E>)
+    constexpr Tensor& operator=(const E& expression){
+        if constexpr (E::elementwise){
+            evaluate<expr::Assign>(expression);
+        } else {
+            *this = Tensor{expression};
+        }
+        return *this;
+    }
 
-        for (size_t i{}; i<R; ++i){
+    // Default destructor
+    ~Tensor() = default;
 
-            rowVec[i] = source.rowVec[i];
 
-        }
-    }
-    
-    // Move Constructor
-    Tensor(const Tensor&& source){
+    /********************** Expression Interface **************************/
 
-        std::cout << "Tensor's move constructor called" << std::endl;
+    using result_type = Tensor;
+    using value_type = T;
+    static constexpr bool elementwise = true;
 
-        for (size_t i{}; i<R; ++i){
+    // Extents, as reported by every expression
+    static constexpr std::array<size_t, rank> shape(){
+        return extent;
+    }
 
-            rowVec[i] = source.rowVec[i];
+    // Distances between consecutive indices along each axis
+    static constexpr std::array<size_t, rank> strides(){
+        return expr::detail::rowMajorStrides(extent);
+    }
 
-        }
+    // Unchecked element access used by expression evaluation
+    template<typename... Index> requires (sizeof...(Index) == rank)
+    constexpr const T& eval(Index... index) const {
+        return element[offset(index...)];
+    }
 
+    // Unchecked element access by position in row-major order
+    constexpr const T& evalLinear(size_t index) const {
+        return element[index];
     }
 
-    // Copy Assignment Operator
-    Tensor& operator=(const Tensor& rhs){
+    // Assignment target that skips the aliasing safeguard of operator=
+    constexpr expr::NoAlias<Tensor> noalias(){
+        return expr::NoAlias<Tensor>{*this};
+    }
 
-        std::cout << "Tensor's copy assignment operator called" << std::endl;
+    // Pointer to the elements, stored contiguously in row-major order
+    constexpr T* data(){
+        return element;
+    }
 
-        if (this == &rhs){
-            return *this;
-        }
+    constexpr const T* data() const {
+        return element;
+    }
 
-        for (size_t i{}; i<R; ++i){
+    // View of the whole tensor. The views below are not available on a
+    // temporary, which they would outlive
+    constexpr TensorView<T, Dims...> view() & {
+        return TensorView<T, Dims...>{element};
+    }
 
-            rowVec[i] = rhs.rowVec[i];
+    constexpr TensorView<const T, Dims...> view() const& {
+        return TensorView<const T, Dims...>{element};
+    }
 
-        }
+    TensorView<const T, Dims...> view() const&& = delete;
 
-        return *this;
+    // View of the same elements with other extents
+    template<size_t... NewDims>
+    constexpr TensorView<T, NewDims...> reshape() & {
+        return view().template reshape<NewDims...>();
     }
 
-    // Move Assignment Operator
-    Tensor& operator=(const Tensor&& rhs){
+    template<size_t... NewDims>
+    constexpr TensorView<const T, NewDims...> reshape() const& {
+        return view().template reshape<NewDims...>();
+    }
 
-        std::cout << "Tensor's move assignment operator called" << std::endl;
+    template<size_t... NewDims>
+    TensorView<const T, NewDims...> reshape() const&& = delete;
 
-        if (this == &rhs){
-            return *this;
-        }
+    // View with its axes reordered: axis i of the view is axis Axes[i]
+    template<size_t... Axes>
+    constexpr auto permute() & {
+        return view().template permute<Axes...>();
+    }
 
-        for (size_t i{}; i<R; ++i){
+    template<size_t... Axes>
+    constexpr auto permute() const& {
+        return view().template permute<Axes...>();
+    }
 
-            rowVec[i] = rhs.rowVec[i];
+    template<size_t... Axes>
+    auto permute() const&& = delete;
 
-        }
+    // Views of the i-th row, of the j-th column and of the rows x columns
+    // block whose top-left element is (i, j), for rank 2
+    MatrixView<T> block(size_t i, size_t j, size_t rows, size_t columns) & requires (rank == 2) {
+        return matrix().block(i, j, rows, columns);
+    }
 
-        return *this;
+    MatrixView<const T> block(size_t i, size_t j, size_t rows, size_t columns) const& requires (rank == 2) {
+        return matrix().block(i, j, rows, columns);
     }
 
-    // Default destructor
-    ~Tensor() = default;
+    MatrixView<const T> block(size_t i, size_t j, size_t rows, size_t columns) const&& requires (rank == 2) = delete;
 
+    VectorView<T> row(size_t index) & requires (rank == 2) {
+        return matrix().row(index);
+    }
 
-    /****************** Methods - Overloaded Operators ********************/
+    VectorView<const T> row(size_t index) const& requires (rank == 2) {
+        return matrix().row(index);
+    }
 
-    // Subscript or Array Index Operator (Const overload for read-only access)
-    
-    const Vector<T, C>& operator[](size_t index) const{
-        /*
-            Matrix m;
-            m[i]; returns reference of i-th row
-            m[i][j]; returns the element of i-th row and j-th column    */
+    VectorView<const T> row(size_t index) const&& requires (rank == 2) = delete;
 
-        if (index >= R) throw std::out_of_range("Index out of bounds");
+    VectorView<T> column(size_t index) & requires (rank == 2) {
+        return matrix().column(index);
+    }
 
-        return rowVec[index];
+    VectorView<const T> column(size_t index) const& requires (rank == 2) {
+        return matrix().column(index);
     }
 
-    
+    VectorView<const T> column(size_t index) const&& requires (rank == 2) = delete;
 
-    // Subscript or Array Index Operator (Non-const overload for read/write access)
-    Vector<T, C>& operator[](size_t index) {
-        /*
-            Matrix m;
-            m[i]; returns reference of i-th row
-            m[i][j]; returns the element of i-th row and j-th column    */
 
-        if (index >= R) throw std::out_of_range("Index out of bounds");
+    /****************** Methods - Overloaded Operators ********************/
+
+    // Subscript or Array Index Operator, for rank 2 (returns a view of the
+    // i-th row, so that t[i][j] is the element of i-th row and j-th column)
+    constexpr VectorView<const T> operator[](size_t index) const requires (rank == 2) {
+        bounds::debugCheck(index, extent[0]);
+        return VectorView<const T>{element + index*extent[rank - 1], extent[rank - 1]};
+    }
 
-        return rowVec[index];
+    constexpr VectorView<T> operator[](size_t index) requires (rank == 2) {
+        bounds::debugCheck(index, extent[0]);
+        return VectorView<T>{element + index*extent[rank - 1], extent[rank - 1]};
     }
 
-    
     // Subscript or Array Index Operator (Const overload for read-only access)
-    const T&  operator[](size_t rowIndex, size_t columnIndex) const {
+    template<typename... Index>
+        requires (sizeof...(Index) == rank and (std::convertible_to<Index, size_t> and ...))
+    constexpr const T& operator[](Index... index) const {
         /*
-            Matrix m;
-            m[i, j]; returns the element of i-th row and j-th column    */
+            Tensor t;
+            t[i, j, k]; returns the element at index (i, j, k)
+            (checked only when bounds are, see Bounds.h, and by t.at(i, j, k)) */
 
-        if (rowIndex >= R or columnIndex >= C) throw std::out_of_range("Index out of bounds");
+        if constexpr (bounds::checked){
+            checkIndex(index...);
+        }
 
-        return (rowVec[rowIndex])[columnIndex];
+        return element[offset(index...)];
     }
 
     // Subscript or Array Index Operator (Non-const overload for read/write access)
-    T&  operator[](size_t rowIndex, size_t columnIndex) {
-        /*
-            Matrix m;
-            m[i, j]; returns the element of i-th row and j-th column    */
-        
-        if (rowIndex >= R or columnIndex >= C) throw std::out_of_range("Index out of bounds");
-        
-        return (rowVec[rowIndex])[columnIndex];  
+    template<typename... Index>
+        requires (sizeof...(Index) == rank and (std::convertible_to<Index, size_t> and ...))
+    constexpr T& operator[](Index... index){
+        if constexpr (bounds::checked){
+            checkIndex(index...);
+        }
+        return element[offset(index...)];
     }
-   
 
-    // Equal-to Operator (==)
-    bool operator==(const Tensor& rhs) const {
+    // Checked element access
+    template<typename... Index>
+        requires (sizeof...(Index) == rank and (std::convertible_to<Index, size_t> and ...))
+    constexpr const T& at(Index... index) const {
+        checkIndex(index...);
+        return element[offset(index...)];
+    }
 
-        for (size_t i{}; i<R; ++i){
+    template<typename... Index>
+        requires (sizeof...(Index) == rank and (std::convertible_to<Index, size_t> and ...))
+    constexpr T& at(Index... index){
+        checkIndex(index...);
+        return element[offset(index...)];
+    }
 
-            if( not (rowVec[i] == rhs.rowVec[i]) ){
-                return false; 
-            }
-            
-        }
+    // Equal-to Operator (==)
+    constexpr bool operator==(const Tensor& rhs) const {
 
-        return true;
+        return compare::equal(element, rhs.element, count);
     }
 
     // Not-Equal-to Operator (!=)
-    bool operator!=(const Tensor& rhs) const {
+    constexpr bool operator!=(const Tensor& rhs) const {
         return !(*this == rhs);
     }
 
-    // Addition Arithmetic Operator (+)
-    Tensor operator+(const Tensor& rhs) const {
-        
-        Tensor temp{};
-
-        for (size_t i{}; i<R; ++i){
-
-            temp.rowVec[i] = rowVec[i] + rhs.rowVec[i];
-        
+    // Compound Assignment Operator (+=)
+    template<expr::Expression E> requires expr::BroadcastsTo<Tensor, E>
+    constexpr void operator+=(const E& rhs) {
+        if constexpr (E::elementwise){
+            evaluate<expr::AddAssign>(rhs);
+        } else {
+            evaluate<expr::AddAssign>(typename E::result_type{rhs});
         }
+    }
 
-        return temp;
+    // Compound Assignment Operator (-=)
+    template<expr::Expression E> requires expr::BroadcastsTo<Tensor, E>
+    constexpr void operator-=(const E& rhs) {
+        if constexpr (E::elementwise){
+            evaluate<expr::SubtractAssign>(rhs);
+        } else {
+            evaluate<expr::SubtractAssign>(typename E::result_type{rhs});
+        }
     }
 
-    // Subtraction Arithmetic Operator (+)
-    Tensor operator-(const Tensor& rhs) const {
-        
-        Tensor temp{};
 
-        for (size_t i{}; i<R; ++i){
+    // Tensor-Vector Multiplication Operator, for rank 2 (evaluated by gemv())
+    template<size_t N> requires (rank == 2 and N == extent[rank - 1])
+    constexpr expr::Product<Tensor, Vector<T, N>, Vector<T, extent[0]>>
+    operator*(const Vector<T, N>& rhsVector) const {
+        return {*this, rhsVector};
+    }
 
-            temp.rowVec[i] = rowVec[i] - rhs.rowVec[i];
-        
+    private:
+
+        constexpr void copyRow(const T (&row)[extent[rank - 1]], size_t index){
+            for (size_t j{}; j<extent[rank - 1]; ++j){
+                element[index*extent[rank - 1] + j] = row[j];
+            }
         }
 
-        return temp;
-    }
+        template<typename... Index>
+        static constexpr void checkIndex(Index... index){
 
-    // Compound Assignment Operator (+=)
-    void operator+=(const Tensor& rhs) {
+            const std::array<size_t, rank> position {static_cast<size_t>(index)...};
 
-        for (size_t i{}; i<R; ++i){
-
-            rowVec[i] += rhs.rowVec[i];
-        
+            for (size_t axis{}; axis<rank; ++axis){
+                bounds::check(position[axis], extent[axis]);
+            }
         }
-    }
 
-    // Compound Assignment Operator (-=)
-    void operator-=(const Tensor& rhs) {
-        
-        for (size_t i{}; i<R; ++i){
+        MatrixView<T> matrix() requires (rank == 2) {
+            return MatrixView<T>{element, extent[0], extent[rank - 1]};
+        }
 
-            rowVec[i] -= rhs.rowVec[i];
-        
+        MatrixView<const T> matrix() const requires (rank == 2) {
+            return MatrixView<const T>{element, extent[0], extent[rank - 1]};
         }
-    }
 
-    // scalar Multiplication Operator
-    Tensor operator*(const T& scalar) const {
-        Tensor scaledTensor {*this};
+};
 
-        for (size_t i{}; i<R; ++i){
 
-            scaledTensor.rowVec[i] *= scalar;
-        
-        }
+template<typename T, size_t ... Cs>
+Tensor(const T (&...arr)[Cs]) -> Tensor<T, sizeof...(arr), (Cs + ... + 0)/sizeof...(Cs)>;
 
-        return scaledTensor;
-    }
 
-    
-    Vector<T, R> operator*(const Vector<T, C>& rhsVector) const {
+/********************** Tensor Contraction *******************************/
 
-        Vector<T, R> lhsVector{};
+// Sums the products of the elements of a and b along axis AxisA of a and
+// axis AxisB of b: the result has the remaining axes of a followed by the
+// remaining axes of b. Computed as gemm() calls on matrix views of a and b,
+// one per pair of leading indices (a single one when the contracted axis is
+// the last axis of a and the first axis of b, the matrix product)
+template<size_t AxisA, size_t AxisB, typename T, size_t... A, size_t... B>
+auto contract(const Tensor<T, A...>& a, const Tensor<T, B...>& b){
 
-        for (size_t i{}; i<R; ++i){
-            
-            lhsVector[i] += rowVec[i].dot(rhsVector);
+    constexpr std::array<size_t, sizeof...(A)> extentA {A...};
+    constexpr std::array<size_t, sizeof...(B)> extentB {B...};
 
-        }
+    static_assert(
+        AxisA < sizeof...(A) and AxisB < sizeof...(B), "Contracted axis out of range"
+    );
+
+    static_assert(
+        extentA[AxisA] == extentB[AxisB], "Contracted axes must have the same extent"
+    );
 
-        return lhsVector;
+    static_assert(
+        sizeof...(A) + sizeof...(B) > 2, "The contraction of two vectors is their dot product"
+    );
 
+    using Result = typename expr::detail::TensorOf<
+        T,
+        expr::detail::join(
+            expr::detail::removeAxis<AxisA>(extentA), expr::detail::removeAxis<AxisB>(extentB)
+        )
+    >::type;
+
+    // a[p, k, q] and b[p2, k, q2], the indices p, q, p2 and q2 standing for
+    // the axes before and after the contracted ones
+    constexpr size_t K {extentA[AxisA]};
+    constexpr size_t P {expr::detail::extentProduct(extentA, 0, AxisA)};
+    constexpr size_t Q {expr::detail::extentProduct(extentA, AxisA + 1, sizeof...(A))};
+    constexpr size_t P2 {expr::detail::extentProduct(extentB, 0, AxisB)};
+    constexpr size_t Q2 {expr::detail::extentProduct(extentB, AxisB + 1, sizeof...(B))};
+
+    // a as P matrices of Q x K (a single P x K matrix when Q is 1), b as P2
+    // matrices of K x Q2 (a single K x P2 matrix when Q2 is 1)
+    constexpr size_t blocksA {Q == 1 ? 1 : P}, M {Q == 1 ? P : Q};
+    constexpr size_t rsa {Q == 1 ? K : 1}, csa {Q == 1 ? 1 : Q};
+    constexpr size_t blocksB {Q2 == 1 ? 1 : P2}, N {Q2 == 1 ? P2 : Q2};
+    constexpr size_t rsb {Q2 == 1 ? 1 : Q2}, csb {Q2 == 1 ? K : 1};
+
+    // result[p, q, p2, q2]
+    constexpr size_t rsc {P2 * Q2};
+
+    Result result {};
+
+    for (size_t p{}; p<blocksA; ++p){
+        for (size_t p2{}; p2<blocksB; ++p2){
+            gemm(
+                T{1},
+                MatrixView<const T>{a.data() + p*K*Q, M, K, rsa, csa},
+                MatrixView<const T>{b.data() + p2*K*Q2, K, N, rsb, csb},
+                T{},
+                MatrixView<T>{result.data() + p*Q*rsc + p2*Q2, M, N, rsc, 1}
+            );
+        }
     }
 
-};
+    return result;
+}
 
 
-template<typename T, size_t ... Cs>
-Tensor(const T (&...arr)[Cs]) -> Tensor<T, sizeof...(arr), (Cs + ... + 0)/sizeof...(Cs)>;
+#ifndef MYMATH_ENABLE_TRACE
+static_assert(std::is_trivially_copyable_v<Tensor<double, 3, 3>>);
+static_assert(sizeof(Tensor<double, 3, 3>) == 9 * sizeof(double));
+static_assert(sizeof(Tensor<float, 2, 3, 4>) == 24 * sizeof(float));
+#endif
+static_assert(std::is_nothrow_move_constructible_v<Tensor<double, 3, 3>>);
 
 #endif
@@ -0,0 +1,434 @@
+#ifndef _THREAD_POOL_H_
+#define _THREAD_POOL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Memory.h"
+
+/*
+    Work-stealing thread pool behind the parallel kernels.
+
+    Large products (kernel::gemm, matrix-vector products), element-wise
+    evaluation and dot products split their rows (or elements) into blocks
+    through parallel::forBlocks / parallel::sum, which run the blocks on the
+    pool. Every worker owns a queue: it pops its own blocks from the back
+    and, once idle, steals from the front of the others. The calling thread
+    takes part in the work as well, so a pool of n threads runs n - 1
+    workers.
+
+    Settings, all global:
+
+    - threadCount: MYMATH_THREADS from the environment, otherwise the
+      number of hardware threads. parallel::setThreadCount(n) replaces the
+      pool; it must not be called while parallel work is running. A count
+      of 1 runs everything on the calling thread.
+    - serialCutoff: work (roughly, multiply-adds) below which an operation
+      runs serially, so that small matrices never pay the dispatch
+      overhead. Operations smaller than minimumWork never even check it.
+    - deterministic: when set, reductions split their input on a fixed
+      grid, independent of the thread count, and combine the partial
+      results in index order, so that e.g. a dot product gives bitwise
+      identical results from run to run and for any number of threads.
+      Otherwise partial results are combined as they complete.
+
+    Parallel regions do not nest: an operation started from inside a
+    worker runs serially on that worker.
+*/
+
+namespace parallel{
+
+    // Operations below this much work are serial at compile time
+    inline constexpr size_t minimumWork = size_t{1} << 12;
+
+    namespace detail{
+
+        // One parallel loop: f(begin, end) over blocks of [0, n)
+        struct Job{
+            void (*invoke)(const void* function, size_t begin, size_t end);
+            const void* function;
+            std::atomic<size_t> remaining;
+            std::atomic<bool> failed;
+            std::exception_ptr error;
+        };
+
+        struct Task{
+            Job* job;
+            size_t begin;
+            size_t end;
+        };
+
+        inline thread_local bool insideWorker {false};
+
+        inline std::atomic<size_t> serialCutoff {size_t{1} << 17};
+        inline std::atomic<bool> deterministic {false};
+
+        // Block size of deterministic reductions
+        inline constexpr size_t reductionBlock = 4096;
+
+        inline size_t defaultThreadCount(){
+
+            if (const char* requested = std::getenv("MYMATH_THREADS")){
+                const long count {std::strtol(requested, nullptr, 10)};
+                if (count > 0){
+                    return static_cast<size_t>(count);
+                }
+            }
+
+            return std::max(std::thread::hardware_concurrency(), 1u);
+        }
+
+    }
+
+
+    class ThreadPool{
+
+        private:
+
+            // Tasks from first to the end of tasks, a vector from the heap
+            // resource that keeps its capacity once drained, so that the
+            // loops of a steady state allocate nothing
+            struct Queue{
+                std::mutex mutex{};
+                std::pmr::vector<detail::Task> tasks{memory::heap()};
+                size_t first{};
+            };
+
+            std::vector<std::unique_ptr<Queue>> queues;
+            std::vector<std::thread> workers;
+
+            std::mutex sleepMutex;
+            std::condition_variable wake;
+            std::mutex finishMutex;
+            std::condition_variable finished;  // notified under finishMutex
+            std::atomic<size_t> queued;        // increased under sleepMutex
+            bool stopping;
+
+            std::atomic<size_t> nextQueue;
+
+            // Pops a task from the back of queue home, or steals one from
+            // the front of another queue
+            bool tryTake(size_t home, detail::Task& task){
+
+                const size_t count {queues.size()};
+
+                for (size_t k{}; k<count; ++k){
+
+                    Queue& queue {*queues[(home + k) % count]};
+                    std::lock_guard lock {queue.mutex};
+
+                    if (queue.first == queue.tasks.size()){
+                        continue;
+                    }
+
+                    if (k == 0){
+                        task = queue.tasks.back();
+                        queue.tasks.pop_back();
+                    } else {
+                        task = queue.tasks[queue.first++];
+                    }
+
+                    if (queue.first == queue.tasks.size()){
+                        queue.tasks.clear();
+                        queue.first = 0;
+                    }
+
+                    queued.fetch_sub(1, std::memory_order_relaxed);
+                    return true;
+                }
+
+                return false;
+            }
+
+            void execute(const detail::Task& task){
+
+                detail::Job& job {*task.job};
+
+                try {
+                    job.invoke(job.function, task.begin, task.end);
+                } catch (...) {
+                    if (not job.failed.exchange(true)){
+                        job.error = std::current_exception();
+                    }
+                }
+
+                // The decrement is the last access to job: once it reads
+                // zero, run() may return and destroy the job, so the waiter
+                // is woken through the pool's own mutex and condition
+                // variable. Taking the mutex orders the notification after
+                // a waiter that saw a nonzero count has started waiting.
+                if (job.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1){
+                    std::lock_guard lock {finishMutex};
+                    finished.notify_all();
+                }
+            }
+
+            void workerLoop(size_t index){
+
+                detail::insideWorker = true;
+
+                detail::Task task{};
+
+                for (;;){
+
+                    if (tryTake(index, task)){
+                        execute(task);
+                        continue;
+                    }
+
+                    std::unique_lock lock {sleepMutex};
+
+                    wake.wait(lock, [this]{
+                        return stopping or queued.load(std::memory_order_relaxed) != 0;
+                    });
+
+                    if (stopping and queued.load(std::memory_order_relaxed) == 0){
+                        return;
+                    }
+                }
+            }
+
+        public:
+
+        /******** Constructors - Assignment Operators - Destructor ***************/
+
+        // Starts threadCount - 1 workers (the calling thread is the last one)
+        explicit ThreadPool(size_t threadCount)
+        : queues{}, workers{}, sleepMutex{}, wake{}, finishMutex{}, finished{}, queued{0},
+          stopping{false}, nextQueue{0} {
+
+            const size_t workerCount {std::max(threadCount, size_t{1}) - 1};
+
+            for (size_t i{}; i<workerCount; ++i){
+                queues.push_back(std::make_unique<Queue>());
+            }
+
+            for (size_t i{}; i<workerCount; ++i){
+                workers.emplace_back([this, i]{ workerLoop(i); });
+            }
+        }
+
+        ThreadPool(const ThreadPool& source) = delete;
+        ThreadPool& operator=(const ThreadPool& rhs) = delete;
+
+        // Destructor (finishes the queued work, then joins the workers)
+        ~ThreadPool(){
+            {
+                std::lock_guard lock {sleepMutex};
+                stopping = true;
+            }
+            wake.notify_all();
+
+            for (auto& worker : workers){
+                worker.join();
+            }
+        }
+
+
+        /****************** Methods - Overloaded Operators ********************/
+
+        // Number of threads taking part in the work, the caller included
+        size_t size() const noexcept {
+            return workers.size() + 1;
+        }
+
+        // Calls function(begin, end) for consecutive blocks of block items
+        // covering [0, n), and returns once all of them are done. The first
+        // exception thrown by a block is rethrown here.
+        template<typename Function>
+        void run(size_t n, size_t block, const Function& function){
+
+            const size_t blockCount {(n + block - 1) / block};
+
+            if (workers.empty() or blockCount <= 1){
+                function(size_t{0}, n);
+                return;
+            }
+
+            detail::Job job{
+                [](const void* f, size_t begin, size_t end){
+                    (*static_cast<const Function*>(f))(begin, end);
+                },
+                &function, {blockCount}, {false}, nullptr
+            };
+
+            // Counted before they are pushed, so that the count never drops
+            // below zero when a worker takes a block right away
+            {
+                std::lock_guard lock {sleepMutex};
+                queued.fetch_add(blockCount, std::memory_order_relaxed);
+            }
+
+            // Spread contiguous runs of blocks over the queues, so that a
+            // worker tends to touch neighbouring rows
+            const size_t queueCount {queues.size()};
+            const size_t first {nextQueue.fetch_add(1, std::memory_order_relaxed)};
+
+            for (size_t q{}; q<queueCount; ++q){
+
+                const size_t from {blockCount * q / queueCount};
+                const size_t to {blockCount * (q + 1) / queueCount};
+
+                Queue& queue {*queues[(first + q) % queueCount]};
+                std::lock_guard lock {queue.mutex};
+
+                for (size_t b{from}; b<to; ++b){
+                    queue.tasks.push_back(
+                        detail::Task{&job, b * block, std::min(n, (b + 1) * block)}
+                    );
+                }
+            }
+
+            wake.notify_all();
+
+            // The caller steals work until its own job is drained
+            detail::Task task{};
+
+            while (job.remaining.load(std::memory_order_acquire) != 0
+                   and tryTake(first, task)){
+                execute(task);
+            }
+
+            if (job.remaining.load(std::memory_order_acquire) != 0){
+                std::unique_lock lock {finishMutex};
+                finished.wait(lock, [&job]{
+                    return job.remaining.load(std::memory_order_acquire) == 0;
+                });
+            }
+
+            if (job.error){
+                std::rethrow_exception(job.error);
+            }
+        }
+
+    };
+
+
+    namespace detail{
+
+        inline std::unique_ptr<ThreadPool>& poolInstance(){
+            static std::unique_ptr<ThreadPool> instance {
+                std::make_unique<ThreadPool>(defaultThreadCount())
+            };
+            return instance;
+        }
+
+    }
+
+    /*************************** Settings ****************************/
+
+    inline ThreadPool& pool(){
+        return *detail::poolInstance();
+    }
+
+    inline size_t threadCount(){
+        return pool().size();
+    }
+
+    // Replaces the pool; must not be called while parallel work is running
+    inline void setThreadCount(size_t count){
+        auto& instance {detail::poolInstance()};
+        instance.reset();
+        instance = std::make_unique<ThreadPool>(std::max(count, size_t{1}));
+    }
+
+    inline size_t serialCutoff() noexcept {
+        return detail::serialCutoff.load(std::memory_order_relaxed);
+    }
+
+    inline void setSerialCutoff(size_t work) noexcept {
+        detail::serialCutoff.store(work, std::memory_order_relaxed);
+    }
+
+    inline bool deterministic() noexcept {
+        return detail::deterministic.load(std::memory_order_relaxed);
+    }
+
+    inline void setDeterministic(bool enabled) noexcept {
+        detail::deterministic.store(enabled, std::memory_order_relaxed);
+    }
+
+
+    /************************ Parallel Loops **************************/
+
+    // Calls function(begin, end) over blocks of [0, n), each a multiple of
+    // granularity items (except the last), where one item costs about
+    // workPerItem. Runs serially, as a single function(0, n), below the
+    // serial cutoff, with one thread, or inside a worker.
+    template<typename Function>
+    void forBlocks(
+        size_t n, size_t workPerItem, size_t granularity, const Function& function
+    ){
+        if (n * workPerItem < serialCutoff() or detail::insideWorker){
+            function(size_t{0}, n);
+            return;
+        }
+
+        ThreadPool& threads {pool()};
+
+        // About four blocks per thread, for the stealing to balance the load
+        const size_t blocks {4 * threads.size()};
+        size_t block {(n + blocks - 1) / blocks};
+        block = (block + granularity - 1) / granularity * granularity;
+
+        threads.run(n, block, function);
+    }
+
+    // Sum of partial(begin, end) over blocks of [0, n), see forBlocks. In
+    // deterministic mode the blocks do not depend on the thread count and
+    // are added in order.
+    template<typename T, typename Partial>
+    T sum(size_t n, size_t workPerItem, const Partial& partial){
+
+        if (deterministic()){
+
+            constexpr size_t block {detail::reductionBlock};
+            const size_t blockCount {(n + block - 1) / block};
+
+            if (blockCount <= 1){
+                return partial(size_t{0}, n);
+            }
+
+            std::pmr::vector<T> partials(blockCount, memory::resource());
+
+            forBlocks(blockCount, block * workPerItem, 1, [&](size_t begin, size_t end){
+                for (size_t b{begin}; b<end; ++b){
+                    partials[b] = partial(b * block, std::min(n, (b + 1) * block));
+                }
+            });
+
+            T total {};
+
+            for (const T& value : partials){
+                total += value;
+            }
+
+            return total;
+        }
+
+        if (n * workPerItem < serialCutoff() or detail::insideWorker){
+            return partial(size_t{0}, n);
+        }
+
+        std::mutex mutex;
+        T total {};
+
+        forBlocks(n, workPerItem, 1, [&](size_t begin, size_t end){
+            const T value {partial(begin, end)};
+            std::lock_guard lock {mutex};
+            total += value;
+        });
+
+        return total;
+    }
+
+}
+
+#endif
@@ -0,0 +1,216 @@
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+/*
+    Lifecycle tracing for Vector, Matrix, Tensor, DynVector, DynMatrix,
+    SparseMatrix and the batches of Batch.h.
+
+    Each traced class derives from trace::Traced<Type>. By default that base
+    is an empty, trivial struct: it occupies no storage (empty base
+    optimization) and keeps Vector, Matrix and Tensor trivially copyable, so
+    constructors and assignment operators carry no I/O and no side effects.
+
+    Compile with -DMYMATH_ENABLE_TRACE to count, per class, every
+    construction, copy, move and assignment. Add -DMYMATH_TRACE_LOG to also
+    record every event, in order, into a fixed-size ring buffer. Nothing is
+    printed until trace::dump() is called:
+
+        trace::reset();
+        Matrix c = a * b;
+        trace::dump(std::cout);
+
+    Traced classes are not trivially copyable in a tracing build, since the
+    special members of the base have to run to be counted.
+*/
+
+#include <cstdint>
+
+namespace trace{
+
+    enum class Type : std::uint8_t {
+        Vector, Matrix, Tensor, DynVector, DynMatrix, VectorBatch, MatrixBatch,
+        SparseMatrix, Count
+    };
+
+    enum class Event : std::uint8_t {
+        Construct, Copy, Move, CopyAssign, MoveAssign, Count
+    };
+
+}
+
+#ifdef MYMATH_ENABLE_TRACE
+
+#include <atomic>
+#include <ostream>
+
+#ifndef MYMATH_TRACE_LOG_CAPACITY
+#define MYMATH_TRACE_LOG_CAPACITY 4096
+#endif
+
+namespace trace{
+
+    // Snapshot of the counters of one traced class
+    struct Counters{
+        size_t constructions;
+        size_t copies;
+        size_t moves;
+        size_t assignments;
+    };
+
+    namespace detail{
+
+        inline constexpr size_t typeCount = static_cast<size_t>(Type::Count);
+        inline constexpr size_t eventCount = static_cast<size_t>(Event::Count);
+        inline constexpr size_t logCapacity = MYMATH_TRACE_LOG_CAPACITY;
+
+        inline constexpr const char* typeName[typeCount] {
+            "Vector", "Matrix", "Tensor", "DynVector", "DynMatrix",
+            "VectorBatch", "MatrixBatch", "SparseMatrix"
+        };
+
+        inline constexpr const char* eventName[eventCount] {
+            "constructor", "copy constructor", "move constructor",
+            "copy assignment operator", "move assignment operator"
+        };
+
+        inline std::atomic<size_t> counter[typeCount][eventCount] {};
+
+        // every log entry packs (type, event) into a single byte, so that
+        // recording stays a relaxed atomic store even when several threads
+        // create temporaries concurrently
+        inline std::atomic<size_t> logSize {};
+        inline std::atomic<std::uint8_t> log[logCapacity] {};
+
+        inline size_t load(Type type, Event event) noexcept {
+            return counter[static_cast<size_t>(type)][static_cast<size_t>(event)]
+                .load(std::memory_order_relaxed);
+        }
+
+    }
+
+    // Records one lifecycle event of a traced class
+    inline void record(Type type, Event event) noexcept {
+
+        const auto t = static_cast<size_t>(type);
+        const auto e = static_cast<size_t>(event);
+
+        detail::counter[t][e].fetch_add(1, std::memory_order_relaxed);
+
+        #ifdef MYMATH_TRACE_LOG
+        const size_t slot {
+            detail::logSize.fetch_add(1, std::memory_order_relaxed)
+        };
+        detail::log[slot % detail::logCapacity].store(
+            static_cast<std::uint8_t>(t * detail::eventCount + e),
+            std::memory_order_relaxed
+        );
+        #endif
+    }
+
+    // Returns the counters accumulated for a traced class since the last reset
+    inline Counters counters(Type type) noexcept {
+        return Counters{
+            detail::load(type, Event::Construct),
+            detail::load(type, Event::Copy),
+            detail::load(type, Event::Move),
+            detail::load(type, Event::CopyAssign)
+                + detail::load(type, Event::MoveAssign)
+        };
+    }
+
+    // Clears all counters and the event log
+    inline void reset() noexcept {
+        for (auto& row : detail::counter){
+            for (auto& count : row){
+                count.store(0, std::memory_order_relaxed);
+            }
+        }
+        detail::logSize.store(0, std::memory_order_relaxed);
+    }
+
+    // Prints the counters of every traced class, followed by the recorded
+    // events (oldest first) when MYMATH_TRACE_LOG is defined
+    inline void dump(std::ostream& os){
+
+        for (size_t t{}; t<detail::typeCount; ++t){
+
+            const Counters c {counters(static_cast<Type>(t))};
+
+            os << detail::typeName[t]
+               << ": constructions " << c.constructions
+               << ", copies " << c.copies
+               << ", moves " << c.moves
+               << ", assignments " << c.assignments << '\n';
+        }
+
+        #ifdef MYMATH_TRACE_LOG
+        const size_t size {detail::logSize.load(std::memory_order_relaxed)};
+        const size_t first {
+            size > detail::logCapacity ? size - detail::logCapacity : 0
+        };
+
+        if (first != 0){
+            os << "(" << first << " older events dropped)" << '\n';
+        }
+
+        for (size_t i{first}; i<size; ++i){
+
+            const size_t entry {
+                detail::log[i % detail::logCapacity].load(std::memory_order_relaxed)
+            };
+
+            os << detail::typeName[entry / detail::eventCount] << "'s "
+               << detail::eventName[entry % detail::eventCount] << " called"
+               << '\n';
+        }
+        #endif
+
+        os.flush();
+    }
+
+    // Base class of every traced class. Its special members record the
+    // corresponding event of the derived class; they are skipped during
+    // constant evaluation so that traced classes stay constexpr.
+    template<Type type>
+    struct Traced{
+
+        constexpr Traced() noexcept {
+            if !consteval { record(type, Event::Construct); }
+        }
+
+        constexpr Traced(const Traced&) noexcept {
+            if !consteval { record(type, Event::Copy); }
+        }
+
+        constexpr Traced(Traced&&) noexcept {
+            if !consteval { record(type, Event::Move); }
+        }
+
+        constexpr Traced& operator=(const Traced&) noexcept {
+            if !consteval { record(type, Event::CopyAssign); }
+            return *this;
+        }
+
+        constexpr Traced& operator=(Traced&&) noexcept {
+            if !consteval { record(type, Event::MoveAssign); }
+            return *this;
+        }
+
+        ~Traced() = default;
+    };
+
+}
+
+#else
+
+namespace trace{
+
+    // Tracing disabled: an empty, trivial base
+    template<Type type>
+    struct Traced{};
+
+}
+
+#endif
+
+#endif
@@ -3,14 +3,21 @@
 
 #include <iostream>
 #include <type_traits>
-#include "core.h"
+#include "Compare.h"
+#include "Trace.h"
+#include "Bounds.h"
+#include "Expression.h"
+#include "Simd.h"
+#include "ThreadPool.h"
+#include "Blas.h"
+#include "View.h"
 
 
 template<typename T, size_t N>
-class Vector{
+class Vector : private trace::Traced<trace::Type::Vector>{
 
     static_assert(
-        std::is_arithmetic<T>::value,
+        numeric::Element<T>,
         "Vector class can only store integral or floating point values"
     );
 
@@ -30,202 +37,285 @@ class Vector{
         return os;
     }
 
-    friend Vector operator*(const T&& scalar, const Vector& vector){
-        return vector * scalar;
-    }
-
-    friend Vector operator*(const T& scalar, const Vector& vector){
-        return vector * scalar;
-    }
+    template<typename Destination> friend class expr::NoAlias;
 
 private:
 
     static constexpr double epsilon = 0.000001;
     static constexpr size_t x=0, y=1, z=2;
 
+    // Long enough vectors of float, double or int32 use the SIMD kernels
+    static constexpr bool useSimd = simd::Accelerated<T> and N >= simd::minLength;
+
     T component[N]; // Array to store vector components
 
+    // Evaluates an expression element by element into this vector, in a
+    // single loop and without temporaries (split across the thread pool
+    // for long vectors). A product is written as a whole by gemv().
+    template<typename Op, typename E>
+    constexpr void evaluate(const E& expression){
+
+        if constexpr (not expr::FixedShape<E>){
+            if (expression.shape()[0] != N){
+                throw std::invalid_argument("Vector dimensions do not match");
+            }
+        }
+
+        if constexpr (expr::Evaluable<E>){
+
+            expression.template evaluateInto<Op>(*this);
+
+        } else if (expr::aliases(expression, *this)){
+
+            evaluate<Op>(typename E::result_type{expression});
+
+        } else {
+
+            auto range = [&](size_t begin, size_t end){
+                for (size_t i{begin}; i<end; ++i){
+                    Op::apply(component[i], expression.eval(i));
+                }
+            };
+
+            if constexpr (N >= parallel::minimumWork){
+                if !consteval {
+                    parallel::forBlocks(N, 1, 1, range);
+                    return;
+                }
+            }
+
+            range(0, N);
+        }
+    }
 
 public:
 
     /******** Constructors - Assignment Operators - Destructor ***************/
 
     // Default Constructor
-    Vector(): component{} {
-        std::cout << "Vector's default constructor called" << std::endl;
-    }
+    constexpr Vector() noexcept : component{} {}
 
     // Variadic Template Constructor
     template<typename... Args>
-    Vector(Args... args) : component{static_cast<T>(args)...} {
+        requires (std::convertible_to<Args, T> && ...)
+    constexpr Vector(Args... args) noexcept : component{static_cast<T>(args)...} {
 
         static_assert(sizeof...(Args) == N, "Number of arguments must be equal to the vector dimension N");
 
-        std::cout << "Vector's Variadic template constructor called" << std::endl;
     }
 
-    // Copy Constructor
-    Vector(const Vector& source){
+    // Copy and Move Constructors, Copy and Move Assignment Operators
+    // Defaulted, so that Vector is trivially copyable and its moves are
+    // noexcept: returning a Vector by value is a plain memberwise copy
+    constexpr Vector(const Vector& source) = default;
+    constexpr Vector(Vector&& source) = default;
+    constexpr Vector& operator=(const Vector& rhs) = default;
+    constexpr Vector& operator=(Vector&& rhs) = default;
+
+    // Expression Constructor (evaluates a whole expression in one pass)
+    template<expr::EvaluatesTo<Vector> E>
+    constexpr Vector(const E& expression): component{} {
+        evaluate<expr::Assign>(expression);
+    }
 
-        std::cout << "Vector's copy constructor called" << std::endl;
+    // Converting Constructor from an expression of run-time dimension (a
+    // view, an expression involving a DynVector), which is checked
+    template<expr::Expression E>
+        requires (
+            not expr::Terminal<E> and not expr::FixedShape<E>
+            and expr::Compatible<Vector, E>
+        )
+    constexpr explicit Vector(const E& expression): component{} {
+        evaluate<expr::Assign>(expression);
+    }
 
-        for (size_t i{}; i<N; ++i){
-            component[i] = source.component[i];
+    // Expression Assignment Operator
+    template<expr::Expression E>
+        requires (not expr::Terminal<E> and expr::Compatible<Vector, E>)
+    constexpr Vector& operator=(const E& expression){
+        if constexpr (E::elementwise){
+            evaluate<expr::Assign>(expression);
+        } else {
+            *this = Vector{expression};
         }
+        return *this;
     }
 
-    // Move Constructor
-    Vector(const Vector&& source){
-        
-        std::cout << "Vector's move constructor called" << std::endl;
+    // Default destructor
+    ~Vector() = default; 
 
-        for (size_t i{}; i<N; ++i){
-            component[i] = source.component[i];
-        }
-        
-    }
 
-    // Copy Assignment Operator
-    Vector& operator=(const Vector& rhs){
+    /********************** Expression Interface **************************/
 
-        std::cout << "Vector's copy assignment operator called" << std::endl;
+    using result_type = Vector;
+    using value_type = T;
+    static constexpr bool elementwise = true;
 
-        if (this == &rhs){
-            return *this;
-        }
+    // Extents, as reported by every expression
+    static constexpr std::array<size_t, 1> shape(){
+        return {N};
+    }
 
-        for (size_t i{}; i<N; ++i){
-            component[i] = rhs.component[i];
-        }
+    // Distance between consecutive components
+    static constexpr std::array<size_t, 1> strides(){
+        return {1};
+    }
 
-        return *this;
+    // Unchecked element access used by expression evaluation
+    constexpr const T& eval(size_t index) const {
+        return component[index];
+    }
 
+    // Assignment target that skips the aliasing safeguard of operator=
+    constexpr expr::NoAlias<Vector> noalias(){
+        return expr::NoAlias<Vector>{*this};
     }
 
-    // Move Assignment Operator
-    Vector& operator=(Vector&& rhs){
+    // Pointer to the N contiguous components
+    constexpr T* data(){
+        return component;
+    }
 
-        std::cout << "Vector's move assignment operator called" << std::endl;
+    constexpr const T* data() const {
+        return component;
+    }
 
+    // View of the whole vector. The views below are not available on a
+    // temporary, which they would outlive
+    constexpr VectorView<T> view() & {
+        return VectorView<T>{component, N};
+    }
 
-        if (this == &rhs){
-            return *this;
-        }
+    constexpr VectorView<const T> view() const& {
+        return VectorView<const T>{component, N};
+    }
 
-        for (size_t i{}; i<N; ++i){
-            component[i] = rhs.component[i];
-        }
+    VectorView<const T> view() const&& = delete;
 
-        return *this;
+    // View of the n components from begin
+    constexpr VectorView<T> segment(size_t begin, size_t n) & {
+        return view().segment(begin, n);
     }
 
-    // Default destructor
-    ~Vector() = default; 
+    constexpr VectorView<const T> segment(size_t begin, size_t n) const& {
+        return view().segment(begin, n);
+    }
+
+    VectorView<const T> segment(size_t begin, size_t n) const&& = delete;
 
 
     /****************** Methods - Overloaded Operators ********************/
 
-    // Subscript or Array Index Operator (Const overload for read-only access)
-    const T& operator[](size_t index) const {
-        if (index >= N) throw std::out_of_range("Index out of bounds");
+    // Subscript or Array Index Operator (Const overload for read-only access),
+    // checked only when bounds are (see Bounds.h)
+    constexpr const T& operator[](size_t index) const {
+        bounds::debugCheck(index, N);
         return component[index];
     }
 
     // Subscript or Array Index Operator (Non-const overload for read/write access)
-    T& operator[](size_t index) {
-        if (index >= N) throw std::out_of_range("Index out of bounds");
+    constexpr T& operator[](size_t index) {
+        bounds::debugCheck(index, N);
         return component[index];
     }
 
+    // Checked element access
+    constexpr const T& at(size_t index) const {
+        bounds::check(index, N);
+        return component[index];
+    }
 
-    // Equal-to Operator (==)
-    bool operator==(const Vector& rhs) const {
-
-        for (size_t i{}; i<N; ++i){
+    constexpr T& at(size_t index) {
+        bounds::check(index, N);
+        return component[index];
+    }
 
-            if ( not isEqual(component[i], rhs[i]) ){
-                return false;
-            }
 
-        }
+    // Equal-to Operator (==)
+    constexpr bool operator==(const Vector& rhs) const {
 
-        return true;
+        return compare::equal(component, rhs.component, N);
     }
 
     // Not-Equal-to Operator (!=)
-    bool operator!=(const Vector& rhs) const {
+    constexpr bool operator!=(const Vector& rhs) const {
         return !(*this == rhs);
     }
 
-    // Addition Arithmetic Operator (+)
-    Vector operator+(const Vector& rhs) const {
-        
-        Vector temp;
-        for (size_t i{}; i<N; ++i){
-            temp.component[i] = component[i] + rhs.component[i];
-        }
-
-        return temp;
-    }
-
-    // Subtraction Arithmetic Operator (-)
-    Vector operator-(const Vector& rhs) const {
-
-        Vector temp;
-        for (size_t i{}; i<N; ++i){
-            temp.component[i] = component[i] - rhs.component[i];
-        }
-
-        return temp;
-    }
-
     // Compound Assignment Operator (+=)
-    void operator+=(const Vector& rhs) {
-        for (size_t i{}; i<N; ++i){
-            component[i] += rhs.component[i];
+    template<expr::Expression E> requires expr::Compatible<Vector, E>
+    constexpr void operator+=(const E& rhs) {
+        if constexpr (std::same_as<E, Vector> and useSimd){
+            if !consteval {
+                parallel::forBlocks(N, 1, 1, [&](size_t begin, size_t end){
+                    simd::axpy(end - begin, T{1}, rhs.component + begin, component + begin);
+                });
+                return;
+            }
         }
-    }
 
-    // Compound Assignment Operator (-=)
-    void operator-=(const Vector& rhs) {
-        for (size_t i{}; i<N; ++i){
-            component[i] -= rhs.component[i];
+        if constexpr (E::elementwise){
+            evaluate<expr::AddAssign>(rhs);
+        } else {
+            evaluate<expr::AddAssign>(Vector{rhs});
         }
     }
 
-    // scalar Multiplication Operator
-    Vector operator*(const T& scalar) const {
-        Vector scaledVector {*this};
-        for (size_t i{}; i<N; ++i){
-            scaledVector.component[i] *= scalar;
+    // Compound Assignment Operator (-=)
+    template<expr::Expression E> requires expr::Compatible<Vector, E>
+    constexpr void operator-=(const E& rhs) {
+        if constexpr (E::elementwise){
+            evaluate<expr::SubtractAssign>(rhs);
+        } else {
+            evaluate<expr::SubtractAssign>(Vector{rhs});
         }
-        return scaledVector;
     }
 
-    void operator *=(const T& scalar) {
+    constexpr void operator *=(const T& scalar) {
         for (size_t i{}; i<N; ++i){
             component[i] *= scalar;
         }
     }
 
-    // Dot Product Method
-    T dot(const Vector& rhs) const {
+    // Dot Product Method (the SIMD kernels and the thread pool are skipped
+    // in constant evaluation)
+    constexpr T dot(const Vector& rhs) const {
 
-        T dotProduct {};
+        // Sums of the 16-bit formats are accumulated in float
+        using A = numeric::accumulator_t<T>;
 
-        for (size_t i{}; i<N; ++i){
-            dotProduct += component[i] * rhs.component[i];
+        auto partial = [&](size_t begin, size_t end) -> A {
+
+            if constexpr (simd::Vectorized<T> and N >= simd::minLength){
+                if !consteval {
+                    return simd::dot(component + begin, rhs.component + begin, end - begin);
+                }
+            }
+
+            A dotProduct {};
+
+            for (size_t i{begin}; i<end; ++i){
+                dotProduct += static_cast<A>(component[i]) * static_cast<A>(rhs.component[i]);
+            }
+
+            return dotProduct;
+        };
+
+        if constexpr (N >= parallel::minimumWork){
+            if !consteval {
+                return static_cast<T>(parallel::sum<A>(N, 1, partial));
+            }
         }
 
-        return dotProduct;
+        return static_cast<T>(partial(0, N));
     }
 
-    T operator*(const Vector& rhs) const {
+    constexpr T operator*(const Vector& rhs) const {
         return (*this).dot(rhs);
     }
     
     // Cross Product Method (3D)
-    Vector<T, 3> cross(const Vector<T, 3>& rhs) const {
+    constexpr Vector<T, 3> cross(const Vector<T, 3>& rhs) const {
 
         static_assert(N == 3, "Vector dimension should be equal to 3");
 
@@ -239,7 +329,7 @@ public:
             component[z] * rhs.component[x] - component[x] * rhs.component[z]
         );
 
-        crosstProduct.component[z] = (
+        crossProduct.component[z] = (
             component[x] * rhs.component[y] - component[y] * rhs.component[x]
         );
 
@@ -248,7 +338,7 @@ public:
     }
 
     // Cross Product Method (2D)
-    T cross(const Vector<T, 2>& rhs) const {
+    constexpr T cross(const Vector<T, 2>& rhs) const {
 
         static_assert(N == 2, "Vector dimension should be equal to 2");
 
@@ -263,4 +353,10 @@ public:
 template<typename T, typename... Args>
 Vector(T, Args...) -> Vector<T, sizeof...(Args) + 1>;
 
+#ifndef MYMATH_ENABLE_TRACE
+static_assert(std::is_trivially_copyable_v<Vector<double, 3>>);
+static_assert(sizeof(Vector<double, 3>) == 3 * sizeof(double));
+#endif
+static_assert(std::is_nothrow_move_constructible_v<Vector<double, 3>>);
+
 #endif
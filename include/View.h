@@ -0,0 +1,654 @@
+#ifndef _VIEW_H_
+#define _VIEW_H_
+
+#include <array>
+#include <iostream>
+#include <stdexcept>
+#include <type_traits>
+#include <version>
+#if __has_include(<mdspan>)
+#include <mdspan>
+#endif
+#include "Compare.h"
+#include "Bounds.h"
+#include "Expression.h"
+#include "AlignedBuffer.h"
+#include "ThreadPool.h"
+#include "Blas.h"
+
+/*
+    Non-owning, strided views of the elements of a Vector, Matrix, Tensor,
+    DynVector or DynMatrix:
+
+        VectorView<T>   pointer, size and stride
+        MatrixView<T>   pointer, rows and columns, row and column strides
+
+    element (i, j) of a MatrixView being pointer[i*rowStride + j*columnStride].
+    A view of const T only reads the elements.
+
+    Rows, columns, sub-blocks and transposes are views, made without copying
+    anything:
+
+        m.row(i);  m.column(j);  m.block(i, j, rows, columns);
+        m.view().transpose();  v.segment(begin, n);
+
+    Views take part in the expression templates, with a shape known at run
+    time (like DynVector and DynMatrix, which an expression involving a view
+    evaluates to), and in the products, which gemm() / gemv() compute
+    straight from the viewed elements:
+
+        c.noalias() = a.view().transpose() * b;  // no copy of a, no temporary
+        m.block(0, 0, 2, 2) += n.block(2, 2, 2, 2);
+        m.column(0) = m.row(1);
+
+    Assigning to a view writes the viewed elements; it never rebinds the
+    view (copying a view does not copy the elements, assigning one does).
+    An element-wise expression may read its destination through views of
+    it, as in a = a.view().transpose() or v = v.segment(1, 2): one whose
+    views overlap the destination's elements in another layout is evaluated
+    into a temporary first (see expr::aliases).
+
+    A view must not outlive the object it refers to, nor a DynVector or
+    DynMatrix that has been resized since. When std::mdspan is available, a
+    view converts from and to a std::mdspan with a strided layout.
+*/
+
+template<typename T, size_t N> class Vector;
+template<typename T, size_t R, size_t C> class Matrix;
+template<typename T> class DynVector;
+template<typename T> class DynMatrix;
+
+template<typename T>
+class VectorView{
+
+    static_assert(
+        numeric::Element<std::remove_const_t<T>>,
+        "VectorView class can only refer to integral or floating point values"
+    );
+
+    friend std::ostream& operator<<(std::ostream& os, const VectorView& view){
+        os << "[ ";
+        for (size_t i{}; i<view.count; ++i){
+            os << view.eval(i) << " ";
+        }
+        os << "]";
+        return os;
+    }
+
+    template<typename Destination> friend class expr::NoAlias;
+
+    private:
+
+        T* pointer;
+        size_t count;
+        size_t step;
+
+        // Evaluates an expression element by element into the viewed
+        // elements (a product is written as a whole by gemv())
+        template<typename Op, typename E>
+        void evaluate(const E& expression){
+
+            checkSize(expression.shape()[0]);
+
+            if constexpr (expr::Evaluable<E>){
+
+                expression.template evaluateInto<Op>(*this);
+
+            } else if (expr::aliases(expression, *this)){
+
+                evaluate<Op>(typename E::result_type{expression});
+
+            } else {
+
+                parallel::forBlocks(count, 1, 1, [&](size_t begin, size_t end){
+                    for (size_t i{begin}; i<end; ++i){
+                        Op::apply(pointer[i*step], expression.eval(i));
+                    }
+                });
+            }
+        }
+
+        // Evaluates an expression that is not element-wise into a
+        // temporary first, in case it reads the viewed elements
+        template<typename Op, typename E>
+        void evaluateAliased(const E& expression){
+
+            AlignedBuffer<value_type> buffer {expression.shape()[0]};
+            VectorView<value_type> temporary {buffer.data(), buffer.size()};
+
+            temporary.template evaluate<expr::Assign>(expression);
+            evaluate<Op>(temporary);
+        }
+
+        void checkSize(size_t n) const {
+            if (n != count) throw std::invalid_argument("Vector dimensions do not match");
+        }
+
+    public:
+
+    /******** Constructors - Assignment Operators - Destructor ***************/
+
+    // Pointer Constructor: size elements, stride apart
+    constexpr VectorView(T* pointer, size_t size, size_t stride = 1) noexcept
+    : pointer{pointer}, count{size}, step{stride} {}
+
+    // Converting Constructor from a view of mutable elements
+    template<typename U> requires (std::same_as<const U, T> and not std::same_as<U, T>)
+    constexpr VectorView(const VectorView<U>& view) noexcept
+    : pointer{view.data()}, count{view.size()}, step{view.stride()} {}
+
+    // Copy Constructor (refers to the same elements)
+    constexpr VectorView(const VectorView& source) = default;
+
+    // Copy Assignment Operator (copies the elements of rhs into the viewed
+    // elements, which must be as many)
+    VectorView& operator=(const VectorView& rhs)
+        requires (not std::is_const_v<T>)
+    {
+        evaluate<expr::Assign>(rhs);
+        return *this;
+    }
+
+    // Expression Assignment Operator
+    template<expr::Expression E>
+        requires (not std::is_const_v<T> and expr::Compatible<VectorView, E>)
+    VectorView& operator=(const E& expression){
+        if constexpr (E::elementwise){
+            evaluate<expr::Assign>(expression);
+        } else {
+            evaluateAliased<expr::Assign>(expression);
+        }
+        return *this;
+    }
+
+    // Default destructor
+    ~VectorView() = default;
+
+    #ifdef __cpp_lib_mdspan
+    // Converting Constructor from a std::mdspan of rank 1 with a strided layout
+    template<typename Extents, typename Layout>
+        requires (Extents::rank() == 1 and Layout::template mapping<Extents>::is_always_strided())
+    constexpr VectorView(const std::mdspan<T, Extents, Layout>& span)
+    : pointer{span.data_handle()},
+      count{static_cast<size_t>(span.extent(0))},
+      step{static_cast<size_t>(span.stride(0))} {}
+
+    // The viewed elements as a std::mdspan
+    constexpr auto mdspan() const {
+        using Extents = std::dextents<size_t, 1>;
+        return std::mdspan<T, Extents, std::layout_stride>{
+            pointer,
+            std::layout_stride::mapping<Extents>{Extents{count}, std::array<size_t, 1>{step}}
+        };
+    }
+    #endif
+
+
+    /********************** Expression Interface **************************/
+
+    using value_type = std::remove_const_t<T>;
+    using result_type = DynVector<value_type>;
+    static constexpr bool elementwise = true;
+
+    // Extents, as reported by every expression
+    constexpr std::array<size_t, 1> shape() const {
+        return {count};
+    }
+
+    // Distance between consecutive elements
+    constexpr std::array<size_t, 1> strides() const {
+        return {step};
+    }
+
+    // Unchecked element access used by expression evaluation
+    constexpr const T& eval(size_t index) const {
+        return pointer[index*step];
+    }
+
+    // Assignment target that skips the aliasing safeguard of operator=
+    expr::NoAlias<VectorView> noalias() requires (not std::is_const_v<T>) {
+        return expr::NoAlias<VectorView>{*this};
+    }
+
+    constexpr T* data() const noexcept {
+        return pointer;
+    }
+
+    constexpr size_t size() const noexcept {
+        return count;
+    }
+
+    constexpr size_t stride() const noexcept {
+        return step;
+    }
+
+
+    /****************** Methods - Overloaded Operators ********************/
+
+    // Subscript or Array Index Operator, checked only when bounds are (see
+    // Bounds.h)
+    constexpr T& operator[](size_t index) const {
+        bounds::debugCheck(index, count);
+        return pointer[index*step];
+    }
+
+    // Checked element access
+    constexpr T& at(size_t index) const {
+        bounds::check(index, count);
+        return pointer[index*step];
+    }
+
+    // View of the n elements from begin
+    constexpr VectorView segment(size_t begin, size_t n) const {
+        if (begin > count or n > count - begin) throw std::out_of_range("Index out of bounds");
+        return VectorView{pointer + begin*step, n, step};
+    }
+
+    // Equal-to Operator (==), with any vector or view of the same dimension
+    template<expr::Strided<1> E> requires expr::SameValueType<VectorView, E>
+    constexpr bool operator==(const E& rhs) const {
+        return compare::equal(*this, rhs);
+    }
+
+    // Compound Assignment Operator (+=)
+    template<expr::Expression E>
+        requires (not std::is_const_v<T> and expr::Compatible<VectorView, E>)
+    void operator+=(const E& rhs) {
+        if constexpr (E::elementwise){
+            evaluate<expr::AddAssign>(rhs);
+        } else {
+            evaluateAliased<expr::AddAssign>(rhs);
+        }
+    }
+
+    // Compound Assignment Operator (-=)
+    template<expr::Expression E>
+        requires (not std::is_const_v<T> and expr::Compatible<VectorView, E>)
+    void operator-=(const E& rhs) {
+        if constexpr (E::elementwise){
+            evaluate<expr::SubtractAssign>(rhs);
+        } else {
+            evaluateAliased<expr::SubtractAssign>(rhs);
+        }
+    }
+
+    void operator*=(const value_type& scalar) requires (not std::is_const_v<T>) {
+        scal(scalar, *this);
+    }
+
+};
+
+
+template<typename T>
+class MatrixView{
+
+    static_assert(
+        numeric::Element<std::remove_const_t<T>>,
+        "MatrixView class can only refer to integral or floating point values"
+    );
+
+    friend std::ostream& operator<<(std::ostream& os, const MatrixView& view){
+        for (size_t i{}; i < view.rowCount; ++i){
+            for (size_t j{}; j < view.columnCount; ++j){
+                os << view.eval(i, j) << " ";
+            }
+            if (i + 1 != view.rowCount) {os << std::endl;}
+        }
+        return os;
+    }
+
+    template<typename Destination> friend class expr::NoAlias;
+
+    private:
+
+        T* pointer;
+        size_t rowCount;
+        size_t columnCount;
+        size_t rowStride;
+        size_t columnStride;
+
+        // Evaluates an expression element by element into the viewed
+        // elements, a block of rows at a time (a product is written as a
+        // whole by gemm())
+        template<typename Op, typename E>
+        void evaluate(const E& expression){
+
+            const auto [rows, columns] = expression.shape();
+
+            checkShape(rows, columns);
+
+            if constexpr (expr::Evaluable<E>){
+
+                expression.template evaluateInto<Op>(*this);
+
+            } else if (expr::aliases(expression, *this)){
+
+                evaluate<Op>(typename E::result_type{expression});
+
+            } else {
+
+                parallel::forBlocks(rows, columns, 1, [&](size_t begin, size_t end){
+                    for (size_t i{begin}; i<end; ++i){
+
+                        T* row {pointer + i*rowStride};
+
+                        for (size_t j{}; j<columns; ++j){
+                            Op::apply(row[j*columnStride], expression.eval(i, j));
+                        }
+                    }
+                });
+            }
+        }
+
+        // Evaluates an expression that is not element-wise into a
+        // temporary first, in case it reads the viewed elements
+        template<typename Op, typename E>
+        void evaluateAliased(const E& expression){
+
+            const auto [rows, columns] = expression.shape();
+
+            AlignedBuffer<value_type> buffer {rows * columns};
+            MatrixView<value_type> temporary {buffer.data(), rows, columns};
+
+            temporary.template evaluate<expr::Assign>(expression);
+            evaluate<Op>(temporary);
+        }
+
+        void checkShape(size_t rows, size_t columns) const {
+            if (rows != rowCount or columns != columnCount){
+                throw std::invalid_argument("Matrix dimensions do not match");
+            }
+        }
+
+    public:
+
+    /******** Constructors - Assignment Operators - Destructor ***************/
+
+    // Pointer Constructor: rows x columns elements, stored row by row
+    // unless strides are given
+    constexpr MatrixView(T* pointer, size_t rows, size_t columns) noexcept
+    : MatrixView{pointer, rows, columns, columns, 1} {}
+
+    constexpr MatrixView(
+        T* pointer, size_t rows, size_t columns, size_t rowStride, size_t columnStride
+    ) noexcept
+    : pointer{pointer}, rowCount{rows}, columnCount{columns},
+      rowStride{rowStride}, columnStride{columnStride} {}
+
+    // Converting Constructor from a view of mutable elements
+    template<typename U> requires (std::same_as<const U, T> and not std::same_as<U, T>)
+    constexpr MatrixView(const MatrixView<U>& view) noexcept
+    : pointer{view.data()}, rowCount{view.rows()}, columnCount{view.columns()},
+      rowStride{view.strides()[0]}, columnStride{view.strides()[1]} {}
+
+    // Copy Constructor (refers to the same elements)
+    constexpr MatrixView(const MatrixView& source) = default;
+
+    // Copy Assignment Operator (copies the elements of rhs into the viewed
+    // elements, which must have the same dimensions)
+    MatrixView& operator=(const MatrixView& rhs)
+        requires (not std::is_const_v<T>)
+    {
+        evaluate<expr::Assign>(rhs);
+        return *this;
+    }
+
+    // Expression Assignment Operator
+    template<expr::Expression E>
+        requires (not std::is_const_v<T> and expr::Compatible<MatrixView, E>)
+    MatrixView& operator=(const E& expression){
+        if constexpr (E::elementwise){
+            evaluate<expr::Assign>(expression);
+        } else {
+            evaluateAliased<expr::Assign>(expression);
+        }
+        return *this;
+    }
+
+    // Default destructor
+    ~MatrixView() = default;
+
+    #ifdef __cpp_lib_mdspan
+    // Converting Constructor from a std::mdspan of rank 2 with a strided layout
+    template<typename Extents, typename Layout>
+        requires (Extents::rank() == 2 and Layout::template mapping<Extents>::is_always_strided())
+    constexpr MatrixView(const std::mdspan<T, Extents, Layout>& span)
+    : pointer{span.data_handle()},
+      rowCount{static_cast<size_t>(span.extent(0))},
+      columnCount{static_cast<size_t>(span.extent(1))},
+      rowStride{static_cast<size_t>(span.stride(0))},
+      columnStride{static_cast<size_t>(span.stride(1))} {}
+
+    // The viewed elements as a std::mdspan
+    constexpr auto mdspan() const {
+        using Extents = std::dextents<size_t, 2>;
+        return std::mdspan<T, Extents, std::layout_stride>{
+            pointer,
+            std::layout_stride::mapping<Extents>{
+                Extents{rowCount, columnCount}, std::array<size_t, 2>{rowStride, columnStride}
+            }
+        };
+    }
+    #endif
+
+
+    /********************** Expression Interface **************************/
+
+    using value_type = std::remove_const_t<T>;
+    using result_type = DynMatrix<value_type>;
+    static constexpr bool elementwise = true;
+
+    // Extents, as reported by every expression
+    constexpr std::array<size_t, 2> shape() const {
+        return {rowCount, columnCount};
+    }
+
+    // Distances between consecutive rows and between consecutive columns
+    constexpr std::array<size_t, 2> strides() const {
+        return {rowStride, columnStride};
+    }
+
+    // Unchecked element access used by expression evaluation
+    constexpr const T& eval(size_t rowIndex, size_t columnIndex) const {
+        return pointer[rowIndex*rowStride + columnIndex*columnStride];
+    }
+
+    // Assignment target that skips the aliasing safeguard of operator=
+    expr::NoAlias<MatrixView> noalias() requires (not std::is_const_v<T>) {
+        return expr::NoAlias<MatrixView>{*this};
+    }
+
+    constexpr T* data() const noexcept {
+        return pointer;
+    }
+
+    constexpr size_t rows() const noexcept {
+        return rowCount;
+    }
+
+    constexpr size_t columns() const noexcept {
+        return columnCount;
+    }
+
+
+    /****************** Methods - Overloaded Operators ********************/
+
+    // Subscript or Array Index Operator, checked only when bounds are (see
+    // Bounds.h)
+    constexpr T& operator[](size_t rowIndex, size_t columnIndex) const {
+        bounds::debugCheck(rowIndex, rowCount);
+        bounds::debugCheck(columnIndex, columnCount);
+        return pointer[rowIndex*rowStride + columnIndex*columnStride];
+    }
+
+    // Checked element access
+    constexpr T& at(size_t rowIndex, size_t columnIndex) const {
+        bounds::check(rowIndex, rowCount);
+        bounds::check(columnIndex, columnCount);
+        return pointer[rowIndex*rowStride + columnIndex*columnStride];
+    }
+
+    // View of the i-th row
+    constexpr VectorView<T> row(size_t index) const {
+        if (index >= rowCount) throw std::out_of_range("Index out of bounds");
+        return VectorView<T>{pointer + index*rowStride, columnCount, columnStride};
+    }
+
+    // View of the j-th column
+    constexpr VectorView<T> column(size_t index) const {
+        if (index >= columnCount) throw std::out_of_range("Index out of bounds");
+        return VectorView<T>{pointer + index*columnStride, rowCount, rowStride};
+    }
+
+    // View of the rows x columns block whose top-left element is (i, j)
+    constexpr MatrixView block(size_t i, size_t j, size_t rows, size_t columns) const {
+
+        if (i > rowCount or rows > rowCount - i or j > columnCount or columns > columnCount - j){
+            throw std::out_of_range("Index out of bounds");
+        }
+
+        return MatrixView{
+            pointer + i*rowStride + j*columnStride, rows, columns, rowStride, columnStride
+        };
+    }
+
+    // View of the transpose: rows and columns swapped, nothing moved
+    constexpr MatrixView transpose() const noexcept {
+        return MatrixView{pointer, columnCount, rowCount, columnStride, rowStride};
+    }
+
+    // Equal-to Operator (==), with any matrix or view of the same dimensions
+    template<expr::Strided<2> E> requires expr::SameValueType<MatrixView, E>
+    constexpr bool operator==(const E& rhs) const {
+        return compare::equal(*this, rhs);
+    }
+
+    // Compound Assignment Operator (+=)
+    template<expr::Expression E>
+        requires (not std::is_const_v<T> and expr::Compatible<MatrixView, E>)
+    void operator+=(const E& rhs) {
+        if constexpr (E::elementwise){
+            evaluate<expr::AddAssign>(rhs);
+        } else {
+            evaluateAliased<expr::AddAssign>(rhs);
+        }
+    }
+
+    // Compound Assignment Operator (-=)
+    template<expr::Expression E>
+        requires (not std::is_const_v<T> and expr::Compatible<MatrixView, E>)
+    void operator-=(const E& rhs) {
+        if constexpr (E::elementwise){
+            evaluate<expr::SubtractAssign>(rhs);
+        } else {
+            evaluateAliased<expr::SubtractAssign>(rhs);
+        }
+    }
+
+    void operator*=(const value_type& scalar) requires (not std::is_const_v<T>) {
+        scal(scalar, *this);
+    }
+
+};
+
+
+namespace expr{
+
+    // Views, as opposed to the concrete classes
+    template<typename E>
+    concept View = Stored<E> && not Terminal<E>;
+
+    // Views evaluate to dynamic objects, which mix with the fixed-size ones
+    template<typename T, size_t N>
+    struct Common<Vector<T, N>, DynVector<T>>{
+        using type = DynVector<T>;
+    };
+
+    template<typename T, size_t N>
+    struct Common<DynVector<T>, Vector<T, N>>{
+        using type = DynVector<T>;
+    };
+
+    template<typename T, size_t R, size_t C>
+    struct Common<Matrix<T, R, C>, DynMatrix<T>>{
+        using type = DynMatrix<T>;
+    };
+
+    template<typename T, size_t R, size_t C>
+    struct Common<DynMatrix<T>, Matrix<T, R, C>>{
+        using type = DynMatrix<T>;
+    };
+
+}
+
+
+/********************* Products Involving Views **************************/
+
+// Matrix Multiplication Operator (evaluated by gemm())
+template<expr::Strided<2> L, expr::Strided<2> R>
+    requires ((expr::View<L> or expr::View<R>) and expr::SameValueType<L, R>)
+constexpr expr::Product<L, R, DynMatrix<typename L::value_type>>
+operator*(const L& lhs, const R& rhs){
+    return {lhs, rhs};
+}
+
+// Matrix-Vector Multiplication Operator (evaluated by gemv())
+template<expr::Strided<2> L, expr::Strided<1> R>
+    requires ((expr::View<L> or expr::View<R>) and expr::SameValueType<L, R>)
+constexpr expr::Product<L, R, DynVector<typename L::value_type>>
+operator*(const L& lhs, const R& rhsVector){
+    return {lhs, rhsVector};
+}
+
+// Dot Product Operator
+template<expr::Strided<1> L, expr::Strided<1> R>
+    requires ((expr::View<L> or expr::View<R>) and expr::SameValueType<L, R>)
+typename L::value_type operator*(const L& lhs, const R& rhs){
+    return dot(lhs, rhs);
+}
+
+
+/*************** Products of Different Element Types *********************/
+
+// Products of operands holding different element types are computed in the
+// promoted type by the widening gemm(), gemv() and dot() (Blas.h), and are
+// of fixed size when both operands are
+
+// Matrix Multiplication Operator
+template<expr::Strided<2> L, expr::Strided<2> R>
+    requires (not expr::SameValueType<L, R>)
+constexpr auto operator*(const L& lhs, const R& rhs){
+
+    using P = expr::Promoted<L, R>;
+
+    if constexpr (expr::FixedShape<L> and expr::FixedShape<R>){
+        static_assert(L::shape()[1] == R::shape()[0], "Matrix dimensions do not match");
+        return expr::Product<L, R, Matrix<P, L::shape()[0], R::shape()[1]>>{lhs, rhs};
+    } else {
+        return expr::Product<L, R, DynMatrix<P>>{lhs, rhs};
+    }
+}
+
+// Matrix-Vector Multiplication Operator
+template<expr::Strided<2> L, expr::Strided<1> R>
+    requires (not expr::SameValueType<L, R>)
+constexpr auto operator*(const L& lhs, const R& rhsVector){
+
+    using P = expr::Promoted<L, R>;
+
+    if constexpr (expr::FixedShape<L> and expr::FixedShape<R>){
+        static_assert(L::shape()[1] == R::shape()[0], "Matrix dimensions do not match");
+        return expr::Product<L, R, Vector<P, L::shape()[0]>>{lhs, rhsVector};
+    } else {
+        return expr::Product<L, R, DynVector<P>>{lhs, rhsVector};
+    }
+}
+
+// Dot Product Operator
+template<expr::Strided<1> L, expr::Strided<1> R>
+    requires (not expr::SameValueType<L, R>)
+expr::Promoted<L, R> operator*(const L& lhs, const R& rhs){
+    return dot(lhs, rhs);
+}
+
+#endif
@@ -1,7 +0,0 @@
-#ifndef _CORE_H_
-#define _CORE_H_
-
-bool isEqual(double x, double y);
-bool isEqual(int x, int y);
-
-#endif